@@ -0,0 +1,73 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#include "AllocationCounter.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+// ThreadSanitizer replaces the allocator itself and has to see every allocation, so under it
+// the counter is unavailable rather than routing allocations around the sanitizer
+#if defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define CLK_THREAD_SANITIZER 1
+#endif
+#endif
+
+#if defined(__SANITIZE_THREAD__)
+#define CLK_THREAD_SANITIZER 1
+#endif
+
+#if defined(__GLIBC__) && !defined(CLK_THREAD_SANITIZER)
+
+// glibc exports its allocator under these names as well, so the definitions below can
+// replace the public entry points for the whole process and still reach the real thing.
+// the executable must export them (see ENABLE_EXPORTS in CMakeLists.txt).
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static _Atomic uint64_t allocationCount;
+
+void *malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&allocationCount, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    atomic_fetch_add_explicit(&allocationCount, 1, memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    atomic_fetch_add_explicit(&allocationCount, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+bool AllocationCounterIsAvailable(void)
+{
+    return true;
+}
+
+uint64_t AllocationCount(void)
+{
+    return atomic_load_explicit(&allocationCount, memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounterIsAvailable(void)
+{
+    return false;
+}
+
+uint64_t AllocationCount(void)
+{
+    return 0;
+}
+
+#endif
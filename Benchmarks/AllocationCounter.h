@@ -0,0 +1,18 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// counts calls to malloc(), calloc() and realloc() made anywhere in the process, including
+// inside Foundation and the Objective-C runtime (but not the C library's calls to itself, such
+// as the allocation in strdup()). counting works by interposing the allocator, which is only
+// done against glibc; elsewhere the counter is unavailable and reads zero.
+bool AllocationCounterIsAvailable(void);
+uint64_t AllocationCount(void);
+
+#endif
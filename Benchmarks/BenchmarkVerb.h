@@ -0,0 +1,21 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "CLKit.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// a verb that accepts a workload's options and does nothing with them
+@interface BenchmarkVerb : NSObject <CLKVerb>
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
++ (instancetype)verbWithName:(NSString *)name options:(NSArray<CLKOption *> *)options optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups;
+
+@end
+
+NS_ASSUME_NONNULL_END
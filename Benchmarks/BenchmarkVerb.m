@@ -0,0 +1,50 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "BenchmarkVerb.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface BenchmarkVerb ()
+
+- (instancetype)_initWithName:(NSString *)name options:(NSArray<CLKOption *> *)options optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation BenchmarkVerb
+{
+    NSString *_name;
+    NSArray<CLKOption *> *_options;
+    NSArray<CLKOptionGroup *> *_optionGroups;
+}
+
+@synthesize name = _name;
+@synthesize options = _options;
+@synthesize optionGroups = _optionGroups;
+
++ (instancetype)verbWithName:(NSString *)name options:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups
+{
+    return [[self alloc] _initWithName:name options:options optionGroups:groups];
+}
+
+- (instancetype)_initWithName:(NSString *)name options:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups
+{
+    self = [super init];
+    if (self != nil) {
+        _name = [name copy];
+        _options = [options copy];
+        _optionGroups = [groups copy];
+    }
+    
+    return self;
+}
+
+- (CLKCommandResult *)runWithManifest:(__unused CLKArgumentManifest *)manifest
+{
+    return [CLKCommandResult resultWithExitStatus:0];
+}
+
+@end
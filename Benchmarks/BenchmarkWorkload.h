@@ -0,0 +1,49 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class CLKOption;
+@class CLKOptionGroup;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// a synthetic command line and the options it is parsed against.
+//
+// generation is deterministic, so a workload with the same parameters produces the same
+// argument vector on every run and every machine.
+@interface BenchmarkWorkload : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
+// flagSetDensity is the fraction of option tokens written as flag sets (`-xyz`). errorRate is the
+// fraction of tokens that are mistakes: unrecognized options, or when there are groups, a pair of
+// mutually exclusive options. groups claim options the workload otherwise leaves out of the
+// argument vector, so at least four options must remain outside of them.
++ (instancetype)workloadWithName:(NSString *)name
+                      tokenCount:(NSUInteger)tokenCount
+                     optionCount:(NSUInteger)optionCount
+                  flagSetDensity:(double)flagSetDensity
+                      groupCount:(NSUInteger)groupCount
+                       errorRate:(double)errorRate;
+
+@property (readonly) NSString *name;
+@property (readonly) NSUInteger tokenCount;
+@property (readonly) NSUInteger optionCount;
+@property (readonly) double flagSetDensity;
+@property (readonly) NSUInteger groupCount;
+@property (readonly) double errorRate;
+
+@property (readonly) NSArray<CLKOption *> *options;
+@property (readonly) NSArray<CLKOptionGroup *> *optionGroups;
+@property (readonly) NSArray<NSString *> *argumentVector;
+
+// enumerates the recognized options in the argument vector in order, with their arguments.
+// `argument` is nil for switch options.
+- (void)enumerateSuppliedOptionsUsingBlock:(void (^)(CLKOption *option, NSString * _Nullable argument))block;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,259 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "BenchmarkWorkload.h"
+
+#import "CLKOption.h"
+#import "CLKOptionGroup.h"
+
+// single-character flags are handed out to the first options, in this order
+static NSString * const BenchmarkWorkloadFlagCharacters = @"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+// options in a flag set
+static const NSUInteger BenchmarkWorkloadFlagSetLength = 3;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface BenchmarkWorkload ()
+
+- (instancetype)_initWithName:(NSString *)name
+                   tokenCount:(NSUInteger)tokenCount
+                  optionCount:(NSUInteger)optionCount
+               flagSetDensity:(double)flagSetDensity
+                   groupCount:(NSUInteger)groupCount
+                    errorRate:(double)errorRate NS_DESIGNATED_INITIALIZER;
+
+- (void)_generateOptions;
+- (void)_generateArgumentVector;
+- (void)_supplyOption:(CLKOption *)option argument:(nullable NSString *)argument;
+
+// xorshift64*, seeded per workload
+- (uint64_t)_nextRandom;
+- (double)_nextUnitRandom;
+- (NSUInteger)_nextRandomBelow:(NSUInteger)bound;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation BenchmarkWorkload
+{
+    NSString *_name;
+    NSUInteger _tokenCount;
+    NSUInteger _optionCount;
+    double _flagSetDensity;
+    NSUInteger _groupCount;
+    double _errorRate;
+    NSArray<CLKOption *> *_options;
+    NSArray<CLKOptionGroup *> *_optionGroups;
+    NSMutableArray<NSString *> *_argumentVector;
+    NSMutableArray<CLKOption *> *_suppliedOptions;
+    NSMutableArray *_suppliedArguments; // NSNull for switch options
+    uint64_t _randomState;
+}
+
+@synthesize name = _name;
+@synthesize tokenCount = _tokenCount;
+@synthesize optionCount = _optionCount;
+@synthesize flagSetDensity = _flagSetDensity;
+@synthesize groupCount = _groupCount;
+@synthesize errorRate = _errorRate;
+@synthesize options = _options;
+@synthesize optionGroups = _optionGroups;
+@synthesize argumentVector = _argumentVector;
+
++ (instancetype)workloadWithName:(NSString *)name
+                      tokenCount:(NSUInteger)tokenCount
+                     optionCount:(NSUInteger)optionCount
+                  flagSetDensity:(double)flagSetDensity
+                      groupCount:(NSUInteger)groupCount
+                       errorRate:(double)errorRate
+{
+    return [[self alloc] _initWithName:name tokenCount:tokenCount optionCount:optionCount flagSetDensity:flagSetDensity groupCount:groupCount errorRate:errorRate];
+}
+
+- (instancetype)_initWithName:(NSString *)name
+                   tokenCount:(NSUInteger)tokenCount
+                  optionCount:(NSUInteger)optionCount
+               flagSetDensity:(double)flagSetDensity
+                   groupCount:(NSUInteger)groupCount
+                    errorRate:(double)errorRate
+{
+    NSParameterAssert(optionCount >= ((groupCount * 2) + 4));
+    NSParameterAssert(flagSetDensity >= 0 && flagSetDensity <= 1);
+    NSParameterAssert(errorRate >= 0 && errorRate <= 1);
+    
+    self = [super init];
+    if (self != nil) {
+        _name = [name copy];
+        _tokenCount = tokenCount;
+        _optionCount = optionCount;
+        _flagSetDensity = flagSetDensity;
+        _groupCount = groupCount;
+        _errorRate = errorRate;
+        _argumentVector = [[NSMutableArray alloc] initWithCapacity:tokenCount];
+        _suppliedOptions = [[NSMutableArray alloc] init];
+        _suppliedArguments = [[NSMutableArray alloc] init];
+        
+        // -[NSString hash] differs between Foundations, so the seed is an FNV-1a hash of the name
+        _randomState = 0xCBF29CE484222325ULL;
+        for (const char *c = name.UTF8String ; *c != '\0' ; c++) {
+            _randomState = ((_randomState ^ (uint8_t)*c) * 0x100000001B3ULL);
+        }
+        
+        [self _generateOptions];
+        [self _generateArgumentVector];
+    }
+    
+    return self;
+}
+
+#pragma mark -
+#pragma mark Generation
+
+- (void)_generateOptions
+{
+    // every third option is a parameter option. parameter options are recurrent so that repeating one
+    // isn't a mistake; only the error rate should produce issues.
+    NSMutableArray<CLKOption *> *options = [NSMutableArray arrayWithCapacity:_optionCount];
+    for (NSUInteger i = 0 ; i < _optionCount ; i++) {
+        NSString *name = [NSString stringWithFormat:@"option-%lu", (unsigned long)i];
+        NSString *flag = nil;
+        if (i < BenchmarkWorkloadFlagCharacters.length) {
+            flag = [BenchmarkWorkloadFlagCharacters substringWithRange:NSMakeRange(i, 1)];
+        }
+        
+        if ((i % 3) == 2) {
+            [options addObject:[CLKOption parameterOptionWithName:name flag:flag required:NO recurrent:YES transformer:nil]];
+        } else {
+            [options addObject:[CLKOption optionWithName:name flag:flag]];
+        }
+    }
+    
+    // groups pair up the options at the end of the list
+    NSMutableArray<CLKOptionGroup *> *groups = [NSMutableArray arrayWithCapacity:_groupCount];
+    for (NSUInteger i = 0 ; i < _groupCount ; i++) {
+        NSUInteger first = (_optionCount - ((i + 1) * 2));
+        [groups addObject:[CLKOptionGroup mutexedGroupForOptionsNamed:@[ options[first].name, options[first + 1].name ]]];
+    }
+    
+    _options = options;
+    _optionGroups = groups;
+}
+
+- (void)_generateArgumentVector
+{
+    NSUInteger ungroupedOptionCount = (_optionCount - (_groupCount * 2));
+    
+    // switch options with flags, which can be combined into flag sets
+    NSMutableArray<CLKOption *> *flagSetCandidates = [NSMutableArray array];
+    for (NSUInteger i = 0 ; i < MIN(ungroupedOptionCount, BenchmarkWorkloadFlagCharacters.length) ; i++) {
+        if (_options[i].type == CLKOptionTypeSwitch) {
+            [flagSetCandidates addObject:_options[i]];
+        }
+    }
+    
+    while (_argumentVector.count < _tokenCount) {
+        NSUInteger remainingTokens = (_tokenCount - _argumentVector.count);
+        
+        if ([self _nextUnitRandom] < _errorRate) {
+            if (_groupCount > 0 && remainingTokens >= 2 && ([self _nextRandom] & 1)) {
+                // both members of a group (see -_generateOptions), each written in a single token
+                NSUInteger first = (_optionCount - (([self _nextRandomBelow:_groupCount] + 1) * 2));
+                for (NSUInteger i = first ; i < (first + 2) ; i++) {
+                    CLKOption *option = _options[i];
+                    if (option.type == CLKOptionTypeSwitch) {
+                        [_argumentVector addObject:[@"--" stringByAppendingString:option.name]];
+                        [self _supplyOption:option argument:nil];
+                    } else {
+                        NSString *argument = [NSString stringWithFormat:@"value-%lu", (unsigned long)_argumentVector.count];
+                        [_argumentVector addObject:[NSString stringWithFormat:@"--%@=%@", option.name, argument]];
+                        [self _supplyOption:option argument:argument];
+                    }
+                }
+            } else {
+                [_argumentVector addObject:[NSString stringWithFormat:@"--no-such-option-%lu", (unsigned long)_argumentVector.count]];
+            }
+            
+            continue;
+        }
+        
+        // one token in eight is a positional argument
+        if (([self _nextRandom] & 7) == 0) {
+            [_argumentVector addObject:[NSString stringWithFormat:@"input-%lu.txt", (unsigned long)_argumentVector.count]];
+            continue;
+        }
+        
+        if (flagSetCandidates.count >= BenchmarkWorkloadFlagSetLength && [self _nextUnitRandom] < _flagSetDensity) {
+            NSMutableString *flagSet = [NSMutableString stringWithString:@"-"];
+            NSUInteger start = [self _nextRandomBelow:flagSetCandidates.count];
+            for (NSUInteger i = 0 ; i < BenchmarkWorkloadFlagSetLength ; i++) {
+                CLKOption *option = flagSetCandidates[(start + i) % flagSetCandidates.count];
+                [flagSet appendString:option.flag];
+                [self _supplyOption:option argument:nil];
+            }
+            
+            [_argumentVector addObject:flagSet];
+            continue;
+        }
+        
+        CLKOption *option = _options[[self _nextRandomBelow:ungroupedOptionCount]];
+        BOOL useFlag = (option.flag != nil && ([self _nextRandom] & 1));
+        NSString *invocation = (useFlag ? [@"-" stringByAppendingString:option.flag] : [@"--" stringByAppendingString:option.name]);
+        
+        if (option.type == CLKOptionTypeSwitch) {
+            [_argumentVector addObject:invocation];
+            [self _supplyOption:option argument:nil];
+            continue;
+        }
+        
+        NSString *argument = [NSString stringWithFormat:@"value-%lu", (unsigned long)_argumentVector.count];
+        if (remainingTokens >= 2 && ([self _nextRandom] & 1)) {
+            [_argumentVector addObject:invocation];
+            [_argumentVector addObject:argument];
+        } else {
+            [_argumentVector addObject:[NSString stringWithFormat:@"%@=%@", invocation, argument]];
+        }
+        
+        [self _supplyOption:option argument:argument];
+    }
+}
+
+- (void)_supplyOption:(CLKOption *)option argument:(NSString *)argument
+{
+    [_suppliedOptions addObject:option];
+    [_suppliedArguments addObject:(argument ?: [NSNull null])];
+}
+
+- (void)enumerateSuppliedOptionsUsingBlock:(void (^)(CLKOption *, NSString *))block
+{
+    for (NSUInteger i = 0 ; i < _suppliedOptions.count ; i++) {
+        id argument = _suppliedArguments[i];
+        block(_suppliedOptions[i], (argument == [NSNull null] ? nil : argument));
+    }
+}
+
+#pragma mark -
+#pragma mark Randomness
+
+- (uint64_t)_nextRandom
+{
+    _randomState ^= (_randomState >> 12);
+    _randomState ^= (_randomState << 25);
+    _randomState ^= (_randomState >> 27);
+    return (_randomState * 0x2545F4914F6CDD1DULL);
+}
+
+- (double)_nextUnitRandom
+{
+    return ((double)([self _nextRandom] >> 11) / (double)(1ULL << 53));
+}
+
+- (NSUInteger)_nextRandomBelow:(NSUInteger)bound
+{
+    NSParameterAssert(bound > 0);
+    return (NSUInteger)([self _nextRandom] % bound);
+}
+
+@end
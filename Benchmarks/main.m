@@ -0,0 +1,673 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import <stdatomic.h>
+#import <stdlib.h>
+#import <string.h>
+#import <sys/resource.h>
+#import <sysexits.h>
+#import <time.h>
+
+#import "AllocationCounter.h"
+#import "BenchmarkVerb.h"
+#import "BenchmarkWorkload.h"
+#import "CLKArgumentManifestValidator.h"
+#import "CLKArgumentManifest_Private.h"
+#import "CLKOptionSchema_Private.h"
+#import "CLKToken.h"
+#import "CLKit.h"
+
+typedef struct {
+    double nanosecondsPerToken;
+    double allocationsPerIteration; // negative when allocations can't be counted
+} Measurement;
+
+// how long each benchmark runs against each workload, in nanoseconds
+static const uint64_t BenchmarkDuration = (250 * 1000 * 1000ULL);
+static const uint64_t QuickBenchmarkDuration = (10 * 1000 * 1000ULL);
+
+// allocation counts are deterministic, so any growth beyond rounding is a regression
+static const double AllocationTolerance = 0.5;
+
+static const double DefaultTolerance = 0.25;
+
+// ctest reports a test that exits with this status as skipped rather than passed
+// (see SKIP_RETURN_CODE in CMakeLists.txt)
+static const int SkippedExitStatus = 77;
+
+// the key of the peak RSS line in baseline files
+static NSString * const PeakResidentSizeKey = @"peak-rss-kib";
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSArray<BenchmarkWorkload *> *StandardWorkloads(void);
+static uint64_t MonotonicNanoseconds(void);
+static uint64_t PeakResidentKibibytes(void);
+static Measurement Measure(NSUInteger tokensPerIteration, uint64_t duration, void (^block)(void));
+static const char *_Nonnull *_Nonnull CopyArgv(NSArray<NSString *> *argumentVector);
+static void FreeArgv(const char *_Nonnull *_Nonnull argv, NSUInteger argc);
+
+static NSDictionary<NSString *, NSArray<NSNumber *> *> *_Nullable ReadBaseline(NSString *path, NSError **outError);
+static BOOL WriteBaseline(NSString *path, NSDictionary<NSString *, NSArray<NSNumber *> *> *results, NSError **outError);
+static NSUInteger CompareWithBaseline(NSDictionary<NSString *, NSArray<NSNumber *> *> *results, NSDictionary<NSString *, NSArray<NSNumber *> *> *baseline, double tolerance);
+
+static NSArray<NSString *> *SwitchTokens(void);
+static uint64_t SwitchParseAllocations(NSUInteger repetitions, BOOL argvBacked);
+static NSUInteger CheckSwitchAllocationBudgets(void);
+static NSArray<NSArray<NSString *> *> *ResetLines(void);
+static uint64_t ResetParseAllocations(NSUInteger lineCount, BOOL argvBacked);
+static NSUInteger CheckResetAllocationBudgets(void);
+static id ParseOutcome(CLKArgumentParser *parser, CLKArgumentManifest *_Nullable manifest);
+static NSUInteger CheckConcurrentParsing(NSUInteger threadCount, NSUInteger roundCount);
+
+NS_ASSUME_NONNULL_END
+
+#pragma mark -
+#pragma mark Workloads
+
+// one workload varies each dimension away from the first. the last one reads thousands of arguments
+// for recurrent parameter options in no particular order, which is how building the manifest went
+// quadratic once.
+static NSArray<BenchmarkWorkload *> *StandardWorkloads(void)
+{
+    return @[
+        [BenchmarkWorkload workloadWithName:@"typical"      tokenCount:64    optionCount:16  flagSetDensity:0.25 groupCount:2  errorRate:0],
+        [BenchmarkWorkload workloadWithName:@"long-argv"    tokenCount:4096  optionCount:16  flagSetDensity:0.25 groupCount:2  errorRate:0],
+        [BenchmarkWorkload workloadWithName:@"many-options" tokenCount:256   optionCount:512 flagSetDensity:0.25 groupCount:2  errorRate:0],
+        [BenchmarkWorkload workloadWithName:@"flag-sets"    tokenCount:256   optionCount:32  flagSetDensity:0.9  groupCount:0  errorRate:0],
+        [BenchmarkWorkload workloadWithName:@"many-groups"  tokenCount:256   optionCount:256 flagSetDensity:0.25 groupCount:96 errorRate:0],
+        [BenchmarkWorkload workloadWithName:@"error-heavy"  tokenCount:256   optionCount:32  flagSetDensity:0.25 groupCount:4  errorRate:0.2],
+        [BenchmarkWorkload workloadWithName:@"interleaved"  tokenCount:32768 optionCount:256 flagSetDensity:0    groupCount:0  errorRate:0]
+    ];
+}
+
+#pragma mark -
+#pragma mark Measurement
+
+static uint64_t MonotonicNanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec);
+}
+
+static uint64_t PeakResidentKibibytes(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return ((uint64_t)usage.ru_maxrss / 1024); // bytes
+#else
+    return (uint64_t)usage.ru_maxrss; // kibibytes
+#endif
+}
+
+static Measurement Measure(NSUInteger tokensPerIteration, uint64_t duration, void (^block)(void))
+{
+    // the first run pays for class initialization and lazily built caches
+    @autoreleasepool {
+        block();
+    }
+    
+    NSUInteger iterations = 0;
+    uint64_t allocationsBefore = AllocationCount();
+    uint64_t start = MonotonicNanoseconds();
+    uint64_t elapsed;
+    do {
+        @autoreleasepool {
+            block();
+        }
+        
+        iterations++;
+        elapsed = (MonotonicNanoseconds() - start);
+    } while (elapsed < duration);
+    
+    uint64_t allocations = (AllocationCount() - allocationsBefore);
+    
+    Measurement measurement = {
+        .nanosecondsPerToken = ((double)elapsed / (double)(iterations * MAX(tokensPerIteration, 1UL))),
+        .allocationsPerIteration = (AllocationCounterIsAvailable() ? ((double)allocations / (double)iterations) : -1)
+    };
+    
+    return measurement;
+}
+
+// the strings are copied so that the vector outlives the autorelease pools of a benchmark
+static const char **CopyArgv(NSArray<NSString *> *argumentVector)
+{
+    const char **argv = calloc((argumentVector.count + 1), sizeof(char *));
+    for (NSUInteger i = 0 ; i < argumentVector.count ; i++) {
+        argv[i] = strdup(argumentVector[i].UTF8String);
+    }
+    
+    return argv;
+}
+
+static void FreeArgv(const char **argv, NSUInteger argc)
+{
+    for (NSUInteger i = 0 ; i < argc ; i++) {
+        free((void *)argv[i]);
+    }
+    
+    free(argv);
+}
+
+#pragma mark -
+#pragma mark Baselines
+
+// a baseline is a text file with one result per line:
+//
+//     <benchmark>/<workload> <ns/token> <allocations/iteration>
+//     peak-rss-kib <KiB>
+//
+// blank lines and lines starting with `#` are ignored.
+static NSDictionary<NSString *, NSArray<NSNumber *> *> *ReadBaseline(NSString *path, NSError **outError)
+{
+    NSString *contents = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:outError];
+    if (contents == nil) {
+        return nil;
+    }
+    
+    NSMutableDictionary<NSString *, NSArray<NSNumber *> *> *baseline = [NSMutableDictionary dictionary];
+    NSCharacterSet *whitespace = [NSCharacterSet whitespaceCharacterSet];
+    for (NSString *line in [contents componentsSeparatedByCharactersInSet:[NSCharacterSet newlineCharacterSet]]) {
+        NSString *trimmedLine = [line stringByTrimmingCharactersInSet:whitespace];
+        if (trimmedLine.length == 0 || [trimmedLine hasPrefix:@"#"]) {
+            continue;
+        }
+        
+        NSArray<NSString *> *fields = [[trimmedLine componentsSeparatedByCharactersInSet:whitespace] filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"length > 0"]];
+        if (fields.count < 2) {
+            continue;
+        }
+        
+        NSMutableArray<NSNumber *> *values = [NSMutableArray array];
+        for (NSUInteger i = 1 ; i < fields.count ; i++) {
+            [values addObject:@(fields[i].doubleValue)];
+        }
+        
+        baseline[fields[0]] = values;
+    }
+    
+    return baseline;
+}
+
+static BOOL WriteBaseline(NSString *path, NSDictionary<NSString *, NSArray<NSNumber *> *> *results, NSError **outError)
+{
+    NSMutableString *contents = [NSMutableString stringWithString:@"# clkbench baseline: <benchmark>/<workload> <ns/token> <allocations/iteration>\n"];
+    for (NSString *key in [results.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        NSArray<NSNumber *> *values = results[key];
+        if ([key isEqualToString:PeakResidentSizeKey]) {
+            [contents appendFormat:@"%@ %llu\n", key, values[0].unsignedLongLongValue];
+        } else {
+            [contents appendFormat:@"%@ %.2f %.1f\n", key, values[0].doubleValue, values[1].doubleValue];
+        }
+    }
+    
+    return [contents writeToFile:path atomically:YES encoding:NSUTF8StringEncoding error:outError];
+}
+
+// answers the number of regressions, having described each of them on stderr
+static NSUInteger CompareWithBaseline(NSDictionary<NSString *, NSArray<NSNumber *> *> *results, NSDictionary<NSString *, NSArray<NSNumber *> *> *baseline, double tolerance)
+{
+    NSUInteger regressions = 0;
+    
+    for (NSString *key in [results.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        NSArray<NSNumber *> *current = results[key];
+        NSArray<NSNumber *> *expected = baseline[key];
+        if (expected == nil) {
+            fprintf(stderr, "note: %s has no baseline\n", key.UTF8String);
+            continue;
+        }
+        
+        // ns/token or KiB, which vary from run to run
+        double currentValue = current[0].doubleValue;
+        double expectedValue = expected[0].doubleValue;
+        if (currentValue > (expectedValue * (1 + tolerance))) {
+            fprintf(stderr, "REGRESSION: %s: %.2f vs. %.2f baseline (+%.0f%%)\n", key.UTF8String, currentValue, expectedValue, (((currentValue / expectedValue) - 1) * 100));
+            regressions++;
+        }
+        
+        if (current.count < 2 || expected.count < 2) {
+            continue;
+        }
+        
+        double currentAllocations = current[1].doubleValue;
+        double expectedAllocations = expected[1].doubleValue;
+        if (currentAllocations >= 0 && expectedAllocations >= 0 && currentAllocations > (expectedAllocations + AllocationTolerance)) {
+            fprintf(stderr, "REGRESSION: %s: %.1f allocations per iteration vs. %.1f baseline\n", key.UTF8String, currentAllocations, expectedAllocations);
+            regressions++;
+        }
+    }
+    
+    return regressions;
+}
+
+#pragma mark -
+#pragma mark Allocation Budgets
+
+// one repetition of the switch tokens the budget covers: a flag, a name and two flag sets
+static NSArray<NSString *> *SwitchTokens(void)
+{
+    return @[ @"-v", @"--quiet", @"-vq", @"-qvvq" ];
+}
+
+// the allocations made parsing `repetitions` repetitions of the switch tokens after a single assignment
+static uint64_t SwitchParseAllocations(NSUInteger repetitions, BOOL argvBacked)
+{
+    NSArray<CLKOption *> *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption optionWithName:@"quiet" flag:@"q"],
+        [CLKOption parameterOptionWithName:@"file" flag:@"f"]
+    ];
+    
+    CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:options optionGroups:nil];
+    NSMutableArray<NSString *> *argumentVector = [NSMutableArray arrayWithObject:@"--file=alpha"];
+    for (NSUInteger i = 0 ; i < repetitions ; i++) {
+        [argumentVector addObjectsFromArray:SwitchTokens()];
+    }
+    
+    const char **cargv = CopyArgv(argumentVector);
+    uint64_t allocations;
+    @autoreleasepool {
+        CLKArgumentParser *parser;
+        if (argvBacked) {
+            parser = [CLKArgumentParser parserWithArgv:cargv argc:(int)argumentVector.count schema:schema];
+        } else {
+            parser = [CLKArgumentParser parserWithArgumentVector:argumentVector schema:schema];
+        }
+        
+        uint64_t start = AllocationCount();
+        CLKArgumentManifest *manifest = [parser parseArguments];
+        allocations = (AllocationCount() - start);
+        if (manifest == nil) {
+            fprintf(stderr, "clkbench: switch tokens failed to parse: %s\n", parser.errors.description.UTF8String);
+            abort();
+        }
+    }
+    
+    FreeArgv(cargv, argumentVector.count);
+    return allocations;
+}
+
+// switch tokens, and the flags of flag sets, must not allocate: parsing twice as many of them
+// allocates exactly as much. answers the number of vectors that went over budget.
+static NSUInteger CheckSwitchAllocationBudgets(void)
+{
+    static const NSUInteger repetitions = 64;
+    NSUInteger violations = 0;
+    for (int argvBacked = 1 ; argvBacked >= 0 ; argvBacked--) {
+        // warm up caches (e.g., the runtime's method caches) outside the measurement
+        (void)SwitchParseAllocations(repetitions, argvBacked);
+        
+        uint64_t single = SwitchParseAllocations(repetitions, argvBacked);
+        uint64_t doubled = SwitchParseAllocations((repetitions * 2), argvBacked);
+        NSUInteger tokenCount = (repetitions * SwitchTokens().count);
+        double allocationsPerToken = ((double)((int64_t)doubled - (int64_t)single) / (double)tokenCount);
+        const char *vector = (argvBacked ? "argv" : "array");
+        fprintf(stdout, "%-10s %-14s %14.2f allocs/token\n", "switches", vector, allocationsPerToken);
+        if (doubled != single) {
+            fprintf(stderr, "REGRESSION: switches/%s: %.2f allocations per switch token (budget 0)\n", vector, allocationsPerToken);
+            violations++;
+        }
+    }
+    
+    return violations;
+}
+
+// two prompt lines for the reset budget, read alternately by one parser
+static NSArray<NSArray<NSString *> *> *ResetLines(void)
+{
+    return @[
+        @[ @"-v", @"--file", @"alpha", @"bravo" ],
+        @[ @"-qvvq", @"--file=charlie", @"--", @"delta", @"echo" ]
+    ];
+}
+
+// the allocations made resetting one parser for, and parsing, `lineCount` lines after warming it up
+static uint64_t ResetParseAllocations(NSUInteger lineCount, BOOL argvBacked)
+{
+    NSArray<CLKOption *> *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption optionWithName:@"quiet" flag:@"q"],
+        [CLKOption parameterOptionWithName:@"file" flag:@"f"]
+    ];
+    
+    CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:options optionGroups:nil];
+    NSArray<NSArray<NSString *> *> *lines = ResetLines();
+    const char **cargvs[2] = { CopyArgv(lines[0]), CopyArgv(lines[1]) };
+    
+    uint64_t allocations = 0;
+    @autoreleasepool {
+        CLKArgumentParser *parser;
+        if (argvBacked) {
+            parser = [CLKArgumentParser parserWithArgv:cargvs[0] argc:(int)lines[0].count schema:schema];
+        } else {
+            parser = [CLKArgumentParser parserWithArgumentVector:lines[0] schema:schema];
+        }
+        
+        // the first few lines grow the parser's storage to fit
+        static const NSUInteger warmUpLineCount = 8;
+        for (NSUInteger i = 0 ; i < (warmUpLineCount + lineCount) ; i++) {
+            NSArray<NSString *> *line = lines[i % 2];
+            uint64_t start = AllocationCount();
+            @autoreleasepool {
+                if (argvBacked) {
+                    [parser resetWithArgv:cargvs[i % 2] argc:(int)line.count];
+                } else {
+                    [parser resetWithArgumentVector:line];
+                }
+                
+                if ([parser parseArguments] == nil) {
+                    fprintf(stderr, "clkbench: reset line failed to parse: %s\n", parser.errors.description.UTF8String);
+                    abort();
+                }
+            }
+            
+            if (i >= warmUpLineCount) {
+                allocations += (AllocationCount() - start);
+            }
+        }
+    }
+    
+    FreeArgv(cargvs[0], lines[0].count);
+    FreeArgv(cargvs[1], lines[1].count);
+    return allocations;
+}
+
+// a reused parser allocates nothing for a line backed by an array once it has warmed up. a line
+// backed by argv may only allocate the strings for the arguments the parse reads, at most one per
+// token. answers the number of vectors that went over budget.
+static NSUInteger CheckResetAllocationBudgets(void)
+{
+    static const NSUInteger lineCount = 256;
+    NSArray<NSArray<NSString *> *> *lines = ResetLines();
+    double tokensPerLine = ((double)(lines[0].count + lines[1].count) / 2.0);
+    
+    NSUInteger violations = 0;
+    for (int argvBacked = 1 ; argvBacked >= 0 ; argvBacked--) {
+        uint64_t allocations = ResetParseAllocations(lineCount, argvBacked);
+        double allocationsPerLine = ((double)allocations / (double)lineCount);
+        double budget = (argvBacked ? tokensPerLine : 0.0);
+        const char *vector = (argvBacked ? "argv" : "array");
+        fprintf(stdout, "%-10s %-14s %14.2f allocs/line\n", "reset", vector, allocationsPerLine);
+        if (allocationsPerLine > budget) {
+            fprintf(stderr, "REGRESSION: reset/%s: %.2f allocations per reset and parse (budget %.2f)\n", vector, allocationsPerLine, budget);
+            violations++;
+        }
+    }
+    
+    return violations;
+}
+
+#pragma mark -
+#pragma mark Concurrent Parsing
+
+// what a parse produced, comparable across parsers: the accumulated options and positional arguments
+// of its manifest, or the descriptions of its errors. read before the parser is reset.
+static id ParseOutcome(CLKArgumentParser *parser, CLKArgumentManifest *manifest)
+{
+    if (manifest == nil) {
+        return [parser.errors valueForKey:@"localizedDescription"];
+    }
+    
+    return @[ manifest.dictionaryRepresentationForAccumulatedOptions, manifest.positionalArguments ];
+}
+
+// `threadCount` threads parse every standard workload `roundCount` times against schemas they all
+// share: with a new parser for an array, a new parser for argv, and a parser of their own that is reset
+// for each round. each thread starts at a different workload so that parses of the same schema overlap.
+// build with CLK_THREAD_SANITIZER to have races reported. answers the number of parses whose outcome
+// differs from a parse of the same workload on the main thread.
+static NSUInteger CheckConcurrentParsing(NSUInteger threadCount, NSUInteger roundCount)
+{
+    NSArray<BenchmarkWorkload *> *workloads = StandardWorkloads();
+    NSUInteger workloadCount = workloads.count;
+    NSMutableArray<CLKOptionSchema *> *schemas = [NSMutableArray arrayWithCapacity:workloadCount];
+    NSMutableArray *expectedOutcomes = [NSMutableArray arrayWithCapacity:workloadCount];
+    const char ***cargvs = calloc(workloadCount, sizeof(const char **));
+    
+    for (NSUInteger i = 0 ; i < workloadCount ; i++) {
+        BenchmarkWorkload *workload = workloads[i];
+        CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:workload.options optionGroups:workload.optionGroups];
+        CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:workload.argumentVector schema:schema];
+        [schemas addObject:schema];
+        [expectedOutcomes addObject:ParseOutcome(parser, [parser parseArguments])];
+        cargvs[i] = CopyArgv(workload.argumentVector);
+    }
+    
+    __block _Atomic NSUInteger mismatches = 0;
+    dispatch_group_t group = dispatch_group_create();
+    for (NSUInteger t = 0 ; t < threadCount ; t++) {
+        dispatch_group_enter(group);
+        [NSThread detachNewThreadWithBlock:^{
+            // filled in on the first round
+            NSMutableArray *resetParsers = [NSMutableArray arrayWithCapacity:workloadCount];
+            for (NSUInteger i = 0 ; i < workloadCount ; i++) {
+                [resetParsers addObject:NSNull.null];
+            }
+            
+            for (NSUInteger round = 0 ; round < roundCount ; round++) {
+                for (NSUInteger j = 0 ; j < workloadCount ; j++) {
+                    NSUInteger w = ((t + j) % workloadCount);
+                    NSArray<NSString *> *argumentVector = workloads[w].argumentVector;
+                    CLKOptionSchema *schema = schemas[w];
+                    @autoreleasepool {
+                        CLKArgumentParser *parsers[3];
+                        parsers[0] = [CLKArgumentParser parserWithArgumentVector:argumentVector schema:schema];
+                        parsers[1] = [CLKArgumentParser parserWithArgv:cargvs[w] argc:(int)argumentVector.count schema:schema];
+                        if (round == 0) {
+                            parsers[2] = [CLKArgumentParser parserWithArgumentVector:argumentVector schema:schema];
+                            resetParsers[w] = parsers[2];
+                        } else {
+                            parsers[2] = resetParsers[w];
+                            [parsers[2] resetWithArgv:cargvs[w] argc:(int)argumentVector.count];
+                        }
+                        
+                        for (int p = 0 ; p < 3 ; p++) {
+                            if (![ParseOutcome(parsers[p], [parsers[p] parseArguments]) isEqual:expectedOutcomes[w]]) {
+                                atomic_fetch_add_explicit(&mismatches, 1, memory_order_relaxed);
+                            }
+                        }
+                    }
+                }
+            }
+            
+            dispatch_group_leave(group);
+        }];
+    }
+    
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    
+    for (NSUInteger i = 0 ; i < workloadCount ; i++) {
+        FreeArgv(cargvs[i], workloads[i].argumentVector.count);
+    }
+    
+    free(cargvs);
+    
+    NSUInteger parseCount = (threadCount * roundCount * workloadCount * 3);
+    fprintf(stdout, "%-10s %lu threads, %lu parses, %lu mismatched\n", "concurrent", (unsigned long)threadCount, (unsigned long)parseCount, (unsigned long)mismatches);
+    if (mismatches > 0) {
+        fprintf(stderr, "REGRESSION: concurrent: %lu of %lu parses against shared schemas differ from a serial parse\n", (unsigned long)mismatches, (unsigned long)parseCount);
+    }
+    
+    return mismatches;
+}
+
+#pragma mark -
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool {
+        // parses profiled through CLK_PARSE_PROFILE report their allocations too
+        if (AllocationCounterIsAvailable()) {
+            CLKParseProfileSetAllocationCounter(AllocationCount);
+        }
+        
+        NSArray<CLKOption *> *options = @[
+            [CLKOption parameterOptionWithName:@"baseline" flag:@"b"],
+            [CLKOption parameterOptionWithName:@"write-baseline" flag:@"w"],
+            [CLKOption parameterOptionWithName:@"tolerance" flag:@"t" required:NO recurrent:NO transformer:[CLKFloatArgumentTransformer new]],
+            [CLKOption optionWithName:@"quick" flag:@"q"],
+            [CLKOption optionWithName:@"allocation-budgets" flag:nil],
+            [CLKOption optionWithName:@"reset-allocation-budgets" flag:nil],
+            [CLKOption parameterOptionWithName:@"concurrent-parsing" flag:nil required:NO recurrent:NO transformer:[CLKUInt64ArgumentTransformer new]]
+        ];
+        
+        CLKArgumentParser *parser = [CLKArgumentParser parserWithArgv:(argv + 1) argc:(argc - 1) options:options];
+        CLKArgumentManifest *manifest = [parser parseArguments];
+        if (manifest == nil) {
+            for (NSError *error in parser.errors) {
+                fprintf(stderr, "clkbench: %s\n", error.localizedDescription.UTF8String);
+            }
+            
+            fprintf(stderr, "usage: clkbench [--quick] [--allocation-budgets] [--reset-allocation-budgets] [--concurrent-parsing <threads>] [--baseline <file> [--tolerance <fraction>]] [--write-baseline <file>]\n");
+            return EX_USAGE;
+        }
+        
+        // each budget is its own test, so that one being skipped or failing doesn't hide the other
+        BOOL switchBudgets = (manifest[@"allocation-budgets"] != nil);
+        BOOL resetBudgets = (manifest[@"reset-allocation-budgets"] != nil);
+        if (switchBudgets || resetBudgets) {
+            if (!AllocationCounterIsAvailable()) {
+                fprintf(stderr, "clkbench: allocations can't be counted on this platform; skipping allocation budgets\n");
+                return SkippedExitStatus;
+            }
+            
+            NSUInteger violations = ((switchBudgets ? CheckSwitchAllocationBudgets() : 0) + (resetBudgets ? CheckResetAllocationBudgets() : 0));
+            return (violations > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+        }
+        
+        NSNumber *threadCount = manifest[@"concurrent-parsing"];
+        if (threadCount != nil) {
+            if (threadCount.unsignedIntegerValue == 0) {
+                fprintf(stderr, "clkbench: --concurrent-parsing needs at least one thread\n");
+                return EX_USAGE;
+            }
+            
+            static const NSUInteger roundCount = 20;
+            NSUInteger mismatches = CheckConcurrentParsing(threadCount.unsignedIntegerValue, roundCount);
+            return (mismatches > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+        }
+        
+        NSString *baselinePath = manifest[@"baseline"];
+        NSString *outputPath = manifest[@"write-baseline"];
+        NSNumber *toleranceArgument = manifest[@"tolerance"];
+        double tolerance = (toleranceArgument != nil ? toleranceArgument.doubleValue : DefaultTolerance);
+        uint64_t duration = (manifest[@"quick"] != nil ? QuickBenchmarkDuration : BenchmarkDuration);
+        
+        // read before measuring anything so that a bad path fails fast
+        NSDictionary<NSString *, NSArray<NSNumber *> *> *baseline = nil;
+        if (baselinePath != nil) {
+            // no baseline is committed until one is recorded on the reference machine
+            if (![[NSFileManager defaultManager] fileExistsAtPath:baselinePath]) {
+                fprintf(stderr, "clkbench: %s: no baseline recorded (see --write-baseline); skipping the regression check\n", baselinePath.UTF8String);
+                return SkippedExitStatus;
+            }
+            
+            NSError *error;
+            baseline = ReadBaseline(baselinePath, &error);
+            if (baseline == nil) {
+                fprintf(stderr, "clkbench: %s: %s\n", baselinePath.UTF8String, error.localizedDescription.UTF8String);
+                return EX_NOINPUT;
+            }
+        }
+        
+        NSMutableDictionary<NSString *, NSArray<NSNumber *> *> *results = [NSMutableDictionary dictionary];
+        __block volatile NSUInteger sink = 0;
+        
+        fprintf(stdout, "%-10s %-14s %12s %14s %12s\n", "benchmark", "workload", "ns/token", "allocs/iter", "peak KiB");
+        
+        for (BenchmarkWorkload *workload in StandardWorkloads()) {
+            NSArray<NSString *> *argumentVector = workload.argumentVector;
+            NSUInteger tokenCount = argumentVector.count;
+            CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:workload.options optionGroups:workload.optionGroups];
+            const char **cargv = CopyArgv(argumentVector);
+            
+            // the depot's argument vector leads with the verb name
+            NSMutableArray<id<CLKVerb>> *verbs = [NSMutableArray array];
+            for (NSUInteger i = 0 ; i < 8 ; i++) {
+                NSString *name = [NSString stringWithFormat:@"verb-%lu", (unsigned long)i];
+                [verbs addObject:[BenchmarkVerb verbWithName:name options:workload.options optionGroups:workload.optionGroups]];
+            }
+            
+            const char **depotArgv = CopyArgv([@[ @"verb-5" ] arrayByAddingObjectsFromArray:argumentVector]);
+            
+            // the manifest a successful parse of the workload would produce, without the parse
+            CLKArgumentManifest *validatedManifest = [[CLKArgumentManifest alloc] initWithOptionRegistry:schema.optionRegistry];
+            [workload enumerateSuppliedOptionsUsingBlock:^(CLKOption *option, NSString *argument) {
+                if (argument == nil) {
+                    [validatedManifest accumulateSwitchOptionNamed:option.name];
+                } else {
+                    [validatedManifest accumulateArgument:argument forParameterOptionNamed:option.name];
+                }
+            }];
+            
+            NSArray<NSString *> *benchmarks = @[ @"tokenize", @"parse", @"validate", @"dispatch" ];
+            for (NSString *benchmark in benchmarks) {
+                Measurement measurement;
+                if ([benchmark isEqualToString:@"tokenize"]) {
+                    measurement = Measure(tokenCount, duration, ^{
+                        for (NSString *token in argumentVector) {
+                            sink += CLKTokenFormForToken(token);
+                        }
+                    });
+                } else if ([benchmark isEqualToString:@"parse"]) {
+                    measurement = Measure(tokenCount, duration, ^{
+                        CLKArgumentParser *workloadParser = [CLKArgumentParser parserWithArgv:cargv argc:(int)tokenCount schema:schema];
+                        sink += ([workloadParser parseArguments] != nil);
+                    });
+                } else if ([benchmark isEqualToString:@"validate"]) {
+                    measurement = Measure(tokenCount, duration, ^{
+                        CLKArgumentManifestValidator *validator = [[CLKArgumentManifestValidator alloc] initWithManifest:validatedManifest];
+                        [validator validateConstraintProgram:schema.constraintProgram issueHandler:^(__unused CLKArgumentIssue *issue) {
+                            sink++;
+                        }];
+                    });
+                } else {
+                    measurement = Measure((tokenCount + 1), duration, ^{
+                        CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgv:depotArgv argc:(int)(tokenCount + 1) verbs:verbs];
+                        sink += (NSUInteger)[depot dispatchVerb].exitStatus;
+                    });
+                }
+                
+                NSString *key = [NSString stringWithFormat:@"%@/%@", benchmark, workload.name];
+                results[key] = @[ @(measurement.nanosecondsPerToken), @(measurement.allocationsPerIteration) ];
+                
+                char allocations[32] = "n/a";
+                if (measurement.allocationsPerIteration >= 0) {
+                    snprintf(allocations, sizeof(allocations), "%.1f", measurement.allocationsPerIteration);
+                }
+                
+                fprintf(stdout, "%-10s %-14s %12.2f %14s %12llu\n", benchmark.UTF8String, workload.name.UTF8String, measurement.nanosecondsPerToken, allocations, PeakResidentKibibytes());
+                fflush(stdout);
+            }
+            
+            FreeArgv(cargv, tokenCount);
+            FreeArgv(depotArgv, (tokenCount + 1));
+        }
+        
+        results[PeakResidentSizeKey] = @[ @(PeakResidentKibibytes()) ];
+        
+        if (outputPath != nil) {
+            NSError *error;
+            if (!WriteBaseline(outputPath, results, &error)) {
+                fprintf(stderr, "clkbench: %s: %s\n", outputPath.UTF8String, error.localizedDescription.UTF8String);
+                return EX_CANTCREAT;
+            }
+        }
+        
+        if (baseline != nil) {
+            NSUInteger regressions = CompareWithBaseline(results, baseline, tolerance);
+            if (regressions > 0) {
+                fprintf(stderr, "clkbench: %lu regression(s) against %s\n", (unsigned long)regressions, baselinePath.UTF8String);
+                return EXIT_FAILURE;
+            }
+        }
+        
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,39 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class CLKOption;
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(uint32_t, CLKArgumentEventType) {
+    // a switch option occurred. `option` is set.
+    CLKArgumentEventTypeSwitchOption = 0,
+    
+    // a parameter option occurred with an argument. `option` is set and `value` is the
+    // argument, after the option's transformer (if any) has been applied.
+    CLKArgumentEventTypeParameterOption = 1,
+    
+    // `value` is the positional argument
+    CLKArgumentEventTypePositionalArgument = 2,
+    
+    // a parsing error or a violated constraint. `error` is set.
+    CLKArgumentEventTypeIssue = 3
+};
+
+// one step of a parse, as delivered by -[CLKArgumentParser nextEvent]
+@interface CLKArgumentEvent : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (readonly) CLKArgumentEventType type;
+@property (nullable, readonly) CLKOption *option;
+@property (nullable, readonly) id value;
+@property (nullable, readonly) NSError *error;
+
+@end
+
+NS_ASSUME_NONNULL_END
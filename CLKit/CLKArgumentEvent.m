@@ -0,0 +1,67 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKArgumentEvent_Private.h"
+
+#import "CLKAssert.h"
+#import "CLKOption.h"
+
+@implementation CLKArgumentEvent
+{
+    CLKArgumentEventType _type;
+    CLKOption *_option;
+    id _value;
+    NSError *_error;
+}
+
+@synthesize type = _type;
+@synthesize option = _option;
+@synthesize value = _value;
+@synthesize error = _error;
+
++ (instancetype)switchOptionEventWithOption:(CLKOption *)option
+{
+    CLKParameterAssert(option.type == CLKOptionTypeSwitch);
+    return [[self alloc] _initWithType:CLKArgumentEventTypeSwitchOption option:option value:nil error:nil];
+}
+
++ (instancetype)parameterOptionEventWithOption:(CLKOption *)option argument:(id)argument
+{
+    CLKParameterAssert(option.type == CLKOptionTypeParameter);
+    CLKParameterAssert(argument != nil);
+    return [[self alloc] _initWithType:CLKArgumentEventTypeParameterOption option:option value:argument error:nil];
+}
+
++ (instancetype)positionalArgumentEventWithArgument:(NSString *)argument
+{
+    CLKParameterAssert(argument != nil);
+    return [[self alloc] _initWithType:CLKArgumentEventTypePositionalArgument option:nil value:argument error:nil];
+}
+
++ (instancetype)issueEventWithError:(NSError *)error
+{
+    CLKParameterAssert(error != nil);
+    return [[self alloc] _initWithType:CLKArgumentEventTypeIssue option:nil value:nil error:error];
+}
+
+- (instancetype)_initWithType:(CLKArgumentEventType)type option:(CLKOption *)option value:(id)value error:(NSError *)error
+{
+    self = [super init];
+    if (self != nil) {
+        _type = type;
+        _option = option;
+        _value = value;
+        _error = error;
+    }
+    
+    return self;
+}
+
+- (NSString *)debugDescription
+{
+    NSString *fmt = @"%@ { type: %u | option: %@ | value: %@ | error: %@ }";
+    return [NSString stringWithFormat:fmt, super.debugDescription, _type, _option.name, _value, _error.localizedDescription];
+}
+
+@end
@@ -0,0 +1,23 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKArgumentEvent.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKArgumentEvent ()
+
++ (instancetype)switchOptionEventWithOption:(CLKOption *)option;
++ (instancetype)parameterOptionEventWithOption:(CLKOption *)option argument:(id)argument;
++ (instancetype)positionalArgumentEventWithArgument:(NSString *)argument;
++ (instancetype)issueEventWithError:(NSError *)error;
+
+- (instancetype)_initWithType:(CLKArgumentEventType)type
+                       option:(nullable CLKOption *)option
+                        value:(nullable id)value
+                        error:(nullable NSError *)error NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
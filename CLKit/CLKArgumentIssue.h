@@ -4,6 +4,8 @@
 
 #import <Foundation/Foundation.h>
 
+#import "CLKError.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface CLKArgumentIssue : NSObject
@@ -15,8 +17,38 @@ NS_ASSUME_NONNULL_BEGIN
 + (instancetype)issueWithError:(NSError *)error salientOption:(nullable NSString *)option;
 + (instancetype)issueWithError:(NSError *)error salientOptions:(nullable NSArray<NSString *> *)options;
 
+// issues whose errors are built when `error` is first read. until then an issue is its domain, code
+// and salient options plus a constant format and up to two arguments, so a parse that only needs to
+// know whether it failed, and why, never formats a description. an argument that is an array of
+// option names is written as a list (`flarn --barf`) to follow a leading `--` in the format.
++ (instancetype)issueWithPOSIXErrorCode:(int)code salientOption:(nullable NSString *)option description:(NSString *)format argument:(nullable NSString *)argument;
++ (instancetype)issueWithCLKErrorCode:(CLKError)code
+                       salientOptions:(nullable NSArray<NSString *> *)options
+                          description:(NSString *)format
+                             argument:(nullable id)argument0
+                             argument:(nullable id)argument1;
+
+// an issue for something the user probably misspelled. when there are `suggestions`, the description
+// ends by offering them (`; did you mean '--verbose'?`) and the error's user info carries them under
+// CLKSuggestionsErrorKey.
++ (instancetype)issueWithPOSIXErrorCode:(int)code
+                            description:(NSString *)format
+                               argument:(nullable NSString *)argument
+                            suggestions:(nullable NSArray<NSString *> *)suggestions;
+
+// as above, for suggestions that were cut short: the offer ends by counting the ones left out
+// (`; did you mean '--valet', '--verbose', '--version' …and 2 more?`).
++ (instancetype)issueWithPOSIXErrorCode:(int)code
+                            description:(NSString *)format
+                               argument:(nullable NSString *)argument
+                            suggestions:(NSArray<NSString *> *)suggestions
+                 omittedSuggestionCount:(NSUInteger)omittedSuggestionCount;
+
+@property (readonly) NSString *domain;
+@property (readonly) NSInteger code;
 @property (readonly) NSError *error;
 @property (nullable, readonly) NSArray<NSString *> *salientOptions;
+@property (nullable, readonly) NSArray<NSString *> *suggestions;
 @property (readonly) BOOL isValidationIssue;
 
 - (BOOL)isEqualToIssue:(CLKArgumentIssue *)issue;
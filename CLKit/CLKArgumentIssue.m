@@ -5,12 +5,22 @@
 #import "CLKArgumentIssue.h"
 
 #import "CLKError.h"
+#import "CLKSuggestionIndex.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 @interface CLKArgumentIssue ()
 
-- (instancetype)_initWithError:(NSError *)error salientOptions:(nullable NSArray<NSString *> *)options NS_DESIGNATED_INITIALIZER;
+- (instancetype)_initWithError:(NSError *)error salientOptions:(nullable NSArray<NSString *> *)options;
+
+- (instancetype)_initWithDomain:(NSString *)domain
+                           code:(NSInteger)code
+                 salientOptions:(nullable NSArray<NSString *> *)options
+                         format:(nullable NSString *)format
+                      argument0:(nullable id)argument0
+                      argument1:(nullable id)argument1 NS_DESIGNATED_INITIALIZER;
+
+- (NSString *)_formattedDescription;
 
 @end
 
@@ -18,12 +28,24 @@ NS_ASSUME_NONNULL_END
 
 @implementation CLKArgumentIssue
 {
-    NSError *_error;
+    NSString *_domain;
+    NSInteger _code;
     NSArray<NSString *> *_salientOptions;
+    
+    // the description, until the error is built
+    NSString *_format;
+    id _argument0;
+    id _argument1;
+    
+    NSArray<NSString *> *_suggestions;
+    NSUInteger _omittedSuggestionCount;
+    NSError *_error;
 }
 
-@synthesize error = _error;
+@synthesize domain = _domain;
+@synthesize code = _code;
 @synthesize salientOptions = _salientOptions;
+@synthesize suggestions = _suggestions;
 
 + (instancetype)issueWithError:(NSError *)error
 {
@@ -40,12 +62,54 @@ NS_ASSUME_NONNULL_END
     return [[self alloc] _initWithError:error salientOptions:options];
 }
 
++ (instancetype)issueWithPOSIXErrorCode:(int)code salientOption:(NSString *)option description:(NSString *)format argument:(NSString *)argument
+{
+    NSArray *options = (option != nil ? @[ option ] : nil);
+    return [[self alloc] _initWithDomain:NSPOSIXErrorDomain code:code salientOptions:options format:format argument0:argument argument1:nil];
+}
+
++ (instancetype)issueWithCLKErrorCode:(CLKError)code salientOptions:(NSArray<NSString *> *)options description:(NSString *)format argument:(id)argument0 argument:(id)argument1
+{
+    return [[self alloc] _initWithDomain:CLKErrorDomain code:code salientOptions:options format:format argument0:argument0 argument1:argument1];
+}
+
++ (instancetype)issueWithPOSIXErrorCode:(int)code description:(NSString *)format argument:(NSString *)argument suggestions:(NSArray<NSString *> *)suggestions
+{
+    CLKArgumentIssue *issue = [[self alloc] _initWithDomain:NSPOSIXErrorDomain code:code salientOptions:nil format:format argument0:argument argument1:nil];
+    issue->_suggestions = (suggestions.count > 0 ? [suggestions copy] : nil);
+    return issue;
+}
+
++ (instancetype)issueWithPOSIXErrorCode:(int)code description:(NSString *)format argument:(NSString *)argument suggestions:(NSArray<NSString *> *)suggestions omittedSuggestionCount:(NSUInteger)omittedSuggestionCount
+{
+    NSParameterAssert(suggestions.count > 0 || omittedSuggestionCount == 0);
+    
+    CLKArgumentIssue *issue = [self issueWithPOSIXErrorCode:code description:format argument:argument suggestions:suggestions];
+    issue->_omittedSuggestionCount = omittedSuggestionCount;
+    return issue;
+}
+
 - (instancetype)_initWithError:(NSError *)error salientOptions:(NSArray<NSString *> *)options
 {
-    self = [super init];
+    self = [self _initWithDomain:error.domain code:error.code salientOptions:options format:nil argument0:nil argument1:nil];
     if (self != nil) {
         _error = error;
+        _suggestions = [error.userInfo[CLKSuggestionsErrorKey] copy];
+    }
+    
+    return self;
+}
+
+- (instancetype)_initWithDomain:(NSString *)domain code:(NSInteger)code salientOptions:(NSArray<NSString *> *)options format:(NSString *)format argument0:(id)argument0 argument1:(id)argument1
+{
+    self = [super init];
+    if (self != nil) {
+        _domain = [domain copy];
+        _code = code;
         _salientOptions = [options copy];
+        _format = [format copy];
+        _argument0 = argument0;
+        _argument1 = argument1;
     }
     
     return self;
@@ -53,7 +117,7 @@ NS_ASSUME_NONNULL_END
 
 - (NSUInteger)hash
 {
-    return (_error.hash ^ _salientOptions.hash);
+    return (_domain.hash ^ (NSUInteger)_code ^ _salientOptions.hash);
 }
 
 - (BOOL)isEqual:(id)obj
@@ -71,7 +135,7 @@ NS_ASSUME_NONNULL_END
 
 - (BOOL)isEqualToIssue:(CLKArgumentIssue *)issue
 {
-    if (![_error isEqual:issue.error]) {
+    if (![self.error isEqual:issue.error]) {
         return NO;
     }
     
@@ -89,18 +153,59 @@ NS_ASSUME_NONNULL_END
 
 - (NSString *)debugDescription
 {
-    return [NSString stringWithFormat:@"%@ {\n    error: %@,\n    salientOptions: [ %@ ]\n}", super.debugDescription, _error.debugDescription, [_salientOptions componentsJoinedByString:@", "]];
+    return [NSString stringWithFormat:@"%@ {\n    error: %@,\n    salientOptions: [ %@ ]\n}", super.debugDescription, self.error.debugDescription, [_salientOptions componentsJoinedByString:@", "]];
+}
+
+- (NSError *)error
+{
+    // issues can be read from several threads (a batch parser's results, for one)
+    @synchronized (self) {
+        if (_error == nil) {
+            NSString *description = [self _formattedDescription];
+            NSDictionary *userInfo;
+            if (_suggestions != nil && _omittedSuggestionCount > 0) {
+                NSString *list = [NSString stringWithFormat:@"'%@'", [_suggestions componentsJoinedByString:@"', '"]];
+                description = [description stringByAppendingFormat:@"; did you mean %@ …and %lu more?", list, (unsigned long)_omittedSuggestionCount];
+                userInfo = @{ NSLocalizedDescriptionKey : description, CLKSuggestionsErrorKey : _suggestions };
+            } else if (_suggestions != nil) {
+                description = [description stringByAppendingFormat:@"; did you mean %@?", CLKSuggestionListDescription(_suggestions)];
+                userInfo = @{ NSLocalizedDescriptionKey : description, CLKSuggestionsErrorKey : _suggestions };
+            } else {
+                userInfo = @{ NSLocalizedDescriptionKey : description };
+            }
+            
+            _error = [NSError errorWithDomain:_domain code:_code userInfo:userInfo];
+            _format = nil;
+            _argument0 = nil;
+            _argument1 = nil;
+        }
+        
+        return _error;
+    }
+}
+
+- (NSString *)_formattedDescription
+{
+    NSAssert((_format != nil), @"formatting an issue without a description");
+    
+    id argument0 = ([_argument0 isKindOfClass:[NSArray class]] ? [_argument0 componentsJoinedByString:@" --"] : _argument0);
+    id argument1 = ([_argument1 isKindOfClass:[NSArray class]] ? [_argument1 componentsJoinedByString:@" --"] : _argument1);
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wformat-nonliteral"
+    return [NSString stringWithFormat:_format, argument0, argument1];
+#pragma clang diagnostic pop
 }
 
 - (BOOL)isValidationIssue
 {
-    if (![_error.domain isEqualToString:CLKErrorDomain]) {
+    if (![_domain isEqualToString:CLKErrorDomain]) {
         return NO;
     }
     
-    return (_error.code == CLKErrorRequiredOptionNotProvided
-            || _error.code == CLKErrorTooManyOccurrencesOfOption
-            || _error.code == CLKErrorMutuallyExclusiveOptionsPresent);
+    return (_code == CLKErrorRequiredOptionNotProvided
+            || _code == CLKErrorTooManyOccurrencesOfOption
+            || _code == CLKErrorMutuallyExclusiveOptionsPresent);
 }
 
 @end
@@ -6,6 +6,16 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+// an option's slot in a manifest's storage.
+//
+// handles are stable for the options a parser was configured with, so a tool can resolve
+// the handles it cares about once and use them to read any number of manifests without
+// hashing option names. resolving an unregistered name yields CLKOptionHandleNone, which
+// reads as absent from every manifest.
+typedef NSUInteger CLKOptionHandle;
+
+extern const CLKOptionHandle CLKOptionHandleNone;
+
 @interface CLKArgumentManifest : NSObject
 
 + (instancetype)new NS_UNAVAILABLE;
@@ -15,6 +25,16 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (readonly) NSArray<NSString *> *positionalArguments;
 
+#pragma mark -
+#pragma mark Typed Access
+
+- (CLKOptionHandle)handleForOptionNamed:(NSString *)optionName;
+
+- (BOOL)hasOption:(CLKOptionHandle)option;
+- (NSUInteger)switchCountForOption:(CLKOptionHandle)option;
+- (NSUInteger)argumentCountForOption:(CLKOptionHandle)option;
+- (id)argumentAtIndex:(NSUInteger)idx forOption:(CLKOptionHandle)option;
+
 @end
 
 NS_ASSUME_NONNULL_END
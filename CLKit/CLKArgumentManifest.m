@@ -5,18 +5,64 @@
 #import "CLKArgumentManifest_Private.h"
 
 #import "CLKAssert.h"
+#import "CLKBitset.h"
 #import "CLKOption_Private.h"
 #import "CLKOptionRegistry.h"
 
+const CLKOptionHandle CLKOptionHandleNone = NSNotFound;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKArgumentManifest ()
+
+- (NSUInteger)_indexOfAccumulatedOptionNamed:(NSString *)optionName;
+- (void)_recordOccurrenceOfOptionAtIndex:(NSUInteger)optionIndex;
+- (NSArray *)_argumentsForOptionAtIndex:(NSUInteger)optionIndex;
+- (void)_groupPendingArgumentsIfNeeded;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
 @implementation CLKArgumentManifest
 {
     CLKOptionRegistry *_optionRegistry;
-    NSMutableDictionary<NSString *, NSNumber *> *_switchOptionOccurrences;
-    NSMutableDictionary<NSString *, NSMutableArray *> *_parameterOptionArguments;
+    NSUInteger _optionCount;
     NSMutableArray<NSString *> *_positionalArguments;
+    
+    // occurrence counts, addressed by option index
+    NSUInteger *_occurrences;
+    
+    // the number of arguments stored for each parameter option. this is the occurrence count
+    // unless occurrences were counted without their arguments, so the slab is only read with it.
+    NSUInteger *_argumentCounts;
+    
+    // arguments for all parameter options share one slab, grouped by option index.
+    // the arguments for option `i` occupy [_argumentOffsets[i], _argumentOffsets[i + 1]).
+    // `_spareSlab` is the slab's storage from before the last grouping, kept for the next one.
+    NSMutableArray *_argumentSlab;
+    NSMutableArray *_spareSlab;
+    NSUInteger *_argumentOffsets;
+    
+    // arguments accumulated since the slab was last grouped, in the order they were read,
+    // alongside the index of the option each belongs to
+    NSMutableArray *_pendingArguments;
+    NSUInteger *_pendingOptionIndexes;
+    NSUInteger _pendingCapacity;
+    
+    // scratch space for grouping: a cursor per option, and the pending arguments' order once sorted
+    NSUInteger *_groupingCursors;
+    NSUInteger *_groupingOrder;
+    
+    uint64_t *_parameterOptions;
+    uint64_t *_presentOptions;
+    uint64_t *_recurringOptions;
 }
 
+@synthesize optionRegistry = _optionRegistry;
 @synthesize positionalArguments = _positionalArguments;
+@synthesize presentOptions = _presentOptions;
+@synthesize recurringOptions = _recurringOptions;
 
 - (instancetype)initWithOptionRegistry:(CLKOptionRegistry *)optionRegistry
 {
@@ -24,15 +70,46 @@
     
     self = [super init];
     if (self != nil) {
+        NSArray<CLKOption *> *options = optionRegistry.options;
         _optionRegistry = optionRegistry;
-        _switchOptionOccurrences = [[NSMutableDictionary alloc] init];
-        _parameterOptionArguments = [[NSMutableDictionary alloc] init];
+        _optionCount = options.count;
         _positionalArguments = [[NSMutableArray alloc] init];
+        _occurrences = calloc(MAX(_optionCount, 1UL), sizeof(NSUInteger));
+        _argumentCounts = calloc(MAX(_optionCount, 1UL), sizeof(NSUInteger));
+        _argumentSlab = [[NSMutableArray alloc] init];
+        _spareSlab = [[NSMutableArray alloc] init];
+        _argumentOffsets = calloc((_optionCount + 1), sizeof(NSUInteger));
+        _pendingArguments = [[NSMutableArray alloc] init];
+        _groupingCursors = calloc((_optionCount + 1), sizeof(NSUInteger));
+        
+        NSUInteger wordCount = MAX(CLKBitsetWordCount(_optionCount), 1UL);
+        _parameterOptions = calloc(wordCount, sizeof(uint64_t));
+        _presentOptions = calloc(wordCount, sizeof(uint64_t));
+        _recurringOptions = calloc(wordCount, sizeof(uint64_t));
+        
+        [options enumerateObjectsUsingBlock:^(CLKOption *option, NSUInteger idx, __unused BOOL *outStop) {
+            if (option.type == CLKOptionTypeParameter) {
+                CLKBitsetSet(self->_parameterOptions, idx);
+            }
+        }];
     }
     
     return self;
 }
 
+- (void)dealloc
+{
+    free(_occurrences);
+    free(_argumentCounts);
+    free(_argumentOffsets);
+    free(_pendingOptionIndexes);
+    free(_groupingCursors);
+    free(_groupingOrder);
+    free(_parameterOptions);
+    free(_presentOptions);
+    free(_recurringOptions);
+}
+
 - (NSString *)debugDescription
 {
     NSString *fmt = @"%@\n%@\n\npositional arguments:\n%@";
@@ -46,102 +123,250 @@
 {
     // it's reasonable to query the manifest for an unregistered option.
     // this makes it easier to write tools with varying configurations, special factoring, etc.
-    CLKOption *option = [_optionRegistry optionNamed:optionName];
-    if (option == nil) {
+    NSUInteger optionIndex = [_optionRegistry indexOfOptionNamed:optionName];
+    if (optionIndex == NSNotFound || _occurrences[optionIndex] == 0) {
         return nil;
     }
     
-    id object = nil;
+    if (!CLKBitsetTest(_parameterOptions, optionIndex)) {
+        return @(_occurrences[optionIndex]);
+    }
     
-    switch (option.type) {
-        case CLKOptionTypeSwitch:
-            object = _switchOptionOccurrences[optionName];
-            break;
-        
-        case CLKOptionTypeParameter:
-            // for non-recurrent parameter options, return the single accumulated
-            // argument. multiple occurrences of non-recurrent options is a usage
-            // error handled by the manifest validator.
-            if (option.recurrent) {
-                object = _parameterOptionArguments[optionName];
-            } else {
-                object = _parameterOptionArguments[optionName].firstObject;
-            }
-            
-            break;
+    // occurrences counted without their arguments leave nothing to return
+    if (_argumentCounts[optionIndex] == 0) {
+        return nil;
+    }
+    
+    // for non-recurrent parameter options, return the single accumulated
+    // argument. multiple occurrences of non-recurrent options is a usage
+    // error handled by the manifest validator.
+    CLKOption *option = _optionRegistry.options[optionIndex];
+    if (option.recurrent) {
+        return [self _argumentsForOptionAtIndex:optionIndex];
     }
     
-    return object;
+    [self _groupPendingArgumentsIfNeeded];
+    return _argumentSlab[_argumentOffsets[optionIndex]];
+}
+
+- (NSArray *)_argumentsForOptionAtIndex:(NSUInteger)optionIndex
+{
+    [self _groupPendingArgumentsIfNeeded];
+    NSRange range = NSMakeRange(_argumentOffsets[optionIndex], _argumentCounts[optionIndex]);
+    return [_argumentSlab subarrayWithRange:range];
 }
 
 - (NSSet<NSString *> *)accumulatedOptionNames
 {
-    NSMutableSet *names = [NSMutableSet setWithArray:_switchOptionOccurrences.allKeys];
-    [names addObjectsFromArray:_parameterOptionArguments.allKeys];
+    NSMutableSet *names = [NSMutableSet set];
+    NSArray<CLKOption *> *options = _optionRegistry.options;
+    for (NSUInteger i = 0 ; i < _optionCount ; i++) {
+        if (CLKBitsetTest(_presentOptions, i)) {
+            [names addObject:options[i].name];
+        }
+    }
+    
     return names;
 }
 
 - (BOOL)hasOptionNamed:(NSString *)optionName
 {
-    return (_switchOptionOccurrences[optionName] != nil || _parameterOptionArguments[optionName] != nil);
+    return [self hasOption:[_optionRegistry indexOfOptionNamed:optionName]];
 }
 
 - (NSUInteger)occurrencesOfOptionNamed:(NSString *)optionName
 {
-    CLKOption *option = [_optionRegistry optionNamed:optionName];
-    if (option == nil) {
+    NSUInteger optionIndex = [_optionRegistry indexOfOptionNamed:optionName];
+    if (optionIndex == NSNotFound) {
         return 0;
     }
     
-    NSUInteger occurrences = 0;
-    switch (option.type) {
-        case CLKOptionTypeSwitch:
-            occurrences = _switchOptionOccurrences[optionName].unsignedIntegerValue;
-            break;
-        
-        case CLKOptionTypeParameter:
-            occurrences = _parameterOptionArguments[optionName].count;
-            break;
-    }
-    
-    return occurrences;
+    return _occurrences[optionIndex];
 }
 
 - (NSDictionary<NSString *, id> *)dictionaryRepresentationForAccumulatedOptions
 {
     NSMutableDictionary *rep = [NSMutableDictionary dictionary];
-    [rep addEntriesFromDictionary:_switchOptionOccurrences];
-    [rep addEntriesFromDictionary:_parameterOptionArguments];
+    NSArray<CLKOption *> *options = _optionRegistry.options;
+    for (NSUInteger i = 0 ; i < _optionCount ; i++) {
+        if (_occurrences[i] == 0) {
+            continue;
+        }
+        
+        if (CLKBitsetTest(_parameterOptions, i)) {
+            if (_argumentCounts[i] > 0) {
+                rep[options[i].name] = [self _argumentsForOptionAtIndex:i];
+            }
+        } else {
+            rep[options[i].name] = @(_occurrences[i]);
+        }
+    }
+    
     return rep;
 }
 
+#pragma mark -
+#pragma mark Typed Access
+
+- (CLKOptionHandle)handleForOptionNamed:(NSString *)optionName
+{
+    return [_optionRegistry indexOfOptionNamed:optionName];
+}
+
+- (BOOL)hasOption:(CLKOptionHandle)option
+{
+    if (option == CLKOptionHandleNone) {
+        return NO;
+    }
+    
+    CLKParameterAssert((option < _optionCount), @"option handle %lu out of range", (unsigned long)option);
+    return CLKBitsetTest(_presentOptions, option);
+}
+
+- (NSUInteger)switchCountForOption:(CLKOptionHandle)option
+{
+    if (option == CLKOptionHandleNone) {
+        return 0;
+    }
+    
+    CLKParameterAssert((option < _optionCount), @"option handle %lu out of range", (unsigned long)option);
+    CLKParameterAssert(!CLKBitsetTest(_parameterOptions, option), @"requesting switch count for parameter option '%@'", _optionRegistry.options[option].name);
+    return _occurrences[option];
+}
+
+- (NSUInteger)argumentCountForOption:(CLKOptionHandle)option
+{
+    if (option == CLKOptionHandleNone) {
+        return 0;
+    }
+    
+    CLKParameterAssert((option < _optionCount), @"option handle %lu out of range", (unsigned long)option);
+    CLKParameterAssert(CLKBitsetTest(_parameterOptions, option), @"requesting argument count for switch option '%@'", _optionRegistry.options[option].name);
+    return _argumentCounts[option];
+}
+
+- (id)argumentAtIndex:(NSUInteger)idx forOption:(CLKOptionHandle)option
+{
+    // an index past this option's range would silently read a neighbor's argument out of the slab
+    CLKHardParameterAssert((option < _optionCount && CLKBitsetTest(_parameterOptions, option)));
+    CLKHardParameterAssert((idx < _argumentCounts[option]), @"argument index %lu beyond bounds for option '%@'", (unsigned long)idx, _optionRegistry.options[option].name);
+    [self _groupPendingArgumentsIfNeeded];
+    return _argumentSlab[_argumentOffsets[option] + idx];
+}
+
 #pragma mark -
 #pragma mark Building Manifests
 
+- (NSUInteger)_indexOfAccumulatedOptionNamed:(NSString *)optionName
+{
+    NSUInteger optionIndex = [_optionRegistry indexOfOptionNamed:optionName];
+    CLKParameterAssert((optionIndex != NSNotFound), @"attempting to accumulate unregistered option named '%@'", optionName);
+    return optionIndex;
+}
+
 - (void)accumulateSwitchOptionNamed:(NSString *)optionName
 {
-    CLKParameterAssert([_optionRegistry hasOptionNamed:optionName], @"attempting to accumulate unregistered option named '%@'", optionName);
-    CLKParameterAssert(([_optionRegistry optionNamed:optionName].type == CLKOptionTypeSwitch), @"attempting to accumulate switch occurrence for parameter option named '%@'", optionName);
-    NSUInteger occurrences = _switchOptionOccurrences[optionName].unsignedIntegerValue;
-    _switchOptionOccurrences[optionName] = @(occurrences + 1);
+    NSUInteger optionIndex = [self _indexOfAccumulatedOptionNamed:optionName];
+    CLKParameterAssert(!CLKBitsetTest(_parameterOptions, optionIndex), @"attempting to accumulate switch occurrence for parameter option named '%@'", optionName);
+    [self _recordOccurrenceOfOptionAtIndex:optionIndex];
 }
 
 - (void)accumulateArgument:(id)argument forParameterOptionNamed:(NSString *)optionName
 {
-    CLKParameterAssert([_optionRegistry hasOptionNamed:optionName], @"attempting to accumulate unregistered option named '%@'", optionName);
-    CLKParameterAssert(([_optionRegistry optionNamed:optionName].type == CLKOptionTypeParameter), @"attempting to accumulate argument for switch option named '%@'", optionName);
-    
-    NSMutableArray *arguments = _parameterOptionArguments[optionName];
-    if (arguments == nil) {
-        arguments = [NSMutableArray array];
-        _parameterOptionArguments[optionName] = arguments;
-    }
+    NSUInteger optionIndex = [self _indexOfAccumulatedOptionNamed:optionName];
+    CLKParameterAssert(CLKBitsetTest(_parameterOptions, optionIndex), @"attempting to accumulate argument for switch option named '%@'", optionName);
     
     // don't assert multiple occurrences of non-recurrent options here.
     // that is a usage error and the validator will handle it in order
     // to provide a good message to the user.
     
-    [arguments addObject:argument];
+    // inserting into this option's range would shift every range after it, which is quadratic
+    // when recurrent options interleave. arguments wait in read order until they're grouped.
+    NSUInteger pendingCount = _pendingArguments.count;
+    if (pendingCount == _pendingCapacity) {
+        _pendingCapacity = MAX((_pendingCapacity * 2), 16UL);
+        _pendingOptionIndexes = realloc(_pendingOptionIndexes, (_pendingCapacity * sizeof(NSUInteger)));
+        _groupingOrder = realloc(_groupingOrder, (_pendingCapacity * sizeof(NSUInteger)));
+    }
+    
+    [_pendingArguments addObject:argument];
+    _pendingOptionIndexes[pendingCount] = optionIndex;
+    _argumentCounts[optionIndex]++;
+    [self _recordOccurrenceOfOptionAtIndex:optionIndex];
+}
+
+- (void)groupAccumulatedArguments
+{
+    NSUInteger pendingCount = _pendingArguments.count;
+    if (pendingCount == 0) {
+        return;
+    }
+    
+    // counting sort of the pending arguments on option index. it's stable, so each option's
+    // arguments keep the order they were read in. cursor `i + 1` starts out counting option `i`.
+    memset(_groupingCursors, 0, ((_optionCount + 1) * sizeof(NSUInteger)));
+    for (NSUInteger k = 0 ; k < pendingCount ; k++) {
+        _groupingCursors[_pendingOptionIndexes[k] + 1]++;
+    }
+    
+    for (NSUInteger i = 1 ; i <= _optionCount ; i++) {
+        _groupingCursors[i] += _groupingCursors[i - 1];
+    }
+    
+    // once the order is filled in, cursor `i` has advanced to where option `i + 1` starts
+    for (NSUInteger k = 0 ; k < pendingCount ; k++) {
+        _groupingOrder[_groupingCursors[_pendingOptionIndexes[k]]++] = k;
+    }
+    
+    // each option's grouped arguments were read before its pending ones.
+    // offset `i + 1` is still the old one when option `i` is copied.
+    NSUInteger pendingStart = 0;
+    for (NSUInteger i = 0 ; i < _optionCount ; i++) {
+        NSUInteger groupedStart = _argumentOffsets[i];
+        NSUInteger groupedEnd = _argumentOffsets[i + 1];
+        _argumentOffsets[i] = _spareSlab.count;
+        for (NSUInteger j = groupedStart ; j < groupedEnd ; j++) {
+            [_spareSlab addObject:_argumentSlab[j]];
+        }
+        
+        for (NSUInteger j = pendingStart ; j < _groupingCursors[i] ; j++) {
+            [_spareSlab addObject:_pendingArguments[_groupingOrder[j]]];
+        }
+        
+        pendingStart = _groupingCursors[i];
+    }
+    
+    _argumentOffsets[_optionCount] = _spareSlab.count;
+    
+    NSMutableArray *groupedSlab = _spareSlab;
+    _spareSlab = _argumentSlab;
+    _argumentSlab = groupedSlab;
+    [_spareSlab removeAllObjects];
+    [_pendingArguments removeAllObjects];
+}
+
+- (void)_groupPendingArgumentsIfNeeded
+{
+    if (_pendingArguments.count > 0) {
+        [self groupAccumulatedArguments];
+    }
+}
+
+- (void)accumulateOccurrenceOfParameterOptionNamed:(NSString *)optionName
+{
+    NSUInteger optionIndex = [self _indexOfAccumulatedOptionNamed:optionName];
+    CLKParameterAssert(CLKBitsetTest(_parameterOptions, optionIndex), @"attempting to accumulate argument for switch option named '%@'", optionName);
+    [self _recordOccurrenceOfOptionAtIndex:optionIndex];
+}
+
+- (void)_recordOccurrenceOfOptionAtIndex:(NSUInteger)optionIndex
+{
+    if (_occurrences[optionIndex] > 0) {
+        CLKBitsetSet(_recurringOptions, optionIndex);
+    }
+    
+    _occurrences[optionIndex]++;
+    CLKBitsetSet(_presentOptions, optionIndex);
 }
 
 - (void)accumulatePositionalArgument:(NSString *)argument
@@ -149,4 +374,17 @@
     [_positionalArguments addObject:argument];
 }
 
+- (void)reset
+{
+    NSUInteger wordCount = MAX(CLKBitsetWordCount(_optionCount), 1UL);
+    memset(_occurrences, 0, (MAX(_optionCount, 1UL) * sizeof(NSUInteger)));
+    memset(_argumentCounts, 0, (MAX(_optionCount, 1UL) * sizeof(NSUInteger)));
+    memset(_argumentOffsets, 0, ((_optionCount + 1) * sizeof(NSUInteger)));
+    memset(_presentOptions, 0, (wordCount * sizeof(uint64_t)));
+    memset(_recurringOptions, 0, (wordCount * sizeof(uint64_t)));
+    [_argumentSlab removeAllObjects];
+    [_pendingArguments removeAllObjects];
+    [_positionalArguments removeAllObjects];
+}
+
 @end
@@ -7,6 +7,7 @@
 @class CLKArgumentIssue;
 @class CLKArgumentManifest;
 @class CLKArgumentManifestConstraint;
+@class CLKConstraintProgram;
 @class CLKOption;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -24,6 +25,12 @@ typedef void (^CLKAMVIssueHandler)(CLKArgumentIssue *issue);
 
 - (void)validateConstraints:(NSArray<CLKArgumentManifestConstraint *> *)constraints issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler;
 
+// the program must be compiled against the manifest's option registry
+- (void)validateConstraintProgram:(CLKConstraintProgram *)program issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler;
+
+// validates a single instruction of the program. answers NO, after reporting issues, if its constraint is violated.
+- (BOOL)validateInstructionAtIndex:(NSUInteger)idx ofProgram:(CLKConstraintProgram *)program issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -8,17 +8,20 @@
 #import "CLKArgumentManifest_Private.h"
 #import "CLKArgumentManifestConstraint.h"
 #import "CLKAssert.h"
+#import "CLKBitset.h"
+#import "CLKConstraintProgram.h"
 #import "CLKError.h"
-#import "NSError+CLKAdditions.h"
+#import "CLKOptionRegistry.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 @interface CLKArgumentManifestValidator ()
 
-- (void)_validateConstraint:(CLKArgumentManifestConstraint *)constraint issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler;
+- (BOOL)_isOptionPresent:(NSUInteger)optionIndex;
+- (BOOL)_validateInstruction:(const CLKConstraintInstruction *)instruction ofProgram:(CLKConstraintProgram *)program atIndex:(NSUInteger)idx issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler;
 - (void)_validateStrictRequirement:(CLKArgumentManifestConstraint *)constraint issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler;
 - (void)_validateAnyPresentRequirement:(CLKArgumentManifestConstraint *)constraint issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler;
-- (NSError *)_errorForUnsatisfiedPresenceOfOption:(NSString *)option predicatedByOption:(nullable NSString *)predicate;
+- (CLKArgumentIssue *)_issueForUnsatisfiedPresenceOfOption:(NSString *)option predicatedByOption:(nullable NSString *)predicate;
 - (void)_validateMutualExclusion:(CLKArgumentManifestConstraint *)constraint issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler;
 - (void)_validateStandaloneExclusion:(CLKArgumentManifestConstraint *)constraint issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler;
 - (void)_validateOccurrenceLimit:(CLKArgumentManifestConstraint *)constraint issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler;
@@ -50,45 +53,102 @@ NS_ASSUME_NONNULL_END
 
 - (void)validateConstraints:(NSArray<CLKArgumentManifestConstraint *> *)constraints issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler
 {
-    // eliminate redundant errors by deduplicating identical constraints.
-    // use an ordered set to assist testing.
-    NSOrderedSet<CLKArgumentManifestConstraint *> *uniqueConstraints = [[NSOrderedSet alloc] initWithArray:constraints];
-    for (CLKArgumentManifestConstraint *constraint in uniqueConstraints) {
-        @autoreleasepool {
-            [self _validateConstraint:constraint issueHandler:issueHandler];
-        }
+    CLKConstraintProgram *program = [CLKConstraintProgram programWithConstraints:constraints optionRegistry:_manifest.optionRegistry];
+    [self validateConstraintProgram:program issueHandler:issueHandler];
+}
+
+- (void)validateConstraintProgram:(CLKConstraintProgram *)program issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler
+{
+    CLKParameterAssert(program.optionRegistry == _manifest.optionRegistry, @"constraint program compiled for a different option registry");
+    
+    // the passing case for every constraint is a few bitset tests against the manifest.
+    // the constraint objects are only consulted to build errors.
+    for (NSUInteger i = 0 ; i < program.instructionCount ; i++) {
+        [self _validateInstruction:[program instructionAtIndex:i] ofProgram:program atIndex:i issueHandler:issueHandler];
     }
 }
 
-- (void)_validateConstraint:(CLKArgumentManifestConstraint *)constraint issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler
+- (BOOL)validateInstructionAtIndex:(NSUInteger)idx ofProgram:(CLKConstraintProgram *)program issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler
 {
-    if (constraint.predicatingOption != nil && ![_manifest hasOptionNamed:constraint.predicatingOption]) {
-        return;
+    CLKParameterAssert(program.optionRegistry == _manifest.optionRegistry, @"constraint program compiled for a different option registry");
+    return [self _validateInstruction:[program instructionAtIndex:idx] ofProgram:program atIndex:idx issueHandler:issueHandler];
+}
+
+- (BOOL)_isOptionPresent:(NSUInteger)optionIndex
+{
+    return (optionIndex != CLKConstraintOptionNone && CLKBitsetTest(_manifest.presentOptions, optionIndex));
+}
+
+- (BOOL)_validateInstruction:(const CLKConstraintInstruction *)instruction ofProgram:(CLKConstraintProgram *)program atIndex:(NSUInteger)idx issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler
+{
+    if (instruction->predicated && ![self _isOptionPresent:instruction->predicatingOption]) {
+        return YES;
     }
     
-    switch (constraint.type) {
+    NSUInteger wordCount = program.bitsetWordCount;
+    BOOL satisfied = YES;
+    switch (instruction->type) {
         case CLKConstraintTypeRequired:
-            [self _validateStrictRequirement:constraint issueHandler:issueHandler];
+            satisfied = [self _isOptionPresent:instruction->significantOption];
             break;
         
         case CLKConstraintTypeAnyRequired:
-            [self _validateAnyPresentRequirement:constraint issueHandler:issueHandler];
+            satisfied = CLKBitsetIntersects([program bandForInstruction:instruction], _manifest.presentOptions, wordCount);
             break;
         
         case CLKConstraintTypeMutuallyExclusive:
-            [self _validateMutualExclusion:constraint issueHandler:issueHandler];
+            satisfied = (CLKBitsetIntersectionCount([program bandForInstruction:instruction], _manifest.presentOptions, wordCount) < 2);
             break;
         
         case CLKConstraintTypeStandalone:
-            [self _validateStandaloneExclusion:constraint issueHandler:issueHandler];
+            // the band holds the significant option and its whitelist
+            satisfied = (![self _isOptionPresent:instruction->significantOption]
+                         || !CLKBitsetHasBitsOutsideMask(_manifest.presentOptions, [program bandForInstruction:instruction], wordCount));
             break;
         
         case CLKConstraintTypeOccurrencesLimited:
-            [self _validateOccurrenceLimit:constraint issueHandler:issueHandler];
+            satisfied = (instruction->significantOption == CLKConstraintOptionNone || !CLKBitsetTest(_manifest.recurringOptions, instruction->significantOption));
             break;
     }
+    
+    if (satisfied) {
+        return YES;
+    }
+    
+    @autoreleasepool {
+        CLKArgumentManifestConstraint *constraint = [program constraintAtIndex:idx];
+        switch (instruction->type) {
+            case CLKConstraintTypeRequired:
+                [self _validateStrictRequirement:constraint issueHandler:issueHandler];
+                break;
+            
+            case CLKConstraintTypeAnyRequired:
+                [self _validateAnyPresentRequirement:constraint issueHandler:issueHandler];
+                break;
+            
+            case CLKConstraintTypeMutuallyExclusive:
+                [self _validateMutualExclusion:constraint issueHandler:issueHandler];
+                break;
+            
+            case CLKConstraintTypeStandalone:
+                [self _validateStandaloneExclusion:constraint issueHandler:issueHandler];
+                break;
+            
+            case CLKConstraintTypeOccurrencesLimited:
+                [self _validateOccurrenceLimit:constraint issueHandler:issueHandler];
+                break;
+        }
+    }
+    
+    return NO;
 }
 
+#pragma mark -
+#pragma mark Reporting Issues
+
+// these methods run only for constraints the bitset tests found unsatisfied.
+// they re-check against the manifest to build the issue.
+
 - (void)_validateStrictRequirement:(CLKArgumentManifestConstraint *)constraint issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler
 {
     NSParameterAssert(constraint.type == CLKConstraintTypeRequired);
@@ -96,8 +156,7 @@ NS_ASSUME_NONNULL_END
     
     NSString *option = constraint.significantOption;
     if (![_manifest hasOptionNamed:option]) {
-        NSError *error = [self _errorForUnsatisfiedPresenceOfOption:option predicatedByOption:constraint.predicatingOption];
-        CLKArgumentIssue *issue = [CLKArgumentIssue issueWithError:error salientOption:option];
+        CLKArgumentIssue *issue = [self _issueForUnsatisfiedPresenceOfOption:option predicatedByOption:constraint.predicatingOption];
         issueHandler(issue);
     }
 }
@@ -113,28 +172,28 @@ NS_ASSUME_NONNULL_END
         }
     }
     
-    NSError *error;
+    CLKArgumentIssue *issue;
     if (bandedOptions.count == 1) {
-        error = [self _errorForUnsatisfiedPresenceOfOption:bandedOptions[0] predicatedByOption:constraint.predicatingOption];
+        issue = [self _issueForUnsatisfiedPresenceOfOption:bandedOptions[0] predicatedByOption:constraint.predicatingOption];
+    } else if (constraint.predicatingOption != nil) {
+        issue = [CLKArgumentIssue issueWithCLKErrorCode:CLKErrorRequiredOptionNotProvided salientOptions:bandedOptions.array
+                                            description:@"one or more of the following options must be provided when using --%@: --%@"
+                                               argument:constraint.predicatingOption argument:bandedOptions.array];
     } else {
-        NSString *optionsDesc = [bandedOptions.array componentsJoinedByString:@" --"];
-        if (constraint.predicatingOption != nil) {
-            error = [NSError clk_CLKErrorWithCode:CLKErrorRequiredOptionNotProvided description:@"one or more of the following options must be provided when using --%@: --%@", constraint.predicatingOption, optionsDesc];
-        } else {
-            error = [NSError clk_CLKErrorWithCode:CLKErrorRequiredOptionNotProvided description:@"one or more of the following options must be provided: --%@", optionsDesc];
-        }
+        issue = [CLKArgumentIssue issueWithCLKErrorCode:CLKErrorRequiredOptionNotProvided salientOptions:bandedOptions.array
+                                            description:@"one or more of the following options must be provided: --%@"
+                                               argument:bandedOptions.array argument:nil];
     }
     
-    CLKArgumentIssue *issue = [CLKArgumentIssue issueWithError:error salientOptions:bandedOptions.array];
     issueHandler(issue);
 }
 
-- (NSError *)_errorForUnsatisfiedPresenceOfOption:(NSString *)option predicatedByOption:(NSString *)predicate
+- (CLKArgumentIssue *)_issueForUnsatisfiedPresenceOfOption:(NSString *)option predicatedByOption:(NSString *)predicate
 {
     if (predicate != nil) {
-        return [NSError clk_CLKErrorWithCode:CLKErrorRequiredOptionNotProvided description:@"--%@ is required when using --%@", option, predicate];
+        return [CLKArgumentIssue issueWithCLKErrorCode:CLKErrorRequiredOptionNotProvided salientOptions:@[ option ] description:@"--%@ is required when using --%@" argument:option argument:predicate];
     } else {
-        return [NSError clk_CLKErrorWithCode:CLKErrorRequiredOptionNotProvided description:@"--%@: required option not provided", option];
+        return [CLKArgumentIssue issueWithCLKErrorCode:CLKErrorRequiredOptionNotProvided salientOptions:@[ option ] description:@"--%@: required option not provided" argument:option argument:nil];
     }
 }
 
@@ -156,9 +215,8 @@ NS_ASSUME_NONNULL_END
     }
     
     if (hits != nil && hits.count > 1) {
-        NSString *desc = [hits componentsJoinedByString:@" --"];
-        NSError *error = [NSError clk_CLKErrorWithCode:CLKErrorMutuallyExclusiveOptionsPresent description:@"--%@: mutually exclusive options encountered", desc];
-        CLKArgumentIssue *issue = [CLKArgumentIssue issueWithError:error salientOptions:hits];
+        CLKArgumentIssue *issue = [CLKArgumentIssue issueWithCLKErrorCode:CLKErrorMutuallyExclusiveOptionsPresent salientOptions:hits
+                                                              description:@"--%@: mutually exclusive options encountered" argument:hits argument:nil];
         issueHandler(issue);
     }
 }
@@ -175,16 +233,16 @@ NS_ASSUME_NONNULL_END
         if (accumulatedOptions.count > 1) {
             NSOrderedSet<NSString *> *whitelist = constraint.bandedOptions;
             if (whitelist.count == 0) {
-                NSError *error = [NSError clk_CLKErrorWithCode:CLKErrorMutuallyExclusiveOptionsPresent description:@"--%@ may not be provided with other options", option];
-                issue = [CLKArgumentIssue issueWithError:error salientOption:option];
+                issue = [CLKArgumentIssue issueWithCLKErrorCode:CLKErrorMutuallyExclusiveOptionsPresent salientOptions:@[ option ]
+                                                    description:@"--%@ may not be provided with other options" argument:option argument:nil];
             } else {
                 NSMutableSet<NSString *> *conflictedOptions = [accumulatedOptions mutableCopy];
                 [conflictedOptions minusSet:whitelist.set];
                 [conflictedOptions removeObject:option];
                 if (conflictedOptions.count > 0) {
-                    NSString *whitelistDesc = [whitelist.array componentsJoinedByString:@" --"];
-                    NSError *error = [NSError clk_CLKErrorWithCode:CLKErrorMutuallyExclusiveOptionsPresent description:@"--%@ may not be provided with options other than the following: --%@", option, whitelistDesc];
-                    issue = [CLKArgumentIssue issueWithError:error salientOption:option];
+                    issue = [CLKArgumentIssue issueWithCLKErrorCode:CLKErrorMutuallyExclusiveOptionsPresent salientOptions:@[ option ]
+                                                        description:@"--%@ may not be provided with options other than the following: --%@"
+                                                           argument:option argument:whitelist.array];
                 }
             }
         }
@@ -202,8 +260,8 @@ NS_ASSUME_NONNULL_END
     
     NSString *option = constraint.significantOption;
     if ([_manifest occurrencesOfOptionNamed:option] > 1) {
-        NSError *error = [NSError clk_CLKErrorWithCode:CLKErrorTooManyOccurrencesOfOption description:@"--%@ may not be provided more than once", option];
-        CLKArgumentIssue *issue = [CLKArgumentIssue issueWithError:error salientOption:option];
+        CLKArgumentIssue *issue = [CLKArgumentIssue issueWithCLKErrorCode:CLKErrorTooManyOccurrencesOfOption salientOptions:@[ option ]
+                                                              description:@"--%@ may not be provided more than once" argument:option argument:nil];
         issueHandler(issue);
     }
 }
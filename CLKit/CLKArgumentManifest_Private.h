@@ -12,8 +12,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)initWithOptionRegistry:(CLKOptionRegistry *)optionRegistry NS_DESIGNATED_INITIALIZER;
 
+@property (readonly) CLKOptionRegistry *optionRegistry;
 @property (readonly) NSDictionary<NSString *, id> *dictionaryRepresentationForAccumulatedOptions;
 
+// bitsets over the registry's option indexes, kept current as options are accumulated.
+// `recurringOptions` holds the options that have occurred more than once.
+@property (readonly) const uint64_t *presentOptions;
+@property (readonly) const uint64_t *recurringOptions;
+
 @property (readonly) NSSet<NSString *> *accumulatedOptionNames;
 - (BOOL)hasOptionNamed:(NSString *)optionName;
 - (NSUInteger)occurrencesOfOptionNamed:(NSString *)optionName;
@@ -22,6 +28,21 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)accumulateArgument:(id)argument forParameterOptionNamed:(NSString *)optionName;
 - (void)accumulatePositionalArgument:(NSString *)argument;
 
+// arguments are kept in the order they were accumulated until they are grouped by option,
+// which reading a parameter option's arguments does first. builders that hand the manifest
+// to other threads call this once they're done accumulating so that reads never mutate it.
+- (void)groupAccumulatedArguments;
+
+// counts an occurrence of a parameter option without storing its argument. the counts
+// are all validation needs, so an event-driven parse can validate in constant memory.
+// the occurrence is reported by -hasOptionNamed: and -occurrencesOfOptionNamed:, but reads of
+// the option's arguments only see arguments that were stored: none, if all were counted this way.
+- (void)accumulateOccurrenceOfParameterOptionNamed:(NSString *)optionName;
+
+// forgets everything accumulated so the manifest can be built again. its storage is
+// kept, so a manifest reused for arguments like the last ones allocates nothing.
+- (void)reset;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -4,12 +4,35 @@
 
 #import <Foundation/Foundation.h>
 
+@class CLKArgumentEvent;
 @class CLKArgumentManifest;
 @class CLKOption;
 @class CLKOptionGroup;
+@class CLKOptionSchema;
+@class CLKOptionSource;
+@class CLKParseProfile;
 
 NS_ASSUME_NONNULL_BEGIN
 
+// additional places a C argv parser can read arguments from
+typedef NS_OPTIONS(NSUInteger, CLKArgumentSourceOptions) {
+    CLKArgumentSourceOptionsNone = 0,
+    
+    // replace each `@path` argument with the arguments in the named file, one per line.
+    // blank lines are skipped and the file's own arguments are not expanded further.
+    // the file is memory-mapped and its arguments are read in place.
+    CLKArgumentSourceExpandResponseFiles = (1 << 0),
+    
+    // after argv, read NUL-delimited arguments from standard input as `xargs -0` does.
+    // input is read concurrently with parsing, a bounded amount at a time.
+    CLKArgumentSourceReadStandardInput = (1 << 1)
+};
+
+// a parser holds the state of one parse: its position in the argument vector, the manifest it is
+// building and the issues it has found. that state is unsynchronized, so a parser must only be
+// used from one thread at a time. what it parses against is not part of that state: schemas,
+// options, groups and option sources are immutable and can be shared by parsers on any number
+// of threads, so concurrent parses need only a parser each.
 @interface CLKArgumentParser : NSObject
 
 + (instancetype)new NS_UNAVAILABLE;
@@ -17,9 +40,79 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)parserWithArgumentVector:(NSArray<NSString *> *)argv options:(NSArray<CLKOption *> *)options;
 + (instancetype)parserWithArgumentVector:(NSArray<NSString *> *)argv options:(NSArray<CLKOption *> *)options optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups;
++ (instancetype)parserWithArgumentVector:(NSArray<NSString *> *)argv schema:(CLKOptionSchema *)schema;
+
+// parses a C argument vector in place. tokens are classified on their UTF-8 bytes and strings are only
+// created for tokens the parser reads, referencing argv's bytes where possible. argv must outlive the
+// parser and the manifest it produces; the argv passed to main() does.
++ (instancetype)parserWithArgv:(const char *_Nonnull [_Nonnull])argv argc:(int)argc options:(NSArray<CLKOption *> *)options;
++ (instancetype)parserWithArgv:(const char *_Nonnull [_Nonnull])argv argc:(int)argc options:(NSArray<CLKOption *> *)options optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups;
++ (instancetype)parserWithArgv:(const char *_Nonnull [_Nonnull])argv argc:(int)argc schema:(CLKOptionSchema *)schema;
+
+// a response file that can't be read, or a read error on standard input, fails the parse with a POSIX error
++ (instancetype)parserWithArgv:(const char *_Nonnull [_Nonnull])argv argc:(int)argc schema:(CLKOptionSchema *)schema sourceOptions:(CLKArgumentSourceOptions)sourceOptions;
 
 - (nullable CLKArgumentManifest *)parseArguments;
 
+// an alternative to -parseArguments that delivers the parse one event at a time, without
+// building a manifest or retaining positional arguments. tokens are read as events are
+// requested. constraints that can't be satisfied by later options (mutual exclusion,
+// standalone options, occurrence limits) are reported as soon as they are violated, so a
+// mutual exclusion issue names only the options seen up to that point. the rest are reported
+// after the last token. answers nil once everything has been delivered.
+//
+// a parser can be used for events or for a manifest, not both. issues delivered as events
+// are not collected in `errors`.
+- (nullable CLKArgumentEvent *)nextEvent;
+
+// prepare the parser to parse a new argument vector, as a new parser with the same schema and settings
+// would. the parser keeps the schema's compiled options and groups, and the storage it has grown for
+// the manifest, issues and tokens, so once it has parsed a few lines like the next one, a reset and
+// parse allocate little beyond the arguments themselves. this is intended for reading lines from
+// an interactive prompt.
+//
+// the manifest returned by the last parse is reused: it is emptied by a reset and refilled by the next
+// parse, so copy anything from it that has to outlive the reset. settings that can only be set before
+// parsing begins can be changed again until the next parse begins. a parser created with
+// CLKArgumentSourceReadStandardInput only reads standard input on its first run; response files are
+// still expanded. can be used at any time, including part of the way through an event-driven parse.
+- (void)resetWithArgumentVector:(NSArray<NSString *> *)argv;
+- (void)resetWithArgv:(const char *_Nonnull [_Nonnull])argv argc:(int)argc;
+
+// the number of workers -parseArguments may use to transform arguments. the default, 1, transforms
+// each argument as it is read. above 1, arguments for options whose transformers are thread-safe
+// are transformed together once the argument vector has been read. the manifest and `errors` are
+// the same either way. events are always transformed as they are read.
+//
+// can only be set before parsing begins.
+@property (nonatomic) NSUInteger transformerConcurrency;
+
+// YES to measure where the parse spends its time (see CLKParseProfile). the default is YES if the
+// CLK_PARSE_PROFILE environment variable is set. when profiling is disabled, the cost is a branch or
+// two per token. can only be set before parsing begins.
+@property (nonatomic) BOOL profilingEnabled;
+
+// the profile of a finished parse, or nil if profiling isn't enabled or the parse hasn't finished.
+// an event-driven parse finishes when -nextEvent first answers nil.
+@property (nullable, readonly) CLKParseProfile *profile;
+
+// YES to accept an unambiguous prefix of an option name in place of the name, as getopt_long does:
+// `--verb` is read as `--verbose` unless another option's name also begins with `verb`. a prefix that
+// more than one name begins with is an issue naming the options it could be. names spelled out in full
+// are looked up as before, and option sources always use full names. the default is NO.
+//
+// can only be set before parsing begins.
+@property (nonatomic) BOOL abbreviatedOptionNamesEnabled;
+
+// settings for options the argument vector doesn't supply (see CLKOptionSource), in order of precedence:
+// an option supplied by the argument vector ignores every source, and an option set by a source ignores
+// the sources after it. a typical order is the environment, then a config file. settings are merged
+// once the argument vector has been read, before the manifest is validated, so option groups apply to
+// the merged result. in an event-driven parse, their events follow the last token's.
+//
+// can only be set before parsing begins.
+@property (copy, nonatomic) NSArray<CLKOptionSource *> *optionSources;
+
 @property (nullable, readonly) NSArray<NSError *> *errors;
 
 @end
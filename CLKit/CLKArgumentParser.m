@@ -4,77 +4,259 @@
 
 #import "CLKArgumentParser_Internal.h"
 
+#import <unistd.h>
+
+#import "CLKArgumentEvent_Private.h"
 #import "CLKArgumentIssue.h"
 #import "CLKArgumentManifest_Private.h"
 #import "CLKArgumentManifestValidator.h"
+#import "CLKArgumentStream.h"
 #import "CLKArgumentTransformer.h"
+#import "CLKArgumentVector.h"
 #import "CLKAssert.h"
+#import "CLKBitset.h"
+#import "CLKConstraintProgram.h"
 #import "CLKError_Private.h"
+#import "CLKNumericParsing.h"
 #import "CLKOption_Private.h"
-#import "CLKOptionGroup_Private.h"
 #import "CLKOptionRegistry.h"
+#import "CLKOptionSchema_Private.h"
+#import "CLKOptionSource_Private.h"
+#import "CLKParseProfile_Private.h"
+#import "CLKSuggestionIndex.h"
 #import "CLKToken.h"
-#import "NSCharacterSet+CLKAdditions.h"
+#import "CLKWorkShare.h"
 #import "NSError+CLKAdditions.h"
-#import "NSMutableArray+CLKAdditions.h"
+
+// flag sets up to this length are read without allocating
+#define CLKFlagSetInlineLength 32
+
+// the most occurrences of a switch option an option source can set
+#define CLKOptionSourceSwitchCountLimit UINT16_MAX
+
+NS_ASSUME_NONNULL_BEGIN
+
+static BOOL CLKSwitchCountForOptionSourceValue(NSString *value, NSUInteger *outCount);
+
+NS_ASSUME_NONNULL_END
+
+// `true`, `yes` or an empty value is one occurrence; `false` or `no` is none
+static BOOL CLKSwitchCountForOptionSourceValue(NSString *value, NSUInteger *outCount)
+{
+    if (value.length == 0 || [value caseInsensitiveCompare:@"true"] == NSOrderedSame || [value caseInsensitiveCompare:@"yes"] == NSOrderedSame) {
+        *outCount = 1;
+        return YES;
+    }
+    
+    if ([value caseInsensitiveCompare:@"false"] == NSOrderedSame || [value caseInsensitiveCompare:@"no"] == NSOrderedSame) {
+        *outCount = 0;
+        return YES;
+    }
+    
+    __block uint64_t count = 0;
+    CLKNumericParseResult result = CLKParseCharactersOfString(value, ^(const unichar *characters, NSUInteger length) {
+        return CLKParseUInt64(characters, length, &count);
+    });
+    
+    if (result != CLKNumericParseResultSuccess || count > CLKOptionSourceSwitchCountLimit) {
+        return NO;
+    }
+    
+    *outCount = (NSUInteger)count;
+    return YES;
+}
 
 @implementation CLKArgumentParser
 {
-    NSMutableArray<NSString *> *_argumentVector;
-    NSArray<CLKOption *> *_options;
-    NSArray<CLKOptionGroup *> *_optionGroups;
+    CLKArgumentVector *_argumentVector;
+    NSUInteger _argumentIndex; // read cursor into _argumentVector
+    unichar *_flagSetCharacters; // flags of an exploded flag set, read as flag tokens ahead of _argumentVector
+    unichar _flagSetInlineCharacters[CLKFlagSetInlineLength]; // _flagSetCharacters for sets that fit
+    unichar *_flagSetHeapCharacters; // _flagSetCharacters for longer sets, kept for the next one
+    NSUInteger _flagSetHeapCapacity;
+    NSUInteger _flagSetLength;
+    NSUInteger _flagSetIndex; // read cursor into _flagSetCharacters
+    CLKTokenAnalysis _tokenAnalysis; // analysis of the next token, as classified by -_readNextArgumentToken
+    CLKOptionSchema *_schema;
     CLKOptionRegistry *_optionRegistry;
     CLKAPState _state;
     CLKOption *_currentParameterOption;
     CLKArgumentManifest *_manifest;
+    CLKArgumentManifestValidator *_validator;
     NSMutableArray<CLKArgumentIssue *> *_parsingIssues;
     NSMutableArray<CLKArgumentIssue *> *_validationIssues;
+    uint64_t *_optionsWithParsingIssues; // bitset by option index
+    NSArray<CLKOptionSource *> *_optionSources;
+    uint64_t *_suppliedOptions; // options the argument vector or an option source has supplied, by option index
+    BOOL _abbreviatedOptionNamesEnabled;
+    
+    // event mode, entered by -nextEvent
+    BOOL _producesEvents;
+    BOOL _eventsFinished;
+    NSMutableArray<CLKArgumentEvent *> *_pendingEvents;
+    uint64_t *_reportedConstraints; // monotonic constraints already reported, by instruction index
+    uint64_t *_activeStandaloneConstraints; // standalone constraints whose significant option is present, by instruction index
+    NSMutableData *_activeStandaloneIndexes; // the same constraints as a list of instruction indexes
+    
+    // transformations deferred to the end of the argument vector (see transformerConcurrency)
+    NSUInteger _transformerConcurrency;
+    NSMutableArray<NSString *> *_deferredArguments;
+    NSMutableArray<CLKOption *> *_deferredOptions;
+    NSMutableData *_deferredIssueIndexes; // for each deferred argument, the count of parsing issues when it was read
+    
+    // NULL unless profiling is enabled
+    CLKParseCounters *_counters;
+    CLKParseProfile *_profile;
 }
 
+@synthesize transformerConcurrency = _transformerConcurrency;
+@synthesize profile = _profile;
+@synthesize optionSources = _optionSources;
+@synthesize abbreviatedOptionNamesEnabled = _abbreviatedOptionNamesEnabled;
+@synthesize manifest = _manifest;
+@synthesize schema = _schema;
+
 + (instancetype)parserWithArgumentVector:(NSArray<NSString *> *)argv options:(NSArray<CLKOption *> *)options
 {
-    return [[self alloc] _initWithArgumentVector:argv options:options optionGroups:nil];
+    return [self parserWithArgumentVector:argv options:options optionGroups:nil];
 }
 
 + (instancetype)parserWithArgumentVector:(NSArray<NSString *> *)argv options:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups
 {
-    return [[self alloc] _initWithArgumentVector:argv options:options optionGroups:groups];
+    CLKHardParameterAssert(argv != nil);
+    
+    CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:options optionGroups:groups];
+    return [self parserWithArgumentVector:argv schema:schema];
 }
 
-- (instancetype)_initWithArgumentVector:(NSArray<NSString *> *)argv options:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups
++ (instancetype)parserWithArgumentVector:(NSArray<NSString *> *)argv schema:(CLKOptionSchema *)schema
 {
     CLKHardParameterAssert(argv != nil);
-    CLKHardParameterAssert(options != nil);
+    
+    CLKArgumentVector *argumentVector = [CLKArgumentVector vectorWithArguments:argv];
+    return [[self alloc] _initWithArgumentVector:argumentVector schema:schema];
+}
+
++ (instancetype)parserWithArgv:(const char *[])argv argc:(int)argc options:(NSArray<CLKOption *> *)options
+{
+    return [self parserWithArgv:argv argc:argc options:options optionGroups:nil];
+}
+
++ (instancetype)parserWithArgv:(const char *[])argv argc:(int)argc options:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups
+{
+    CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:options optionGroups:groups];
+    return [self parserWithArgv:argv argc:argc schema:schema];
+}
+
++ (instancetype)parserWithArgv:(const char *[])argv argc:(int)argc schema:(CLKOptionSchema *)schema
+{
+    CLKArgumentVector *argumentVector = [CLKArgumentVector vectorWithArgv:argv argc:argc];
+    return [[self alloc] _initWithArgumentVector:argumentVector schema:schema];
+}
+
++ (instancetype)parserWithArgv:(const char *[])argv argc:(int)argc schema:(CLKOptionSchema *)schema sourceOptions:(CLKArgumentSourceOptions)sourceOptions
+{
+    CLKArgumentStream *stream = nil;
+    if (sourceOptions & CLKArgumentSourceReadStandardInput) {
+        stream = [CLKArgumentStream streamWithFileDescriptor:STDIN_FILENO];
+    }
+    
+    BOOL expandResponseFiles = ((sourceOptions & CLKArgumentSourceExpandResponseFiles) != 0);
+    CLKArgumentVector *argumentVector = [CLKArgumentVector vectorWithArgv:argv argc:argc expandingResponseFiles:expandResponseFiles stream:stream];
+    return [[self alloc] _initWithArgumentVector:argumentVector schema:schema];
+}
+
+- (instancetype)_initWithArgumentVector:(CLKArgumentVector *)argumentVector schema:(CLKOptionSchema *)schema
+{
+    CLKHardParameterAssert(argumentVector != nil);
+    CLKHardParameterAssert(schema != nil);
     
     self = [super init];
     if (self != nil) {
         _state = CLKAPStateBegin;
-        _argumentVector = [argv mutableCopy];
-        _options = [options copy];
-        _optionGroups = [groups copy];
-        _optionRegistry = [[CLKOptionRegistry alloc] initWithOptions:options];
+        _argumentVector = argumentVector;
+        _argumentIndex = 0;
+        _flagSetCharacters = _flagSetInlineCharacters;
+        _flagSetLength = 0;
+        _flagSetIndex = 0;
+        _schema = schema;
+        _optionRegistry = schema.optionRegistry;
         _manifest = [[CLKArgumentManifest alloc] initWithOptionRegistry:_optionRegistry];
+        _validator = [[CLKArgumentManifestValidator alloc] initWithManifest:_manifest];
         _parsingIssues = [[NSMutableArray alloc] init];
         _validationIssues = [[NSMutableArray alloc] init];
-        
-        // sanity-check groups
-        for (CLKOptionGroup *group in groups) {
-            for (NSString *optionName in group.allOptions) {
-                CLKHardAssert([_optionRegistry hasOptionNamed:optionName], NSInvalidArgumentException, @"unregistered option '%@' found in option group", optionName);
-            }
+        _optionsWithParsingIssues = calloc(MAX(CLKBitsetWordCount(_optionRegistry.options.count), 1UL), sizeof(uint64_t));
+        _optionSources = @[];
+        _suppliedOptions = calloc(MAX(CLKBitsetWordCount(_optionRegistry.options.count), 1UL), sizeof(uint64_t));
+        _transformerConcurrency = 1;
+        if (CLKParseProfileIsEnabledByEnvironment()) {
+            _counters = CLKParseCountersCreate(_optionRegistry.options.count);
         }
     }
     
     return self;
 }
 
+- (void)dealloc
+{
+    free(_flagSetHeapCharacters);
+    free(_optionsWithParsingIssues);
+    free(_suppliedOptions);
+    free(_reportedConstraints);
+    free(_activeStandaloneConstraints);
+    CLKParseCountersFree(_counters);
+}
+
 - (NSString *)debugDescription
 {
-    return [NSString stringWithFormat:@"%@ { state: %d | argvec: %@ }", super.debugDescription, _state, _argumentVector];
+    NSMutableArray<NSString *> *remainingTokens = [NSMutableArray array];
+    for (NSUInteger i = _flagSetIndex ; i < _flagSetLength ; i++) {
+        [remainingTokens addObject:[NSString stringWithFormat:@"-%C", _flagSetCharacters[i]]];
+    }
+    
+    [remainingTokens addObjectsFromArray:[_argumentVector argumentsFromIndex:_argumentIndex]];
+    return [NSString stringWithFormat:@"%@ { state: %d | argvec: %@ }", super.debugDescription, _state, remainingTokens];
 }
 
 #pragma mark -
 
+- (void)setTransformerConcurrency:(NSUInteger)transformerConcurrency
+{
+    CLKHardAssert((_state == CLKAPStateBegin), NSGenericException, @"cannot change transformer concurrency after parsing has begun");
+    CLKHardParameterAssert(transformerConcurrency > 0);
+    _transformerConcurrency = transformerConcurrency;
+}
+
+- (void)setProfilingEnabled:(BOOL)profilingEnabled
+{
+    CLKHardAssert((_state == CLKAPStateBegin), NSGenericException, @"cannot change profiling after parsing has begun");
+    
+    if (profilingEnabled && _counters == NULL) {
+        _counters = CLKParseCountersCreate(_optionRegistry.options.count);
+    } else if (!profilingEnabled) {
+        CLKParseCountersFree(_counters);
+        _counters = NULL;
+    }
+}
+
+- (BOOL)profilingEnabled
+{
+    return (_counters != NULL);
+}
+
+- (void)setOptionSources:(NSArray<CLKOptionSource *> *)optionSources
+{
+    CLKHardAssert((_state == CLKAPStateBegin), NSGenericException, @"cannot change option sources after parsing has begun");
+    CLKHardParameterAssert(optionSources != nil);
+    _optionSources = [optionSources copy];
+}
+
+- (void)setAbbreviatedOptionNamesEnabled:(BOOL)abbreviatedOptionNamesEnabled
+{
+    CLKHardAssert((_state == CLKAPStateBegin), NSGenericException, @"cannot change abbreviated option names after parsing has begun");
+    _abbreviatedOptionNamesEnabled = abbreviatedOptionNamesEnabled;
+}
+
 - (void)setCurrentParameterOption:(CLKOption *)option
 {
     NSParameterAssert(option == nil || option.type == CLKOptionTypeParameter);
@@ -89,64 +271,282 @@
     return _currentParameterOption;
 }
 
-- (CLKOption *)_optionForOptionNameToken:(NSString *)token issue:(CLKArgumentIssue **)outIssue
+#pragma mark -
+#pragma mark Resetting
+
+- (void)resetWithArgumentVector:(NSArray<NSString *> *)argv
 {
-    NSParameterAssert(token.length > 2);
-    NSParameterAssert(outIssue != nil);
+    CLKHardParameterAssert(argv != nil);
     
-    NSString *name = [token substringFromIndex:2];
-    CLKOption *option = [_optionRegistry optionNamed:name];
-    if (option == nil) {
-        NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '%@'", token];
-        *outIssue = [CLKArgumentIssue issueWithError:error];
-        return nil;
+    if (![_argumentVector resetWithArguments:argv]) {
+        _argumentVector = [CLKArgumentVector vectorWithArguments:argv];
     }
     
-    return option;
+    [self _reset];
 }
 
-- (CLKOption *)_optionForOptionFlagToken:(NSString *)token issue:(CLKArgumentIssue **)outIssue
+- (void)resetWithArgv:(const char *[])argv argc:(int)argc
 {
-    NSParameterAssert(token.length == 2);
-    NSParameterAssert(outIssue != nil);
+    if (![_argumentVector resetWithArgv:argv argc:argc]) {
+        _argumentVector = [CLKArgumentVector vectorWithArgv:argv argc:argc];
+    }
     
-    NSString *flag = [token substringFromIndex:1];
-    CLKOption *option = [_optionRegistry optionForFlag:flag];
-    if (option == nil) {
-        NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '%@'", token];
-        *outIssue = [CLKArgumentIssue issueWithError:error];
-        return nil;
+    [self _reset];
+}
+
+- (void)_resetWithArgumentVector:(CLKArgumentVector *)argumentVector
+{
+    CLKHardParameterAssert(argumentVector != nil);
+    _argumentVector = argumentVector;
+    [self _reset];
+}
+
+- (void)_reset
+{
+    NSUInteger optionWordCount = MAX(CLKBitsetWordCount(_optionRegistry.options.count), 1UL);
+    
+    _state = CLKAPStateBegin;
+    _argumentIndex = 0;
+    _flagSetCharacters = _flagSetInlineCharacters;
+    _flagSetLength = 0;
+    _flagSetIndex = 0;
+    _currentParameterOption = nil;
+    [_manifest reset];
+    [_parsingIssues removeAllObjects];
+    [_validationIssues removeAllObjects];
+    memset(_optionsWithParsingIssues, 0, (optionWordCount * sizeof(uint64_t)));
+    memset(_suppliedOptions, 0, (optionWordCount * sizeof(uint64_t)));
+    
+    _producesEvents = NO;
+    _eventsFinished = NO;
+    [_pendingEvents removeAllObjects];
+    if (_reportedConstraints != NULL) {
+        NSUInteger constraintWordCount = MAX(CLKBitsetWordCount(_schema.constraintProgram.instructionCount), 1UL);
+        memset(_reportedConstraints, 0, (constraintWordCount * sizeof(uint64_t)));
+        memset(_activeStandaloneConstraints, 0, (constraintWordCount * sizeof(uint64_t)));
+        _activeStandaloneIndexes.length = 0;
+    }
+    
+    // only left behind by a parse that was abandoned by an exception
+    [_deferredArguments removeAllObjects];
+    [_deferredOptions removeAllObjects];
+    _deferredIssueIndexes.length = 0;
+    
+    if (_counters != NULL) {
+        CLKParseCountersReset(_counters);
+    }
+    
+    _profile = nil;
+}
+
+#pragma mark -
+#pragma mark Reading Tokens
+
+- (BOOL)_hasNextToken
+{
+    return (_flagSetIndex < _flagSetLength || [_argumentVector hasArgumentAtIndex:_argumentIndex]);
+}
+
+- (CLKTokenAnalysis)_analyzeNextToken
+{
+    NSAssert([self _hasNextToken], @"no tokens remaining");
+    
+    // flags from an exploded flag set are read as `-x`, ahead of the rest of the argument vector
+    if (_flagSetIndex < _flagSetLength) {
+        return (CLKTokenAnalysis){ .form = CLKTokenFormOptionFlag, .optionRange = NSMakeRange(1, 1), .argumentRange = NSMakeRange(NSNotFound, 0) };
+    }
+    
+    // classified without materializing the token when the vector is backed by argv
+    return [_argumentVector analysisOfArgumentAtIndex:_argumentIndex];
+}
+
+- (NSString *)_popNextToken
+{
+    NSAssert([self _hasNextToken], @"no tokens remaining");
+    
+    if (_flagSetIndex < _flagSetLength) {
+        NSString *token = [[NSString alloc] initWithFormat:@"-%C", _flagSetCharacters[_flagSetIndex]];
+        [self _skipNextToken];
+        return token;
+    }
+    
+    NSString *token = [_argumentVector argumentAtIndex:_argumentIndex];
+    _argumentIndex++;
+    return token;
+}
+
+- (void)_skipNextToken
+{
+    NSAssert([self _hasNextToken], @"no tokens remaining");
+    
+    if (_flagSetIndex < _flagSetLength) {
+        _flagSetIndex++;
+        if (_flagSetIndex == _flagSetLength) {
+            _flagSetCharacters = _flagSetInlineCharacters;
+            _flagSetLength = 0;
+            _flagSetIndex = 0;
+        }
+        
+        return;
+    }
+    
+    _argumentIndex++;
+}
+
+- (NSString *)_popNextTokenOptionSegment
+{
+    NSAssert((_tokenAnalysis.optionRange.location != NSNotFound), @"popping the option segment of a token without one");
+    
+    if (_flagSetIndex < _flagSetLength) {
+        return [self _popNextToken];
+    }
+    
+    NSString *segment = [_argumentVector substringWithRange:NSMakeRange(0, NSMaxRange(_tokenAnalysis.optionRange)) ofArgumentAtIndex:_argumentIndex];
+    _argumentIndex++;
+    return segment;
+}
+
+#pragma mark -
+
+- (CLKOption *)_optionForNextToken
+{
+    CLKTokenForm form = _tokenAnalysis.form;
+    NSRange optionRange = _tokenAnalysis.optionRange;
+    
+    if (form == CLKTokenFormOptionFlag || form == CLKTokenFormParameterOptionFlagAssignment) {
+        NSAssert((optionRange.length == 1), @"unexpected option flag length %lu", (unsigned long)optionRange.length);
+        unichar flag;
+        if (_flagSetIndex < _flagSetLength) {
+            flag = _flagSetCharacters[_flagSetIndex];
+        } else {
+            [_argumentVector getCharacters:&flag range:optionRange ofArgumentAtIndex:_argumentIndex];
+        }
+        
+        return [_optionRegistry optionForFlagCharacter:flag];
+    }
+    
+    NSAssert((form == CLKTokenFormOptionName || form == CLKTokenFormParameterOptionNameAssignment), @"looking up an option for a token of form %d", form);
+    NSAssert((_flagSetIndex == _flagSetLength), @"looking up an option name while synthesized flags are pending");
+    
+    unichar stackBuffer[CLKOptionNameStackBufferLength];
+    unichar *characters = stackBuffer;
+    if (optionRange.length > CLKOptionNameStackBufferLength) {
+        characters = malloc(optionRange.length * sizeof(unichar));
+    }
+    
+    [_argumentVector getCharacters:characters range:optionRange ofArgumentAtIndex:_argumentIndex];
+    CLKOption *option;
+    if (_abbreviatedOptionNamesEnabled) {
+        option = [_optionRegistry optionNamedWithPrefixCharacters:characters length:optionRange.length];
+    } else {
+        option = [_optionRegistry optionNamedWithCharacters:characters length:optionRange.length];
+    }
+    
+    if (characters != stackBuffer) {
+        free(characters);
     }
     
     return option;
 }
 
+- (void)_popUnrecognizedOption
+{
+    // names are offered the closest option names; there are too few flags for a misspelled one to say much
+    BOOL named = ((_tokenAnalysis.form == CLKTokenFormOptionName || _tokenAnalysis.form == CLKTokenFormParameterOptionNameAssignment) && _flagSetIndex == _flagSetLength);
+    NSRange nameRange = _tokenAnalysis.optionRange;
+    NSString *optionSegment = [self _popNextTokenOptionSegment];
+    
+    NSMutableArray<NSString *> *suggestions = nil;
+    if (named) {
+        NSString *name = [optionSegment substringFromIndex:nameRange.location];
+        if (_abbreviatedOptionNamesEnabled) {
+            // a name that didn't resolve as an abbreviation begins either several option names or none.
+            // a short prefix can begin most of a large registry's names, so only a few are named.
+            NSArray<CLKOption *> *options = _optionRegistry.options;
+            NSMutableArray<NSString *> *candidates = [NSMutableArray arrayWithCapacity:CLKSuggestionLimit];
+            __block NSUInteger candidateCount = 0;
+            [_optionRegistry.nameTrie enumerateIndexesOfStringsWithPrefix:name usingBlock:^(NSUInteger idx, __unused BOOL *outStop) {
+                if (candidateCount < CLKSuggestionLimit) {
+                    [candidates addObject:[@"--" stringByAppendingString:options[idx].name]];
+                }
+                
+                candidateCount++;
+            }];
+            
+            if (candidateCount > 1) {
+                NSUInteger omittedCount = (candidateCount - candidates.count);
+                CLKArgumentIssue *issue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL description:@"ambiguous option: '%@'" argument:optionSegment suggestions:candidates omittedSuggestionCount:omittedCount];
+                [self _accumulateParsingIssue:issue];
+                return;
+            }
+        }
+        
+        for (NSString *suggestion in [_optionRegistry.nameSuggestionIndex suggestionsForString:name]) {
+            if (suggestions == nil) {
+                suggestions = [NSMutableArray arrayWithCapacity:CLKSuggestionLimit];
+            }
+            
+            [suggestions addObject:[@"--" stringByAppendingString:suggestion]];
+        }
+    }
+    
+    CLKArgumentIssue *issue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL description:@"unrecognized option: '%@'" argument:optionSegment suggestions:suggestions];
+    [self _accumulateParsingIssue:issue];
+}
+
 #pragma mark -
 #pragma mark Errors
 
 - (NSArray<NSError *> *)errors
 {
-    NSMutableArray<NSError *> *errors = [NSMutableArray array];
+    NSArray<CLKArgumentIssue *> *issues = self.issues;
+    if (issues == nil) {
+        return nil;
+    }
     
-    for (CLKArgumentIssue *issue in _parsingIssues) {
+    // this is where the errors' descriptions are formatted
+    NSMutableArray<NSError *> *errors = [[NSMutableArray alloc] initWithCapacity:issues.count];
+    for (CLKArgumentIssue *issue in issues) {
         [errors addObject:issue.error];
     }
     
-    for (CLKArgumentIssue *issue in _validationIssues) {
-        [errors addObject:issue.error];
+    return errors;
+}
+
+- (NSArray<CLKArgumentIssue *> *)issues
+{
+    if (![self _hasIssues]) {
+        return nil;
     }
     
-    return (errors.count > 0 ? errors : nil);
+    return [_parsingIssues arrayByAddingObjectsFromArray:_validationIssues];
+}
+
+- (BOOL)_hasIssues
+{
+    return (_parsingIssues.count > 0 || _validationIssues.count > 0);
 }
 
 - (void)_accumulateParsingIssue:(CLKArgumentIssue *)issue
 {
-    [_parsingIssues addObject:issue];
+    for (NSString *optionName in issue.salientOptions) {
+        [self _noteParsingIssueForOptionNamed:optionName];
+    }
+    
+    if (_producesEvents) {
+        [self _enqueueEvent:[CLKArgumentEvent issueEventWithError:issue.error]];
+    } else {
+        [_parsingIssues addObject:issue];
+    }
 }
 
 - (void)_accumulateValidationIssue:(CLKArgumentIssue *)issue
 {
-    [_validationIssues addObject:issue];
+    if (_producesEvents) {
+        [self _enqueueEvent:[CLKArgumentEvent issueEventWithError:issue.error]];
+    } else {
+        [_validationIssues addObject:issue];
+    }
 }
 
 - (BOOL)_shouldAccumulateValidationIssue:(CLKArgumentIssue *)issue
@@ -157,7 +557,7 @@
     // in this event, both a parsing error and a validation error are generated. displaying both errors is confusing.
     // the solution is to display *just* the parsing error; we don't want to display both a parsing error *and* an
     // "option not provided" error if we know the user *did* supply the option at least once.
-    if (issue.error.code == CLKErrorRequiredOptionNotProvided && [issue.error.domain isEqualToString:CLKErrorDomain]) {
+    if (issue.code == CLKErrorRequiredOptionNotProvided && [issue.domain isEqualToString:CLKErrorDomain]) {
         NSAssert(issue.salientOptions.count > 0, @"salient options missing");
         for (NSString *optionName in issue.salientOptions) {
             if ([self _hasParsingIssueForOptionNamed:optionName]) {
@@ -169,15 +569,177 @@
     return YES;
 }
 
+- (void)_noteParsingIssueForOptionNamed:(NSString *)optionName
+{
+    NSUInteger optionIndex = [_optionRegistry indexOfOptionNamed:optionName];
+    if (optionIndex != NSNotFound) {
+        CLKBitsetSet(_optionsWithParsingIssues, optionIndex);
+    }
+}
+
 - (BOOL)_hasParsingIssueForOptionNamed:(NSString *)optionName
 {
-    for (CLKArgumentIssue *issue in _parsingIssues) {
-        if ([issue.salientOptions containsObject:optionName]) {
-            return YES;
+    NSUInteger optionIndex = [_optionRegistry indexOfOptionNamed:optionName];
+    return (optionIndex != NSNotFound && CLKBitsetTest(_optionsWithParsingIssues, optionIndex));
+}
+
+#pragma mark -
+#pragma mark Results
+
+- (void)_accumulateSwitchOption:(CLKOption *)option
+{
+    [_manifest accumulateSwitchOptionNamed:option.name];
+    if (_producesEvents) {
+        [self _enqueueEvent:[CLKArgumentEvent switchOptionEventWithOption:option]];
+        [self _validateMonotonicConstraintsForOption:option];
+    }
+}
+
+- (void)_accumulateArgument:(id)argument forParameterOption:(CLKOption *)option
+{
+    if (_producesEvents) {
+        [_manifest accumulateOccurrenceOfParameterOptionNamed:option.name];
+        [self _enqueueEvent:[CLKArgumentEvent parameterOptionEventWithOption:option argument:argument]];
+        [self _validateMonotonicConstraintsForOption:option];
+    } else {
+        [_manifest accumulateArgument:argument forParameterOptionNamed:option.name];
+    }
+}
+
+- (void)_accumulatePositionalArgument:(NSString *)argument
+{
+    if (_producesEvents) {
+        [self _enqueueEvent:[CLKArgumentEvent positionalArgumentEventWithArgument:argument]];
+    } else {
+        [_manifest accumulatePositionalArgument:argument];
+    }
+}
+
+#pragma mark -
+#pragma mark Events
+
+- (CLKArgumentEvent *)nextEvent
+{
+    CLKHardAssert((_producesEvents || _state == CLKAPStateBegin), NSGenericException, @"cannot pull events from a parser after use");
+    
+    // kept across resets (see -_reset)
+    if (!_producesEvents) {
+        _producesEvents = YES;
+        if (_pendingEvents == nil) {
+            _pendingEvents = [[NSMutableArray alloc] init];
+            NSUInteger constraintWordCount = MAX(CLKBitsetWordCount(_schema.constraintProgram.instructionCount), 1UL);
+            _reportedConstraints = calloc(constraintWordCount, sizeof(uint64_t));
+            _activeStandaloneConstraints = calloc(constraintWordCount, sizeof(uint64_t));
+            _activeStandaloneIndexes = [[NSMutableData alloc] init];
+        }
+    }
+    
+    CLKParseProfileMark mark = { 0, 0 };
+    if (_counters != NULL) {
+        mark = CLKParseProfileMarkNow(_counters);
+    }
+    
+    // each state consumes at most one token, so only a handful of events are ever pending
+    while (_pendingEvents.count == 0 && !_eventsFinished) {
+        if (_state == CLKAPStateEnd) {
+            [self _finishEvents];
+            _eventsFinished = YES;
+        } else {
+            _state = (_counters != NULL ? [self _performCurrentStateRecordingProfile] : [self _performCurrentState]);
         }
     }
     
-    return NO;
+    CLKArgumentEvent *event = _pendingEvents.firstObject;
+    if (event != nil) {
+        [_pendingEvents removeObjectAtIndex:0];
+    }
+    
+    if (_counters != NULL && _profile == nil) {
+        CLKParseProfileCounterAdd(&_counters->total, mark);
+        if (event == nil) {
+            [self _finishProfile];
+        }
+    }
+    
+    return event;
+}
+
+- (void)_enqueueEvent:(CLKArgumentEvent *)event
+{
+    NSAssert(_producesEvents, @"enqueuing an event outside of event mode");
+    [_pendingEvents addObject:event];
+}
+
+- (void)_validateMonotonicConstraintsForOption:(CLKOption *)option
+{
+    // a violated monotonic constraint can't be satisfied by options that come later,
+    // so it is reported as soon as it happens, and only once
+    CLKConstraintProgram *program = _schema.constraintProgram;
+    NSUInteger optionIndex = [_optionRegistry indexOfOptionNamed:option.name];
+    void (^issueHandler)(CLKArgumentIssue *) = ^(CLKArgumentIssue *issue) {
+        [self _handleValidationIssue:issue];
+    };
+    
+    // only the constraints the option is involved in can have changed
+    NSUInteger count;
+    const uint32_t *instructionIndexes = [program monotonicInstructionIndexesForOption:optionIndex count:&count];
+    for (NSUInteger i = 0 ; i < count ; i++) {
+        NSUInteger instructionIndex = instructionIndexes[i];
+        if (CLKBitsetTest(_reportedConstraints, instructionIndex)) {
+            continue;
+        }
+        
+        if (![self _validateInstructionAtIndex:instructionIndex ofProgram:program validator:_validator issueHandler:issueHandler]) {
+            CLKBitsetSet(_reportedConstraints, instructionIndex);
+            continue;
+        }
+        
+        const CLKConstraintInstruction *instruction = [program instructionAtIndex:instructionIndex];
+        if (instruction->type == CLKConstraintTypeStandalone && instruction->significantOption == optionIndex && !CLKBitsetTest(_activeStandaloneConstraints, instructionIndex)) {
+            CLKBitsetSet(_activeStandaloneConstraints, instructionIndex);
+            [_activeStandaloneIndexes appendBytes:&instructionIndex length:sizeof(instructionIndex)];
+        }
+    }
+    
+    // ...except for standalone constraints, which any option can break once their significant option is present
+    const NSUInteger *activeIndexes = _activeStandaloneIndexes.bytes;
+    NSUInteger activeCount = (_activeStandaloneIndexes.length / sizeof(NSUInteger));
+    for (NSUInteger i = 0 ; i < activeCount ; i++) {
+        NSUInteger instructionIndex = activeIndexes[i];
+        const CLKConstraintInstruction *instruction = [program instructionAtIndex:instructionIndex];
+        if (CLKBitsetTest(_reportedConstraints, instructionIndex) || instruction->significantOption == optionIndex || instruction->predicatingOption == optionIndex) {
+            continue; // already reported, or checked above
+        }
+        
+        if (![self _validateInstructionAtIndex:instructionIndex ofProgram:program validator:_validator issueHandler:issueHandler]) {
+            CLKBitsetSet(_reportedConstraints, instructionIndex);
+        }
+    }
+}
+
+- (void)_finishEvents
+{
+    NSAssert((_state == CLKAPStateEnd), @"finishing events before the end of the argument vector");
+    
+    // see -parseArguments
+    if (_argumentVector.error != nil) {
+        [self _accumulateParsingIssue:[CLKArgumentIssue issueWithError:_argumentVector.error]];
+        return;
+    }
+    
+    [self _mergeOptionSources];
+    
+    // everything else depends on which options were absent, which is only known now
+    CLKConstraintProgram *program = _schema.constraintProgram;
+    for (NSUInteger i = 0 ; i < program.instructionCount ; i++) {
+        if (CLKConstraintTypeIsMonotonic([program instructionAtIndex:i]->type)) {
+            continue;
+        }
+        
+        [self _validateInstructionAtIndex:i ofProgram:program validator:_validator issueHandler:^(CLKArgumentIssue *issue) {
+            [self _handleValidationIssue:issue];
+        }];
+    }
 }
 
 #pragma mark -
@@ -185,74 +747,109 @@
 
 - (CLKArgumentManifest *)parseArguments
 {
-    CLKHardAssert((_state == CLKAPStateBegin), NSGenericException, @"cannot re-run a parser after use");
+    CLKHardAssert((_state == CLKAPStateBegin), NSGenericException, @"cannot re-run a parser after use without resetting it");
     
+    if (_counters == NULL) {
+        return [self _parseArguments];
+    }
+    
+    CLKParseProfileMark mark = CLKParseProfileMarkNow(_counters);
+    CLKArgumentManifest *manifest = [self _parseArguments];
+    CLKParseProfileCounterAdd(&_counters->total, mark);
+    [self _finishProfile];
+    return manifest;
+}
+
+- (CLKArgumentManifest *)_parseArguments
+{
     while (_state != CLKAPStateEnd) {
         @autoreleasepool {
-            switch (_state) {
-                case CLKAPStateBegin:
-                    _state = CLKAPStateReadNextArgumentToken;
-                    break;
-                
-                case CLKAPStateReadNextArgumentToken:
-                    _state = [self _readNextArgumentToken];
-                    break;
-                
-                case CLKAPStateParseOptionName:
-                    _state = [self _parseOptionName];
-                    break;
-                
-                case CLKAPStateParseOptionFlag:
-                    _state = [self _parseOptionFlag];
-                    break;
-                
-                case CLKAPStateParseOptionFlagSet:
-                    _state = [self _parseOptionFlagSet];
-                    break;
-                
-                case CLKAPStateParseParameterOptionNameAssignment:
-                    _state = [self _parseOptionNameAssignment];
-                    break;
-                
-                case CLKAPStateParseParameterOptionFlagAssignment:
-                    _state = [self _parseOptionFlagAssignment];
-                    break;
-                
-                case CLKAPStateParseArgument:
-                    _state = [self _parseArgument];
-                    break;
-                
-                case CLKAPStateParseRemainderArguments:
-                    _state = [self _parseRemainderArguments];
-                    break;
-                
-                case CLKAPStateEnd:
-                    break;
-            }
+            _state = (_counters != NULL ? [self _performCurrentStateRecordingProfile] : [self _performCurrentState]);
         }
     };
     
+    // an argument source that failed (an unreadable response file, a read error on stdin)
+    // leaves the manifest incomplete, so validating it would only add misleading errors
+    if (_argumentVector.error != nil) {
+        [self _accumulateParsingIssue:[CLKArgumentIssue issueWithError:_argumentVector.error]];
+        return nil;
+    }
+    
+    [self _mergeOptionSources];
+    [self _performDeferredTransformations];
+    [_manifest groupAccumulatedArguments];
+    
     if (![self _validateManifest]) {
-        NSAssert((self.errors.count > 0), @"expected one or more errors on validation failure");
+        NSAssert([self _hasIssues], @"expected one or more issues on validation failure");
     }
     
-    if (self.errors.count > 0) {
-        _manifest = nil;
+    // the manifest is kept for the next run even when it isn't returned
+    if ([self _hasIssues]) {
         return nil;
     }
     
     return _manifest;
 }
 
+- (CLKAPState)_performCurrentState
+{
+    switch (_state) {
+        case CLKAPStateBegin:
+            return CLKAPStateReadNextArgumentToken;
+        
+        case CLKAPStateReadNextArgumentToken:
+            return [self _readNextArgumentToken];
+        
+        case CLKAPStateParseOptionName:
+            return [self _parseOptionName];
+        
+        case CLKAPStateParseOptionFlag:
+            return [self _parseOptionFlag];
+        
+        case CLKAPStateParseOptionFlagSet:
+            return [self _parseOptionFlagSet];
+        
+        case CLKAPStateParseParameterOptionNameAssignment:
+            return [self _parseOptionNameAssignment];
+        
+        case CLKAPStateParseParameterOptionFlagAssignment:
+            return [self _parseOptionFlagAssignment];
+        
+        case CLKAPStateParseArgument:
+            return [self _parseArgument];
+        
+        case CLKAPStateParseOptionParsingSentinel:
+            return [self _parseOptionParsingSentinel];
+        
+        case CLKAPStateParseRemainderArguments:
+            return [self _parseRemainderArguments];
+        
+        case CLKAPStateEnd:
+            return CLKAPStateEnd;
+    }
+}
+
+- (CLKAPState)_performCurrentStateRecordingProfile
+{
+    NSAssert((_counters != NULL), @"recording a profile without counters");
+    
+    CLKAPState state = _state;
+    CLKParseProfileMark mark = CLKParseProfileMarkNow(_counters);
+    CLKAPState nextState = [self _performCurrentState];
+    CLKParseProfileCounterAdd(&_counters->states[state], mark);
+    return nextState;
+}
+
 - (CLKAPState)_readNextArgumentToken
 {
     // if we're reached the end of the argument vector, we've parsed everything
-    if (_argumentVector.count == 0) {
+    if (![self _hasNextToken]) {
         return CLKAPStateEnd;
     }
     
-    NSString *nextToken = _argumentVector.firstObject;
-    switch (CLKTokenFormForToken(nextToken)) {
+    _tokenAnalysis = [self _analyzeNextToken];
+    CLKParseCountersNoteTokenForm(_counters, _tokenAnalysis.form);
+    switch (_tokenAnalysis.form) {
         case CLKTokenFormOptionName: {
             return CLKAPStateParseOptionName;
         }
@@ -274,7 +871,7 @@
         }
         
         case CLKTokenFormOptionParsingSentinel: {
-            return CLKAPStateParseRemainderArguments;
+            return CLKAPStateParseOptionParsingSentinel;
         }
         
         case CLKTokenFormArgument: {
@@ -282,9 +879,8 @@
         }
         
         case CLKTokenFormMalformedOption: {
-            [_argumentVector removeObjectAtIndex:0];
-            NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"unexpected token in argument vector: '%@'", nextToken];
-            CLKArgumentIssue *issue = [CLKArgumentIssue issueWithError:error];
+            NSString *nextToken = [self _popNextToken];
+            CLKArgumentIssue *issue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL salientOption:nil description:@"unexpected token in argument vector: '%@'" argument:nextToken];
             [self _accumulateParsingIssue:issue];
             return CLKAPStateReadNextArgumentToken;
         }
@@ -293,143 +889,116 @@
 
 - (CLKAPState)_parseOptionName
 {
-    NSAssert((_argumentVector.count > 0), @"empty argument vector");
-    NSString *rawArgument = [_argumentVector clk_popFirstObject];
-    NSAssert((rawArgument.length > 2 && [rawArgument hasPrefix:@"--"]), @"encountered '%@' when attempting to parse an option name", rawArgument);
+    NSAssert((_tokenAnalysis.form == CLKTokenFormOptionName), @"encountered a token of form %d when attempting to parse an option name", _tokenAnalysis.form);
     
-    CLKArgumentIssue *issue;
-    CLKOption *option = [self _optionForOptionNameToken:rawArgument issue:&issue];
+    CLKOption *option = [self _optionForNextToken];
     if (option == nil) {
-        [self _accumulateParsingIssue:issue];
+        [self _popUnrecognizedOption];
         return CLKAPStateReadNextArgumentToken;
     }
     
-    return [self _handleParsedOption:option userInvocation:rawArgument];
+    [self _skipNextToken];
+    return [self _handleParsedOption:option invokedByFlag:NO];
 }
 
 - (CLKAPState)_parseOptionFlagSet
 {
-    NSAssert((_argumentVector.count > 0), @"empty argument vector");
-    
     // simple trick to implement option flag sets:
     //
-    //    1. explode the group into individual flags
-    //    2. add the flags to the front of argv
+    //    1. copy the flags out of the set's token
+    //    2. read them as individual flags ahead of the rest of argv
     //    3. let normal option flag parsing take care of them
     //
+    // the flags are read in place, so the argument vector stays immutable and a flag set
+    // costs nothing per flag. flags are only turned into strings to report issues.
     
-    NSString *token = [_argumentVector clk_popFirstObject];
-    NSAssert(token.length > 1, @"invalid option flag set token length");
-    NSAssert([token characterAtIndex:0] == '-' && [token characterAtIndex:1] != '-', @"encountered '%@' when attempting to parse an option flag set", token);
-    
-    NSUInteger len = token.length - 1;
-    unichar flags[len];
-    [token getCharacters:flags range:NSMakeRange(1, len)];
+    NSAssert((_flagSetIndex == _flagSetLength), @"encountered flag set while synthesized flags are pending");
+    NSAssert((_tokenAnalysis.form == CLKTokenFormOptionFlagSet), @"encountered a token of form %d when attempting to parse an option flag set", _tokenAnalysis.form);
     
-    // reverse enumeration preserves order when inserted at index 0 in _argumentVector
-    NSUInteger ri = len;
-    for (NSUInteger i = 0 ; i < len ; i++) {
-        ri--;
-        unichar f = flags[ri];
-        NSString *synthSwitch = [[NSString alloc] initWithFormat:@"-%C", f];
-        [_argumentVector insertObject:synthSwitch atIndex:0];
+    NSRange flagRange = _tokenAnalysis.optionRange;
+    NSAssert(flagRange.length > 1, @"invalid option flag set length");
+    if (flagRange.length > CLKFlagSetInlineLength) {
+        if (flagRange.length > _flagSetHeapCapacity) {
+            _flagSetHeapCharacters = realloc(_flagSetHeapCharacters, (flagRange.length * sizeof(unichar)));
+            _flagSetHeapCapacity = flagRange.length;
+        }
+        
+        _flagSetCharacters = _flagSetHeapCharacters;
     }
     
+    [_argumentVector getCharacters:_flagSetCharacters range:flagRange ofArgumentAtIndex:_argumentIndex];
+    _flagSetLength = flagRange.length;
+    _flagSetIndex = 0;
+    _argumentIndex++;
     return CLKAPStateReadNextArgumentToken;
 }
 
 - (CLKAPState)_parseOptionFlag
 {
-    NSAssert((_argumentVector.count > 0), @"empty argument vector");
-    NSString *token = [_argumentVector clk_popFirstObject];
-    NSAssert((token.length == 2 && [token characterAtIndex:0] == '-'), @"encountered '%@' when attempting to parse an option flag", token);
+    NSAssert((_tokenAnalysis.form == CLKTokenFormOptionFlag), @"encountered a token of form %d when attempting to parse an option flag", _tokenAnalysis.form);
     
-    CLKArgumentIssue *issue;
-    CLKOption *option = [self _optionForOptionFlagToken:token issue:&issue];
+    CLKOption *option = [self _optionForNextToken];
     if (option == nil) {
-        [self _accumulateParsingIssue:issue];
+        [self _popUnrecognizedOption];
         return CLKAPStateReadNextArgumentToken;
     }
     
-    return [self _handleParsedOption:option userInvocation:token];
+    [self _skipNextToken];
+    return [self _handleParsedOption:option invokedByFlag:YES];
 }
 
 - (CLKAPState)_parseOptionNameAssignment
 {
-    NSAssert((_argumentVector.count > 0), @"empty argument vector");
-    NSString *rawArgument = [_argumentVector clk_popFirstObject];
-    NSAssert((rawArgument.length > 3 && [rawArgument hasPrefix:@"--"]), @"encountered '%@' when attempting to parse a parameter option name assignment token", rawArgument);
-    
-    NSUInteger split = [rawArgument rangeOfCharacterFromSet:NSCharacterSet.clk_parameterOptionAssignmentCharacterSet].location;
-    NSAssert((split != NSNotFound), @"expected assignment character in token '%@'", rawArgument);
-    NSAssert((split != 2), @"unexpected assignment character at index 2 in token '%@'", rawArgument);
-    NSRange optionTokenRange = NSMakeRange(0, split);
-    NSRange argumentRange = NSMakeRange((split + 1), (rawArgument.length - split - 1));
-    NSString *optionNameSegment = [rawArgument substringWithRange:optionTokenRange];
-    NSAssert((optionNameSegment.length > 0), @"expected option name segment");
-    NSString *argumentSegment = [rawArgument substringWithRange:argumentRange];
-    
-    CLKArgumentIssue *optionLookupIssue;
-    CLKOption *option = [self _optionForOptionNameToken:optionNameSegment issue:&optionLookupIssue];
-    if (option == nil) {
-        [self _accumulateParsingIssue:optionLookupIssue];
-        return CLKAPStateReadNextArgumentToken;
-    }
-    
-    if (argumentSegment.length == 0) {
-        NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"expected argument for option '%@'", optionNameSegment];
-        CLKArgumentIssue *issue = [CLKArgumentIssue issueWithError:error salientOption:option.name];
-        [self _accumulateParsingIssue:issue];
-        return CLKAPStateReadNextArgumentToken;
-    }
-    
-    CLKArgumentIssue *processingIssue;
-    if (![self _processAssignedArgument:argumentSegment forParameterOption:option userInvocation:optionNameSegment issue:&processingIssue]) {
-        [self _accumulateParsingIssue:processingIssue];
-        return CLKAPStateReadNextArgumentToken;
-    }
-    
-    return CLKAPStateReadNextArgumentToken;
+    NSAssert((_tokenAnalysis.form == CLKTokenFormParameterOptionNameAssignment), @"encountered a token of form %d when attempting to parse a parameter option name assignment token", _tokenAnalysis.form);
+    return [self _parseOptionAssignment];
 }
 
 - (CLKAPState)_parseOptionFlagAssignment
 {
-    NSAssert((_argumentVector.count > 0), @"empty argument vector");
-    NSString *rawArgument = [_argumentVector clk_popFirstObject];
-    NSAssert((rawArgument.length > 2 && [rawArgument hasPrefix:@"-"]), @"encountered '%@' when attempting to parse a parameter option flag assignment token", rawArgument);
-    NSAssert([NSCharacterSet.clk_parameterOptionAssignmentCharacterSet characterIsMember:[rawArgument characterAtIndex:2]], @"expected assignment character at index 2 in token '%@'", rawArgument);
-    
-    NSString *flagSegment = [rawArgument substringToIndex:2];
-    NSString *argumentSegment = [rawArgument substringFromIndex:3];
-    
-    CLKArgumentIssue *optionLookupIssue;
-    CLKOption *option = [self _optionForOptionFlagToken:flagSegment issue:&optionLookupIssue];
+    NSAssert((_tokenAnalysis.form == CLKTokenFormParameterOptionFlagAssignment), @"encountered a token of form %d when attempting to parse a parameter option flag assignment token", _tokenAnalysis.form);
+    return [self _parseOptionAssignment];
+}
+
+- (CLKAPState)_parseOptionAssignment
+{
+    // the token is sliced in place. of its segments, only the argument is ever created,
+    // unless there is an issue to report.
+    CLKOption *option = [self _optionForNextToken];
     if (option == nil) {
-        [self _accumulateParsingIssue:optionLookupIssue];
+        [self _popUnrecognizedOption];
         return CLKAPStateReadNextArgumentToken;
     }
     
-    if (argumentSegment.length == 0) {
-        NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"expected argument for option '%@'", flagSegment];
-        CLKArgumentIssue *issue = [CLKArgumentIssue issueWithError:error salientOption:option.name];
+    [self _noteSuppliedOption:option];
+    
+    if (_tokenAnalysis.argumentRange.length == 0) {
+        NSString *optionSegment = [self _popNextTokenOptionSegment];
+        CLKArgumentIssue *issue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL salientOption:option.name description:@"expected argument for option '%@'" argument:optionSegment];
         [self _accumulateParsingIssue:issue];
         return CLKAPStateReadNextArgumentToken;
     }
     
-    CLKArgumentIssue *processingIssue;
-    if (![self _processAssignedArgument:argumentSegment forParameterOption:option userInvocation:flagSegment issue:&processingIssue]) {
-        [self _accumulateParsingIssue:processingIssue];
+    if (option.type != CLKOptionTypeParameter) {
+        NSString *optionSegment = [self _popNextTokenOptionSegment];
+        CLKArgumentIssue *issue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL salientOption:option.name description:@"option '%@' does not accept arguments" argument:optionSegment];
+        [self _accumulateParsingIssue:issue];
         return CLKAPStateReadNextArgumentToken;
     }
     
+    NSString *argument = [_argumentVector substringWithRange:_tokenAnalysis.argumentRange ofArgumentAtIndex:_argumentIndex];
+    [self _skipNextToken];
+    
+    CLKArgumentIssue *issue;
+    if (![self _processArgument:argument forParameterOption:option issue:&issue]) {
+        [self _accumulateParsingIssue:issue];
+    }
+    
     return CLKAPStateReadNextArgumentToken;
 }
 
 - (CLKAPState)_parseArgument
 {
-    NSAssert((_argumentVector.count > 0), @"empty argument vector");
-    
-    NSString *argument = [_argumentVector clk_popFirstObject];
+    NSString *argument = [self _popNextToken];
     CLKArgumentIssue *issue;
     if (![self _processArgument:argument issue:&issue]) {
         [self _accumulateParsingIssue:issue];
@@ -438,58 +1007,71 @@
     return CLKAPStateReadNextArgumentToken;
 }
 
-- (CLKAPState)_parseRemainderArguments
+- (CLKAPState)_parseOptionParsingSentinel
 {
-    NSAssert([_argumentVector.firstObject isEqualToString:@"--"], @"expected sentinel at index 0 of argument vector");
+    NSAssert((_tokenAnalysis.form == CLKTokenFormOptionParsingSentinel), @"expected sentinel at head of argument vector");
+    [self _skipNextToken]; // discard sentinel
     
-    [_argumentVector removeObjectAtIndex:0]; // discard sentinel
-    
-    if (self.currentParameterOption != nil && _argumentVector.count == 0) {
+    if (_currentParameterOption != nil && ![self _hasNextToken]) {
         // a parameter option was supplied prior to the sentinel but no argument was supplied on the other side
-        NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"expected option argument following sentinel"];
-        CLKArgumentIssue *issue = [CLKArgumentIssue issueWithError:error salientOption:self.currentParameterOption.name];
+        CLKArgumentIssue *issue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL salientOption:_currentParameterOption.name description:@"expected option argument following sentinel" argument:nil];
         [self _accumulateParsingIssue:issue];
         return CLKAPStateEnd;
     }
     
-    while (_argumentVector.count > 0) {
-        // if we were handling a parameter option when we encountered the sentinel,
-        // the first argument after the sentinel will be collected as an argument
-        // for that option.
-        NSString *argument = [_argumentVector clk_popFirstObject];
-        CLKArgumentIssue *issue;
-        if (![self _processArgument:argument issue:&issue]) {
-            [self _accumulateParsingIssue:issue];
-        }
+    return CLKAPStateParseRemainderArguments;
+}
+
+- (CLKAPState)_parseRemainderArguments
+{
+    // one argument per pass, so an event-driven parse never holds more than one of them
+    if (![self _hasNextToken]) {
+        return CLKAPStateEnd;
+    }
+    
+    // if we were handling a parameter option when we encountered the sentinel,
+    // the first argument after the sentinel will be collected as an argument
+    // for that option.
+    NSString *argument = [self _popNextToken];
+    CLKParseCountersNoteTokenForm(_counters, CLKTokenFormArgument); // remainder arguments aren't analyzed
+    CLKArgumentIssue *issue;
+    if (![self _processArgument:argument issue:&issue]) {
+        [self _accumulateParsingIssue:issue];
     }
     
-    return CLKAPStateEnd;
+    return CLKAPStateParseRemainderArguments;
 }
 
-- (CLKAPState)_handleParsedOption:(CLKOption *)option userInvocation:(NSString *)userInvocation
+- (CLKAPState)_handleParsedOption:(CLKOption *)option invokedByFlag:(BOOL)invokedByFlag
 {
-    NSAssert(self.currentParameterOption == nil, @"currentParameterOption unexpectedly set");
+    NSAssert(_currentParameterOption == nil, @"currentParameterOption unexpectedly set");
+    
+    [self _noteSuppliedOption:option];
     
     if (option.type == CLKOptionTypeParameter) {
         // if the argument vector is empty at this point, we have encountered a parameter option at the end of the vector
-        if (_argumentVector.count == 0) {
-            NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"expected argument for option '%@'", userInvocation];
-            CLKArgumentIssue *issue = [CLKArgumentIssue issueWithError:error salientOption:option.name];
+        if (![self _hasNextToken]) {
+            NSString *userInvocation = (invokedByFlag ? [@"-" stringByAppendingString:option.flag] : [@"--" stringByAppendingString:option.name]);
+            CLKArgumentIssue *issue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL salientOption:option.name description:@"expected argument for option '%@'" argument:userInvocation];
             [self _accumulateParsingIssue:issue];
             return CLKAPStateReadNextArgumentToken;
         }
         
         self.currentParameterOption = option;
         
+        // the argument state expects the analysis of its token to be current
+        _tokenAnalysis = [self _analyzeNextToken];
+        CLKParseCountersNoteTokenForm(_counters, _tokenAnalysis.form);
+        
         // if the next argument after this option is the parsing sentinel, transition to the sentinel parsing state
-        if (CLKTokenFormForToken(_argumentVector.firstObject) == CLKTokenFormOptionParsingSentinel) {
-            return CLKAPStateParseRemainderArguments;
+        if (_tokenAnalysis.form == CLKTokenFormOptionParsingSentinel) {
+            return CLKAPStateParseOptionParsingSentinel;
         }
         
         return CLKAPStateParseArgument;
     }
     
-    [_manifest accumulateSwitchOptionNamed:option.name];
+    [self _accumulateSwitchOption:option];
     return CLKAPStateReadNextArgumentToken;
 }
 
@@ -498,9 +1080,9 @@
 
 - (BOOL)_processArgument:(NSString *)argument issue:(CLKArgumentIssue **)outIssue
 {
-    if (self.currentParameterOption != nil) {
-        BOOL result = [self _processArgument:argument forParameterOption:self.currentParameterOption issue:outIssue];
-        self.currentParameterOption = nil;
+    if (_currentParameterOption != nil) {
+        BOOL result = [self _processArgument:argument forParameterOption:_currentParameterOption issue:outIssue];
+        _currentParameterOption = nil;
         return result;
     } else {
         return [self _processPositionalArgument:argument issue:outIssue];
@@ -510,16 +1092,15 @@
 - (BOOL)_processPositionalArgument:(NSString *)argument issue:(CLKArgumentIssue **)outIssue
 {
     NSParameterAssert(outIssue != nil);
-    NSAssert(self.currentParameterOption == nil, @"currentParameterOption unexpectedly set");
+    NSAssert(_currentParameterOption == nil, @"currentParameterOption unexpectedly set");
     
     // reject: empty string passed into argv (e.g., --foo "")
     if (argument.length == 0) {
-        NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"encountered zero-length argument"];
-        *outIssue = [CLKArgumentIssue issueWithError:error];
+        *outIssue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL salientOption:nil description:@"encountered zero-length argument" argument:nil];
         return NO;
     }
     
-    [_manifest accumulatePositionalArgument:argument];
+    [self _accumulatePositionalArgument:argument];
     return YES;
 }
 
@@ -530,50 +1111,214 @@
     
     // reject: empty string passed into argv (e.g., --foo "")
     if (argument.length == 0) {
-        NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"encountered zero-length argument"];
-        *outIssue = [CLKArgumentIssue issueWithError:error salientOption:option.name];
+        *outIssue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL salientOption:option.name description:@"encountered zero-length argument" argument:nil];
         return NO;
     }
     
+    // arguments from option sources are merged at the end of the argument vector and taken as they are
     BOOL rejectOptionLikeToken = !(_state == CLKAPStateParseParameterOptionNameAssignment
                                    || _state == CLKAPStateParseParameterOptionFlagAssignment
-                                   || _state == CLKAPStateParseRemainderArguments);
+                                   || _state == CLKAPStateParseRemainderArguments
+                                   || _state == CLKAPStateEnd);
     
     // reject: the next argument looks like an option, but we expect an argument
     if (rejectOptionLikeToken) {
-        CLKTokenForm form = CLKTokenFormForToken(argument);
-        if (CLKTokenFormIsKindOfOption(form)) {
-            NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"expected argument for option but encountered option-like token '%@'", argument];
-            *outIssue = [CLKArgumentIssue issueWithError:error salientOption:option.name];
+        NSAssert((_state == CLKAPStateParseArgument), @"unexpected state %d when rejecting option-like tokens", _state);
+        if (CLKTokenFormIsKindOfOption(_tokenAnalysis.form)) {
+            *outIssue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL salientOption:option.name description:@"expected argument for option but encountered option-like token '%@'" argument:argument];
             return NO;
         }
     }
     
     CLKArgumentTransformer *transformer = option.transformer;
     if (transformer != nil) {
+        if (_transformerConcurrency > 1 && !_producesEvents && transformer.threadSafe) {
+            [self _deferTransformationOfArgument:argument forParameterOption:option];
+            return YES;
+        }
+        
+        CLKParseProfileMark mark = { 0, 0 };
+        if (_counters != NULL) {
+            mark = CLKParseProfileMarkNow(_counters);
+        }
+        
         NSError *transformerError;
         argument = [transformer transformedArgument:argument error:&transformerError];
+        if (_counters != NULL) {
+            CLKParseProfileCounterAdd(&_counters->transformers[[_optionRegistry indexOfOptionNamed:option.name]], mark);
+        }
+        
         if (argument == nil) {
             *outIssue = [CLKArgumentIssue issueWithError:transformerError salientOption:option.name];
             return NO;
         }
     }
     
-    [_manifest accumulateArgument:argument forParameterOptionNamed:option.name];
+    [self _accumulateArgument:argument forParameterOption:option];
     return YES;
 }
 
-- (BOOL)_processAssignedArgument:(NSString *)argument forParameterOption:(CLKOption *)option userInvocation:(NSString *)userInvocation issue:(CLKArgumentIssue **)outIssue
+#pragma mark -
+#pragma mark Option Sources
+
+- (void)_noteSuppliedOption:(CLKOption *)option
 {
-    NSParameterAssert(outIssue != nil);
+    NSUInteger optionIndex = [_optionRegistry indexOfOptionNamed:option.name];
+    NSAssert((optionIndex != NSNotFound), @"option not registered: %@", option);
+    CLKBitsetSet(_suppliedOptions, optionIndex);
+}
+
+- (void)_mergeOptionSources
+{
+    NSAssert((_state == CLKAPStateEnd), @"merging option sources before the end of the argument vector");
     
-    if (option.type != CLKOptionTypeParameter) {
-        NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"option '%@' does not accept arguments", userInvocation];
-        *outIssue = [CLKArgumentIssue issueWithError:error salientOption:option.name];
-        return NO;
+    NSArray<CLKOption *> *options = _optionRegistry.options;
+    for (CLKOptionSource *source in _optionSources) {
+        for (NSString *optionName in [source _unrecognizedOptionNamesInRegistry:_optionRegistry]) {
+            // sources name options as they are written in the source, without dashes
+            NSArray<NSString *> *suggestions = [_optionRegistry.nameSuggestionIndex suggestionsForString:optionName];
+            NSError *error;
+            if (suggestions.count > 0) {
+                error = [NSError clk_POSIXErrorWithCode:EINVAL suggestions:suggestions description:@"%@: unrecognized option: '%@'; did you mean %@?", source.name, optionName, CLKSuggestionListDescription(suggestions)];
+            } else {
+                error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"%@: unrecognized option: '%@'", source.name, optionName];
+            }
+            
+            [self _accumulateParsingIssue:[CLKArgumentIssue issueWithError:error]];
+        }
+        
+        // an option is supplied by the first place that sets it, even to nothing
+        [source _enumerateSettingsInRegistry:_optionRegistry usingBlock:^(NSUInteger optionIndex, NSArray<NSString *> *values) {
+            if (CLKBitsetTest(self->_suppliedOptions, optionIndex)) {
+                return;
+            }
+            
+            CLKBitsetSet(self->_suppliedOptions, optionIndex);
+            for (NSString *value in values) {
+                [self _mergeValue:value forOption:options[optionIndex] fromSource:source];
+            }
+        }];
+    }
+}
+
+- (void)_mergeValue:(NSString *)value forOption:(CLKOption *)option fromSource:(CLKOptionSource *)source
+{
+    if (option.type == CLKOptionTypeParameter) {
+        CLKArgumentIssue *issue;
+        if (value.length == 0) {
+            NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"%@: expected argument for option '--%@'", [source _locationOfOptionNamed:option.name], option.name];
+            issue = [CLKArgumentIssue issueWithError:error salientOption:option.name];
+        } else if ([self _processArgument:value forParameterOption:option issue:&issue]) {
+            return;
+        }
+        
+        [self _accumulateParsingIssue:issue];
+        return;
+    }
+    
+    NSUInteger count;
+    if (!CLKSwitchCountForOptionSourceValue(value, &count)) {
+        NSError *error = [NSError clk_POSIXErrorWithCode:EINVAL description:@"%@: expected a count for option '--%@' but found '%@'", [source _locationOfOptionNamed:option.name], option.name, value];
+        [self _accumulateParsingIssue:[CLKArgumentIssue issueWithError:error salientOption:option.name]];
+        return;
     }
     
-    return [self _processArgument:argument forParameterOption:option issue:outIssue];
+    for (NSUInteger i = 0 ; i < count ; i++) {
+        [self _accumulateSwitchOption:option];
+    }
+}
+
+#pragma mark -
+#pragma mark Deferred Transformation
+
+- (void)_deferTransformationOfArgument:(NSString *)argument forParameterOption:(CLKOption *)option
+{
+    NSAssert((_transformerConcurrency > 1 && !_producesEvents), @"deferring a transformation that should run inline");
+    
+    if (_deferredArguments == nil) {
+        _deferredArguments = [[NSMutableArray alloc] init];
+        _deferredOptions = [[NSMutableArray alloc] init];
+        _deferredIssueIndexes = [[NSMutableData alloc] init];
+    }
+    
+    NSUInteger issueIndex = _parsingIssues.count;
+    [_deferredArguments addObject:argument];
+    [_deferredOptions addObject:option];
+    [_deferredIssueIndexes appendBytes:&issueIndex length:sizeof(issueIndex)];
+}
+
+- (void)_performDeferredTransformations
+{
+    NSUInteger count = _deferredArguments.count;
+    if (count == 0) {
+        return;
+    }
+    
+    CLKHardAssert((count < UINT32_MAX), NSRangeException, @"cannot defer more than %u transformations", (UINT32_MAX - 1));
+    
+    // each worker writes only the slots for the indexes it takes. the objects are retained there
+    // and taken back below, once CLKWorkShareApply() has joined the workers.
+    NSArray<NSString *> *arguments = _deferredArguments;
+    NSArray<CLKOption *> *options = _deferredOptions;
+    void **results = calloc(count, sizeof(void *));
+    void **errors = calloc(count, sizeof(void *));
+    
+    // the allocation counter is process-wide, so only time is measured for concurrent transformations
+    uint64_t *durations = (_counters != NULL ? calloc(count, sizeof(uint64_t)) : NULL);
+    
+    CLKWorkShareApply((uint32_t)count, _transformerConcurrency, ^(uint32_t idx) {
+        uint64_t start = (durations != NULL ? CLKParseProfileNanoseconds() : 0);
+        NSError *error;
+        id result = [options[idx].transformer transformedArgument:arguments[idx] error:&error];
+        if (result != nil) {
+            results[idx] = (__bridge_retained void *)result;
+        } else {
+            errors[idx] = (__bridge_retained void *)error;
+        }
+        
+        if (durations != NULL) {
+            durations[idx] = (CLKParseProfileNanoseconds() - start);
+        }
+    });
+    
+    if (durations != NULL) {
+        for (NSUInteger i = 0 ; i < count ; i++) {
+            CLKParseProfileCounter *counter = &_counters->transformers[[_optionRegistry indexOfOptionNamed:options[i].name]];
+            counter->count++;
+            counter->nanoseconds += durations[i];
+        }
+        
+        free(durations);
+    }
+    
+    // arguments are accumulated in the order they were read, which is the order each option's
+    // arguments would have had if they had been transformed inline
+    for (NSUInteger i = 0 ; i < count ; i++) {
+        id result = (__bridge_transfer id)results[i];
+        if (result != nil) {
+            [self _accumulateArgument:result forParameterOption:options[i]];
+        }
+    }
+    
+    // failures go where they would have been reported inline. inserting from the back keeps the
+    // recorded positions of the earlier ones valid.
+    const NSUInteger *issueIndexes = _deferredIssueIndexes.bytes;
+    for (NSUInteger i = count ; i > 0 ; i--) {
+        if (results[i - 1] != NULL) {
+            continue;
+        }
+        
+        NSError *error = (__bridge_transfer NSError *)errors[i - 1];
+        NSString *optionName = options[i - 1].name;
+        [_parsingIssues insertObject:[CLKArgumentIssue issueWithError:error salientOption:optionName] atIndex:issueIndexes[i - 1]];
+        [self _noteParsingIssueForOptionNamed:optionName];
+    }
+    
+    free(results);
+    free(errors);
+    [_deferredArguments removeAllObjects];
+    [_deferredOptions removeAllObjects];
+    _deferredIssueIndexes.length = 0;
 }
 
 #pragma mark -
@@ -586,25 +1331,48 @@
     __block BOOL result = YES;
     
     @autoreleasepool {
-        NSMutableArray<CLKArgumentManifestConstraint *> *constraints = [NSMutableArray array];
-        for (CLKOption *option in _options) {
-            [constraints addObjectsFromArray:option.constraints];
-        }
-        
-        for (CLKOptionGroup *group in _optionGroups) {
-            [constraints addObjectsFromArray:group.constraints];
+        // one instruction at a time so that each can be timed. the handler is passed as a literal so that
+        // it stays on the stack; a passing manifest is validated without allocating.
+        CLKConstraintProgram *program = _schema.constraintProgram;
+        for (NSUInteger i = 0 ; i < program.instructionCount ; i++) {
+            [self _validateInstructionAtIndex:i ofProgram:program validator:_validator issueHandler:^(CLKArgumentIssue *issue) {
+                result = NO;
+                [self _handleValidationIssue:issue];
+            }];
         }
-        
-        CLKArgumentManifestValidator *validator = [[CLKArgumentManifestValidator alloc] initWithManifest:_manifest];
-        [validator validateConstraints:constraints issueHandler:^(CLKArgumentIssue *issue) {
-            result = NO;
-            if ([self _shouldAccumulateValidationIssue:issue]) {
-                [self _accumulateValidationIssue:issue];
-            }
-        }];
     }
     
     return result;
 }
 
+- (BOOL)_validateInstructionAtIndex:(NSUInteger)idx ofProgram:(CLKConstraintProgram *)program validator:(CLKArgumentManifestValidator *)validator issueHandler:(NS_NOESCAPE CLKAMVIssueHandler)issueHandler
+{
+    if (_counters == NULL) {
+        return [validator validateInstructionAtIndex:idx ofProgram:program issueHandler:issueHandler];
+    }
+    
+    CLKParseProfileMark mark = CLKParseProfileMarkNow(_counters);
+    BOOL satisfied = [validator validateInstructionAtIndex:idx ofProgram:program issueHandler:issueHandler];
+    CLKParseProfileCounterAdd(&_counters->constraintTypes[[program instructionAtIndex:idx]->type], mark);
+    return satisfied;
+}
+
+- (void)_handleValidationIssue:(CLKArgumentIssue *)issue
+{
+    if ([self _shouldAccumulateValidationIssue:issue]) {
+        [self _accumulateValidationIssue:issue];
+    }
+}
+
+#pragma mark -
+#pragma mark Profiling
+
+- (void)_finishProfile
+{
+    NSAssert((_counters != NULL && _profile == nil), @"finishing a profile twice or without counters");
+    
+    _profile = [[CLKParseProfile alloc] _initWithCounters:_counters optionRegistry:_optionRegistry];
+    CLKParseProfileWriteToEnvironmentDestination(_profile);
+}
+
 @end
@@ -4,6 +4,8 @@
 
 #import "CLKArgumentParser.h"
 
+#import "CLKToken.h"
+
 typedef NS_ENUM(uint32_t, CLKAPState) {
     CLKAPStateBegin = 0,
     CLKAPStateReadNextArgumentToken = 1,
@@ -13,47 +15,109 @@ typedef NS_ENUM(uint32_t, CLKAPState) {
     CLKAPStateParseParameterOptionNameAssignment = 5,
     CLKAPStateParseParameterOptionFlagAssignment = 6,
     CLKAPStateParseArgument = 7,
-    CLKAPStateParseRemainderArguments = 8,
-    CLKAPStateEnd = 9
+    CLKAPStateParseOptionParsingSentinel = 8,
+    CLKAPStateParseRemainderArguments = 9,
+    CLKAPStateEnd = 10
 };
 
+@class CLKArgumentEvent;
 @class CLKArgumentIssue;
+@class CLKArgumentManifest;
+@class CLKArgumentManifestValidator;
+@class CLKArgumentVector;
+@class CLKConstraintProgram;
 @class CLKOption;
-@class CLKOptionGroup;
+@class CLKOptionSchema;
 
 NS_ASSUME_NONNULL_BEGIN
 
 @interface CLKArgumentParser ()
 
-- (instancetype)_initWithArgumentVector:(NSArray<NSString *> *)argv
-                               options:(NSArray<CLKOption *> *)options
-                          optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups NS_DESIGNATED_INITIALIZER;
+- (instancetype)_initWithArgumentVector:(CLKArgumentVector *)argumentVector schema:(CLKOptionSchema *)schema NS_DESIGNATED_INITIALIZER;
+
+@property (readonly) CLKOptionSchema *schema;
+
+@property (nullable, nonatomic, retain) CLKOption *currentParameterOption;
+
+#pragma mark -
+#pragma mark Resetting
+
+// returns everything but the argument vector to the state of a new parser, keeping storage
+- (void)_reset;
+
+// resets the parser to read `argumentVector`, which it reads in place, like the one it was created with
+- (void)_resetWithArgumentVector:(CLKArgumentVector *)argumentVector;
+
+#pragma mark -
+#pragma mark Reading Tokens
+
+- (BOOL)_hasNextToken;
+- (CLKTokenAnalysis)_analyzeNextToken;
+- (NSString *)_popNextToken;
+- (void)_skipNextToken;
+
+// the next token's option segment with its dashes, e.g. `--flarn` of `--flarn=barf`. only created to report issues.
+- (NSString *)_popNextTokenOptionSegment;
+
+#pragma mark -
+
+// looks up the option in the next token's option segment without creating the token.
+// the next token must be an option name, flag or assignment.
+- (nullable CLKOption *)_optionForNextToken;
+
+// consumes the next token, reporting it as an unrecognized option
+- (void)_popUnrecognizedOption;
 
-@property (nullable, retain) CLKOption *currentParameterOption;
+#pragma mark -
+#pragma mark Results
+
+// the manifest built by the current run. in event mode it holds counts but no arguments.
+@property (readonly) CLKArgumentManifest *manifest;
+
+// in manifest mode these build the manifest and collect issues. in event mode they
+// queue events and count occurrences for validation.
+- (void)_accumulateSwitchOption:(CLKOption *)option;
+- (void)_accumulateArgument:(id)argument forParameterOption:(CLKOption *)option;
+- (void)_accumulatePositionalArgument:(NSString *)argument;
+
+#pragma mark -
+#pragma mark Events
 
-- (nullable CLKOption *)_optionForOptionNameToken:(NSString *)token issue:(CLKArgumentIssue *__nullable *__nonnull)outIssue;
-- (nullable CLKOption *)_optionForOptionFlagToken:(NSString *)token issue:(CLKArgumentIssue *__nullable *__nonnull)outIssue;
+- (void)_enqueueEvent:(CLKArgumentEvent *)event;
+- (void)_validateMonotonicConstraintsForOption:(CLKOption *)option;
+- (void)_finishEvents;
 
 #pragma mark -
 #pragma mark Errors
 
+// parsing issues followed by validation issues, or nil if there are none. unlike `errors`,
+// reading these doesn't format any error descriptions.
+@property (nullable, readonly) NSArray<CLKArgumentIssue *> *issues;
+
+- (BOOL)_hasIssues;
 - (void)_accumulateParsingIssue:(CLKArgumentIssue *)issue;
 - (void)_accumulateValidationIssue:(CLKArgumentIssue *)issue;
 - (BOOL)_shouldAccumulateValidationIssue:(CLKArgumentIssue *)issue;
+- (void)_noteParsingIssueForOptionNamed:(NSString *)optionName;
 - (BOOL)_hasParsingIssueForOptionNamed:(NSString *)optionName;
 
 #pragma mark -
 #pragma mark Parsing
 
+- (nullable CLKArgumentManifest *)_parseArguments;
+- (CLKAPState)_performCurrentState;
+- (CLKAPState)_performCurrentStateRecordingProfile;
 - (CLKAPState)_readNextArgumentToken;
 - (CLKAPState)_parseOptionName;
 - (CLKAPState)_parseOptionFlagSet;
 - (CLKAPState)_parseOptionFlag;
 - (CLKAPState)_parseOptionNameAssignment;
 - (CLKAPState)_parseOptionFlagAssignment;
+- (CLKAPState)_parseOptionAssignment;
 - (CLKAPState)_parseArgument;
+- (CLKAPState)_parseOptionParsingSentinel;
 - (CLKAPState)_parseRemainderArguments;
-- (CLKAPState)_handleParsedOption:(CLKOption *)option userInvocation:(NSString *)userInvocation;
+- (CLKAPState)_handleParsedOption:(CLKOption *)option invokedByFlag:(BOOL)invokedByFlag;
 
 #pragma mark -
 #pragma mark Processing
@@ -61,12 +125,31 @@ NS_ASSUME_NONNULL_BEGIN
 - (BOOL)_processArgument:(NSString *)argument issue:(CLKArgumentIssue *__nullable *__nonnull)outIssue;
 - (BOOL)_processPositionalArgument:(NSString *)argument issue:(CLKArgumentIssue *__nullable *__nonnull)outIssue;
 - (BOOL)_processArgument:(NSString *)argument forParameterOption:(CLKOption *)option issue:(CLKArgumentIssue *__nullable *__nonnull)outIssue;
-- (BOOL)_processAssignedArgument:(NSString *)argument forParameterOption:(CLKOption *)option userInvocation:(NSString *)userInvocation issue:(CLKArgumentIssue *__nullable *__nonnull)outIssue;
+
+#pragma mark -
+#pragma mark Option Sources
+
+- (void)_noteSuppliedOption:(CLKOption *)option;
+- (void)_mergeOptionSources;
+- (void)_mergeValue:(NSString *)value forOption:(CLKOption *)option fromSource:(CLKOptionSource *)source;
+
+#pragma mark -
+#pragma mark Deferred Transformation
+
+- (void)_deferTransformationOfArgument:(NSString *)argument forParameterOption:(CLKOption *)option;
+- (void)_performDeferredTransformations;
 
 #pragma mark -
 #pragma mark Validation
 
 - (BOOL)_validateManifest;
+- (BOOL)_validateInstructionAtIndex:(NSUInteger)idx ofProgram:(CLKConstraintProgram *)program validator:(CLKArgumentManifestValidator *)validator issueHandler:(NS_NOESCAPE void (^)(CLKArgumentIssue *issue))issueHandler;
+- (void)_handleValidationIssue:(CLKArgumentIssue *)issue;
+
+#pragma mark -
+#pragma mark Profiling
+
+- (void)_finishProfile;
 
 @end
 
@@ -0,0 +1,46 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// the UTF-8 bytes of one argument, not NUL-terminated.
+//
+// `owner` is the object keeping the bytes alive, or nil when they belong to the process (as
+// argv does). the span doesn't retain its owner; whoever holds the span must.
+typedef struct {
+    const char *bytes;
+    NSUInteger length;
+    __unsafe_unretained NSData *_Nullable owner;
+} CLKArgumentSpan;
+
+// NUL-delimited arguments read from a file descriptor, in the manner of `xargs -0`.
+//
+// the descriptor is read in fixed-size chunks on a background thread while the consumer
+// reads arguments out of earlier chunks. a small number of chunks are buffered ahead of the
+// consumer, after which the reader waits, so memory use doesn't depend on the length of the
+// input. arguments are not copied out of the chunks except for the few that straddle one.
+// a final argument without a trailing NUL is still read.
+@interface CLKArgumentStream : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
+// the stream reads `fd` but doesn't close it
++ (instancetype)streamWithFileDescriptor:(int)fd;
+
+// blocks until the next argument is available. answers NO at the end of the stream or on a
+// read error. `outArgument->owner` is only guaranteed to be alive until the next call.
+- (BOOL)readArgument:(CLKArgumentSpan *)outArgument;
+
+// set once -readArgument: has answered NO because of a read error
+@property (nullable, readonly) NSError *error;
+
+// stops the reader. a reader blocked in read(2) stops after the read returns.
+- (void)cancel;
+
+@end
+
+NS_ASSUME_NONNULL_END
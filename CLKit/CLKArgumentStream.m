@@ -0,0 +1,273 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKArgumentStream.h"
+
+#import <unistd.h>
+
+#import "CLKAssert.h"
+#import "NSError+CLKAdditions.h"
+
+static const NSUInteger CLKArgumentStreamChunkSize = (64 * 1024);
+static const NSUInteger CLKArgumentStreamMaxBufferedChunks = 4;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// a buffer of input and the ranges of the complete arguments in it
+@interface CLKArgumentStreamChunk : NSObject
+
+- (instancetype)initWithData:(NSData *)data ranges:(NSData *)ranges NS_DESIGNATED_INITIALIZER;
+
+@property (readonly) NSData *data;
+@property (readonly) NSUInteger argumentCount;
+- (CLKArgumentSpan)argumentAtIndex:(NSUInteger)idx;
+
+@end
+
+@interface CLKArgumentStream ()
+
+- (instancetype)_initWithFileDescriptor:(int)fd NS_DESIGNATED_INITIALIZER;
+
+- (void)_readInput;
+- (BOOL)_enqueueChunk:(CLKArgumentStreamChunk *)chunk;
+- (void)_finishWithError:(nullable NSError *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation CLKArgumentStreamChunk
+{
+    NSData *_data;
+    NSData *_ranges;
+}
+
+@synthesize data = _data;
+
+- (instancetype)initWithData:(NSData *)data ranges:(NSData *)ranges
+{
+    self = [super init];
+    if (self != nil) {
+        _data = data;
+        _ranges = ranges;
+    }
+    
+    return self;
+}
+
+- (NSUInteger)argumentCount
+{
+    return (_ranges.length / sizeof(NSRange));
+}
+
+- (CLKArgumentSpan)argumentAtIndex:(NSUInteger)idx
+{
+    NSParameterAssert(idx < self.argumentCount);
+    
+    NSRange range = ((const NSRange *)_ranges.bytes)[idx];
+    CLKArgumentSpan span = {
+        .bytes = ((const char *)_data.bytes + range.location),
+        .length = range.length,
+        .owner = _data
+    };
+    
+    return span;
+}
+
+@end
+
+#pragma mark -
+
+@implementation CLKArgumentStream
+{
+    int _fd;
+    
+    // shared with the reader thread, guarded by _condition
+    NSCondition *_condition;
+    NSMutableArray<CLKArgumentStreamChunk *> *_bufferedChunks;
+    BOOL _finished;
+    BOOL _cancelled;
+    NSError *_error;
+    
+    // consumer state
+    CLKArgumentStreamChunk *_currentChunk;
+    NSUInteger _currentArgumentIndex;
+}
+
++ (instancetype)streamWithFileDescriptor:(int)fd
+{
+    CLKHardParameterAssert(fd >= 0);
+    
+    CLKArgumentStream *stream = [[self alloc] _initWithFileDescriptor:fd];
+    [NSThread detachNewThreadWithBlock:^{
+        [stream _readInput];
+    }];
+    
+    return stream;
+}
+
+- (instancetype)_initWithFileDescriptor:(int)fd
+{
+    self = [super init];
+    if (self != nil) {
+        _fd = fd;
+        _condition = [[NSCondition alloc] init];
+        _bufferedChunks = [[NSMutableArray alloc] init];
+    }
+    
+    return self;
+}
+
+#pragma mark -
+#pragma mark Reader
+
+- (void)_readInput
+{
+    NSMutableData *buffer = nil;
+    NSUInteger carriedLength = 0; // length of the partial argument at the start of `buffer`
+    
+    for (;;) {
+        [_condition lock];
+        BOOL cancelled = _cancelled;
+        [_condition unlock];
+        if (cancelled) {
+            return;
+        }
+        
+        // a partial argument at least as long as a chunk would leave no room to read; grow instead
+        NSUInteger capacity = MAX(CLKArgumentStreamChunkSize, (carriedLength * 2));
+        NSMutableData *nextBuffer = [[NSMutableData alloc] initWithLength:capacity];
+        if (carriedLength > 0) {
+            memcpy(nextBuffer.mutableBytes, ((const char *)buffer.bytes + (buffer.length - carriedLength)), carriedLength);
+        }
+        
+        buffer = nextBuffer;
+        char *bytes = buffer.mutableBytes;
+        
+        ssize_t readLength;
+        do {
+            readLength = read(_fd, (bytes + carriedLength), (capacity - carriedLength));
+        } while (readLength < 0 && errno == EINTR);
+        
+        if (readLength < 0) {
+            int code = errno;
+            [self _finishWithError:[NSError clk_POSIXErrorWithCode:code description:@"error reading arguments: %s", strerror(code)]];
+            return;
+        }
+        
+        NSUInteger length = carriedLength + (NSUInteger)readLength;
+        NSMutableData *ranges = [[NSMutableData alloc] init];
+        NSUInteger start = 0;
+        
+        if (readLength == 0) {
+            // end of input. whatever was carried is the final argument.
+            if (carriedLength > 0) {
+                NSRange range = NSMakeRange(0, carriedLength);
+                [ranges appendBytes:&range length:sizeof(range)];
+                buffer.length = length;
+                [self _enqueueChunk:[[CLKArgumentStreamChunk alloc] initWithData:buffer ranges:ranges]];
+            }
+            
+            [self _finishWithError:nil];
+            return;
+        }
+        
+        const char *delimiter;
+        while ((delimiter = memchr((bytes + start), '\0', (length - start))) != NULL) {
+            NSUInteger end = (NSUInteger)(delimiter - bytes);
+            NSRange range = NSMakeRange(start, (end - start));
+            [ranges appendBytes:&range length:sizeof(range)];
+            start = end + 1;
+        }
+        
+        carriedLength = length - start;
+        buffer.length = length;
+        
+        if (ranges.length > 0) {
+            if (![self _enqueueChunk:[[CLKArgumentStreamChunk alloc] initWithData:buffer ranges:ranges]]) {
+                return;
+            }
+        }
+    }
+}
+
+- (BOOL)_enqueueChunk:(CLKArgumentStreamChunk *)chunk
+{
+    [_condition lock];
+    
+    while (_bufferedChunks.count >= CLKArgumentStreamMaxBufferedChunks && !_cancelled) {
+        [_condition wait];
+    }
+    
+    BOOL cancelled = _cancelled;
+    if (!cancelled) {
+        [_bufferedChunks addObject:chunk];
+        [_condition broadcast];
+    }
+    
+    [_condition unlock];
+    return !cancelled;
+}
+
+- (void)_finishWithError:(NSError *)error
+{
+    [_condition lock];
+    _finished = YES;
+    _error = error;
+    [_condition broadcast];
+    [_condition unlock];
+}
+
+#pragma mark -
+#pragma mark Consumer
+
+- (BOOL)readArgument:(CLKArgumentSpan *)outArgument
+{
+    NSParameterAssert(outArgument != NULL);
+    
+    while (_currentChunk == nil || _currentArgumentIndex >= _currentChunk.argumentCount) {
+        [_condition lock];
+        
+        while (_bufferedChunks.count == 0 && !_finished) {
+            [_condition wait];
+        }
+        
+        CLKArgumentStreamChunk *chunk = _bufferedChunks.firstObject;
+        if (chunk != nil) {
+            [_bufferedChunks removeObjectAtIndex:0];
+            [_condition broadcast];
+        }
+        
+        [_condition unlock];
+        
+        _currentChunk = chunk;
+        _currentArgumentIndex = 0;
+        if (chunk == nil) {
+            return NO;
+        }
+    }
+    
+    *outArgument = [_currentChunk argumentAtIndex:_currentArgumentIndex];
+    _currentArgumentIndex++;
+    return YES;
+}
+
+- (NSError *)error
+{
+    [_condition lock];
+    NSError *error = _error;
+    [_condition unlock];
+    return error;
+}
+
+- (void)cancel
+{
+    [_condition lock];
+    _cancelled = YES;
+    [_bufferedChunks removeAllObjects];
+    [_condition broadcast];
+    [_condition unlock];
+}
+
+@end
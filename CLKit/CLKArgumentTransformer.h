@@ -10,6 +10,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (nullable id)transformedArgument:(NSString *)argument error:(NSError **)outError;
 
+// YES if -transformedArgument:error: can be called from several threads at once. subclasses that
+// keep no mutable state can override this to take part in concurrent transformation
+// (see -[CLKArgumentParser transformerConcurrency]). the default is NO.
+@property (readonly, getter=isThreadSafe) BOOL threadSafe;
+
 @end
 
 @interface CLKIntArgumentTransformer : CLKArgumentTransformer
@@ -20,4 +25,42 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+#pragma mark -
+#pragma mark Numeric Transformers
+
+// the numeric transformers read an argument's characters in place rather than converting it to
+// a C string, reject anything but the number itself (including whitespace), and fail with ERANGE
+// instead of clamping values that don't fit. each produces an NSNumber.
+//
+// integers may be written in hexadecimal with a `0x` prefix or in octal with a `0o` prefix.
+// a leading zero alone doesn't make a number octal.
+
+// int64_t
+@interface CLKInt64ArgumentTransformer : CLKArgumentTransformer
+
+@end
+
+// uint64_t. signs are not accepted.
+@interface CLKUInt64ArgumentTransformer : CLKArgumentTransformer
+
+@end
+
+// double, written as `[+-]digits[.digits][e[+-]digits]`
+@interface CLKDoubleArgumentTransformer : CLKArgumentTransformer
+
+@end
+
+// a count of bytes (uint64_t) with an optional, case-insensitive unit: `64K`, `2GiB`, `1500KB`.
+// K, M, G, T, P and E, alone or followed by `iB`, are powers of 1024. followed by `B`, they are
+// powers of 1000. `B` or no unit at all is bytes.
+@interface CLKByteSizeArgumentTransformer : CLKArgumentTransformer
+
+@end
+
+// a duration as an NSTimeInterval, written as one or more numbers with units: `250ms`, `1h30m`, `1.5s`.
+// the units are ns, us (or µs), ms, s, m, h and d. `0` needs no unit.
+@interface CLKDurationArgumentTransformer : CLKArgumentTransformer
+
+@end
+
 NS_ASSUME_NONNULL_END
@@ -5,8 +5,28 @@
 #import "CLKArgumentTransformer.h"
 
 #import "CLKError_Private.h"
+#import "CLKNumericParsing.h"
 #import "NSError+CLKAdditions.h"
 
+NS_ASSUME_NONNULL_BEGIN
+
+static NSError *CLKNumericTransformationError(CLKNumericParseResult result, NSString *argument, NSString *valueDescription);
+
+NS_ASSUME_NONNULL_END
+
+static NSError *CLKNumericTransformationError(CLKNumericParseResult result, NSString *argument, NSString *valueDescription)
+{
+    NSCAssert((result != CLKNumericParseResultSuccess), @"no error to describe");
+    
+    if (result == CLKNumericParseResultOutOfRange) {
+        return [NSError clk_POSIXErrorWithCode:ERANGE description:@"couldn't coerce '%@' to %@: value out of range", argument, valueDescription];
+    }
+    
+    return [NSError clk_POSIXErrorWithCode:EINVAL description:@"couldn't coerce '%@' to %@", argument, valueDescription];
+}
+
+#pragma mark -
+
 @implementation CLKArgumentTransformer
 
 - (id)transformedArgument:(NSString *)argument error:(__unused NSError **)outError
@@ -14,6 +34,11 @@
     return argument;
 }
 
+- (BOOL)isThreadSafe
+{
+    return NO;
+}
+
 @end
 
 @implementation CLKIntArgumentTransformer
@@ -31,6 +56,11 @@
     return @(n);
 }
 
+- (BOOL)isThreadSafe
+{
+    return YES;
+}
+
 @end
 
 @implementation CLKFloatArgumentTransformer
@@ -48,4 +78,131 @@
     return @(f);
 }
 
+- (BOOL)isThreadSafe
+{
+    return YES;
+}
+
+@end
+
+#pragma mark -
+
+@implementation CLKInt64ArgumentTransformer
+
+- (id)transformedArgument:(NSString *)argument error:(NSError **)outError
+{
+    __block int64_t value = 0;
+    CLKNumericParseResult result = CLKParseCharactersOfString(argument, ^(const unichar *characters, NSUInteger length) {
+        return CLKParseInt64(characters, length, &value);
+    });
+    
+    if (result != CLKNumericParseResultSuccess) {
+        CLKSetOutError(outError, CLKNumericTransformationError(result, argument, @"a 64-bit integer value"));
+        return nil;
+    }
+    
+    return @(value);
+}
+
+- (BOOL)isThreadSafe
+{
+    return YES;
+}
+
+@end
+
+@implementation CLKUInt64ArgumentTransformer
+
+- (id)transformedArgument:(NSString *)argument error:(NSError **)outError
+{
+    __block uint64_t value = 0;
+    CLKNumericParseResult result = CLKParseCharactersOfString(argument, ^(const unichar *characters, NSUInteger length) {
+        return CLKParseUInt64(characters, length, &value);
+    });
+    
+    if (result != CLKNumericParseResultSuccess) {
+        CLKSetOutError(outError, CLKNumericTransformationError(result, argument, @"an unsigned 64-bit integer value"));
+        return nil;
+    }
+    
+    return @(value);
+}
+
+- (BOOL)isThreadSafe
+{
+    return YES;
+}
+
+@end
+
+@implementation CLKDoubleArgumentTransformer
+
+- (id)transformedArgument:(NSString *)argument error:(NSError **)outError
+{
+    __block double value = 0;
+    CLKNumericParseResult result = CLKParseCharactersOfString(argument, ^(const unichar *characters, NSUInteger length) {
+        return CLKParseDouble(characters, length, &value);
+    });
+    
+    if (result != CLKNumericParseResultSuccess) {
+        CLKSetOutError(outError, CLKNumericTransformationError(result, argument, @"a floating-point value"));
+        return nil;
+    }
+    
+    return @(value);
+}
+
+- (BOOL)isThreadSafe
+{
+    return YES;
+}
+
+@end
+
+@implementation CLKByteSizeArgumentTransformer
+
+- (id)transformedArgument:(NSString *)argument error:(NSError **)outError
+{
+    __block uint64_t value = 0;
+    CLKNumericParseResult result = CLKParseCharactersOfString(argument, ^(const unichar *characters, NSUInteger length) {
+        return CLKParseByteSize(characters, length, &value);
+    });
+    
+    if (result != CLKNumericParseResultSuccess) {
+        CLKSetOutError(outError, CLKNumericTransformationError(result, argument, @"a byte size"));
+        return nil;
+    }
+    
+    return @(value);
+}
+
+- (BOOL)isThreadSafe
+{
+    return YES;
+}
+
+@end
+
+@implementation CLKDurationArgumentTransformer
+
+- (id)transformedArgument:(NSString *)argument error:(NSError **)outError
+{
+    __block int64_t nanoseconds = 0;
+    CLKNumericParseResult result = CLKParseCharactersOfString(argument, ^(const unichar *characters, NSUInteger length) {
+        return CLKParseDuration(characters, length, &nanoseconds);
+    });
+    
+    if (result != CLKNumericParseResultSuccess) {
+        CLKSetOutError(outError, CLKNumericTransformationError(result, argument, @"a duration"));
+        return nil;
+    }
+    
+    return @((NSTimeInterval)nanoseconds / 1e9);
+}
+
+- (BOOL)isThreadSafe
+{
+    return YES;
+}
+
 @end
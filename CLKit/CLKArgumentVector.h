@@ -0,0 +1,71 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "CLKToken.h"
+
+@class CLKArgumentStream;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// a random-access view of an argument vector, optionally followed by a stream. the view doesn't
+// change while it is read, but it can be reset to read a new argument vector (see below).
+//
+// a vector backed by a C argv classifies tokens on their UTF-8 bytes and only creates
+// strings for tokens that are read. those strings reference argv's bytes directly where
+// possible, so argv must outlive the vector and anything read from it. the argv passed
+// to main() lives for the duration of the process, which is the intended use. strings read
+// from response files and streams keep their backing buffers alive themselves.
+@interface CLKArgumentVector : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
++ (instancetype)vectorWithArguments:(NSArray<NSString *> *)arguments;
++ (instancetype)vectorWithArgv:(const char *_Nonnull [_Nonnull])argv argc:(int)argc;
+
+// see CLKArgumentSourceExpandResponseFiles. arguments from `stream`, if any, follow argv.
++ (instancetype)vectorWithArgv:(const char *_Nonnull [_Nonnull])argv
+                          argc:(int)argc
+        expandingResponseFiles:(BOOL)expandResponseFiles
+                        stream:(nullable CLKArgumentStream *)stream;
+
+// the number of arguments known up front, which excludes the stream
+@property (readonly) NSUInteger count;
+
+// may wait for the stream. stream arguments must be visited in order: once this has answered
+// YES for a stream argument, earlier stream arguments are no longer available.
+- (BOOL)hasArgumentAtIndex:(NSUInteger)idx;
+
+- (NSString *)argumentAtIndex:(NSUInteger)idx;
+- (CLKTokenAnalysis)analysisOfArgumentAtIndex:(NSUInteger)idx;
+
+// slices of an argument, in characters. a vector backed by argv reads these in place when the
+// argument is ASCII up to the end of the range, which is the case for the option segment of any
+// token classified on its bytes; only other arguments are created to be sliced.
+- (void)getCharacters:(unichar *)buffer range:(NSRange)range ofArgumentAtIndex:(NSUInteger)idx;
+- (NSString *)substringWithRange:(NSRange)range ofArgumentAtIndex:(NSUInteger)idx;
+
+// the first response file that couldn't be read or the stream's read error, if any.
+// a vector whose response files couldn't be read is empty.
+@property (nullable, readonly) NSError *error;
+
+// shares storage with the receiver. not supported for vectors with a stream.
+// neither vector can be reset afterward.
+- (CLKArgumentVector *)subvectorFromIndex:(NSUInteger)idx;
+
+// point the receiver at a new argument vector of the same kind, reusing its storage. a vector backed
+// by argv keeps expanding response files if it did before, stops reading its stream and clears its
+// error. arguments already read from the vector stay valid. answers NO, leaving the receiver as it
+// was, for a vector of the other kind or a vector that shares its storage with a subvector.
+- (BOOL)resetWithArguments:(NSArray<NSString *> *)arguments;
+- (BOOL)resetWithArgv:(const char *_Nonnull [_Nonnull])argv argc:(int)argc;
+
+// materializes every argument still available. intended for diagnostics.
+- (NSArray<NSString *> *)argumentsFromIndex:(NSUInteger)idx;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,400 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKArgumentVector.h"
+
+#import "CLKArgumentStream.h"
+#import "CLKAssert.h"
+#import "NSError+CLKAdditions.h"
+
+static void CLKAppendResponseFileSpans(NSMutableData *spanStorage, NSData *file);
+static BOOL CLKArgumentSpanIsASCIIThrough(const CLKArgumentSpan *span, NSUInteger end);
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKArgumentVector ()
+
+- (instancetype)_initWithArguments:(nullable NSArray<NSString *> *)arguments
+                       spanStorage:(nullable NSMutableData *)spanStorage
+                     responseFiles:(nullable NSMutableArray<NSData *> *)responseFiles
+                             range:(NSRange)range
+                            stream:(nullable CLKArgumentStream *)stream
+                             error:(nullable NSError *)error NS_DESIGNATED_INITIALIZER;
+
++ (nullable NSData *)_mapResponseFileAtPath:(const char *)path error:(NSError **)outError;
+
+// replaces the spans in the receiver's storage with argv's
+- (void)_readArgv:(const char *_Nonnull [_Nonnull])argv argc:(int)argc expandingResponseFiles:(BOOL)expandResponseFiles;
+
+- (const CLKArgumentSpan *)_spanAtIndex:(NSUInteger)idx;
+- (nullable NSString *)_stringWithBytesOfSpan:(const CLKArgumentSpan *)span range:(NSRange)range;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+static void CLKAppendResponseFileSpans(NSMutableData *spanStorage, NSData *file)
+{
+    const char *bytes = file.bytes;
+    NSUInteger length = file.length;
+    NSUInteger start = 0;
+    
+    while (start < length) {
+        const char *newline = memchr((bytes + start), '\n', (length - start));
+        NSUInteger end = (newline != NULL ? (NSUInteger)(newline - bytes) : length);
+        NSUInteger lineLength = end - start;
+        if (lineLength > 0 && bytes[end - 1] == '\r') {
+            lineLength--;
+        }
+        
+        if (lineLength > 0) {
+            CLKArgumentSpan span = { (bytes + start), lineLength, file };
+            [spanStorage appendBytes:&span length:sizeof(span)];
+        }
+        
+        start = end + 1;
+    }
+}
+
+// YES if the span's characters up to `end` are its bytes, so character ranges below `end` are byte ranges
+static BOOL CLKArgumentSpanIsASCIIThrough(const CLKArgumentSpan *span, NSUInteger end)
+{
+    if (end > span->length) {
+        return NO;
+    }
+    
+    for (NSUInteger i = 0 ; i < end ; i++) {
+        if ((unsigned char)span->bytes[i] >= 0x80) {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+@implementation CLKArgumentVector
+{
+    // exactly one of these is set
+    NSArray<NSString *> *_arguments;
+    NSMutableData *_spanStorage;
+    
+    const CLKArgumentSpan *_spans; // _spanStorage's bytes
+    NSMutableArray<NSData *> *_responseFiles; // owners of the spans read from response files
+    NSRange _range; // the window of the backing storage visible through this vector
+    BOOL _expandsResponseFiles;
+    BOOL _storageShared; // a subvector views this vector's storage, or this is a subvector
+    
+    CLKArgumentStream *_stream;
+    CLKArgumentSpan _streamArgument; // the most recently read stream argument
+    NSData *_streamArgumentOwner;
+    NSUInteger _streamIndex; // index of _streamArgument within the stream, or NSNotFound before the first read
+    BOOL _streamEnded;
+    
+    NSError *_error;
+}
+
+@synthesize error = _error;
+
++ (instancetype)vectorWithArguments:(NSArray<NSString *> *)arguments
+{
+    CLKHardParameterAssert(arguments != nil);
+    
+    NSArray *copiedArguments = [arguments copy];
+    return [[self alloc] _initWithArguments:copiedArguments spanStorage:nil responseFiles:nil range:NSMakeRange(0, copiedArguments.count) stream:nil error:nil];
+}
+
++ (instancetype)vectorWithArgv:(const char *[])argv argc:(int)argc
+{
+    return [self vectorWithArgv:argv argc:argc expandingResponseFiles:NO stream:nil];
+}
+
++ (instancetype)vectorWithArgv:(const char *[])argv argc:(int)argc expandingResponseFiles:(BOOL)expandResponseFiles stream:(CLKArgumentStream *)stream
+{
+    CLKHardParameterAssert(argc >= 0);
+    CLKHardParameterAssert(argv != NULL || argc == 0);
+    
+    NSMutableData *spanStorage = [[NSMutableData alloc] initWithCapacity:((NSUInteger)argc * sizeof(CLKArgumentSpan))];
+    NSMutableArray<NSData *> *responseFiles = [[NSMutableArray alloc] init];
+    CLKArgumentVector *vector = [[self alloc] _initWithArguments:nil spanStorage:spanStorage responseFiles:responseFiles range:NSMakeRange(0, 0) stream:stream error:nil];
+    [vector _readArgv:argv argc:argc expandingResponseFiles:expandResponseFiles];
+    return vector;
+}
+
++ (NSData *)_mapResponseFileAtPath:(const char *)path error:(NSError **)outError
+{
+    NSString *pathString = [NSFileManager.defaultManager stringWithFileSystemRepresentation:path length:strlen(path)];
+    NSError *readError = nil;
+    NSData *file = [NSData dataWithContentsOfFile:pathString options:NSDataReadingMappedAlways error:&readError];
+    if (file == nil) {
+        NSError *underlyingError = readError.userInfo[NSUnderlyingErrorKey];
+        int code = ([underlyingError.domain isEqualToString:NSPOSIXErrorDomain] ? (int)underlyingError.code : EIO);
+        *outError = [NSError clk_POSIXErrorWithCode:code description:@"@%@: %s", pathString, strerror(code)];
+        return nil;
+    }
+    
+    return file;
+}
+
+- (instancetype)_initWithArguments:(NSArray<NSString *> *)arguments
+                       spanStorage:(NSMutableData *)spanStorage
+                     responseFiles:(NSMutableArray<NSData *> *)responseFiles
+                             range:(NSRange)range
+                            stream:(CLKArgumentStream *)stream
+                             error:(NSError *)error
+{
+    NSParameterAssert((arguments == nil) != (spanStorage == nil));
+    NSParameterAssert(stream == nil || spanStorage != nil);
+    
+    self = [super init];
+    if (self != nil) {
+        _arguments = arguments;
+        _spanStorage = spanStorage;
+        _spans = spanStorage.bytes;
+        _responseFiles = responseFiles;
+        _range = range;
+        _stream = stream;
+        _streamIndex = NSNotFound;
+        _error = error;
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    [_stream cancel];
+}
+
+- (NSString *)debugDescription
+{
+    return [NSString stringWithFormat:@"%@ { %@ }", super.debugDescription, [self argumentsFromIndex:0]];
+}
+
+#pragma mark -
+
+- (NSUInteger)count
+{
+    return _range.length;
+}
+
+- (BOOL)hasArgumentAtIndex:(NSUInteger)idx
+{
+    if (idx < _range.length) {
+        return YES;
+    }
+    
+    if (_stream == nil) {
+        return NO;
+    }
+    
+    NSUInteger streamIndex = idx - _range.length;
+    CLKParameterAssert((_streamIndex == NSNotFound || streamIndex >= _streamIndex), @"stream argument %lu is no longer available", (unsigned long)streamIndex);
+    
+    while (_streamIndex == NSNotFound || _streamIndex < streamIndex) {
+        if (_streamEnded) {
+            return NO;
+        }
+        
+        // a failed read leaves _streamArgument (and its owner) untouched
+        if (![_stream readArgument:&_streamArgument]) {
+            _streamEnded = YES;
+            if (_error == nil) {
+                _error = _stream.error;
+            }
+            
+            return NO;
+        }
+        
+        _streamArgumentOwner = _streamArgument.owner;
+        _streamIndex = (_streamIndex == NSNotFound ? 0 : (_streamIndex + 1));
+    }
+    
+    return YES;
+}
+
+- (const CLKArgumentSpan *)_spanAtIndex:(NSUInteger)idx
+{
+    if (idx < _range.length) {
+        return &_spans[_range.location + idx];
+    }
+    
+    NSUInteger streamIndex = idx - _range.length;
+    CLKHardParameterAssert((_streamIndex != NSNotFound && streamIndex == _streamIndex), @"stream argument %lu is not available", (unsigned long)streamIndex);
+    return &_streamArgument;
+}
+
+- (NSString *)argumentAtIndex:(NSUInteger)idx
+{
+    if (_arguments != nil) {
+        NSParameterAssert(idx < _range.length);
+        return _arguments[_range.location + idx];
+    }
+    
+    const CLKArgumentSpan *span = [self _spanAtIndex:idx];
+    NSString *argument = [self _stringWithBytesOfSpan:span range:NSMakeRange(0, span->length)];
+    CLKHardAssert((argument != nil), NSInvalidArgumentException, @"argument at index %lu is not valid UTF-8", (unsigned long)(_range.location + idx));
+    return argument;
+}
+
+- (NSString *)_stringWithBytesOfSpan:(const CLKArgumentSpan *)span range:(NSRange)range
+{
+    NSParameterAssert(NSMaxRange(range) <= span->length);
+    
+    void *bytes = (void *)(span->bytes + range.location);
+    NSData *owner = span->owner;
+    if (owner == nil) {
+        return [[NSString alloc] initWithBytesNoCopy:bytes length:range.length encoding:NSUTF8StringEncoding freeWhenDone:NO];
+    }
+    
+    // the string keeps the buffer it points into alive, so it can outlive the vector
+    return [[NSString alloc] initWithBytesNoCopy:bytes length:range.length encoding:NSUTF8StringEncoding deallocator:^(__unused void *unusedBytes, __unused NSUInteger length) {
+        (void)owner;
+    }];
+}
+
+- (CLKTokenAnalysis)analysisOfArgumentAtIndex:(NSUInteger)idx
+{
+    if (_arguments == nil) {
+        const CLKArgumentSpan *span = [self _spanAtIndex:idx];
+        CLKTokenAnalysis analysis;
+        if (CLKTokenAnalyzeUTF8(span->bytes, span->length, &analysis)) {
+            return analysis;
+        }
+    }
+    
+    return CLKTokenAnalyze([self argumentAtIndex:idx]);
+}
+
+- (void)getCharacters:(unichar *)buffer range:(NSRange)range ofArgumentAtIndex:(NSUInteger)idx
+{
+    if (_arguments == nil) {
+        const CLKArgumentSpan *span = [self _spanAtIndex:idx];
+        if (CLKArgumentSpanIsASCIIThrough(span, NSMaxRange(range))) {
+            for (NSUInteger i = 0 ; i < range.length ; i++) {
+                buffer[i] = (unichar)span->bytes[range.location + i];
+            }
+            
+            return;
+        }
+    }
+    
+    [[self argumentAtIndex:idx] getCharacters:buffer range:range];
+}
+
+- (NSString *)substringWithRange:(NSRange)range ofArgumentAtIndex:(NSUInteger)idx
+{
+    if (_arguments == nil) {
+        const CLKArgumentSpan *span = [self _spanAtIndex:idx];
+        if (CLKArgumentSpanIsASCIIThrough(span, NSMaxRange(range))) {
+            return [self _stringWithBytesOfSpan:span range:range];
+        }
+    }
+    
+    return [[self argumentAtIndex:idx] substringWithRange:range];
+}
+
+- (CLKArgumentVector *)subvectorFromIndex:(NSUInteger)idx
+{
+    NSParameterAssert(idx <= _range.length);
+    CLKHardParameterAssert((_stream == nil), @"subvectors of streamed argument vectors are not supported");
+    
+    NSRange range = NSMakeRange((_range.location + idx), (_range.length - idx));
+    CLKArgumentVector *subvector = [[CLKArgumentVector alloc] _initWithArguments:_arguments spanStorage:_spanStorage responseFiles:_responseFiles range:range stream:nil error:_error];
+    
+    // resetting either vector would pull the storage out from under the other
+    _storageShared = YES;
+    subvector->_storageShared = YES;
+    return subvector;
+}
+
+- (NSArray<NSString *> *)argumentsFromIndex:(NSUInteger)idx
+{
+    NSMutableArray<NSString *> *arguments = [NSMutableArray array];
+    for (NSUInteger i = idx ; i < _range.length ; i++) {
+        [arguments addObject:[self argumentAtIndex:i]];
+    }
+    
+    // earlier stream arguments are gone, but the most recent one is still available
+    if (_streamIndex != NSNotFound && (_range.length + _streamIndex) >= idx) {
+        [arguments addObject:[self argumentAtIndex:(_range.length + _streamIndex)]];
+    }
+    
+    return arguments;
+}
+
+#pragma mark -
+#pragma mark Resetting
+
+- (BOOL)resetWithArguments:(NSArray<NSString *> *)arguments
+{
+    CLKHardParameterAssert(arguments != nil);
+    
+    if (_arguments == nil || _storageShared) {
+        return NO;
+    }
+    
+    _arguments = [arguments copy];
+    _range = NSMakeRange(0, _arguments.count);
+    return YES;
+}
+
+- (BOOL)resetWithArgv:(const char *[])argv argc:(int)argc
+{
+    CLKHardParameterAssert(argc >= 0);
+    CLKHardParameterAssert(argv != NULL || argc == 0);
+    
+    if (_spanStorage == nil || _storageShared) {
+        return NO;
+    }
+    
+    // a stream can only be read once
+    [_stream cancel];
+    _stream = nil;
+    _streamArgumentOwner = nil;
+    _streamIndex = NSNotFound;
+    _streamEnded = NO;
+    
+    [self _readArgv:argv argc:argc expandingResponseFiles:_expandsResponseFiles];
+    return YES;
+}
+
+- (void)_readArgv:(const char *[])argv argc:(int)argc expandingResponseFiles:(BOOL)expandResponseFiles
+{
+    NSAssert((_spanStorage != nil && !_storageShared), @"reading argv into storage the vector doesn't own");
+    
+    // truncating keeps the storage's capacity, so reading an argv no longer than the last allocates nothing
+    _spanStorage.length = 0;
+    [_responseFiles removeAllObjects];
+    _expandsResponseFiles = expandResponseFiles;
+    _error = nil;
+    
+    for (int i = 0 ; i < argc ; i++) {
+        const char *argument = argv[i];
+        if (expandResponseFiles && argument[0] == '@' && argument[1] != '\0') {
+            NSError *error = nil;
+            NSData *file = [CLKArgumentVector _mapResponseFileAtPath:(argument + 1) error:&error];
+            if (file == nil) {
+                // a vector whose response files couldn't be read is empty
+                [_stream cancel];
+                _stream = nil;
+                _spanStorage.length = 0;
+                [_responseFiles removeAllObjects];
+                _error = error;
+                break;
+            }
+            
+            [_responseFiles addObject:file];
+            CLKAppendResponseFileSpans(_spanStorage, file);
+            continue;
+        }
+        
+        CLKArgumentSpan span = { argument, strlen(argument), nil };
+        [_spanStorage appendBytes:&span length:sizeof(span)];
+    }
+    
+    _spans = _spanStorage.bytes;
+    _range = NSMakeRange(0, (_spanStorage.length / sizeof(CLKArgumentSpan)));
+}
+
+@end
@@ -0,0 +1,57 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class CLKArgumentManifest;
+@class CLKOption;
+@class CLKOptionGroup;
+@class CLKOptionSchema;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// the outcome of parsing one argument vector: a manifest on success, errors on failure
+@interface CLKParsingResult : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nullable, nonatomic, readonly) CLKArgumentManifest *manifest;
+@property (nullable, nonatomic, readonly) NSArray<NSError *> *errors;
+
+// the number of errors and their codes (in the errors' domains), available without building the
+// errors themselves. a result's error descriptions are only formatted once `errors` is read.
+@property (nonatomic, readonly) NSUInteger errorCount;
+@property (nullable, nonatomic, readonly) NSArray<NSNumber *> *errorCodes;
+
+@end
+
+// parses many argument vectors against one set of options.
+//
+// the schema is built once and shared by every vector. vectors are divided among a fixed
+// number of workers; a worker that finishes its share steals half of the remaining share
+// of another worker, so a few expensive vectors don't leave the rest of the pool idle.
+// results are returned in input order. a batch parser is immutable and can be reused,
+// including from several threads at once.
+//
+// the options' transformers are shared by all workers and may be called concurrently.
+@interface CLKBatchParser : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
++ (instancetype)batchParserWithOptions:(NSArray<CLKOption *> *)options optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups;
++ (instancetype)batchParserWithSchema:(CLKOptionSchema *)schema;
+
+// `workerCount` must be at least one. the default is the number of active processors.
++ (instancetype)batchParserWithSchema:(CLKOptionSchema *)schema workerCount:(NSUInteger)workerCount;
+
+@property (nonatomic, readonly) CLKOptionSchema *schema;
+@property (nonatomic, readonly) NSUInteger workerCount;
+
+- (NSArray<CLKParsingResult *> *)parseArgumentVectors:(NSArray<NSArray<NSString *> *> *)vectors;
+
+@end
+
+NS_ASSUME_NONNULL_END
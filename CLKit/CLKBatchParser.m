@@ -0,0 +1,174 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKBatchParser.h"
+
+#import "CLKArgumentIssue.h"
+#import "CLKArgumentParser_Internal.h"
+#import "CLKAssert.h"
+#import "CLKOptionSchema.h"
+#import "CLKWorkShare.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKParsingResult ()
+
+- (instancetype)_initWithManifest:(nullable CLKArgumentManifest *)manifest issues:(nullable NSArray<CLKArgumentIssue *> *)issues NS_DESIGNATED_INITIALIZER;
+
+@end
+
+@interface CLKBatchParser ()
+
+- (instancetype)_initWithSchema:(CLKOptionSchema *)schema workerCount:(NSUInteger)workerCount NS_DESIGNATED_INITIALIZER;
+
+- (CLKParsingResult *)_parseArgumentVector:(NSArray<NSString *> *)argv;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#pragma mark -
+
+@implementation CLKParsingResult
+{
+    CLKArgumentManifest *_manifest;
+    NSArray<CLKArgumentIssue *> *_issues;
+    NSArray<NSError *> *_errors; // built from _issues when first read
+}
+
+@synthesize manifest = _manifest;
+
+- (instancetype)_initWithManifest:(CLKArgumentManifest *)manifest issues:(NSArray<CLKArgumentIssue *> *)issues
+{
+    self = [super init];
+    if (self != nil) {
+        _manifest = manifest;
+        _issues = [issues copy];
+    }
+    
+    return self;
+}
+
+- (NSString *)debugDescription
+{
+    return [NSString stringWithFormat:@"%@ { manifest: %@, errors: %@ }", super.debugDescription, _manifest, self.errors];
+}
+
+- (NSArray<NSError *> *)errors
+{
+    // results are often read from a different thread than the one that parsed them
+    @synchronized (self) {
+        if (_errors == nil && _issues != nil) {
+            NSMutableArray<NSError *> *errors = [[NSMutableArray alloc] initWithCapacity:_issues.count];
+            for (CLKArgumentIssue *issue in _issues) {
+                [errors addObject:issue.error];
+            }
+            
+            _errors = errors;
+        }
+        
+        return _errors;
+    }
+}
+
+- (NSUInteger)errorCount
+{
+    return _issues.count;
+}
+
+- (NSArray<NSNumber *> *)errorCodes
+{
+    if (_issues == nil) {
+        return nil;
+    }
+    
+    NSMutableArray<NSNumber *> *codes = [[NSMutableArray alloc] initWithCapacity:_issues.count];
+    for (CLKArgumentIssue *issue in _issues) {
+        [codes addObject:@(issue.code)];
+    }
+    
+    return codes;
+}
+
+@end
+
+#pragma mark -
+
+@implementation CLKBatchParser
+{
+    CLKOptionSchema *_schema;
+    NSUInteger _workerCount;
+}
+
+@synthesize schema = _schema;
+@synthesize workerCount = _workerCount;
+
++ (instancetype)batchParserWithOptions:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups
+{
+    CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:options optionGroups:groups];
+    return [[self alloc] _initWithSchema:schema workerCount:NSProcessInfo.processInfo.activeProcessorCount];
+}
+
++ (instancetype)batchParserWithSchema:(CLKOptionSchema *)schema
+{
+    return [[self alloc] _initWithSchema:schema workerCount:NSProcessInfo.processInfo.activeProcessorCount];
+}
+
++ (instancetype)batchParserWithSchema:(CLKOptionSchema *)schema workerCount:(NSUInteger)workerCount
+{
+    return [[self alloc] _initWithSchema:schema workerCount:workerCount];
+}
+
+- (instancetype)_initWithSchema:(CLKOptionSchema *)schema workerCount:(NSUInteger)workerCount
+{
+    CLKHardParameterAssert(schema != nil);
+    CLKHardParameterAssert(workerCount > 0);
+    
+    self = [super init];
+    if (self != nil) {
+        _schema = schema;
+        _workerCount = workerCount;
+    }
+    
+    return self;
+}
+
+#pragma mark -
+
+- (NSArray<CLKParsingResult *> *)parseArgumentVectors:(NSArray<NSArray<NSString *> *> *)vectors
+{
+    CLKHardParameterAssert(vectors != nil);
+    CLKHardParameterAssert((vectors.count < UINT32_MAX), @"batches are limited to %u argument vectors", UINT32_MAX - 1);
+    
+    vectors = [vectors copy];
+    uint32_t vectorCount = (uint32_t)vectors.count;
+    if (vectorCount == 0) {
+        return @[];
+    }
+    
+    // each worker writes only the slots for the indexes it takes. the results are retained
+    // here and handed to the array below, once CLKWorkShareApply() has joined the workers.
+    void **slots = calloc(vectorCount, sizeof(void *));
+    CLKWorkShareApply(vectorCount, _workerCount, ^(uint32_t idx) {
+        CLKParsingResult *result = [self _parseArgumentVector:vectors[idx]];
+        slots[idx] = (__bridge_retained void *)result;
+    });
+    
+    NSMutableArray<CLKParsingResult *> *results = [[NSMutableArray alloc] initWithCapacity:vectorCount];
+    for (uint32_t i = 0 ; i < vectorCount ; i++) {
+        [results addObject:(__bridge_transfer CLKParsingResult *)slots[i]];
+    }
+    
+    free(slots);
+    return results;
+}
+
+- (CLKParsingResult *)_parseArgumentVector:(NSArray<NSString *> *)argv
+{
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv schema:_schema];
+    CLKArgumentManifest *manifest = [parser parseArguments];
+    return [[CLKParsingResult alloc] _initWithManifest:manifest issues:parser.issues];
+}
+
+@end
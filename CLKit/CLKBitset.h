@@ -0,0 +1,60 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// fixed-width bitsets over option indexes, stored as arrays of 64-bit words.
+// callers own the storage and pass the word count along.
+
+NS_ASSUME_NONNULL_BEGIN
+
+static inline NSUInteger CLKBitsetWordCount(NSUInteger bitCount)
+{
+    return ((bitCount + 63) / 64);
+}
+
+static inline void CLKBitsetSet(uint64_t *bits, NSUInteger idx)
+{
+    bits[idx / 64] |= (1ULL << (idx % 64));
+}
+
+static inline BOOL CLKBitsetTest(const uint64_t *bits, NSUInteger idx)
+{
+    return ((bits[idx / 64] & (1ULL << (idx % 64))) != 0);
+}
+
+static inline BOOL CLKBitsetIntersects(const uint64_t *lhs, const uint64_t *rhs, NSUInteger wordCount)
+{
+    for (NSUInteger i = 0 ; i < wordCount ; i++) {
+        if (lhs[i] & rhs[i]) {
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+static inline NSUInteger CLKBitsetIntersectionCount(const uint64_t *lhs, const uint64_t *rhs, NSUInteger wordCount)
+{
+    NSUInteger count = 0;
+    for (NSUInteger i = 0 ; i < wordCount ; i++) {
+        count += (NSUInteger)__builtin_popcountll(lhs[i] & rhs[i]);
+    }
+    
+    return count;
+}
+
+// answers YES if any bit in `bits` is outside of `mask`
+static inline BOOL CLKBitsetHasBitsOutsideMask(const uint64_t *bits, const uint64_t *mask, NSUInteger wordCount)
+{
+    for (NSUInteger i = 0 ; i < wordCount ; i++) {
+        if (bits[i] & ~mask[i]) {
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,32 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// the environment a verb runs in. verbs that write output or resolve relative paths through their
+// context behave the same whether they run in their own process or in a CLKVerbServer on behalf of
+// a client, where the working directory and environment are the client's and output is sent to it.
+@interface CLKCommandContext : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
+// the context of the verb running on the calling thread. outside of a server request this is the
+// process's own context, which writes to stdout and stderr.
++ (CLKCommandContext *)currentContext;
+
+@property (readonly) NSString *workingDirectory;
+@property (readonly) NSDictionary<NSString *, NSString *> *environment;
+
+- (void)writeOutputData:(NSData *)data;
+- (void)writeErrorData:(NSData *)data;
+
+- (void)printOutput:(NSString *)format, ... NS_FORMAT_FUNCTION(1, 2);
+- (void)printError:(NSString *)format, ... NS_FORMAT_FUNCTION(1, 2);
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,136 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKCommandContext_Private.h"
+
+#import <stdio.h>
+#import <unistd.h>
+
+#import "CLKAssert.h"
+
+static NSString * const CLKCCCurrentContextKey = @"CLKCommandContext.currentContext";
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKCommandContext ()
+
++ (CLKCommandContext *)_processContext;
+
+- (void)_write:(NSString *)string toStream:(int)stream;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation CLKCommandContext
+{
+    NSString *_workingDirectory;
+    NSDictionary<NSString *, NSString *> *_environment;
+    CLKCommandContextWriter _writer;
+}
+
+@synthesize workingDirectory = _workingDirectory;
+@synthesize environment = _environment;
+
++ (CLKCommandContext *)currentContext
+{
+    CLKCommandContext *context = NSThread.currentThread.threadDictionary[CLKCCCurrentContextKey];
+    return (context != nil ? context : [self _processContext]);
+}
+
++ (CLKCommandContext *)_processContext
+{
+    static CLKCommandContext *processContext;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSString *workingDirectory = NSFileManager.defaultManager.currentDirectoryPath;
+        NSDictionary *environment = NSProcessInfo.processInfo.environment;
+        
+        // through stdio, so the output stays in order with anything else the process prints
+        processContext = [[self alloc] _initWithWorkingDirectory:workingDirectory environment:environment writer:^(int stream, NSData *data) {
+            FILE *file = (stream == STDERR_FILENO ? stderr : stdout);
+            fwrite(data.bytes, 1, data.length, file);
+        }];
+    });
+    
+    return processContext;
+}
+
+- (instancetype)_initWithWorkingDirectory:(NSString *)workingDirectory environment:(NSDictionary<NSString *, NSString *> *)environment writer:(CLKCommandContextWriter)writer
+{
+    CLKHardParameterAssert(workingDirectory != nil);
+    CLKHardParameterAssert(environment != nil);
+    CLKHardParameterAssert(writer != nil);
+    
+    self = [super init];
+    if (self != nil) {
+        _workingDirectory = [workingDirectory copy];
+        _environment = [environment copy];
+        _writer = [writer copy];
+    }
+    
+    return self;
+}
+
+- (void)_performAsCurrentContext:(NS_NOESCAPE void (^)(void))block
+{
+    NSMutableDictionary *threadDictionary = NSThread.currentThread.threadDictionary;
+    CLKCommandContext *previousContext = threadDictionary[CLKCCCurrentContextKey];
+    threadDictionary[CLKCCCurrentContextKey] = self;
+    block();
+    
+    if (previousContext != nil) {
+        threadDictionary[CLKCCCurrentContextKey] = previousContext;
+    } else {
+        [threadDictionary removeObjectForKey:CLKCCCurrentContextKey];
+    }
+}
+
+#pragma mark -
+
+- (void)writeOutputData:(NSData *)data
+{
+    CLKHardParameterAssert(data != nil);
+    _writer(STDOUT_FILENO, data);
+}
+
+- (void)writeErrorData:(NSData *)data
+{
+    CLKHardParameterAssert(data != nil);
+    _writer(STDERR_FILENO, data);
+}
+
+- (void)printOutput:(NSString *)format, ...
+{
+    CLKHardParameterAssert(format != nil);
+    
+    va_list args;
+    va_start(args, format);
+    NSString *string = [[NSString alloc] initWithFormat:format arguments:args];
+    va_end(args);
+    
+    [self _write:string toStream:STDOUT_FILENO];
+}
+
+- (void)printError:(NSString *)format, ...
+{
+    CLKHardParameterAssert(format != nil);
+    
+    va_list args;
+    va_start(args, format);
+    NSString *string = [[NSString alloc] initWithFormat:format arguments:args];
+    va_end(args);
+    
+    [self _write:string toStream:STDERR_FILENO];
+}
+
+- (void)_write:(NSString *)string toStream:(int)stream
+{
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    if (data.length > 0) {
+        _writer(stream, data);
+    }
+}
+
+@end
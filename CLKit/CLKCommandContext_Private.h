@@ -0,0 +1,23 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKCommandContext.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// `stream` is STDOUT_FILENO or STDERR_FILENO. may be called from any thread.
+typedef void (^CLKCommandContextWriter)(int stream, NSData *data);
+
+@interface CLKCommandContext ()
+
+- (instancetype)_initWithWorkingDirectory:(NSString *)workingDirectory
+                              environment:(NSDictionary<NSString *, NSString *> *)environment
+                                   writer:(CLKCommandContextWriter)writer NS_DESIGNATED_INITIALIZER;
+
+// makes the receiver the current context of the calling thread for the duration of `block`
+- (void)_performAsCurrentContext:(NS_NOESCAPE void (^)(void))block;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -4,6 +4,8 @@
 
 #import <Foundation/Foundation.h>
 
+@class CLKParseProfile;
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface CLKCommandResult : NSObject
@@ -22,6 +24,10 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nullable, readonly) NSString *errorDescription;
 @property (nullable, readonly) NSDictionary *userInfo;
 
+// the profile of the parse that ran the verb, for results from a depot with profiling enabled
+// (see -[CLKVerbDepot profilingEnabled])
+@property (nullable, readonly) CLKParseProfile *parseProfile;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -2,20 +2,23 @@
 //  Copyright (c) 2018 Plastic Pulse. All rights reserved.
 //
 
-#import "CLKCommandResult.h"
+#import "CLKCommandResult_Private.h"
 
+#import "CLKArgumentIssue.h"
 #import "CLKError.h"
 
 @implementation CLKCommandResult
 {
     int _exitStatus;
     NSArray<NSError *> *_errors;
+    NSArray<CLKArgumentIssue *> *_issues; // the source of _errors until they are first read
     NSDictionary *_userInfo;
+    CLKParseProfile *_parseProfile;
 }
 
 @synthesize exitStatus = _exitStatus;
-@synthesize errors = _errors;
 @synthesize userInfo = _userInfo;
+@synthesize parseProfile = _parseProfile;
 
 + (instancetype)resultWithExitStatus:(int)exitStatus
 {
@@ -44,6 +47,33 @@
     return self;
 }
 
+- (instancetype)_initWithExitStatus:(int)exitStatus issues:(NSArray<CLKArgumentIssue *> *)issues
+{
+    self = [self initWithExitStatus:exitStatus errors:nil userInfo:nil];
+    if (self != nil) {
+        _issues = [issues copy];
+    }
+    
+    return self;
+}
+
+- (NSArray<NSError *> *)errors
+{
+    @synchronized (self) {
+        if (_issues != nil) {
+            NSMutableArray<NSError *> *errors = [[NSMutableArray alloc] initWithCapacity:_issues.count];
+            for (CLKArgumentIssue *issue in _issues) {
+                [errors addObject:issue.error];
+            }
+            
+            _errors = (errors.count > 0 ? errors : nil);
+            _issues = nil;
+        }
+        
+        return _errors;
+    }
+}
+
 - (NSString *)errorDescription
 {
     if (self.errors.count == 0) {
@@ -0,0 +1,21 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKCommandResult.h"
+
+@class CLKArgumentIssue;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKCommandResult ()
+
+// the result's errors are built from the issues when `errors` or `errorDescription` is first read
+- (instancetype)_initWithExitStatus:(int)exitStatus issues:(NSArray<CLKArgumentIssue *> *)issues;
+
+// set by the depot after the verb has run
+@property (nullable, readwrite) CLKParseProfile *parseProfile;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,89 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "CLKArgumentManifestConstraint.h"
+
+@class CLKOptionRegistry;
+
+// a single compiled constraint. option references are indexes into the registry the
+// program was compiled against. references to unregistered options are CLKConstraintOptionNone,
+// which never counts as present.
+typedef struct {
+    CLKConstraintType type;
+    NSUInteger significantOption;
+    BOOL predicated; // YES if the constraint has a predicating option, even an unregistered one
+    NSUInteger predicatingOption;
+    
+    // word offset into the program's band storage. for mutex and any-required constraints, the band
+    // is the set of banded options. for standalone constraints, it is the whitelist plus the
+    // significant option. unused by other constraint types.
+    NSUInteger bandOffset;
+} CLKConstraintInstruction;
+
+#define CLKConstraintOptionNone NSNotFound
+
+// YES for constraints that stay violated once violated, no matter which options occur afterward.
+// these can be checked as each option occurs; the rest can only be checked once parsing is done.
+static inline BOOL CLKConstraintTypeIsMonotonic(CLKConstraintType type)
+{
+    switch (type) {
+        case CLKConstraintTypeMutuallyExclusive:
+        case CLKConstraintTypeStandalone:
+        case CLKConstraintTypeOccurrencesLimited:
+            return YES;
+        
+        case CLKConstraintTypeRequired:
+        case CLKConstraintTypeAnyRequired:
+            return NO;
+    }
+}
+
+NS_ASSUME_NONNULL_BEGIN
+
+// a deduplicated list of constraints compiled into bitset tests over option indexes.
+// immutable and safe to share across threads.
+@interface CLKConstraintProgram : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
++ (instancetype)programWithConstraints:(NSArray<CLKArgumentManifestConstraint *> *)constraints optionRegistry:(CLKOptionRegistry *)registry;
+
+// adopts instructions and bands compiled by another program from the same constraints, without copying
+// or checking them. `constraintIndexes` maps each instruction to the constraint in `constraints` it was
+// compiled from. `tablesOwner` is retained for as long as the program uses the tables.
++ (instancetype)programWithConstraints:(NSArray<CLKArgumentManifestConstraint *> *)constraints
+                          instructions:(const CLKConstraintInstruction *)instructions
+                     constraintIndexes:(const uint32_t *)constraintIndexes
+                      instructionCount:(NSUInteger)instructionCount
+                                 bands:(const uint64_t *)bands
+                        optionRegistry:(CLKOptionRegistry *)registry
+                           tablesOwner:(id)tablesOwner;
+
+@property (nonatomic, readonly) CLKOptionRegistry *optionRegistry;
+
+// the number of words in each bitset used by the program: its bands and the manifest's occurrence sets
+@property (nonatomic, readonly) NSUInteger bitsetWordCount;
+
+@property (nonatomic, readonly) NSUInteger instructionCount;
+- (const CLKConstraintInstruction *)instructionAtIndex:(NSUInteger)idx;
+- (CLKArgumentManifestConstraint *)constraintAtIndex:(NSUInteger)idx;
+- (const uint64_t *)bandForInstruction:(const CLKConstraintInstruction *)instruction;
+
+// the monotonic instructions an occurrence of the option can newly violate, in program order: mutex
+// instructions banding it, and instructions it is the significant or predicating option of. a standalone
+// instruction can also be violated by any option outside its whitelist once its significant option is
+// present, so callers checking options as they occur have to keep those instructions in view themselves.
+- (const uint32_t *)monotonicInstructionIndexesForOption:(NSUInteger)optionIndex count:(NSUInteger *)outCount;
+
+// the program's storage, for writing it to a CLKSchemaArchive
+@property (nonatomic, readonly) const CLKConstraintInstruction *instructions;
+@property (nonatomic, readonly) const uint64_t *bands;
+@property (nonatomic, readonly) NSUInteger bandStorageWordCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,296 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKConstraintProgram.h"
+
+#import "CLKAssert.h"
+#import "CLKBitset.h"
+#import "CLKOptionRegistry.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKConstraintProgram ()
+
+- (instancetype)_initWithConstraints:(NSArray<CLKArgumentManifestConstraint *> *)constraints optionRegistry:(CLKOptionRegistry *)registry NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)_initWithConstraints:(NSArray<CLKArgumentManifestConstraint *> *)constraints
+                        instructions:(const CLKConstraintInstruction *)instructions
+                   constraintIndexes:(const uint32_t *)constraintIndexes
+                    instructionCount:(NSUInteger)instructionCount
+                               bands:(const uint64_t *)bands
+                      optionRegistry:(CLKOptionRegistry *)registry
+                         tablesOwner:(id)tablesOwner NS_DESIGNATED_INITIALIZER;
+
+- (NSUInteger)_indexOfOptionNamed:(nullable NSString *)optionName;
+- (void)_indexMonotonicInstructions;
+- (void)_enumerateOptionsInvolvedInInstruction:(const CLKConstraintInstruction *)instruction usingBlock:(void (^)(NSUInteger optionIndex))block;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation CLKConstraintProgram
+{
+    CLKOptionRegistry *_optionRegistry;
+    NSUInteger _bitsetWordCount;
+    NSArray<CLKArgumentManifestConstraint *> *_constraints; // parallel to _instructions
+    CLKConstraintInstruction *_instructions;
+    NSUInteger _instructionCount;
+    uint64_t *_bands;
+    NSUInteger _bandStorageWordCount;
+    
+    // set when the instructions and bands belong to someone else. _constraints is then the list the
+    // instructions were compiled from, and _constraintIndexes maps each instruction to its constraint.
+    id _tablesOwner;
+    const uint32_t *_constraintIndexes;
+    
+    // the monotonic instructions involving each option, by option index. the instructions for option `i`
+    // are _monotonicInstructionIndexes[_monotonicOffsets[i]] up to _monotonicInstructionIndexes[_monotonicOffsets[i + 1]].
+    // always owned by the program, even when the tables are not.
+    NSUInteger *_monotonicOffsets;
+    uint32_t *_monotonicInstructionIndexes;
+}
+
+@synthesize optionRegistry = _optionRegistry;
+@synthesize bitsetWordCount = _bitsetWordCount;
+@synthesize bandStorageWordCount = _bandStorageWordCount;
+
++ (instancetype)programWithConstraints:(NSArray<CLKArgumentManifestConstraint *> *)constraints optionRegistry:(CLKOptionRegistry *)registry
+{
+    return [[self alloc] _initWithConstraints:constraints optionRegistry:registry];
+}
+
++ (instancetype)programWithConstraints:(NSArray<CLKArgumentManifestConstraint *> *)constraints
+                          instructions:(const CLKConstraintInstruction *)instructions
+                     constraintIndexes:(const uint32_t *)constraintIndexes
+                      instructionCount:(NSUInteger)instructionCount
+                                 bands:(const uint64_t *)bands
+                        optionRegistry:(CLKOptionRegistry *)registry
+                           tablesOwner:(id)tablesOwner
+{
+    return [[self alloc] _initWithConstraints:constraints instructions:instructions constraintIndexes:constraintIndexes instructionCount:instructionCount bands:bands optionRegistry:registry tablesOwner:tablesOwner];
+}
+
+- (instancetype)_initWithConstraints:(NSArray<CLKArgumentManifestConstraint *> *)constraints optionRegistry:(CLKOptionRegistry *)registry
+{
+    CLKHardParameterAssert(constraints != nil);
+    CLKHardParameterAssert(registry != nil);
+    
+    self = [super init];
+    if (self != nil) {
+        _optionRegistry = registry;
+        _bitsetWordCount = CLKBitsetWordCount(registry.options.count);
+        
+        // eliminate redundant errors by deduplicating identical constraints.
+        // use an ordered set to assist testing.
+        _constraints = [[NSOrderedSet alloc] initWithArray:constraints].array;
+        _instructionCount = _constraints.count;
+        
+        NSUInteger bandCount = 0;
+        for (CLKArgumentManifestConstraint *constraint in _constraints) {
+            if (constraint.type == CLKConstraintTypeAnyRequired
+                || constraint.type == CLKConstraintTypeMutuallyExclusive
+                || constraint.type == CLKConstraintTypeStandalone)
+            {
+                bandCount++;
+            }
+        }
+        
+        _instructions = calloc(MAX(_constraints.count, 1UL), sizeof(CLKConstraintInstruction));
+        _bandStorageWordCount = (bandCount * _bitsetWordCount);
+        _bands = calloc(MAX(_bandStorageWordCount, 1UL), sizeof(uint64_t));
+        
+        NSUInteger bandOffset = 0;
+        for (NSUInteger i = 0 ; i < _constraints.count ; i++) {
+            CLKArgumentManifestConstraint *constraint = _constraints[i];
+            CLKConstraintInstruction *instruction = &_instructions[i];
+            instruction->type = constraint.type;
+            instruction->significantOption = [self _indexOfOptionNamed:constraint.significantOption];
+            instruction->predicated = (constraint.predicatingOption != nil);
+            instruction->predicatingOption = [self _indexOfOptionNamed:constraint.predicatingOption];
+            instruction->bandOffset = CLKConstraintOptionNone;
+            
+            switch (constraint.type) {
+                case CLKConstraintTypeRequired:
+                case CLKConstraintTypeOccurrencesLimited:
+                    break;
+                
+                case CLKConstraintTypeAnyRequired:
+                case CLKConstraintTypeMutuallyExclusive:
+                case CLKConstraintTypeStandalone: {
+                    instruction->bandOffset = bandOffset;
+                    uint64_t *band = _bands + bandOffset;
+                    bandOffset += _bitsetWordCount;
+                    
+                    for (NSString *optionName in constraint.bandedOptions) {
+                        NSUInteger optionIndex = [self _indexOfOptionNamed:optionName];
+                        if (optionIndex != CLKConstraintOptionNone) {
+                            CLKBitsetSet(band, optionIndex);
+                        }
+                    }
+                    
+                    if (constraint.type == CLKConstraintTypeStandalone && instruction->significantOption != CLKConstraintOptionNone) {
+                        CLKBitsetSet(band, instruction->significantOption);
+                    }
+                    
+                    break;
+                }
+            }
+        }
+        
+        [self _indexMonotonicInstructions];
+    }
+    
+    return self;
+}
+
+- (instancetype)_initWithConstraints:(NSArray<CLKArgumentManifestConstraint *> *)constraints
+                        instructions:(const CLKConstraintInstruction *)instructions
+                   constraintIndexes:(const uint32_t *)constraintIndexes
+                    instructionCount:(NSUInteger)instructionCount
+                               bands:(const uint64_t *)bands
+                      optionRegistry:(CLKOptionRegistry *)registry
+                         tablesOwner:(id)tablesOwner
+{
+    CLKHardParameterAssert(constraints != nil);
+    CLKHardParameterAssert(registry != nil);
+    CLKHardParameterAssert(tablesOwner != nil);
+    
+    self = [super init];
+    if (self != nil) {
+        _optionRegistry = registry;
+        _bitsetWordCount = CLKBitsetWordCount(registry.options.count);
+        _constraints = [constraints copy];
+        _instructions = (CLKConstraintInstruction *)instructions;
+        _instructionCount = instructionCount;
+        _bands = (uint64_t *)bands;
+        _tablesOwner = tablesOwner;
+        _constraintIndexes = constraintIndexes;
+        [self _indexMonotonicInstructions];
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_tablesOwner == nil) {
+        free(_instructions);
+        free(_bands);
+    }
+    
+    free(_monotonicOffsets);
+    free(_monotonicInstructionIndexes);
+}
+
+- (void)_indexMonotonicInstructions
+{
+    NSUInteger optionCount = _optionRegistry.options.count;
+    _monotonicOffsets = calloc((optionCount + 1), sizeof(NSUInteger));
+    
+    // count the instructions for each option, then turn the counts into offsets and fill the
+    // offsets back in as the instructions are placed. instructions are visited in order, so
+    // each option's instructions end up in program order.
+    for (NSUInteger i = 0 ; i < _instructionCount ; i++) {
+        [self _enumerateOptionsInvolvedInInstruction:&_instructions[i] usingBlock:^(NSUInteger optionIndex) {
+            self->_monotonicOffsets[optionIndex + 1]++;
+        }];
+    }
+    
+    for (NSUInteger i = 0 ; i < optionCount ; i++) {
+        _monotonicOffsets[i + 1] += _monotonicOffsets[i];
+    }
+    
+    _monotonicInstructionIndexes = calloc(MAX(_monotonicOffsets[optionCount], 1UL), sizeof(uint32_t));
+    NSUInteger *cursors = calloc(MAX(optionCount, 1UL), sizeof(NSUInteger));
+    memcpy(cursors, _monotonicOffsets, (optionCount * sizeof(NSUInteger)));
+    for (NSUInteger i = 0 ; i < _instructionCount ; i++) {
+        [self _enumerateOptionsInvolvedInInstruction:&_instructions[i] usingBlock:^(NSUInteger optionIndex) {
+            self->_monotonicInstructionIndexes[cursors[optionIndex]++] = (uint32_t)i;
+        }];
+    }
+    
+    free(cursors);
+}
+
+- (void)_enumerateOptionsInvolvedInInstruction:(const CLKConstraintInstruction *)instruction usingBlock:(void (^)(NSUInteger optionIndex))block
+{
+    if (!CLKConstraintTypeIsMonotonic(instruction->type)) {
+        return;
+    }
+    
+    BOOL predicatingOptionInvolved = NO;
+    if (instruction->type == CLKConstraintTypeMutuallyExclusive) {
+        const uint64_t *band = (_bands + instruction->bandOffset);
+        for (NSUInteger w = 0 ; w < _bitsetWordCount ; w++) {
+            for (uint64_t bits = band[w] ; bits != 0 ; bits &= (bits - 1)) {
+                block((w * 64) + (NSUInteger)__builtin_ctzll(bits));
+            }
+        }
+        
+        predicatingOptionInvolved = (instruction->predicatingOption != CLKConstraintOptionNone && CLKBitsetTest(band, instruction->predicatingOption));
+    } else if (instruction->significantOption != CLKConstraintOptionNone) {
+        block(instruction->significantOption);
+        predicatingOptionInvolved = (instruction->predicatingOption == instruction->significantOption);
+    }
+    
+    // listing an instruction twice under one option would only check it twice
+    if (instruction->predicatingOption != CLKConstraintOptionNone && !predicatingOptionInvolved) {
+        block(instruction->predicatingOption);
+    }
+}
+
+- (NSUInteger)_indexOfOptionNamed:(NSString *)optionName
+{
+    if (optionName == nil) {
+        return CLKConstraintOptionNone;
+    }
+    
+    return [_optionRegistry indexOfOptionNamed:optionName];
+}
+
+#pragma mark -
+
+- (NSUInteger)instructionCount
+{
+    return _instructionCount;
+}
+
+- (const CLKConstraintInstruction *)instructionAtIndex:(NSUInteger)idx
+{
+    NSParameterAssert(idx < _instructionCount);
+    return &_instructions[idx];
+}
+
+- (CLKArgumentManifestConstraint *)constraintAtIndex:(NSUInteger)idx
+{
+    NSParameterAssert(idx < _instructionCount);
+    return _constraints[(_constraintIndexes != NULL ? _constraintIndexes[idx] : idx)];
+}
+
+- (const uint64_t *)bandForInstruction:(const CLKConstraintInstruction *)instruction
+{
+    NSParameterAssert(instruction->bandOffset != CLKConstraintOptionNone);
+    return (_bands + instruction->bandOffset);
+}
+
+- (const uint32_t *)monotonicInstructionIndexesForOption:(NSUInteger)optionIndex count:(NSUInteger *)outCount
+{
+    NSParameterAssert(optionIndex < _optionRegistry.options.count);
+    NSParameterAssert(outCount != NULL);
+    *outCount = (_monotonicOffsets[optionIndex + 1] - _monotonicOffsets[optionIndex]);
+    return (_monotonicInstructionIndexes + _monotonicOffsets[optionIndex]);
+}
+
+- (const CLKConstraintInstruction *)instructions
+{
+    return _instructions;
+}
+
+- (const uint64_t *)bands
+{
+    return _bands;
+}
+
+@end
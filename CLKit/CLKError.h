@@ -8,6 +8,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 extern NSString * const CLKErrorDomain;
 
+// in the user info of errors for unrecognized options and verbs: an array of the closest
+// recognized ones, as they would be written (`--verbose`), when any are close enough
+extern NSString * const CLKSuggestionsErrorKey;
+
 NS_ASSUME_NONNULL_END
 
 typedef NS_ERROR_ENUM(CLKErrorDomain, CLKError) {
@@ -20,5 +24,11 @@ typedef NS_ERROR_ENUM(CLKErrorDomain, CLKError) {
     
     // verb errors
     CLKErrorNoVerbSpecified = 200,
-    CLKErrorUnrecognizedVerb = 201
+    CLKErrorUnrecognizedVerb = 201,
+    
+    // schema archive errors
+    CLKErrorInvalidSchemaArchive = 300,
+    
+    // option source errors
+    CLKErrorInvalidConfigFile = 400
 };
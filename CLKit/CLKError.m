@@ -5,3 +5,4 @@
 #import "CLKError.h"
 
 NSString * const CLKErrorDomain = @"com.plasticpulse.clkit.error-domain";
+NSString * const CLKSuggestionsErrorKey = @"CLKSuggestions";
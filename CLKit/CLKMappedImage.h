@@ -0,0 +1,38 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// helpers shared by the binary images CLKit maps from disk: compiled config files and schema archives.
+// both are a header followed by sections aligned to CLKMappedImageAlignment, referred to by their
+// offset from the start of the image, with names stored as UTF-16 and sorted by code unit.
+
+#define CLKMappedImageAlignment 8U
+
+NS_ASSUME_NONNULL_BEGIN
+
+// YES if `count` elements of `elementSize` bytes at `offset` lie within an image of `length` bytes
+static inline BOOL CLKMappedImageSectionIsValid(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t length)
+{
+    if ((offset % CLKMappedImageAlignment) != 0 || offset > length) {
+        return NO;
+    }
+    
+    return (count <= ((length - offset) / elementSize));
+}
+
+// orders by UTF-16 code unit, which is not necessarily -compare:'s order
+static inline int CLKMappedImageCompareCharacters(const unichar *lhs, NSUInteger lhsLength, const unichar *rhs, NSUInteger rhsLength)
+{
+    NSUInteger length = MIN(lhsLength, rhsLength);
+    for (NSUInteger i = 0 ; i < length ; i++) {
+        if (lhs[i] != rhs[i]) {
+            return (lhs[i] < rhs[i] ? -1 : 1);
+        }
+    }
+    
+    return (lhsLength == rhsLength ? 0 : (lhsLength < rhsLength ? -1 : 1));
+}
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,43 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// strict numeric parsers over UTF-16 character buffers, used by the numeric argument transformers.
+//
+// the parsers consume the entire buffer; leading or trailing whitespace, or anything else that
+// isn't part of the number, is malformed. results that don't fit their type are out of range
+// rather than clamped. nothing is allocated.
+
+typedef NS_ENUM(uint32_t, CLKNumericParseResult) {
+    CLKNumericParseResultSuccess = 0,
+    CLKNumericParseResultMalformed = 1,
+    CLKNumericParseResultOutOfRange = 2
+};
+
+NS_ASSUME_NONNULL_BEGIN
+
+// decimal, or hexadecimal with a `0x` prefix, or octal with a `0o` prefix.
+// a leading zero alone doesn't make a number octal.
+CLKNumericParseResult CLKParseUInt64(const unichar *characters, NSUInteger length, uint64_t *outValue);
+
+// CLKParseUInt64() with an optional leading `-` or `+`
+CLKNumericParseResult CLKParseInt64(const unichar *characters, NSUInteger length, int64_t *outValue);
+
+// `[+-]digits[.digits][e[+-]digits]`. the integer or the fraction may be omitted, but not both.
+CLKNumericParseResult CLKParseDouble(const unichar *characters, NSUInteger length, double *outValue);
+
+// a decimal count of bytes with an optional unit: `64K`, `2GiB`, `1500KB`. units are case-insensitive.
+// K, M, G, T, P and E, alone or followed by `iB`, are powers of 1024. followed by `B`, they are powers
+// of 1000. `B` or no unit at all is bytes.
+CLKNumericParseResult CLKParseByteSize(const unichar *characters, NSUInteger length, uint64_t *outValue);
+
+// a sequence of decimal numbers, each with an optional fraction and a unit: `250ms`, `1h30m`, `1.5s`.
+// the units are ns, us (or µs), ms, s, m, h and d. a bare `0` is also accepted.
+CLKNumericParseResult CLKParseDuration(const unichar *characters, NSUInteger length, int64_t *outNanoseconds);
+
+// runs `parser` over the characters of `string`, read into a stack buffer when the string is short
+CLKNumericParseResult CLKParseCharactersOfString(NSString *string, NS_NOESCAPE CLKNumericParseResult (^parser)(const unichar *characters, NSUInteger length));
+
+NS_ASSUME_NONNULL_END
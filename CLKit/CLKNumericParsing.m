@@ -0,0 +1,471 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKNumericParsing.h"
+
+#import <math.h>
+
+// arguments up to this length are parsed out of a stack buffer
+#define CLKNumericStackBufferLength 64
+
+// fraction digits beyond these don't affect a duration
+#define CLKDurationMaxFractionDigits 18
+
+NS_ASSUME_NONNULL_BEGIN
+
+static inline BOOL CLKLoadEightCharacters(const unichar *characters, uint64_t *outChunk);
+static inline BOOL CLKChunkIsEightDigits(uint64_t chunk);
+static inline uint32_t CLKChunkParseEightDigits(uint64_t chunk);
+static inline BOOL CLKCharacterIsDigit(unichar c);
+static inline unichar CLKCharacterLowercase(unichar c);
+
+static CLKNumericParseResult CLKParseDecimalDigits(const unichar *characters, NSUInteger length, NSUInteger *ioIndex, uint64_t *outValue);
+static CLKNumericParseResult CLKParseRadixDigits(const unichar *characters, NSUInteger length, NSUInteger *ioIndex, unsigned int bitsPerDigit, uint64_t *outValue);
+static CLKNumericParseResult CLKParseMagnitude(const unichar *characters, NSUInteger length, NSUInteger *ioIndex, uint64_t *outValue);
+static BOOL CLKParseDurationUnit(const unichar *characters, NSUInteger length, NSUInteger *ioIndex, uint64_t *outNanoseconds);
+
+NS_ASSUME_NONNULL_END
+
+#pragma mark -
+#pragma mark Digits
+
+// packs eight ASCII characters into a word, first character in the low byte. answers NO if any of them aren't ASCII.
+static inline BOOL CLKLoadEightCharacters(const unichar *characters, uint64_t *outChunk)
+{
+    uint64_t chunk = 0;
+    unichar high = 0;
+    for (unsigned int i = 0 ; i < 8 ; i++) {
+        high |= characters[i];
+        chunk |= ((uint64_t)(characters[i] & 0xFF) << (i * 8));
+    }
+    
+    *outChunk = chunk;
+    return ((high & 0xFF80) == 0);
+}
+
+// every byte is in ['0', '9']: its high nibble is 3, and adding 6 doesn't carry out of the low nibble
+static inline BOOL CLKChunkIsEightDigits(uint64_t chunk)
+{
+    return (((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
+
+// combines adjacent digits pairwise (into 2-digit, then 4-digit, then the 8-digit value) with three multiplications
+static inline uint32_t CLKChunkParseEightDigits(uint64_t chunk)
+{
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 0x000F424000000064ULL; // 100 + (1000000 << 32)
+    const uint64_t mul2 = 0x0000271000000001ULL; // 1 + (10000 << 32)
+    
+    chunk -= 0x3030303030303030ULL;
+    chunk = ((chunk * 10) + (chunk >> 8));
+    chunk = ((((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32);
+    return (uint32_t)chunk;
+}
+
+static inline BOOL CLKCharacterIsDigit(unichar c)
+{
+    return (c >= '0' && c <= '9');
+}
+
+static inline unichar CLKCharacterLowercase(unichar c)
+{
+    return ((c >= 'A' && c <= 'Z') ? (c | 0x20) : c);
+}
+
+// parses a run of decimal digits starting at *ioIndex, leaving *ioIndex after the run.
+// digits past the range of uint64_t are still consumed so the caller sees where the number ends.
+static CLKNumericParseResult CLKParseDecimalDigits(const unichar *characters, NSUInteger length, NSUInteger *ioIndex, uint64_t *outValue)
+{
+    NSUInteger i = *ioIndex;
+    NSUInteger start = i;
+    uint64_t value = 0;
+    BOOL overflow = NO;
+    
+    uint64_t chunk;
+    while ((length - i) >= 8 && CLKLoadEightCharacters(characters + i, &chunk) && CLKChunkIsEightDigits(chunk)) {
+        overflow |= __builtin_mul_overflow(value, 100000000ULL, &value);
+        overflow |= __builtin_add_overflow(value, CLKChunkParseEightDigits(chunk), &value);
+        i += 8;
+    }
+    
+    for ( ; i < length && CLKCharacterIsDigit(characters[i]) ; i++) {
+        overflow |= __builtin_mul_overflow(value, 10ULL, &value);
+        overflow |= __builtin_add_overflow(value, (uint64_t)(characters[i] - '0'), &value);
+    }
+    
+    if (i == start) {
+        return CLKNumericParseResultMalformed;
+    }
+    
+    *ioIndex = i;
+    *outValue = value;
+    return (overflow ? CLKNumericParseResultOutOfRange : CLKNumericParseResultSuccess);
+}
+
+// hexadecimal (4 bits per digit) or octal (3 bits per digit)
+static CLKNumericParseResult CLKParseRadixDigits(const unichar *characters, NSUInteger length, NSUInteger *ioIndex, unsigned int bitsPerDigit, uint64_t *outValue)
+{
+    NSUInteger i = *ioIndex;
+    NSUInteger start = i;
+    uint64_t value = 0;
+    BOOL overflow = NO;
+    
+    for ( ; i < length ; i++) {
+        unichar c = CLKCharacterLowercase(characters[i]);
+        uint64_t digit;
+        if (CLKCharacterIsDigit(c)) {
+            digit = (uint64_t)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            digit = (uint64_t)(c - 'a' + 10);
+        } else {
+            break;
+        }
+        
+        if (digit >= (1ULL << bitsPerDigit)) {
+            break;
+        }
+        
+        overflow |= ((value >> (64 - bitsPerDigit)) != 0);
+        value = ((value << bitsPerDigit) | digit);
+    }
+    
+    if (i == start) {
+        return CLKNumericParseResultMalformed;
+    }
+    
+    *ioIndex = i;
+    *outValue = value;
+    return (overflow ? CLKNumericParseResultOutOfRange : CLKNumericParseResultSuccess);
+}
+
+static CLKNumericParseResult CLKParseMagnitude(const unichar *characters, NSUInteger length, NSUInteger *ioIndex, uint64_t *outValue)
+{
+    NSUInteger i = *ioIndex;
+    if ((length - i) > 2 && characters[i] == '0') {
+        unichar prefix = CLKCharacterLowercase(characters[i + 1]);
+        if (prefix == 'x' || prefix == 'o') {
+            *ioIndex = (i + 2);
+            return CLKParseRadixDigits(characters, length, ioIndex, (prefix == 'x' ? 4 : 3), outValue);
+        }
+    }
+    
+    return CLKParseDecimalDigits(characters, length, ioIndex, outValue);
+}
+
+#pragma mark -
+#pragma mark Integers
+
+CLKNumericParseResult CLKParseUInt64(const unichar *characters, NSUInteger length, uint64_t *outValue)
+{
+    NSUInteger i = 0;
+    uint64_t value;
+    CLKNumericParseResult result = CLKParseMagnitude(characters, length, &i, &value);
+    if (result == CLKNumericParseResultMalformed || i != length) {
+        return CLKNumericParseResultMalformed;
+    }
+    
+    if (result == CLKNumericParseResultSuccess) {
+        *outValue = value;
+    }
+    
+    return result;
+}
+
+CLKNumericParseResult CLKParseInt64(const unichar *characters, NSUInteger length, int64_t *outValue)
+{
+    BOOL negative = NO;
+    NSUInteger i = 0;
+    if (length > 0 && (characters[0] == '-' || characters[0] == '+')) {
+        negative = (characters[0] == '-');
+        i++;
+    }
+    
+    uint64_t magnitude;
+    CLKNumericParseResult result = CLKParseMagnitude(characters, length, &i, &magnitude);
+    if (result == CLKNumericParseResultMalformed || i != length) {
+        return CLKNumericParseResultMalformed;
+    }
+    
+    uint64_t limit = (negative ? ((uint64_t)INT64_MAX + 1) : (uint64_t)INT64_MAX);
+    if (result == CLKNumericParseResultOutOfRange || magnitude > limit) {
+        return CLKNumericParseResultOutOfRange;
+    }
+    
+    // -(INT64_MIN) isn't representable, so negate in unsigned arithmetic
+    *outValue = (negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude);
+    return CLKNumericParseResultSuccess;
+}
+
+#pragma mark -
+#pragma mark Floating Point
+
+CLKNumericParseResult CLKParseDouble(const unichar *characters, NSUInteger length, double *outValue)
+{
+    // validate the grammar here so strtod() can't accept anything broader (whitespace, hex floats, `inf`, `nan`)
+    NSUInteger i = 0;
+    if (i < length && (characters[i] == '-' || characters[i] == '+')) {
+        i++;
+    }
+    
+    NSUInteger mantissaDigits = 0;
+    for ( ; i < length && CLKCharacterIsDigit(characters[i]) ; i++) {
+        mantissaDigits++;
+    }
+    
+    if (i < length && characters[i] == '.') {
+        for (i++ ; i < length && CLKCharacterIsDigit(characters[i]) ; i++) {
+            mantissaDigits++;
+        }
+    }
+    
+    if (mantissaDigits == 0) {
+        return CLKNumericParseResultMalformed;
+    }
+    
+    if (i < length && CLKCharacterLowercase(characters[i]) == 'e') {
+        i++;
+        if (i < length && (characters[i] == '-' || characters[i] == '+')) {
+            i++;
+        }
+        
+        NSUInteger exponentStart = i;
+        while (i < length && CLKCharacterIsDigit(characters[i])) {
+            i++;
+        }
+        
+        if (i == exponentStart) {
+            return CLKNumericParseResultMalformed;
+        }
+    }
+    
+    if (i != length) {
+        return CLKNumericParseResultMalformed;
+    }
+    
+    // the grammar is all ASCII, so narrowing is exact
+    char stackBuffer[CLKNumericStackBufferLength + 1];
+    char *buffer = stackBuffer;
+    if (length > CLKNumericStackBufferLength) {
+        buffer = malloc(length + 1);
+    }
+    
+    for (i = 0 ; i < length ; i++) {
+        buffer[i] = (char)characters[i];
+    }
+    
+    buffer[length] = '\0';
+    double value = strtod(buffer, NULL);
+    
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+    
+    // underflow rounds toward zero, which is fine; overflow has no sensible value
+    if (isinf(value)) {
+        return CLKNumericParseResultOutOfRange;
+    }
+    
+    *outValue = value;
+    return CLKNumericParseResultSuccess;
+}
+
+#pragma mark -
+#pragma mark Units
+
+CLKNumericParseResult CLKParseByteSize(const unichar *characters, NSUInteger length, uint64_t *outValue)
+{
+    NSUInteger i = 0;
+    uint64_t count;
+    CLKNumericParseResult result = CLKParseDecimalDigits(characters, length, &i, &count);
+    if (result == CLKNumericParseResultMalformed) {
+        return result;
+    }
+    
+    unsigned int exponent = 0;
+    uint64_t base = 1024;
+    if (i < length) {
+        switch (CLKCharacterLowercase(characters[i])) {
+            case 'b': exponent = 0; break;
+            case 'k': exponent = 1; break;
+            case 'm': exponent = 2; break;
+            case 'g': exponent = 3; break;
+            case 't': exponent = 4; break;
+            case 'p': exponent = 5; break;
+            case 'e': exponent = 6; break;
+            default: return CLKNumericParseResultMalformed;
+        }
+        
+        i++;
+        
+        if (exponent > 0 && i < length) {
+            if ((length - i) == 2 && CLKCharacterLowercase(characters[i]) == 'i' && CLKCharacterLowercase(characters[i + 1]) == 'b') {
+                i += 2;
+            } else if ((length - i) == 1 && CLKCharacterLowercase(characters[i]) == 'b') {
+                base = 1000;
+                i++;
+            }
+        }
+    }
+    
+    if (i != length) {
+        return CLKNumericParseResultMalformed;
+    }
+    
+    if (result == CLKNumericParseResultOutOfRange) {
+        return result;
+    }
+    
+    uint64_t value = count;
+    for (unsigned int e = 0 ; e < exponent ; e++) {
+        if (__builtin_mul_overflow(value, base, &value)) {
+            return CLKNumericParseResultOutOfRange;
+        }
+    }
+    
+    *outValue = value;
+    return CLKNumericParseResultSuccess;
+}
+
+static BOOL CLKParseDurationUnit(const unichar *characters, NSUInteger length, NSUInteger *ioIndex, uint64_t *outNanoseconds)
+{
+    NSUInteger i = *ioIndex;
+    if (i >= length) {
+        return NO;
+    }
+    
+    unichar c = characters[i];
+    BOOL followedByS = ((i + 1) < length && characters[i + 1] == 's');
+    uint64_t nanoseconds;
+    NSUInteger unitLength = 1;
+    
+    switch (c) {
+        case 'n':
+            if (!followedByS) {
+                return NO;
+            }
+            
+            nanoseconds = 1;
+            unitLength = 2;
+            break;
+        
+        case 'u':
+        case 0x00B5: // MICRO SIGN
+        case 0x03BC: // GREEK SMALL LETTER MU
+            if (!followedByS) {
+                return NO;
+            }
+            
+            nanoseconds = 1000;
+            unitLength = 2;
+            break;
+        
+        case 'm':
+            if (followedByS) {
+                nanoseconds = 1000000;
+                unitLength = 2;
+            } else {
+                nanoseconds = (60 * 1000000000ULL);
+            }
+            
+            break;
+        
+        case 's':
+            nanoseconds = 1000000000ULL;
+            break;
+        
+        case 'h':
+            nanoseconds = (60 * 60 * 1000000000ULL);
+            break;
+        
+        case 'd':
+            nanoseconds = (24 * 60 * 60 * 1000000000ULL);
+            break;
+        
+        default:
+            return NO;
+    }
+    
+    *ioIndex = (i + unitLength);
+    *outNanoseconds = nanoseconds;
+    return YES;
+}
+
+CLKNumericParseResult CLKParseDuration(const unichar *characters, NSUInteger length, int64_t *outNanoseconds)
+{
+    if (length == 1 && characters[0] == '0') {
+        *outNanoseconds = 0;
+        return CLKNumericParseResultSuccess;
+    }
+    
+    if (length == 0) {
+        return CLKNumericParseResultMalformed;
+    }
+    
+    uint64_t total = 0;
+    BOOL overflow = NO;
+    NSUInteger i = 0;
+    while (i < length) {
+        // `.5s` has no integer part; `5.s` and `.s` are malformed
+        uint64_t integer = 0;
+        CLKNumericParseResult integerResult = CLKParseDecimalDigits(characters, length, &i, &integer);
+        BOOL hasInteger = (integerResult != CLKNumericParseResultMalformed);
+        overflow |= (integerResult == CLKNumericParseResultOutOfRange);
+        
+        uint64_t fraction = 0;
+        uint64_t fractionScale = 1;
+        if (i < length && characters[i] == '.') {
+            NSUInteger fractionStart = ++i;
+            for ( ; i < length && CLKCharacterIsDigit(characters[i]) ; i++) {
+                if ((i - fractionStart) < CLKDurationMaxFractionDigits) {
+                    fraction = ((fraction * 10) + (uint64_t)(characters[i] - '0'));
+                    fractionScale *= 10;
+                }
+            }
+            
+            if (i == fractionStart) {
+                return CLKNumericParseResultMalformed;
+            }
+        } else if (!hasInteger) {
+            return CLKNumericParseResultMalformed;
+        }
+        
+        uint64_t unit;
+        if (!CLKParseDurationUnit(characters, length, &i, &unit)) {
+            return CLKNumericParseResultMalformed;
+        }
+        
+        uint64_t component;
+        overflow |= __builtin_mul_overflow(integer, unit, &component);
+        overflow |= __builtin_add_overflow(component, (uint64_t)llround(((double)fraction / (double)fractionScale) * (double)unit), &component);
+        overflow |= __builtin_add_overflow(total, component, &total);
+    }
+    
+    if (overflow || total > (uint64_t)INT64_MAX) {
+        return CLKNumericParseResultOutOfRange;
+    }
+    
+    *outNanoseconds = (int64_t)total;
+    return CLKNumericParseResultSuccess;
+}
+
+#pragma mark -
+
+CLKNumericParseResult CLKParseCharactersOfString(NSString *string, CLKNumericParseResult (^parser)(const unichar *, NSUInteger))
+{
+    NSUInteger length = string.length;
+    unichar stackBuffer[CLKNumericStackBufferLength];
+    unichar *characters = stackBuffer;
+    if (length > CLKNumericStackBufferLength) {
+        characters = malloc(length * sizeof(unichar));
+    }
+    
+    [string getCharacters:characters range:NSMakeRange(0, length)];
+    CLKNumericParseResult result = parser(characters, length);
+    
+    if (characters != stackBuffer) {
+        free(characters);
+    }
+    
+    return result;
+}
@@ -13,6 +13,10 @@ typedef NS_ENUM(uint32_t, CLKOptionType) {
 
 NS_ASSUME_NONNULL_BEGIN
 
+// options are immutable once created and can be shared by any number of parsers on any thread.
+// an option's transformer is shared with it, so it is only called from several threads at once
+// when it declares itself thread-safe (see -[CLKArgumentTransformer isThreadSafe]); otherwise give
+// each thread its own options.
 @interface CLKOption : NSObject <NSCopying>
 
 + (instancetype)new NS_UNAVAILABLE;
@@ -42,13 +46,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 #pragma mark -
 
-@property (readonly) CLKOptionType type;
-@property (readonly) NSString *name;
-@property (nullable, readonly) NSString *flag;
-@property (readonly) BOOL required;
-@property (readonly) BOOL recurrent;
-@property (readonly) BOOL standalone;
-@property (nullable, readonly) CLKArgumentTransformer *transformer;
+@property (nonatomic, readonly) CLKOptionType type;
+@property (nonatomic, readonly) NSString *name;
+@property (nullable, nonatomic, readonly) NSString *flag;
+@property (nonatomic, readonly) BOOL required;
+@property (nonatomic, readonly) BOOL recurrent;
+@property (nonatomic, readonly) BOOL standalone;
+@property (nullable, nonatomic, readonly) CLKArgumentTransformer *transformer;
 
 - (BOOL)isEqualToOption:(CLKOption *)option;
 
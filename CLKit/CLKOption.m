@@ -148,7 +148,7 @@ NSString *CLKStringForOptionType(CLKOptionType type)
         [constraints addObject:constraint];
     }
     
-    _constraints = constraints;
+    _constraints = [constraints copy];
 }
 
 - (id)copyWithZone:(__unused NSZone *)zone
@@ -0,0 +1,33 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class CLKOptionSchema;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// completes option names and flags for a partially typed command line.
+//
+// the words before the cursor are scanned (not parsed) for the options already present. options
+// that the schema's constraints would reject given those are left out: a non-recurrent option that
+// is present, options mutually exclusive with a present option, and options a present standalone
+// option doesn't allow (or a standalone option when other options are present).
+@interface CLKOptionCompleter : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
++ (instancetype)completerWithSchema:(CLKOptionSchema *)schema;
+
+@property (readonly) CLKOptionSchema *schema;
+
+// `word` is the partial word under the cursor. completions are `--name` and `-f` tokens beginning
+// with `word`: a word of `-` gets flags and names, an empty word gets names. words that can't begin
+// an option (arguments, positional arguments, anything after `--`) get no completions.
+- (NSArray<NSString *> *)completionsForWord:(NSString *)word precedingWords:(NSArray<NSString *> *)precedingWords;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,218 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKOptionCompleter.h"
+
+#import "CLKAssert.h"
+#import "CLKBitset.h"
+#import "CLKConstraintProgram.h"
+#import "CLKOption.h"
+#import "CLKOptionRegistry.h"
+#import "CLKOptionSchema_Private.h"
+#import "CLKPrefixTrie.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKOptionCompleter ()
+
+- (instancetype)_initWithSchema:(CLKOptionSchema *)schema NS_DESIGNATED_INITIALIZER;
+
+// fills `presentOptions` with the options in `words`. answers NO if the next word can't be an option.
+- (BOOL)_scanWords:(NSArray<NSString *> *)words presentOptions:(uint64_t *)presentOptions;
+
+- (void)_excludeOptions:(uint64_t *)excludedOptions givenPresentOptions:(const uint64_t *)presentOptions;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation CLKOptionCompleter
+{
+    CLKOptionSchema *_schema;
+    CLKOptionRegistry *_optionRegistry;
+}
+
+@synthesize schema = _schema;
+
++ (instancetype)completerWithSchema:(CLKOptionSchema *)schema
+{
+    return [[self alloc] _initWithSchema:schema];
+}
+
+- (instancetype)_initWithSchema:(CLKOptionSchema *)schema
+{
+    CLKHardParameterAssert(schema != nil);
+    
+    self = [super init];
+    if (self != nil) {
+        _schema = schema;
+        _optionRegistry = schema.optionRegistry;
+    }
+    
+    return self;
+}
+
+#pragma mark -
+
+- (NSArray<NSString *> *)completionsForWord:(NSString *)word precedingWords:(NSArray<NSString *> *)precedingWords
+{
+    CLKHardParameterAssert(word != nil);
+    CLKHardParameterAssert(precedingWords != nil);
+    
+    BOOL completeNames = (word.length == 0 || [word isEqualToString:@"-"] || ([word hasPrefix:@"--"] && ![word containsString:@"="]));
+    BOOL completeFlags = (word.length > 0 && word.length <= 2 && [word hasPrefix:@"-"] && ![word isEqualToString:@"--"]);
+    if (!completeNames && !completeFlags) {
+        return @[];
+    }
+    
+    NSUInteger wordCount = _schema.constraintProgram.bitsetWordCount;
+    uint64_t *presentOptions = calloc(MAX(wordCount, 1UL), sizeof(uint64_t));
+    uint64_t *excludedOptions = calloc(MAX(wordCount, 1UL), sizeof(uint64_t));
+    NSMutableArray<NSString *> *completions = [NSMutableArray array];
+    
+    if ([self _scanWords:precedingWords presentOptions:presentOptions]) {
+        [self _excludeOptions:excludedOptions givenPresentOptions:presentOptions];
+        NSArray<CLKOption *> *options = _optionRegistry.options;
+        
+        if (completeFlags) {
+            unichar flagPrefix = (word.length == 2 ? [word characterAtIndex:1] : 0);
+            NSMutableArray<NSString *> *flags = [NSMutableArray array];
+            for (NSUInteger i = 0 ; i < options.count ; i++) {
+                NSString *flag = options[i].flag;
+                if (flag == nil || CLKBitsetTest(excludedOptions, i)) {
+                    continue;
+                }
+                
+                if (flagPrefix == 0 || [flag characterAtIndex:0] == flagPrefix) {
+                    [flags addObject:[@"-" stringByAppendingString:flag]];
+                }
+            }
+            
+            [flags sortUsingSelector:@selector(compare:)];
+            [completions addObjectsFromArray:flags];
+        }
+        
+        if (completeNames) {
+            NSString *namePrefix = (word.length > 2 ? [word substringFromIndex:2] : @"");
+            [_optionRegistry.nameTrie enumerateIndexesOfStringsWithPrefix:namePrefix usingBlock:^(NSUInteger idx, __unused BOOL *outStop) {
+                if (!CLKBitsetTest(excludedOptions, idx)) {
+                    [completions addObject:[@"--" stringByAppendingString:options[idx].name]];
+                }
+            }];
+        }
+    }
+    
+    free(presentOptions);
+    free(excludedOptions);
+    return completions;
+}
+
+- (BOOL)_scanWords:(NSArray<NSString *> *)words presentOptions:(uint64_t *)presentOptions
+{
+    BOOL expectingArgument = NO;
+    for (NSString *word in words) {
+        if (expectingArgument) {
+            expectingArgument = NO;
+            continue;
+        }
+        
+        if ([word isEqualToString:@"--"]) {
+            return NO;
+        }
+        
+        NSUInteger length = word.length;
+        if (length < 2 || [word characterAtIndex:0] != '-') {
+            continue;
+        }
+        
+        NSUInteger assignment = [word rangeOfString:@"="].location;
+        NSUInteger end = (assignment != NSNotFound ? assignment : length);
+        
+        if ([word characterAtIndex:1] == '-') {
+            if (end <= 2) {
+                continue;
+            }
+            
+            NSUInteger optionIndex = [_optionRegistry indexOfOptionNamed:[word substringWithRange:NSMakeRange(2, end - 2)]];
+            if (optionIndex != NSNotFound) {
+                CLKBitsetSet(presentOptions, optionIndex);
+                expectingArgument = (_optionRegistry.options[optionIndex].type == CLKOptionTypeParameter && assignment == NSNotFound);
+            }
+        } else {
+            // a flag set. a parameter option's argument follows the set.
+            for (NSUInteger i = 1 ; i < end ; i++) {
+                CLKOption *option = [_optionRegistry optionForFlagCharacter:[word characterAtIndex:i]];
+                if (option != nil) {
+                    CLKBitsetSet(presentOptions, [_optionRegistry indexOfOptionNamed:option.name]);
+                    expectingArgument = (expectingArgument || (option.type == CLKOptionTypeParameter && assignment == NSNotFound));
+                }
+            }
+        }
+    }
+    
+    return !expectingArgument;
+}
+
+- (void)_excludeOptions:(uint64_t *)excludedOptions givenPresentOptions:(const uint64_t *)presentOptions
+{
+    CLKConstraintProgram *program = _schema.constraintProgram;
+    NSUInteger optionCount = _optionRegistry.options.count;
+    NSUInteger wordCount = program.bitsetWordCount;
+    
+    for (NSUInteger i = 0 ; i < program.instructionCount ; i++) {
+        const CLKConstraintInstruction *instruction = [program instructionAtIndex:i];
+        if (instruction->predicated && (instruction->predicatingOption == CLKConstraintOptionNone || !CLKBitsetTest(presentOptions, instruction->predicatingOption))) {
+            continue;
+        }
+        
+        NSUInteger significantOption = instruction->significantOption;
+        switch (instruction->type) {
+            case CLKConstraintTypeMutuallyExclusive: {
+                const uint64_t *band = [program bandForInstruction:instruction];
+                if (CLKBitsetIntersects(band, presentOptions, wordCount)) {
+                    for (NSUInteger o = 0 ; o < optionCount ; o++) {
+                        if (CLKBitsetTest(band, o) && !CLKBitsetTest(presentOptions, o)) {
+                            CLKBitsetSet(excludedOptions, o);
+                        }
+                    }
+                }
+                
+                break;
+            }
+            
+            case CLKConstraintTypeStandalone: {
+                if (significantOption == CLKConstraintOptionNone) {
+                    break;
+                }
+                
+                // the band holds the significant option and its whitelist
+                const uint64_t *band = [program bandForInstruction:instruction];
+                if (CLKBitsetTest(presentOptions, significantOption)) {
+                    for (NSUInteger o = 0 ; o < optionCount ; o++) {
+                        if (!CLKBitsetTest(band, o)) {
+                            CLKBitsetSet(excludedOptions, o);
+                        }
+                    }
+                } else if (CLKBitsetHasBitsOutsideMask(presentOptions, band, wordCount)) {
+                    CLKBitsetSet(excludedOptions, significantOption);
+                }
+                
+                break;
+            }
+            
+            case CLKConstraintTypeOccurrencesLimited:
+                if (significantOption != CLKConstraintOptionNone && CLKBitsetTest(presentOptions, significantOption)) {
+                    CLKBitsetSet(excludedOptions, significantOption);
+                }
+                
+                break;
+            
+            case CLKConstraintTypeRequired:
+            case CLKConstraintTypeAnyRequired:
+                break;
+        }
+    }
+}
+
+@end
@@ -6,6 +6,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+// groups are immutable once created and can be shared by any number of parsers on any thread
 @interface CLKOptionGroup : NSObject
 
 + (instancetype)new NS_UNAVAILABLE;
@@ -10,8 +10,8 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface CLKOptionGroup ()
 
-@property (readonly) NSSet<NSString *> *allOptions;
-@property (readonly) NSArray<CLKArgumentManifestConstraint *> *constraints;
+@property (nonatomic, readonly) NSSet<NSString *> *allOptions;
+@property (nonatomic, readonly) NSArray<CLKArgumentManifestConstraint *> *constraints;
 
 @end
 
@@ -5,22 +5,98 @@
 #import <Foundation/Foundation.h>
 
 @class CLKOption;
+@class CLKPrefixTrie;
+@class CLKSuggestionIndex;
+
+#define CLKOptionFlagTableLength 128
+
+// sentinel for unoccupied entries in the flag table and the name slots
+#define CLKOptionIndexNone UINT32_MAX
+
+// names up to this length are looked up out of a stack buffer
+#define CLKOptionNameStackBufferLength 128
+
+// a registry's lookup tables. they hold option indexes and offsets rather than pointers,
+// so they can be written to a CLKSchemaArchive and used in place when it is loaded. the tables
+// only cover the registry's own options: in a registry with a parent, index 0 is the first
+// option it doesn't inherit.
+typedef struct {
+    const uint32_t *flagTable; // CLKOptionFlagTableLength entries, ASCII flag -> option index
+    const uint64_t *nonASCIIFlags; // (flag << 32) | option index, sorted
+    NSUInteger nonASCIIFlagCount;
+    const int32_t *nameDisplacements; // MAX(option count, 1) entries
+    const uint32_t *nameSlots; // MAX(option count, 1) entries
+    const NSUInteger *nameOffsets; // option count + 1 entries
+    const unichar *nameCharacters; // nameOffsets[option count] characters
+} CLKOptionRegistryTables;
 
 NS_ASSUME_NONNULL_BEGIN
 
+// an immutable lookup structure for a set of options. safe to share across threads.
+//
+// flags are looked up in a table indexed by the flag character. names are looked up
+// through a minimal perfect hash built over the registered names, so a lookup costs
+// one hash of the candidate name and at most one name comparison.
+//
+// a registry can inherit the options of a parent registry, e.g. those declared by a verb family
+// for all of its verbs. it then only indexes its own options and looks up the rest in the parent,
+// so any number of registries share the parent's tables. inherited options come first: their
+// indexes are the same in every registry that inherits them.
 @interface CLKOptionRegistry : NSObject
 
 + (instancetype)new NS_UNAVAILABLE;
 - (instancetype)init NS_UNAVAILABLE;
 
 + (instancetype)registryWithOptions:(NSArray<CLKOption *> *)options;
-- (instancetype)initWithOptions:(NSArray<CLKOption *> *)options NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithOptions:(NSArray<CLKOption *> *)options;
+
+// `options` may not share names or flags with the options the registry inherits
+- (instancetype)initWithOptions:(NSArray<CLKOption *> *)options parentRegistry:(nullable CLKOptionRegistry *)parentRegistry NS_DESIGNATED_INITIALIZER;
+
+// adopts tables built by another registry for the same options without copying or checking them.
+// `tablesOwner` is retained for as long as the registry uses the tables.
+- (instancetype)initWithOptions:(NSArray<CLKOption *> *)options tables:(CLKOptionRegistryTables)tables tablesOwner:(id)tablesOwner NS_DESIGNATED_INITIALIZER;
+
+@property (nonatomic, readonly) CLKOptionRegistryTables tables;
+
+@property (nullable, nonatomic, readonly) CLKOptionRegistry *parentRegistry;
+
+// an option's index is its position in this array. inherited options come first.
+@property (nonatomic, readonly) NSArray<CLKOption *> *options;
+
+// the number of options inherited from the parent registry and its ancestors
+@property (nonatomic, readonly) NSUInteger inheritedOptionCount;
 
 - (nullable CLKOption *)optionNamed:(NSString *)name;
+- (nullable CLKOption *)optionNamedInString:(NSString *)string range:(NSRange)range;
+- (nullable CLKOption *)optionNamedWithCharacters:(const unichar *)characters length:(NSUInteger)length;
+
+// answers the option named `prefix` or, failing that, the only option whose name begins with it, as
+// getopt_long resolves abbreviated long options. an exact name costs what -optionNamed: costs; only
+// a prefix that isn't a name goes on to `nameTrie`, at one step per character of the prefix.
+- (nullable CLKOption *)optionNamedWithPrefix:(NSString *)prefix;
+- (nullable CLKOption *)optionNamedWithPrefixCharacters:(const unichar *)characters length:(NSUInteger)length;
+
 - (nullable CLKOption *)optionForFlag:(NSString *)flag;
+- (nullable CLKOption *)optionForFlagCharacter:(unichar)flag;
 
 - (BOOL)hasOptionNamed:(NSString *)name;
 
+// answers NSNotFound for unregistered names
+- (NSUInteger)indexOfOptionNamed:(NSString *)name;
+
+// a prefix index over the option names, by option index. built the first time it is read and published
+// without a lock, since abbreviated names are looked up in it while parsing. can be read from any thread.
+@property (nonatomic, readonly) CLKPrefixTrie *nameTrie;
+
+// option indexes by the environment variable each option is read from, without CLKOptionSourceEnvironmentPrefix
+// (see +[CLKOptionSource environmentSource]). built and published like `nameTrie`.
+@property (nonatomic, readonly) NSDictionary<NSString *, NSIndexSet *> *environmentKeyIndex;
+
+// an index of the option names for suggesting corrections to misspelled ones. built under a lock
+// the first time it is read, so it can be read from any thread.
+@property (nonatomic, readonly) CLKSuggestionIndex *nameSuggestionIndex;
+
 @end
 
 NS_ASSUME_NONNULL_END
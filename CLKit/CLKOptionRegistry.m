@@ -4,15 +4,109 @@
 
 #import "CLKOptionRegistry.h"
 
+#import <stdatomic.h>
+
 #import "CLKAssert.h"
 #import "CLKOption.h"
+#import "CLKOptionSource_Private.h"
+#import "CLKPrefixTrie.h"
+#import "CLKSuggestionIndex.h"
+
+static inline uint32_t CLKOptionNameHash(uint32_t seed, const unichar *characters, NSUInteger length)
+{
+    // FNV-1a over UTF-16 code units, finished with murmur3's fmix32 so the low bits are usable as a modulus
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b1u);
+    for (NSUInteger i = 0 ; i < length ; i++) {
+        h ^= characters[i];
+        h *= 16777619u;
+    }
+    
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// answers the retained object in `slot`, building and publishing one first if the slot is NULL.
+// threads that race to build it each build one and the first to be published is kept.
+static id CLKLoadOrPublishObject(_Atomic(void *) *slot, id (^build)(void))
+{
+    void *object = atomic_load_explicit(slot, memory_order_acquire);
+    if (object == NULL) {
+        void *builtObject = (__bridge_retained void *)build();
+        if (atomic_compare_exchange_strong_explicit(slot, &object, builtObject, memory_order_acq_rel, memory_order_acquire)) {
+            object = builtObject;
+        } else {
+            (void)(__bridge_transfer id)builtObject;
+        }
+    }
+    
+    return (__bridge id)object;
+}
+
+static int CLKOptionFlagEntryCompare(const void *lhs, const void *rhs)
+{
+    uint64_t a = *(const uint64_t *)lhs;
+    uint64_t b = *(const uint64_t *)rhs;
+    return (a < b ? -1 : (a > b ? 1 : 0));
+}
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKOptionRegistry ()
+
+- (void)_buildFlagTables;
+- (void)_buildNameHash;
++ (NSArray<NSNumber *> *)_indexesOfBuckets:(NSArray<NSArray *> *)buckets;
+
+- (NSUInteger)_indexOfOptionNamedInString:(NSString *)string range:(NSRange)range;
+- (NSUInteger)_indexOfOptionNamedWithCharacters:(const unichar *)characters length:(NSUInteger)length;
+
+@end
+
+NS_ASSUME_NONNULL_END
 
 @implementation CLKOptionRegistry
 {
-    NSMutableDictionary<NSString *, CLKOption *> *_optionNameMap;
-    NSMutableDictionary<NSString *, CLKOption *> *_optionFlagMap;
+    NSArray<CLKOption *> *_options; // an option's index is its position in this array
+    
+    // the tables below cover _ownOptions, and their indexes are offset by _inheritedOptionCount.
+    // everything else is looked up in the parent.
+    CLKOptionRegistry *_parentRegistry;
+    NSUInteger _inheritedOptionCount;
+    NSArray<CLKOption *> *_ownOptions;
+    
+    uint32_t _flagTable[CLKOptionFlagTableLength]; // ASCII flag -> option index
+    uint64_t *_nonASCIIFlags; // (flag << 32) | option index, sorted so lookups can bisect
+    NSUInteger _nonASCIIFlagCount;
+    
+    // minimal perfect hash over option names ("hash, displace, and compress").
+    // a name's first-level hash picks a bucket in _nameDisplacements. a positive entry
+    // is the seed that places the bucket's names without collisions; a negative entry
+    // encodes the slot of a bucket's only name. slots hold option indexes, and lookups
+    // confirm the candidate against the packed names since unknown names hash somewhere too.
+    NSUInteger _slotCount;
+    int32_t *_nameDisplacements;
+    uint32_t *_nameSlots;
+    unichar *_nameCharacters;
+    NSUInteger *_nameOffsets; // option index -> offset into _nameCharacters. has `count + 1` entries.
+    
+    // set when the tables belong to someone else (see -initWithOptions:tables:tablesOwner:)
+    id _tablesOwner;
+    
+    // retained, and NULL until first read (see CLKLoadOrPublishObject())
+    _Atomic(void *) _nameTrie; // CLKPrefixTrie
+    _Atomic(void *) _environmentKeyIndex; // NSDictionary
+    
+    CLKSuggestionIndex *_nameSuggestionIndex; // only needed for errors, so built on demand
 }
 
+@synthesize options = _options;
+@synthesize parentRegistry = _parentRegistry;
+@synthesize inheritedOptionCount = _inheritedOptionCount;
+
 + (instancetype)registryWithOptions:(NSArray<CLKOption *> *)options
 {
     // for some reason, the compiler doesn't know what -initWithOptions: we want
@@ -21,45 +115,428 @@
 
 - (instancetype)initWithOptions:(NSArray<CLKOption *> *)options
 {
+    return [self initWithOptions:options parentRegistry:nil];
+}
+
+- (instancetype)initWithOptions:(NSArray<CLKOption *> *)options parentRegistry:(CLKOptionRegistry *)parentRegistry
+{
+    CLKHardParameterAssert(options != nil);
+    CLKHardParameterAssert((options.count + parentRegistry.options.count) < CLKOptionIndexNone);
+    
     self = [super init];
     if (self != nil) {
-        _optionNameMap = [[NSMutableDictionary alloc] init];
-        _optionFlagMap = [[NSMutableDictionary alloc] init];
+        _ownOptions = [options copy];
+        _parentRegistry = parentRegistry;
+        _inheritedOptionCount = parentRegistry.options.count;
+        _options = (parentRegistry != nil ? [parentRegistry.options arrayByAddingObjectsFromArray:_ownOptions] : _ownOptions);
         
-        // build the maps and do some sanity checks along the way
-        for (CLKOption *option in options) {
-            CLKHardAssert((_optionNameMap[option.name] == nil), NSInvalidArgumentException, @"encountered multiple options named '%@'", option.name);
-            _optionNameMap[option.name] = option;
+        NSMutableSet<NSString *> *names = [[NSMutableSet alloc] init];
+        for (CLKOption *option in _ownOptions) {
+            CLKHardAssert(![names containsObject:option.name], NSInvalidArgumentException, @"encountered multiple options named '%@'", option.name);
+            CLKHardAssert(![parentRegistry hasOptionNamed:option.name], NSInvalidArgumentException, @"encountered option named '%@' that is already inherited", option.name);
+            [names addObject:option.name];
             
-            if (option.flag != nil) {
-                CLKOption *collision = _optionFlagMap[option.flag];
-                CLKHardAssert((collision == nil), NSInvalidArgumentException, @"encountered colliding flag '%@' for options '%@' and '%@'", option.flag, option.name, collision.name);
-                _optionFlagMap[option.flag] = option;
-            }
+            CLKOption *collision = (option.flag != nil ? [parentRegistry optionForFlag:option.flag] : nil);
+            CLKHardAssert((collision == nil), NSInvalidArgumentException, @"encountered colliding flag '%@' for options '%@' and '%@'", option.flag, option.name, collision.name);
         }
+        
+        [self _buildFlagTables];
+        [self _buildNameHash];
+    }
+    
+    return self;
+}
+
+- (instancetype)initWithOptions:(NSArray<CLKOption *> *)options tables:(CLKOptionRegistryTables)tables tablesOwner:(id)tablesOwner
+{
+    CLKHardParameterAssert(options != nil);
+    CLKHardParameterAssert(tablesOwner != nil);
+    
+    self = [super init];
+    if (self != nil) {
+        _options = [options copy];
+        _ownOptions = _options;
+        _tablesOwner = tablesOwner;
+        
+        memcpy(_flagTable, tables.flagTable, sizeof(_flagTable));
+        _nonASCIIFlags = (uint64_t *)tables.nonASCIIFlags;
+        _nonASCIIFlagCount = tables.nonASCIIFlagCount;
+        _slotCount = _ownOptions.count;
+        _nameDisplacements = (int32_t *)tables.nameDisplacements;
+        _nameSlots = (uint32_t *)tables.nameSlots;
+        _nameOffsets = (NSUInteger *)tables.nameOffsets;
+        _nameCharacters = (unichar *)tables.nameCharacters;
     }
     
     return self;
 }
 
+- (void)dealloc
+{
+    void *nameTrie = atomic_load_explicit(&_nameTrie, memory_order_relaxed);
+    if (nameTrie != NULL) {
+        (void)(__bridge_transfer CLKPrefixTrie *)nameTrie;
+    }
+    
+    void *environmentKeyIndex = atomic_load_explicit(&_environmentKeyIndex, memory_order_relaxed);
+    if (environmentKeyIndex != NULL) {
+        (void)(__bridge_transfer NSDictionary *)environmentKeyIndex;
+    }
+    
+    if (_tablesOwner == nil) {
+        free(_nonASCIIFlags);
+        free(_nameDisplacements);
+        free(_nameSlots);
+        free(_nameCharacters);
+        free(_nameOffsets);
+    }
+}
+
+- (void)_buildFlagTables
+{
+    for (NSUInteger i = 0 ; i < CLKOptionFlagTableLength ; i++) {
+        _flagTable[i] = CLKOptionIndexNone;
+    }
+    
+    NSUInteger count = _ownOptions.count;
+    _nonASCIIFlags = malloc(MAX(count, 1UL) * sizeof(uint64_t));
+    for (NSUInteger i = 0 ; i < count ; i++) {
+        CLKOption *option = _ownOptions[i];
+        if (option.flag == nil) {
+            continue;
+        }
+        
+        unichar flag = [option.flag characterAtIndex:0];
+        if (flag < CLKOptionFlagTableLength) {
+            uint32_t collision = _flagTable[flag];
+            CLKHardAssert((collision == CLKOptionIndexNone), NSInvalidArgumentException, @"encountered colliding flag '%@' for options '%@' and '%@'", option.flag, option.name, _ownOptions[collision].name);
+            _flagTable[flag] = (uint32_t)i;
+        } else {
+            _nonASCIIFlags[_nonASCIIFlagCount++] = (((uint64_t)flag << 32) | i);
+        }
+    }
+    
+    // sorting by flag, then index, puts colliding flags next to each other with the earlier option first
+    qsort(_nonASCIIFlags, _nonASCIIFlagCount, sizeof(uint64_t), CLKOptionFlagEntryCompare);
+    for (NSUInteger i = 1 ; i < _nonASCIIFlagCount ; i++) {
+        CLKOption *option = _ownOptions[(uint32_t)_nonASCIIFlags[i]];
+        CLKOption *collision = _ownOptions[(uint32_t)_nonASCIIFlags[i - 1]];
+        CLKHardAssert(((_nonASCIIFlags[i] >> 32) != (_nonASCIIFlags[i - 1] >> 32)), NSInvalidArgumentException, @"encountered colliding flag '%@' for options '%@' and '%@'", option.flag, option.name, collision.name);
+    }
+}
+
+- (void)_buildNameHash
+{
+    NSUInteger count = _ownOptions.count;
+    
+    // pack the names so lookups can compare without touching the option objects
+    _nameOffsets = malloc((count + 1) * sizeof(NSUInteger));
+    NSUInteger totalLength = 0;
+    for (NSUInteger i = 0 ; i < count ; i++) {
+        _nameOffsets[i] = totalLength;
+        totalLength += _ownOptions[i].name.length;
+    }
+    
+    _nameOffsets[count] = totalLength;
+    _nameCharacters = malloc(MAX(totalLength, 1UL) * sizeof(unichar));
+    for (NSUInteger i = 0 ; i < count ; i++) {
+        NSString *name = _ownOptions[i].name;
+        [name getCharacters:(_nameCharacters + _nameOffsets[i]) range:NSMakeRange(0, name.length)];
+    }
+    
+    _slotCount = count;
+    _nameDisplacements = calloc(MAX(count, 1UL), sizeof(int32_t));
+    _nameSlots = malloc(MAX(count, 1UL) * sizeof(uint32_t));
+    for (NSUInteger i = 0 ; i < count ; i++) {
+        _nameSlots[i] = CLKOptionIndexNone;
+    }
+    
+    if (count == 0) {
+        return;
+    }
+    
+    // bucket the names by their first-level hash
+    NSMutableArray<NSMutableArray<NSNumber *> *> *buckets = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0 ; i < count ; i++) {
+        [buckets addObject:[[NSMutableArray alloc] init]];
+    }
+    
+    for (NSUInteger i = 0 ; i < count ; i++) {
+        uint32_t h = CLKOptionNameHash(0, (_nameCharacters + _nameOffsets[i]), (_nameOffsets[i + 1] - _nameOffsets[i]));
+        [buckets[h % count] addObject:@(i)];
+    }
+    
+    // place the largest buckets first while the table is emptiest
+    NSArray<NSNumber *> *bucketOrder = [[self class] _indexesOfBuckets:buckets];
+    
+    NSUInteger orderIndex = 0;
+    uint32_t *candidateSlots = malloc(count * sizeof(uint32_t));
+    for ( ; orderIndex < bucketOrder.count ; orderIndex++) {
+        NSUInteger bucketIndex = bucketOrder[orderIndex].unsignedIntegerValue;
+        NSArray<NSNumber *> *bucket = buckets[bucketIndex];
+        if (bucket.count < 2) {
+            break;
+        }
+        
+        int32_t seed = 1;
+        NSUInteger placed = 0;
+        while (placed < bucket.count) {
+            NSUInteger optionIndex = bucket[placed].unsignedIntegerValue;
+            uint32_t h = CLKOptionNameHash((uint32_t)seed, (_nameCharacters + _nameOffsets[optionIndex]), (_nameOffsets[optionIndex + 1] - _nameOffsets[optionIndex]));
+            uint32_t slot = (uint32_t)(h % count);
+            
+            BOOL collision = (_nameSlots[slot] != CLKOptionIndexNone);
+            for (NSUInteger j = 0 ; j < placed && !collision ; j++) {
+                collision = (candidateSlots[j] == slot);
+            }
+            
+            if (collision) {
+                CLKHardAssert((seed < INT32_MAX), NSInternalInconsistencyException, @"failed to build option name hash");
+                seed++;
+                placed = 0;
+                continue;
+            }
+            
+            candidateSlots[placed] = slot;
+            placed++;
+        }
+        
+        _nameDisplacements[bucketIndex] = seed;
+        for (NSUInteger j = 0 ; j < bucket.count ; j++) {
+            _nameSlots[candidateSlots[j]] = (uint32_t)bucket[j].unsignedIntegerValue;
+        }
+    }
+    
+    free(candidateSlots);
+    
+    // single-name buckets go straight into whatever slots are left
+    NSUInteger freeSlot = 0;
+    for ( ; orderIndex < bucketOrder.count ; orderIndex++) {
+        NSUInteger bucketIndex = bucketOrder[orderIndex].unsignedIntegerValue;
+        NSArray<NSNumber *> *bucket = buckets[bucketIndex];
+        if (bucket.count == 0) {
+            break;
+        }
+        
+        while (_nameSlots[freeSlot] != CLKOptionIndexNone) {
+            freeSlot++;
+        }
+        
+        _nameSlots[freeSlot] = (uint32_t)bucket[0].unsignedIntegerValue;
+        _nameDisplacements[bucketIndex] = -(int32_t)(freeSlot + 1);
+    }
+}
+
++ (NSArray<NSNumber *> *)_indexesOfBuckets:(NSArray<NSArray *> *)buckets
+{
+    NSMutableArray<NSNumber *> *indexes = [[NSMutableArray alloc] initWithCapacity:buckets.count];
+    for (NSUInteger i = 0 ; i < buckets.count ; i++) {
+        [indexes addObject:@(i)];
+    }
+    
+    [indexes sortWithOptions:NSSortStable usingComparator:^(NSNumber *lhs, NSNumber *rhs) {
+        NSUInteger lhsCount = buckets[lhs.unsignedIntegerValue].count;
+        NSUInteger rhsCount = buckets[rhs.unsignedIntegerValue].count;
+        if (lhsCount == rhsCount) {
+            return NSOrderedSame;
+        }
+        
+        return (lhsCount > rhsCount ? NSOrderedAscending : NSOrderedDescending);
+    }];
+    
+    return indexes;
+}
+
 #pragma mark -
 
 - (nullable CLKOption *)optionNamed:(NSString *)name
 {
     NSParameterAssert(name.length > 0);
-    return _optionNameMap[name];
+    return [self optionNamedInString:name range:NSMakeRange(0, name.length)];
+}
+
+- (nullable CLKOption *)optionNamedInString:(NSString *)string range:(NSRange)range
+{
+    NSUInteger optionIndex = [self _indexOfOptionNamedInString:string range:range];
+    return (optionIndex != NSNotFound ? _options[optionIndex] : nil);
+}
+
+- (nullable CLKOption *)optionNamedWithCharacters:(const unichar *)characters length:(NSUInteger)length
+{
+    NSUInteger optionIndex = [self _indexOfOptionNamedWithCharacters:characters length:length];
+    return (optionIndex != NSNotFound ? _options[optionIndex] : nil);
+}
+
+- (nullable CLKOption *)optionNamedWithPrefix:(NSString *)prefix
+{
+    NSParameterAssert(prefix.length > 0);
+    
+    NSUInteger length = prefix.length;
+    unichar stackBuffer[CLKOptionNameStackBufferLength];
+    unichar *characters = (length > CLKOptionNameStackBufferLength ? malloc(length * sizeof(unichar)) : stackBuffer);
+    [prefix getCharacters:characters range:NSMakeRange(0, length)];
+    CLKOption *option = [self optionNamedWithPrefixCharacters:characters length:length];
+    if (characters != stackBuffer) {
+        free(characters);
+    }
+    
+    return option;
+}
+
+- (nullable CLKOption *)optionNamedWithPrefixCharacters:(const unichar *)characters length:(NSUInteger)length
+{
+    NSParameterAssert(length > 0);
+    
+    NSUInteger optionIndex = [self _indexOfOptionNamedWithCharacters:characters length:length];
+    if (optionIndex == NSNotFound) {
+        // the trie covers inherited options too, so an abbreviation can't be ambiguous with one of them unnoticed
+        optionIndex = [self.nameTrie indexOfStringWithUniquePrefixCharacters:characters length:length];
+    }
+    
+    return (optionIndex != NSNotFound ? _options[optionIndex] : nil);
+}
+
+- (CLKOptionRegistryTables)tables
+{
+    return (CLKOptionRegistryTables){
+        .flagTable = _flagTable,
+        .nonASCIIFlags = _nonASCIIFlags,
+        .nonASCIIFlagCount = _nonASCIIFlagCount,
+        .nameDisplacements = _nameDisplacements,
+        .nameSlots = _nameSlots,
+        .nameOffsets = _nameOffsets,
+        .nameCharacters = _nameCharacters
+    };
+}
+
+- (NSUInteger)indexOfOptionNamed:(NSString *)name
+{
+    NSParameterAssert(name.length > 0);
+    return [self _indexOfOptionNamedInString:name range:NSMakeRange(0, name.length)];
+}
+
+- (CLKPrefixTrie *)nameTrie
+{
+    return CLKLoadOrPublishObject(&_nameTrie, ^id {
+        return [CLKPrefixTrie trieWithStrings:[self->_options valueForKey:@"name"]];
+    });
+}
+
+- (NSDictionary<NSString *, NSIndexSet *> *)environmentKeyIndex
+{
+    return CLKLoadOrPublishObject(&_environmentKeyIndex, ^id {
+        // distinct names can share a key (`dry-run` and `dry_run`), and a variable sets all of them
+        NSMutableDictionary<NSString *, NSMutableIndexSet *> *index = [[NSMutableDictionary alloc] initWithCapacity:self->_options.count];
+        [self->_options enumerateObjectsUsingBlock:^(CLKOption *option, NSUInteger optionIndex, __unused BOOL *outStop) {
+            NSString *key = CLKOptionSourceEnvironmentKey(option.name);
+            NSMutableIndexSet *optionIndexes = index[key];
+            if (optionIndexes == nil) {
+                optionIndexes = [[NSMutableIndexSet alloc] init];
+                index[key] = optionIndexes;
+            }
+            
+            [optionIndexes addIndex:optionIndex];
+        }];
+        
+        return [index copy];
+    });
+}
+
+- (CLKSuggestionIndex *)nameSuggestionIndex
+{
+    @synchronized (self) {
+        if (_nameSuggestionIndex == nil) {
+            _nameSuggestionIndex = [CLKSuggestionIndex indexWithStrings:[_options valueForKey:@"name"]];
+        }
+        
+        return _nameSuggestionIndex;
+    }
+}
+
+- (NSUInteger)_indexOfOptionNamedInString:(NSString *)string range:(NSRange)range
+{
+    NSParameterAssert(range.length > 0 && NSMaxRange(range) <= string.length);
+    
+    unichar stackBuffer[CLKOptionNameStackBufferLength];
+    unichar *characters = stackBuffer;
+    if (range.length > CLKOptionNameStackBufferLength) {
+        characters = malloc(range.length * sizeof(unichar));
+    }
+    
+    [string getCharacters:characters range:range];
+    NSUInteger optionIndex = [self _indexOfOptionNamedWithCharacters:characters length:range.length];
+    
+    if (characters != stackBuffer) {
+        free(characters);
+    }
+    
+    return optionIndex;
+}
+
+- (NSUInteger)_indexOfOptionNamedWithCharacters:(const unichar *)characters length:(NSUInteger)length
+{
+    NSParameterAssert(length > 0);
+    
+    if (_slotCount == 0) {
+        return (_parentRegistry != nil ? [_parentRegistry _indexOfOptionNamedWithCharacters:characters length:length] : NSNotFound);
+    }
+    
+    int32_t displacement = _nameDisplacements[CLKOptionNameHash(0, characters, length) % _slotCount];
+    uint32_t slot;
+    if (displacement < 0) {
+        slot = (uint32_t)(-displacement - 1);
+    } else {
+        // an empty bucket has a displacement of zero. no name hashes there, so the comparison below fails.
+        slot = (uint32_t)(CLKOptionNameHash((uint32_t)displacement, characters, length) % _slotCount);
+    }
+    
+    uint32_t optionIndex = _nameSlots[slot];
+    NSUInteger offset = _nameOffsets[optionIndex];
+    if ((_nameOffsets[optionIndex + 1] - offset) != length || memcmp((_nameCharacters + offset), characters, (length * sizeof(unichar))) != 0) {
+        return (_parentRegistry != nil ? [_parentRegistry _indexOfOptionNamedWithCharacters:characters length:length] : NSNotFound);
+    }
+    
+    return (_inheritedOptionCount + optionIndex);
 }
 
 - (nullable CLKOption *)optionForFlag:(NSString *)flag
 {
     NSParameterAssert(flag.length == 1);
-    return _optionFlagMap[flag];
+    return [self optionForFlagCharacter:[flag characterAtIndex:0]];
+}
+
+- (nullable CLKOption *)optionForFlagCharacter:(unichar)flag
+{
+    if (flag < CLKOptionFlagTableLength) {
+        uint32_t optionIndex = _flagTable[flag];
+        if (optionIndex != CLKOptionIndexNone) {
+            return _ownOptions[optionIndex];
+        }
+        
+        return [_parentRegistry optionForFlagCharacter:flag];
+    }
+    
+    NSUInteger low = 0;
+    NSUInteger high = _nonASCIIFlagCount;
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        unichar midFlag = (unichar)(_nonASCIIFlags[mid] >> 32);
+        if (midFlag == flag) {
+            return _ownOptions[(uint32_t)_nonASCIIFlags[mid]];
+        } else if (midFlag < flag) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    return [_parentRegistry optionForFlagCharacter:flag];
 }
 
 - (BOOL)hasOptionNamed:(NSString *)name
 {
     NSParameterAssert(name.length > 0);
-    return (_optionNameMap[name] != nil);
+    return ([self optionNamed:name] != nil);
 }
 
 @end
@@ -0,0 +1,35 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "CLKArgumentManifest.h"
+
+@class CLKOption;
+@class CLKOptionGroup;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// an immutable, compiled description of a command's options.
+//
+// building a schema indexes the options and checks the groups against them. parsers
+// created with a schema skip that work, and any number of parsers (on any thread) can
+// share one schema.
+@interface CLKOptionSchema : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
++ (instancetype)schemaWithOptions:(NSArray<CLKOption *> *)options;
++ (instancetype)schemaWithOptions:(NSArray<CLKOption *> *)options optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups;
+
+@property (nonatomic, readonly) NSArray<CLKOption *> *options;
+@property (nullable, nonatomic, readonly) NSArray<CLKOptionGroup *> *optionGroups;
+
+// handles resolved here are valid for every manifest produced by parsers using this schema
+- (CLKOptionHandle)handleForOptionNamed:(NSString *)optionName;
+
+@end
+
+NS_ASSUME_NONNULL_END
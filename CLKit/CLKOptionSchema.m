@@ -0,0 +1,104 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKOptionSchema_Private.h"
+
+#import "CLKArgumentManifestConstraint.h"
+#import "CLKAssert.h"
+#import "CLKConstraintProgram.h"
+#import "CLKOption_Private.h"
+#import "CLKOptionGroup_Private.h"
+#import "CLKOptionRegistry.h"
+
+@implementation CLKOptionSchema
+{
+    NSArray<CLKOption *> *_options;
+    NSArray<CLKOptionGroup *> *_optionGroups;
+    CLKOptionRegistry *_optionRegistry;
+    CLKConstraintProgram *_constraintProgram;
+}
+
+@synthesize options = _options;
+@synthesize optionGroups = _optionGroups;
+@synthesize optionRegistry = _optionRegistry;
+@synthesize constraintProgram = _constraintProgram;
+
++ (instancetype)schemaWithOptions:(NSArray<CLKOption *> *)options
+{
+    return [[self alloc] _initWithOptions:options optionGroups:nil];
+}
+
++ (instancetype)schemaWithOptions:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups
+{
+    return [[self alloc] _initWithOptions:options optionGroups:groups];
+}
+
+- (instancetype)_initWithOptions:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups
+{
+    return [self _initWithOptions:options optionGroups:groups inheritedSchema:nil];
+}
+
+- (instancetype)_initWithOptions:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups inheritedSchema:(CLKOptionSchema *)inheritedSchema
+{
+    CLKHardParameterAssert(options != nil);
+    
+    CLKOptionRegistry *registry = [[CLKOptionRegistry alloc] initWithOptions:options parentRegistry:inheritedSchema.optionRegistry];
+    
+    // sanity-check groups. groups may refer to inherited options.
+    for (CLKOptionGroup *group in groups) {
+        for (NSString *optionName in group.allOptions) {
+            CLKHardAssert([registry hasOptionNamed:optionName], NSInvalidArgumentException, @"unregistered option '%@' found in option group", optionName);
+        }
+    }
+    
+    NSArray<CLKOption *> *allOptions = registry.options;
+    NSArray<CLKOptionGroup *> *allGroups = groups;
+    if (inheritedSchema.optionGroups.count > 0) {
+        allGroups = (groups != nil ? [inheritedSchema.optionGroups arrayByAddingObjectsFromArray:groups] : inheritedSchema.optionGroups);
+    }
+    
+    // the program's bands span every option the schema's manifests hold, so inherited constraints are
+    // compiled again for the larger option set
+    NSArray<CLKArgumentManifestConstraint *> *constraints = [[self class] _constraintsForOptions:allOptions optionGroups:allGroups];
+    CLKConstraintProgram *program = [CLKConstraintProgram programWithConstraints:constraints optionRegistry:registry];
+    return [self _initWithOptions:allOptions optionGroups:allGroups optionRegistry:registry constraintProgram:program];
+}
+
+- (instancetype)_initWithOptions:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups optionRegistry:(CLKOptionRegistry *)registry constraintProgram:(CLKConstraintProgram *)constraintProgram
+{
+    CLKHardParameterAssert(options != nil);
+    CLKHardParameterAssert(registry != nil);
+    CLKHardParameterAssert(constraintProgram != nil);
+    
+    self = [super init];
+    if (self != nil) {
+        _options = [options copy];
+        _optionGroups = [groups copy];
+        _optionRegistry = registry;
+        _constraintProgram = constraintProgram;
+    }
+    
+    return self;
+}
+
++ (NSArray<CLKArgumentManifestConstraint *> *)_constraintsForOptions:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups
+{
+    NSMutableArray<CLKArgumentManifestConstraint *> *constraints = [[NSMutableArray alloc] init];
+    for (CLKOption *option in options) {
+        [constraints addObjectsFromArray:option.constraints];
+    }
+    
+    for (CLKOptionGroup *group in groups) {
+        [constraints addObjectsFromArray:group.constraints];
+    }
+    
+    return constraints;
+}
+
+- (CLKOptionHandle)handleForOptionNamed:(NSString *)optionName
+{
+    return [_optionRegistry indexOfOptionNamed:optionName];
+}
+
+@end
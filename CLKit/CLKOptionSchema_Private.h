@@ -0,0 +1,41 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKOptionSchema.h"
+
+@class CLKArgumentManifestConstraint;
+@class CLKConstraintProgram;
+@class CLKOptionRegistry;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKOptionSchema ()
+
+// indexes the options, checks the groups against them and compiles their constraints
+- (instancetype)_initWithOptions:(NSArray<CLKOption *> *)options optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups;
+
+// compiles `options` and `groups` on top of an inherited schema, e.g. a verb family's for one of its
+// verbs. the new registry looks inherited options up in the inherited schema's registry rather than
+// indexing them again. `options` and `optionGroups` of the result include the inherited ones, first.
+- (instancetype)_initWithOptions:(NSArray<CLKOption *> *)options
+                    optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups
+                 inheritedSchema:(nullable CLKOptionSchema *)inheritedSchema;
+
+// adopts a registry and program already built for the options, e.g. by a CLKSchemaArchive
+- (instancetype)_initWithOptions:(NSArray<CLKOption *> *)options
+                    optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups
+                  optionRegistry:(CLKOptionRegistry *)registry
+               constraintProgram:(CLKConstraintProgram *)constraintProgram NS_DESIGNATED_INITIALIZER;
+
+// the constraints of every option, then every group, in order and not deduplicated
++ (NSArray<CLKArgumentManifestConstraint *> *)_constraintsForOptions:(NSArray<CLKOption *> *)options optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups;
+
+@property (nonatomic, readonly) CLKOptionRegistry *optionRegistry;
+
+// the constraints of every option and group in the schema
+@property (nonatomic, readonly) CLKConstraintProgram *constraintProgram;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,54 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// the prefix of the environment variables read by +[CLKOptionSource environmentSource]
+extern NSString * const CLKOptionSourceEnvironmentPrefix;
+
+// settings for options from somewhere other than the argument vector: the environment or a config
+// file. a parser given option sources (see -[CLKArgumentParser optionSources]) merges their settings
+// into its manifest before validating it.
+//
+// a source's settings are values keyed by option name. for a parameter option each value is an
+// argument, transformed like one from the argument vector. for a switch option a value is a count of
+// occurrences, `true` or `yes` (one) or `false` or `no` (none); an empty value is one occurrence.
+//
+// sources are immutable and safe to share across threads.
+@interface CLKOptionSource : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
+// the process's CLKIT_-prefixed environment variables, scanned once per process. a variable supplies
+// one value for the option whose name, upper-cased and with dashes as underscores, follows the prefix:
+// CLKIT_DRY_RUN=1 sets `dry-run`. variables that don't name one of a parser's options are ignored,
+// since the environment is shared with every other program.
++ (instancetype)environmentSource;
+
+// as above, from a dictionary of environment variables
++ (instancetype)sourceWithEnvironment:(NSDictionary<NSString *, NSString *> *)environment;
+
+// a config file holds one setting per line: an option name, optionally followed by `=` and a value.
+// whitespace around names and values is ignored, as are blank lines and lines starting with `#`. an
+// option may be set on more than one line; each line is one value. settings naming an option a parser
+// doesn't have are reported as issues.
+//
+// parsing a config file is skipped when `cacheDirectory` holds the compiled image of one with the same
+// path, size and modification time. images are written after parsing and mapped into memory when
+// read. a missing cache directory is created; failing to read or write an image only costs the parse.
+// answers nil and an error if the file can't be read or is malformed (CLKErrorInvalidConfigFile).
++ (nullable instancetype)sourceWithContentsOfConfigFile:(NSString *)path cacheDirectory:(nullable NSString *)cacheDirectory error:(NSError **)outError;
+
+// where the settings came from: a config file's path or `environment`
+@property (nonatomic, readonly) NSString *name;
+
+// answers nil if the source has no setting for the option
+- (nullable NSArray<NSString *> *)valuesForOptionNamed:(NSString *)optionName;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,633 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKOptionSource_Private.h"
+
+#import <errno.h>
+#import <fcntl.h>
+#import <string.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
+#import "CLKAssert.h"
+#import "CLKError.h"
+#import "CLKMappedImage.h"
+#import "CLKOptionRegistry.h"
+#import "NSError+CLKAdditions.h"
+
+NSString * const CLKOptionSourceEnvironmentPrefix = @"CLKIT_";
+
+// a compiled config file is a header followed by the file's settings, as entries sorted by option
+// name, and the UTF-16 strings they refer to. sections are aligned to CLKConfigImageAlignment and
+// referred to by their offset from the start of the image. the header records the path, size and
+// modification time of the file the image was compiled from, which is what makes it current.
+
+#define CLKConfigImageVersion 1U
+#define CLKConfigImageByteOrderMark 0x01020304U
+#define CLKConfigImageAlignment CLKMappedImageAlignment
+#define CLKConfigImagePathExtension @"clkconfig"
+
+static const uint8_t CLKConfigImageMagic[4] = { 'C', 'L', 'K', 'C' };
+
+typedef struct {
+    uint8_t magic[4];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint32_t entryCount;
+    uint64_t length;
+    int64_t modificationSeconds;
+    int64_t modificationNanoseconds;
+    uint64_t size; // of the config file
+    uint64_t pathOffset; // UTF-16 code units into the strings
+    uint64_t pathLength;
+    uint64_t entriesOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsLength; // UTF-16 code units
+} CLKConfigImageHeader;
+
+// one line of the config file. lines setting the same option keep their order.
+typedef struct {
+    uint64_t nameOffset;
+    uint64_t valueOffset;
+    uint32_t nameLength;
+    uint32_t valueLength;
+} CLKConfigImageEntry;
+
+// the identity of a version of a config file
+typedef struct {
+    int64_t modificationSeconds;
+    int64_t modificationNanoseconds;
+    uint64_t size;
+} CLKConfigFileStamp;
+
+NS_ASSUME_NONNULL_BEGIN
+
+static inline uint64_t CLKConfigImageAlign(uint64_t offset);
+static uint64_t CLKConfigImageAppendString(NSMutableData *strings, NSString *string);
+
+@interface CLKOptionSource ()
+
++ (nullable NSData *)_imageWithConfigFileContents:(NSData *)contents path:(NSString *)path stamp:(CLKConfigFileStamp)stamp error:(NSError **)outError;
++ (nullable NSData *)_mappedImageAtPath:(NSString *)imagePath;
++ (BOOL)_isValidImage:(NSData *)image;
++ (NSString *)_imagePathForConfigFile:(NSString *)path cacheDirectory:(NSString *)cacheDirectory;
+
+- (instancetype)_initWithEnvironment:(NSDictionary<NSString *, NSString *> *)environment NS_DESIGNATED_INITIALIZER;
+- (instancetype)_initWithName:(NSString *)name image:(NSData *)image loadedFromCache:(BOOL)loadedFromCache NS_DESIGNATED_INITIALIZER;
+
+- (BOOL)_imageMatchesPath:(NSString *)path stamp:(CLKConfigFileStamp)stamp;
+- (NSString *)_stringAtOffset:(uint64_t)offset length:(uint64_t)length;
+- (NSRange)_entryRangeForOptionNamed:(NSString *)optionName;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#pragma mark -
+#pragma mark Images
+
+static inline uint64_t CLKConfigImageAlign(uint64_t offset)
+{
+    return ((offset + (CLKConfigImageAlignment - 1)) & ~((uint64_t)CLKConfigImageAlignment - 1));
+}
+
+// answers the string's offset in UTF-16 code units
+static uint64_t CLKConfigImageAppendString(NSMutableData *strings, NSString *string)
+{
+    NSUInteger offset = (strings.length / sizeof(unichar));
+    NSUInteger length = string.length;
+    [strings increaseLengthBy:(length * sizeof(unichar))];
+    [string getCharacters:((unichar *)strings.mutableBytes + offset) range:NSMakeRange(0, length)];
+    return offset;
+}
+
+#pragma mark -
+#pragma mark Environment
+
+NSString *CLKOptionSourceEnvironmentKey(NSString *optionName)
+{
+    return [optionName.uppercaseString stringByReplacingOccurrencesOfString:@"-" withString:@"_"];
+}
+
+#pragma mark -
+
+@implementation CLKOptionSource
+{
+    NSString *_name;
+    BOOL _loadedFromCache;
+    
+    // environment sources: values by CLKOptionSourceEnvironmentKey()
+    NSDictionary<NSString *, NSString *> *_environment;
+    
+    // config file sources
+    NSData *_image;
+    const CLKConfigImageHeader *_header;
+    const CLKConfigImageEntry *_entries;
+    const unichar *_strings;
+}
+
+@synthesize name = _name;
+@synthesize _loadedFromCache = _loadedFromCache;
+
++ (instancetype)environmentSource
+{
+    static CLKOptionSource *source;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        source = [self sourceWithEnvironment:NSProcessInfo.processInfo.environment];
+    });
+    
+    return source;
+}
+
++ (instancetype)sourceWithEnvironment:(NSDictionary<NSString *, NSString *> *)environment
+{
+    CLKHardParameterAssert(environment != nil);
+    
+    NSUInteger prefixLength = CLKOptionSourceEnvironmentPrefix.length;
+    NSMutableDictionary<NSString *, NSString *> *index = [[NSMutableDictionary alloc] init];
+    [environment enumerateKeysAndObjectsUsingBlock:^(NSString *variable, NSString *value, __unused BOOL *outStop) {
+        if (variable.length > prefixLength && [variable hasPrefix:CLKOptionSourceEnvironmentPrefix]) {
+            index[[variable substringFromIndex:prefixLength]] = value;
+        }
+    }];
+    
+    return [[self alloc] _initWithEnvironment:index];
+}
+
++ (instancetype)sourceWithContentsOfConfigFile:(NSString *)path cacheDirectory:(NSString *)cacheDirectory error:(NSError **)outError
+{
+    CLKHardParameterAssert(path != nil);
+    
+    // images are keyed by absolute path
+    if (!path.absolutePath) {
+        path = [NSFileManager.defaultManager.currentDirectoryPath stringByAppendingPathComponent:path];
+    }
+    
+    path = path.stringByStandardizingPath;
+    
+    int fd = open(path.fileSystemRepresentation, (O_RDONLY | O_CLOEXEC));
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        int code = errno;
+        if (fd >= 0) {
+            close(fd);
+        }
+        
+        if (outError != nil) {
+            *outError = [NSError clk_POSIXErrorWithCode:code description:@"%@: %s", path, strerror(code)];
+        }
+        
+        return nil;
+    }
+    
+    CLKConfigFileStamp stamp;
+#if defined(__APPLE__)
+    stamp.modificationSeconds = info.st_mtimespec.tv_sec;
+    stamp.modificationNanoseconds = info.st_mtimespec.tv_nsec;
+#else
+    stamp.modificationSeconds = info.st_mtim.tv_sec;
+    stamp.modificationNanoseconds = info.st_mtim.tv_nsec;
+#endif
+    stamp.size = (uint64_t)info.st_size;
+    
+    NSString *imagePath = (cacheDirectory != nil ? [self _imagePathForConfigFile:path cacheDirectory:cacheDirectory] : nil);
+    if (imagePath != nil) {
+        NSData *image = [self _mappedImageAtPath:imagePath];
+        if (image != nil) {
+            CLKOptionSource *source = [[self alloc] _initWithName:path image:image loadedFromCache:YES];
+            if ([source _imageMatchesPath:path stamp:stamp]) {
+                close(fd);
+                return source;
+            }
+        }
+    }
+    
+    // the file is read through the descriptor that was stamped
+    NSMutableData *contents = [[NSMutableData alloc] initWithLength:(NSUInteger)info.st_size];
+    NSUInteger length = 0;
+    while (length < contents.length) {
+        ssize_t count = read(fd, ((uint8_t *)contents.mutableBytes + length), (contents.length - length));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        
+        if (count < 0) {
+            int code = errno;
+            close(fd);
+            if (outError != nil) {
+                *outError = [NSError clk_POSIXErrorWithCode:code description:@"%@: %s", path, strerror(code)];
+            }
+            
+            return nil;
+        }
+        
+        if (count == 0) {
+            break;
+        }
+        
+        length += (NSUInteger)count;
+    }
+    
+    close(fd);
+    contents.length = length;
+    
+    NSData *image = [self _imageWithConfigFileContents:contents path:path stamp:stamp error:outError];
+    if (image == nil) {
+        return nil;
+    }
+    
+    if (imagePath != nil) {
+        [NSFileManager.defaultManager createDirectoryAtPath:cacheDirectory withIntermediateDirectories:YES attributes:nil error:NULL];
+        [image writeToFile:imagePath atomically:YES];
+    }
+    
+    return [[self alloc] _initWithName:path image:image loadedFromCache:NO];
+}
+
+- (instancetype)_initWithEnvironment:(NSDictionary<NSString *, NSString *> *)environment
+{
+    CLKHardParameterAssert(environment != nil);
+    
+    self = [super init];
+    if (self != nil) {
+        _name = @"environment";
+        _environment = [environment copy];
+    }
+    
+    return self;
+}
+
+- (instancetype)_initWithName:(NSString *)name image:(NSData *)image loadedFromCache:(BOOL)loadedFromCache
+{
+    CLKHardParameterAssert(name != nil);
+    CLKHardParameterAssert(image != nil);
+    CLKHardParameterAssert([CLKOptionSource _isValidImage:image]);
+    
+    self = [super init];
+    if (self != nil) {
+        _name = [name copy];
+        _loadedFromCache = loadedFromCache;
+        _image = image;
+        _header = (const CLKConfigImageHeader *)image.bytes;
+        _entries = (const CLKConfigImageEntry *)((const uint8_t *)image.bytes + _header->entriesOffset);
+        _strings = (const unichar *)((const uint8_t *)image.bytes + _header->stringsOffset);
+    }
+    
+    return self;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"%@ { %@ }", super.description, _name];
+}
+
+#pragma mark -
+#pragma mark Settings
+
+- (NSArray<NSString *> *)valuesForOptionNamed:(NSString *)optionName
+{
+    CLKHardParameterAssert(optionName != nil);
+    
+    if (_environment != nil) {
+        NSString *value = _environment[CLKOptionSourceEnvironmentKey(optionName)];
+        return (value != nil ? @[ value ] : nil);
+    }
+    
+    NSRange range = [self _entryRangeForOptionNamed:optionName];
+    if (range.length == 0) {
+        return nil;
+    }
+    
+    NSMutableArray<NSString *> *values = [[NSMutableArray alloc] initWithCapacity:range.length];
+    for (NSUInteger i = range.location ; i < NSMaxRange(range) ; i++) {
+        [values addObject:[self _stringAtOffset:_entries[i].valueOffset length:_entries[i].valueLength]];
+    }
+    
+    return values;
+}
+
+- (void)_enumerateSettingsInRegistry:(CLKOptionRegistry *)registry usingBlock:(void (^)(NSUInteger optionIndex, NSArray<NSString *> *values))block
+{
+    CLKHardParameterAssert(registry != nil);
+    CLKHardParameterAssert(block != nil);
+    
+    NSMutableDictionary<NSNumber *, NSArray<NSString *> *> *settings = [[NSMutableDictionary alloc] init];
+    if (_environment != nil) {
+        NSDictionary<NSString *, NSIndexSet *> *keyIndex = registry.environmentKeyIndex;
+        [_environment enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *value, __unused BOOL *outStop) {
+            [keyIndex[key] enumerateIndexesUsingBlock:^(NSUInteger optionIndex, __unused BOOL *outInnerStop) {
+                settings[@(optionIndex)] = @[ value ];
+            }];
+        }];
+    } else {
+        // the entries are sorted by name, so each name's entries are adjacent
+        NSUInteger start = 0;
+        while (start < _header->entryCount) {
+            const CLKConfigImageEntry *entry = &_entries[start];
+            NSUInteger end = (start + 1);
+            while (end < _header->entryCount && CLKMappedImageCompareCharacters((_strings + _entries[end].nameOffset), _entries[end].nameLength, (_strings + entry->nameOffset), entry->nameLength) == 0) {
+                end++;
+            }
+            
+            NSUInteger optionIndex = [registry indexOfOptionNamed:[self _stringAtOffset:entry->nameOffset length:entry->nameLength]];
+            if (optionIndex != NSNotFound) {
+                NSMutableArray<NSString *> *values = [[NSMutableArray alloc] initWithCapacity:(end - start)];
+                for (NSUInteger i = start ; i < end ; i++) {
+                    [values addObject:[self _stringAtOffset:_entries[i].valueOffset length:_entries[i].valueLength]];
+                }
+                
+                settings[@(optionIndex)] = values;
+            }
+            
+            start = end;
+        }
+    }
+    
+    for (NSNumber *optionIndex in [settings.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        block(optionIndex.unsignedIntegerValue, settings[optionIndex]);
+    }
+}
+
+- (NSArray<NSString *> *)_unrecognizedOptionNamesInRegistry:(CLKOptionRegistry *)registry
+{
+    CLKHardParameterAssert(registry != nil);
+    
+    NSMutableArray<NSString *> *optionNames = [[NSMutableArray alloc] init];
+    if (_environment != nil) {
+        return optionNames;
+    }
+    
+    // the entries are sorted by name, so each name's entries are adjacent
+    NSString *previousName = nil;
+    for (NSUInteger i = 0 ; i < _header->entryCount ; i++) {
+        const CLKConfigImageEntry *entry = &_entries[i];
+        if (previousName != nil && CLKMappedImageCompareCharacters((_strings + entry->nameOffset), entry->nameLength, (_strings + _entries[i - 1].nameOffset), _entries[i - 1].nameLength) == 0) {
+            continue;
+        }
+        
+        previousName = [self _stringAtOffset:entry->nameOffset length:entry->nameLength];
+        if (![registry hasOptionNamed:previousName]) {
+            [optionNames addObject:previousName];
+        }
+    }
+    
+    return optionNames;
+}
+
+- (NSString *)_locationOfOptionNamed:(NSString *)optionName
+{
+    CLKHardParameterAssert(optionName != nil);
+    
+    if (_environment != nil) {
+        return [CLKOptionSourceEnvironmentPrefix stringByAppendingString:CLKOptionSourceEnvironmentKey(optionName)];
+    }
+    
+    return _name;
+}
+
+- (NSString *)_stringAtOffset:(uint64_t)offset length:(uint64_t)length
+{
+    return [[NSString alloc] initWithCharacters:(_strings + offset) length:(NSUInteger)length];
+}
+
+// the entries setting the option, found by binary search
+- (NSRange)_entryRangeForOptionNamed:(NSString *)optionName
+{
+    NSUInteger length = optionName.length;
+    unichar stackBuffer[CLKOptionNameStackBufferLength];
+    unichar *characters = (length > CLKOptionNameStackBufferLength ? malloc(length * sizeof(unichar)) : stackBuffer);
+    [optionName getCharacters:characters range:NSMakeRange(0, length)];
+    
+    // the first entry not ordered before the name
+    NSUInteger low = 0;
+    NSUInteger high = _header->entryCount;
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        if (CLKMappedImageCompareCharacters((_strings + _entries[mid].nameOffset), _entries[mid].nameLength, characters, length) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    NSUInteger end = low;
+    while (end < _header->entryCount && CLKMappedImageCompareCharacters((_strings + _entries[end].nameOffset), _entries[end].nameLength, characters, length) == 0) {
+        end++;
+    }
+    
+    if (characters != stackBuffer) {
+        free(characters);
+    }
+    
+    return NSMakeRange(low, (end - low));
+}
+
+#pragma mark -
+#pragma mark Config Files
+
++ (NSData *)_imageWithConfigFileContents:(NSData *)contents path:(NSString *)path stamp:(CLKConfigFileStamp)stamp error:(NSError **)outError
+{
+    NSString *text = [[NSString alloc] initWithData:contents encoding:NSUTF8StringEncoding];
+    if (text == nil) {
+        if (outError != nil) {
+            *outError = [NSError clk_CLKErrorWithCode:CLKErrorInvalidConfigFile description:@"%@: not a UTF-8 text file", path];
+        }
+        
+        return nil;
+    }
+    
+    NSCharacterSet *whitespace = NSCharacterSet.whitespaceCharacterSet;
+    NSMutableArray<NSString *> *names = [[NSMutableArray alloc] init];
+    NSMutableArray<NSString *> *values = [[NSMutableArray alloc] init];
+    __block NSUInteger lineNumber = 0;
+    __block NSError *error = nil;
+    [text enumerateLinesUsingBlock:^(NSString *line, BOOL *outStop) {
+        lineNumber++;
+        NSString *setting = [line stringByTrimmingCharactersInSet:whitespace];
+        if (setting.length == 0 || [setting hasPrefix:@"#"]) {
+            return;
+        }
+        
+        NSString *name = setting;
+        NSString *value = @"";
+        NSRange assignment = [setting rangeOfString:@"="];
+        if (assignment.location != NSNotFound) {
+            name = [[setting substringToIndex:assignment.location] stringByTrimmingCharactersInSet:whitespace];
+            value = [[setting substringFromIndex:NSMaxRange(assignment)] stringByTrimmingCharactersInSet:whitespace];
+        }
+        
+        if (name.length == 0 || [name rangeOfCharacterFromSet:whitespace].location != NSNotFound || name.length > UINT32_MAX || value.length > UINT32_MAX) {
+            error = [NSError clk_CLKErrorWithCode:CLKErrorInvalidConfigFile description:@"%@:%lu: malformed setting '%@'", path, (unsigned long)lineNumber, setting];
+            *outStop = YES;
+            return;
+        }
+        
+        [names addObject:name];
+        [values addObject:value];
+    }];
+    
+    if (error != nil) {
+        if (outError != nil) {
+            *outError = error;
+        }
+        
+        return nil;
+    }
+    
+    NSUInteger entryCount = names.count;
+    CLKHardAssert((entryCount < UINT32_MAX), NSRangeException, @"config file has too many settings: %@", path);
+    
+    NSMutableData *strings = [[NSMutableData alloc] init];
+    uint64_t pathOffset = CLKConfigImageAppendString(strings, path);
+    CLKConfigImageEntry *entries = calloc(MAX(entryCount, 1UL), sizeof(CLKConfigImageEntry));
+    for (NSUInteger i = 0 ; i < entryCount ; i++) {
+        entries[i].nameOffset = CLKConfigImageAppendString(strings, names[i]);
+        entries[i].nameLength = (uint32_t)names[i].length;
+        entries[i].valueOffset = CLKConfigImageAppendString(strings, values[i]);
+        entries[i].valueLength = (uint32_t)values[i].length;
+    }
+    
+    // sorted by name, then by line: names are appended in line order, so ties go to the lower offset
+    const unichar *characters = strings.bytes;
+    NSMutableArray<NSNumber *> *order = [[NSMutableArray alloc] initWithCapacity:entryCount];
+    for (NSUInteger i = 0 ; i < entryCount ; i++) {
+        [order addObject:@(i)];
+    }
+    
+    [order sortUsingComparator:^(NSNumber *lhsIndex, NSNumber *rhsIndex) {
+        const CLKConfigImageEntry *lhs = &entries[lhsIndex.unsignedIntegerValue];
+        const CLKConfigImageEntry *rhs = &entries[rhsIndex.unsignedIntegerValue];
+        int result = CLKMappedImageCompareCharacters((characters + lhs->nameOffset), lhs->nameLength, (characters + rhs->nameOffset), rhs->nameLength);
+        if (result == 0) {
+            result = (lhs->nameOffset < rhs->nameOffset ? -1 : 1);
+        }
+        
+        return (NSComparisonResult)result;
+    }];
+    
+    uint64_t entriesOffset = CLKConfigImageAlign(sizeof(CLKConfigImageHeader));
+    uint64_t stringsOffset = CLKConfigImageAlign(entriesOffset + (entryCount * sizeof(CLKConfigImageEntry)));
+    uint64_t length = (stringsOffset + strings.length);
+    
+    NSMutableData *image = [[NSMutableData alloc] initWithLength:(NSUInteger)length];
+    uint8_t *bytes = image.mutableBytes;
+    CLKConfigImageEntry *sortedEntries = (CLKConfigImageEntry *)(bytes + entriesOffset);
+    for (NSUInteger i = 0 ; i < entryCount ; i++) {
+        sortedEntries[i] = entries[order[i].unsignedIntegerValue];
+    }
+    
+    free(entries);
+    memcpy((bytes + stringsOffset), strings.bytes, strings.length);
+    
+    CLKConfigImageHeader *header = (CLKConfigImageHeader *)bytes;
+    memcpy(header->magic, CLKConfigImageMagic, sizeof(header->magic));
+    header->version = CLKConfigImageVersion;
+    header->byteOrderMark = CLKConfigImageByteOrderMark;
+    header->entryCount = (uint32_t)entryCount;
+    header->length = length;
+    header->modificationSeconds = stamp.modificationSeconds;
+    header->modificationNanoseconds = stamp.modificationNanoseconds;
+    header->size = stamp.size;
+    header->pathOffset = pathOffset;
+    header->pathLength = path.length;
+    header->entriesOffset = entriesOffset;
+    header->stringsOffset = stringsOffset;
+    header->stringsLength = (strings.length / sizeof(unichar));
+    return image;
+}
+
+// answers nil if there is no image at the path or it isn't one this build can read
++ (NSData *)_mappedImageAtPath:(NSString *)imagePath
+{
+    int fd = open(imagePath.fileSystemRepresentation, (O_RDONLY | O_CLOEXEC));
+    if (fd < 0) {
+        return nil;
+    }
+    
+    struct stat info;
+    void *bytes = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        bytes = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    
+    close(fd);
+    if (bytes == MAP_FAILED) {
+        return nil;
+    }
+    
+    NSData *image = [[NSData alloc] initWithBytesNoCopy:bytes length:(NSUInteger)info.st_size deallocator:^(void *mappedBytes, NSUInteger mappedLength) {
+        munmap(mappedBytes, mappedLength);
+    }];
+    
+    return ([self _isValidImage:image] ? image : nil);
+}
+
+// images are read in place, so make sure a damaged one can't send a lookup out of bounds
++ (BOOL)_isValidImage:(NSData *)image
+{
+    NSUInteger length = image.length;
+    if ((((uintptr_t)image.bytes) % CLKConfigImageAlignment) != 0 || length < sizeof(CLKConfigImageHeader)) {
+        return NO;
+    }
+    
+    const CLKConfigImageHeader *header = image.bytes;
+    if (memcmp(header->magic, CLKConfigImageMagic, sizeof(header->magic)) != 0
+        || header->version != CLKConfigImageVersion
+        || header->byteOrderMark != CLKConfigImageByteOrderMark
+        || header->length != length
+        || !CLKMappedImageSectionIsValid(header->entriesOffset, header->entryCount, sizeof(CLKConfigImageEntry), length)
+        || !CLKMappedImageSectionIsValid(header->stringsOffset, header->stringsLength, sizeof(unichar), length))
+    {
+        return NO;
+    }
+    
+    uint64_t stringsLength = header->stringsLength;
+    if (header->pathOffset > stringsLength || header->pathLength > (stringsLength - header->pathOffset)) {
+        return NO;
+    }
+    
+    const CLKConfigImageEntry *entries = (const CLKConfigImageEntry *)((const uint8_t *)image.bytes + header->entriesOffset);
+    for (NSUInteger i = 0 ; i < header->entryCount ; i++) {
+        const CLKConfigImageEntry *entry = &entries[i];
+        if (entry->nameOffset > stringsLength || entry->nameLength > (stringsLength - entry->nameOffset)
+            || entry->valueOffset > stringsLength || entry->valueLength > (stringsLength - entry->valueOffset))
+        {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+// FNV-1a of the path's UTF-8 bytes. the image records the full path, so a collision only costs a parse.
++ (NSString *)_imagePathForConfigFile:(NSString *)path cacheDirectory:(NSString *)cacheDirectory
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char *cursor = path.fileSystemRepresentation ; *cursor != '\0' ; cursor++) {
+        h ^= (uint8_t)*cursor;
+        h *= 0x100000001b3ULL;
+    }
+    
+    NSString *fileName = [NSString stringWithFormat:@"%016llx.%@", h, CLKConfigImagePathExtension];
+    return [cacheDirectory stringByAppendingPathComponent:fileName];
+}
+
+- (BOOL)_imageMatchesPath:(NSString *)path stamp:(CLKConfigFileStamp)stamp
+{
+    NSParameterAssert(_image != nil);
+    
+    if (_header->modificationSeconds != stamp.modificationSeconds
+        || _header->modificationNanoseconds != stamp.modificationNanoseconds
+        || _header->size != stamp.size
+        || _header->pathLength != path.length)
+    {
+        return NO;
+    }
+    
+    return [[self _stringAtOffset:_header->pathOffset length:_header->pathLength] isEqualToString:path];
+}
+
+@end
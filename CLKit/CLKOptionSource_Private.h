@@ -0,0 +1,33 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKOptionSource.h"
+
+@class CLKOptionRegistry;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// the environment variable an option is read from, without CLKOptionSourceEnvironmentPrefix:
+// `dry-run` is set by CLKIT_DRY_RUN
+NSString *CLKOptionSourceEnvironmentKey(NSString *optionName);
+
+@interface CLKOptionSource ()
+
+// YES if a config file source was read from its compiled image rather than parsed
+@property (nonatomic, readonly) BOOL _loadedFromCache;
+
+// calls the block with the values the source sets for each of `registry`'s options, in option index
+// order. only the source's own settings are looked up, so the cost doesn't grow with the registry.
+- (void)_enumerateSettingsInRegistry:(CLKOptionRegistry *)registry usingBlock:(void (^)(NSUInteger optionIndex, NSArray<NSString *> *values))block;
+
+// the names the source sets that aren't options in `registry`, in the order they were set. always
+// empty for environment sources (see +environmentSource).
+- (NSArray<NSString *> *)_unrecognizedOptionNamesInRegistry:(CLKOptionRegistry *)registry;
+
+// where the setting for an option came from, for issue descriptions: the variable or the file
+- (NSString *)_locationOfOptionNamed:(NSString *)optionName;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -26,7 +26,7 @@ NSString *CLKStringForOptionType(CLKOptionType type);
 
 - (void)_initConstraints;
 
-@property (readonly) NSArray<CLKArgumentManifestConstraint *> *constraints;
+@property (nonatomic, readonly) NSArray<CLKArgumentManifestConstraint *> *constraints;
 
 + (void)_validateOptionName:(NSString *)name flag:(nullable NSString *)flag;
 
@@ -0,0 +1,61 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// answers the number of allocations the process has made so far (see CLKParseProfileSetAllocationCounter())
+typedef uint64_t (*CLKParseProfileAllocationCounter)(void);
+
+// CLKit can't count allocations by itself. profiles only include allocation counts while a counter is
+// installed, such as one that interposes malloc(). pass NULL to remove the counter.
+void CLKParseProfileSetAllocationCounter(CLKParseProfileAllocationCounter _Nullable counter);
+
+// where the time in one parse went. profiles are collected by parsers with profiling enabled (see
+// -[CLKArgumentParser profilingEnabled]) and are immutable.
+//
+// setting the CLK_PARSE_PROFILE environment variable enables profiling for every parser and verb depot
+// in the process. each finished parse appends its profile to the file the variable names, or to
+// standard error if it is `-`, as one line of JSON: the profile's dictionary representation plus the
+// process name and pid under `process` and `pid`.
+//
+// every measurement is a dictionary with a `count`, the `nanoseconds` spent and, if allocations were
+// counted, the `allocations` made. times are inclusive: a state's time includes the transformers it
+// ran. measurements that were never taken (a state that was never visited, say) are omitted.
+@interface CLKParseProfile : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
+// the whole parse, including validation. for an event-driven parse, the time spent in -nextEvent.
+@property (readonly) uint64_t nanoseconds;
+
+// YES if an allocation counter was installed for the whole parse
+@property (readonly) BOOL countsAllocations;
+@property (readonly) uint64_t allocationCount;
+
+// visits to each state of the parser's state machine, keyed by state name (e.g., `parseOptionFlag`)
+@property (readonly) NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *states;
+
+// the number of tokens read of each form, keyed by form name (e.g., `optionFlagSet`). the flags of
+// a flag set are counted as they are read, in addition to the set.
+@property (readonly) NSDictionary<NSString *, NSNumber *> *tokenForms;
+
+// transformer calls, keyed by option name. transformations run concurrently (see
+// -[CLKArgumentParser transformerConcurrency]) are timed but their allocations aren't counted.
+@property (readonly) NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *transformers;
+
+// constraint checks, keyed by constraint type (e.g., `mutuallyExclusive`)
+@property (readonly) NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *constraints;
+
+// the measurements above under `nanoseconds`, `allocations`, `states`, `tokenForms`, `transformers`
+// and `constraints`
+@property (readonly) NSDictionary<NSString *, id> *dictionaryRepresentation;
+
+@property (readonly) NSData *JSONData;
+
+@end
+
+NS_ASSUME_NONNULL_END
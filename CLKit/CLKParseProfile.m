@@ -0,0 +1,283 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKParseProfile_Private.h"
+
+#import <errno.h>
+#import <fcntl.h>
+#import <stdatomic.h>
+#import <stdlib.h>
+#import <string.h>
+#import <unistd.h>
+
+#import "CLKAssert.h"
+#import "CLKOption.h"
+#import "CLKOptionRegistry.h"
+
+// indexed by CLKAPState
+static NSString *const CLKParseProfileStateNames[CLKParseProfileStateCount] = {
+    @"begin",
+    @"readNextArgumentToken",
+    @"parseOptionName",
+    @"parseOptionFlag",
+    @"parseOptionFlagSet",
+    @"parseParameterOptionNameAssignment",
+    @"parseParameterOptionFlagAssignment",
+    @"parseArgument",
+    @"parseOptionParsingSentinel",
+    @"parseRemainderArguments",
+    @"end"
+};
+
+// indexed by CLKTokenForm
+static NSString *const CLKParseProfileTokenFormNames[CLKParseProfileTokenFormCount] = {
+    @"optionName",
+    @"optionFlag",
+    @"optionFlagSet",
+    @"parameterOptionNameAssignment",
+    @"parameterOptionFlagAssignment",
+    @"optionParsingSentinel",
+    @"argument",
+    @"malformedOption"
+};
+
+// indexed by CLKConstraintType
+static NSString *const CLKParseProfileConstraintTypeNames[CLKParseProfileConstraintTypeCount] = {
+    @"required",
+    @"anyRequired",
+    @"mutuallyExclusive",
+    @"standalone",
+    @"occurrencesLimited"
+};
+
+static _Atomic(CLKParseProfileAllocationCounter) CLKParseProfileInstalledAllocationCounter = NULL;
+
+NS_ASSUME_NONNULL_BEGIN
+
+static NSDictionary<NSString *, NSNumber *> *CLKParseProfileCounterDictionary(const CLKParseProfileCounter *counter, BOOL countsAllocations);
+static const char *_Nullable CLKParseProfileEnvironmentDestination(void);
+
+NS_ASSUME_NONNULL_END
+
+#pragma mark -
+#pragma mark Counters
+
+void CLKParseProfileSetAllocationCounter(CLKParseProfileAllocationCounter counter)
+{
+    atomic_store_explicit(&CLKParseProfileInstalledAllocationCounter, counter, memory_order_release);
+}
+
+uint64_t CLKParseProfileAllocationCount(BOOL *outAvailable)
+{
+    CLKParseProfileAllocationCounter counter = atomic_load_explicit(&CLKParseProfileInstalledAllocationCounter, memory_order_acquire);
+    if (outAvailable != NULL) {
+        *outAvailable = (counter != NULL);
+    }
+    
+    return (counter != NULL ? counter() : 0);
+}
+
+CLKParseCounters *CLKParseCountersCreate(NSUInteger optionCount)
+{
+    CLKParseCounters *counters = calloc(1, sizeof(CLKParseCounters));
+    counters->transformers = calloc(MAX(optionCount, 1UL), sizeof(CLKParseProfileCounter));
+    counters->optionCount = optionCount;
+    counters->countsAllocations = YES;
+    return counters;
+}
+
+void CLKParseCountersFree(CLKParseCounters *counters)
+{
+    if (counters != NULL) {
+        free(counters->transformers);
+        free(counters);
+    }
+}
+
+void CLKParseCountersReset(CLKParseCounters *counters)
+{
+    CLKParseProfileCounter *transformers = counters->transformers;
+    NSUInteger optionCount = counters->optionCount;
+    memset(transformers, 0, (MAX(optionCount, 1UL) * sizeof(CLKParseProfileCounter)));
+    memset(counters, 0, sizeof(CLKParseCounters));
+    counters->transformers = transformers;
+    counters->optionCount = optionCount;
+    counters->countsAllocations = YES;
+}
+
+static NSDictionary<NSString *, NSNumber *> *CLKParseProfileCounterDictionary(const CLKParseProfileCounter *counter, BOOL countsAllocations)
+{
+    if (countsAllocations) {
+        return @{
+            @"count" : @(counter->count),
+            @"nanoseconds" : @(counter->nanoseconds),
+            @"allocations" : @(counter->allocations)
+        };
+    }
+    
+    return @{
+        @"count" : @(counter->count),
+        @"nanoseconds" : @(counter->nanoseconds)
+    };
+}
+
+#pragma mark -
+#pragma mark CLK_PARSE_PROFILE
+
+static const char *CLKParseProfileEnvironmentDestination(void)
+{
+    static const char *destination = NULL;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        const char *value = getenv(CLKParseProfileEnvironmentVariable);
+        if (value != NULL && value[0] != '\0') {
+            destination = strdup(value);
+        }
+    });
+    
+    return destination;
+}
+
+BOOL CLKParseProfileIsEnabledByEnvironment(void)
+{
+    return (CLKParseProfileEnvironmentDestination() != NULL);
+}
+
+void CLKParseProfileWriteToEnvironmentDestination(CLKParseProfile *profile)
+{
+    const char *destination = CLKParseProfileEnvironmentDestination();
+    if (destination == NULL) {
+        return;
+    }
+    
+    NSMutableDictionary<NSString *, id> *record = [profile.dictionaryRepresentation mutableCopy];
+    record[@"process"] = NSProcessInfo.processInfo.processName;
+    record[@"pid"] = @(getpid());
+    
+    NSMutableData *line = [[NSJSONSerialization dataWithJSONObject:record options:0 error:NULL] mutableCopy];
+    if (line == nil) {
+        return;
+    }
+    
+    [line appendBytes:"\n" length:1];
+    
+    // one write per profile, so that concurrent writers append whole lines
+    BOOL writesStandardError = (strcmp(destination, "-") == 0);
+    int fd = (writesStandardError ? STDERR_FILENO : open(destination, (O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC), 0644));
+    if (fd < 0) {
+        return;
+    }
+    
+    ssize_t count;
+    do {
+        count = write(fd, line.bytes, line.length);
+    } while (count < 0 && errno == EINTR);
+    
+    if (!writesStandardError) {
+        close(fd);
+    }
+}
+
+#pragma mark -
+
+@implementation CLKParseProfile
+{
+    uint64_t _nanoseconds;
+    BOOL _countsAllocations;
+    uint64_t _allocationCount;
+    NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *_states;
+    NSDictionary<NSString *, NSNumber *> *_tokenForms;
+    NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *_transformers;
+    NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *_constraints;
+}
+
+@synthesize nanoseconds = _nanoseconds;
+@synthesize countsAllocations = _countsAllocations;
+@synthesize allocationCount = _allocationCount;
+@synthesize states = _states;
+@synthesize tokenForms = _tokenForms;
+@synthesize transformers = _transformers;
+@synthesize constraints = _constraints;
+
+- (instancetype)_initWithCounters:(const CLKParseCounters *)counters optionRegistry:(CLKOptionRegistry *)registry
+{
+    CLKHardParameterAssert(counters != NULL);
+    CLKHardParameterAssert(registry != nil);
+    CLKHardParameterAssert(counters->optionCount == registry.options.count);
+    
+    self = [super init];
+    if (self != nil) {
+        BOOL countsAllocations = counters->countsAllocations;
+        _nanoseconds = counters->total.nanoseconds;
+        _countsAllocations = countsAllocations;
+        _allocationCount = (countsAllocations ? counters->total.allocations : 0);
+        
+        NSMutableDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *states = [[NSMutableDictionary alloc] init];
+        for (NSUInteger i = 0 ; i < CLKParseProfileStateCount ; i++) {
+            if (counters->states[i].count > 0) {
+                states[CLKParseProfileStateNames[i]] = CLKParseProfileCounterDictionary(&counters->states[i], countsAllocations);
+            }
+        }
+        
+        NSMutableDictionary<NSString *, NSNumber *> *tokenForms = [[NSMutableDictionary alloc] init];
+        for (NSUInteger i = 0 ; i < CLKParseProfileTokenFormCount ; i++) {
+            if (counters->tokenForms[i] > 0) {
+                tokenForms[CLKParseProfileTokenFormNames[i]] = @(counters->tokenForms[i]);
+            }
+        }
+        
+        NSArray<CLKOption *> *options = registry.options;
+        NSMutableDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *transformers = [[NSMutableDictionary alloc] init];
+        for (NSUInteger i = 0 ; i < counters->optionCount ; i++) {
+            if (counters->transformers[i].count > 0) {
+                transformers[options[i].name] = CLKParseProfileCounterDictionary(&counters->transformers[i], countsAllocations);
+            }
+        }
+        
+        NSMutableDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *constraints = [[NSMutableDictionary alloc] init];
+        for (NSUInteger i = 0 ; i < CLKParseProfileConstraintTypeCount ; i++) {
+            if (counters->constraintTypes[i].count > 0) {
+                constraints[CLKParseProfileConstraintTypeNames[i]] = CLKParseProfileCounterDictionary(&counters->constraintTypes[i], countsAllocations);
+            }
+        }
+        
+        _states = states;
+        _tokenForms = tokenForms;
+        _transformers = transformers;
+        _constraints = constraints;
+    }
+    
+    return self;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"%@ { %llu ns | states: %@ | token forms: %@ }", super.description, _nanoseconds, _states, _tokenForms];
+}
+
+#pragma mark -
+
+- (NSDictionary<NSString *, id> *)dictionaryRepresentation
+{
+    NSMutableDictionary<NSString *, id> *dictionary = [NSMutableDictionary dictionary];
+    dictionary[@"nanoseconds"] = @(_nanoseconds);
+    if (_countsAllocations) {
+        dictionary[@"allocations"] = @(_allocationCount);
+    }
+    
+    dictionary[@"states"] = _states;
+    dictionary[@"tokenForms"] = _tokenForms;
+    dictionary[@"transformers"] = _transformers;
+    dictionary[@"constraints"] = _constraints;
+    return dictionary;
+}
+
+- (NSData *)JSONData
+{
+    NSData *data = [NSJSONSerialization dataWithJSONObject:self.dictionaryRepresentation options:0 error:NULL];
+    CLKHardAssert((data != nil), NSInternalInconsistencyException, @"profile could not be serialized");
+    return data;
+}
+
+@end
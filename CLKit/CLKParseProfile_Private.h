@@ -0,0 +1,110 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKParseProfile.h"
+
+#import <time.h>
+
+#import "CLKToken.h"
+
+@class CLKOptionRegistry;
+
+typedef struct {
+    uint64_t count;
+    uint64_t nanoseconds;
+    uint64_t allocations;
+} CLKParseProfileCounter;
+
+#define CLKParseProfileStateCount 11
+#define CLKParseProfileTokenFormCount 8
+#define CLKParseProfileConstraintTypeCount 5
+
+// the raw measurements a parser collects while profiling. states are indexed by CLKAPState,
+// transformers by option index.
+typedef struct {
+    CLKParseProfileCounter total;
+    CLKParseProfileCounter states[CLKParseProfileStateCount];
+    uint64_t tokenForms[CLKParseProfileTokenFormCount];
+    CLKParseProfileCounter constraintTypes[CLKParseProfileConstraintTypeCount];
+    CLKParseProfileCounter *transformers;
+    NSUInteger optionCount;
+    BOOL countsAllocations; // NO if the allocation counter was missing at any point
+} CLKParseCounters;
+
+// the start of a measurement
+typedef struct {
+    uint64_t nanoseconds;
+    uint64_t allocations;
+} CLKParseProfileMark;
+
+NS_ASSUME_NONNULL_BEGIN
+
+CLKParseCounters *CLKParseCountersCreate(NSUInteger optionCount);
+void CLKParseCountersFree(CLKParseCounters *_Nullable counters);
+
+// zeroes the measurements for another parse
+void CLKParseCountersReset(CLKParseCounters *counters);
+
+uint64_t CLKParseProfileAllocationCount(BOOL *outAvailable);
+
+static inline uint64_t CLKParseProfileNanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec);
+}
+
+static inline CLKParseProfileMark CLKParseProfileMarkNow(CLKParseCounters *counters)
+{
+    BOOL available;
+    CLKParseProfileMark mark;
+    mark.allocations = CLKParseProfileAllocationCount(&available);
+    counters->countsAllocations = (counters->countsAllocations && available);
+    mark.nanoseconds = CLKParseProfileNanoseconds();
+    return mark;
+}
+
+// counts one measurement from `mark` to now
+static inline void CLKParseProfileCounterAdd(CLKParseProfileCounter *counter, CLKParseProfileMark mark)
+{
+    uint64_t nanoseconds = CLKParseProfileNanoseconds();
+    counter->count++;
+    counter->nanoseconds += (nanoseconds - mark.nanoseconds);
+    
+    // a counter removed mid-measurement reads zero
+    uint64_t allocations = CLKParseProfileAllocationCount(NULL);
+    if (allocations >= mark.allocations) {
+        counter->allocations += (allocations - mark.allocations);
+    }
+}
+
+static inline void CLKParseCountersNoteTokenForm(CLKParseCounters *_Nullable counters, CLKTokenForm form)
+{
+    if (counters != NULL) {
+        counters->tokenForms[form]++;
+    }
+}
+
+#pragma mark -
+#pragma mark CLK_PARSE_PROFILE
+
+#define CLKParseProfileEnvironmentVariable "CLK_PARSE_PROFILE"
+
+// YES if CLK_PARSE_PROFILE is set. read once per process.
+BOOL CLKParseProfileIsEnabledByEnvironment(void);
+
+// appends the profile to the destination named by CLK_PARSE_PROFILE, if there is one.
+// failures are ignored; profiling never fails a parse.
+void CLKParseProfileWriteToEnvironmentDestination(CLKParseProfile *profile);
+
+#pragma mark -
+
+@interface CLKParseProfile ()
+
+// `registry` names the transformer counters
+- (instancetype)_initWithCounters:(const CLKParseCounters *)counters optionRegistry:(CLKOptionRegistry *)registry NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,41 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// an immutable prefix index over a list of strings, identified by their indexes in that list.
+// safe to share across threads.
+//
+// the nodes are stored in one array in depth-first order, so every string with a given prefix
+// lies in a single run of nodes: finding them costs one step per character of the prefix and
+// one pass over the run. a node's children are found through a sorted table of child indexes.
+// strings are ordered by UTF-16 code unit.
+@interface CLKPrefixTrie : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
+// when a string occurs more than once, the index of its first occurrence is used
++ (instancetype)trieWithStrings:(NSArray<NSString *> *)strings;
+
+@property (readonly) NSUInteger nodeCount;
+
+// answers NSNotFound if `string` isn't in the trie
+- (NSUInteger)indexOfString:(NSString *)string;
+
+// answers the index of the only string beginning with `prefix` (including `prefix` itself), or NSNotFound
+// if no string or more than one begins with it. each node records the only string under it, so this
+// costs one step per character of the prefix however many strings share it.
+- (NSUInteger)indexOfStringWithUniquePrefix:(NSString *)prefix;
+- (NSUInteger)indexOfStringWithUniquePrefixCharacters:(const unichar *)characters length:(NSUInteger)length;
+
+// enumerates the indexes of the strings beginning with `prefix` (including `prefix` itself)
+// in the strings' order
+- (void)enumerateIndexesOfStringsWithPrefix:(NSString *)prefix usingBlock:(NS_NOESCAPE void (^)(NSUInteger idx, BOOL *outStop))block;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,285 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKPrefixTrie.h"
+
+#import "CLKAssert.h"
+
+#define CLKPTValueNone UINT32_MAX
+
+typedef struct {
+    unichar character; // the character on the edge into this node. unused by the root.
+    uint32_t value; // index of the string ending here, or CLKPTValueNone
+    uint32_t soleValue; // index of the only string ending at or under this node, or CLKPTValueNone if there are none or several
+    uint32_t childOffset; // offset of this node's children in the child table
+    uint32_t childCount;
+    uint32_t subtreeEnd; // one past the last node under this one
+} CLKPTNode;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKPrefixTrie ()
+
+- (instancetype)_initWithStrings:(NSArray<NSString *> *)strings NS_DESIGNATED_INITIALIZER;
+
+- (uint32_t)_buildNodeWithKeys:(const uint32_t *)keys count:(NSUInteger)count depth:(NSUInteger)depth;
+- (uint32_t)_nodeForPrefix:(NSString *)prefix;
+- (uint32_t)_nodeForPrefixCharacters:(const unichar *)characters length:(NSUInteger)length;
+- (uint32_t)_childOfNode:(uint32_t)nodeIndex withCharacter:(unichar)character;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation CLKPrefixTrie
+{
+    CLKPTNode *_nodes;
+    uint32_t _nodeCount;
+    uint32_t *_children; // child node indexes, sorted by character within each node
+    uint32_t _childCount;
+    
+    // the strings' characters, packed, used only while building
+    unichar *_characters;
+    NSUInteger *_offsets;
+}
+
++ (instancetype)trieWithStrings:(NSArray<NSString *> *)strings
+{
+    return [[self alloc] _initWithStrings:strings];
+}
+
+- (instancetype)_initWithStrings:(NSArray<NSString *> *)strings
+{
+    CLKHardParameterAssert(strings != nil);
+    CLKHardParameterAssert(strings.count < CLKPTValueNone);
+    
+    self = [super init];
+    if (self != nil) {
+        NSUInteger count = strings.count;
+        _offsets = malloc((count + 1) * sizeof(NSUInteger));
+        NSUInteger totalLength = 0;
+        for (NSUInteger i = 0 ; i < count ; i++) {
+            _offsets[i] = totalLength;
+            totalLength += strings[i].length;
+        }
+        
+        _offsets[count] = totalLength;
+        CLKHardAssert((totalLength < UINT32_MAX), NSInvalidArgumentException, @"too many characters for a prefix trie");
+        
+        _characters = malloc(MAX(totalLength, 1UL) * sizeof(unichar));
+        for (NSUInteger i = 0 ; i < count ; i++) {
+            [strings[i] getCharacters:(_characters + _offsets[i]) range:NSMakeRange(0, strings[i].length)];
+        }
+        
+        // every node but the root is entered by a character of some string
+        _nodes = malloc((totalLength + 1) * sizeof(CLKPTNode));
+        _children = malloc(MAX(totalLength, 1UL) * sizeof(uint32_t));
+        
+        // sorted by characters, then by index, so duplicates keep their first index at the front of their run
+        NSMutableArray<NSNumber *> *sortedKeys = [[NSMutableArray alloc] initWithCapacity:count];
+        for (NSUInteger i = 0 ; i < count ; i++) {
+            [sortedKeys addObject:@(i)];
+        }
+        
+        const unichar *characters = _characters;
+        const NSUInteger *offsets = _offsets;
+        [sortedKeys sortUsingComparator:^NSComparisonResult(NSNumber *lhs, NSNumber *rhs) {
+            NSUInteger a = lhs.unsignedIntegerValue;
+            NSUInteger b = rhs.unsignedIntegerValue;
+            NSUInteger aLength = offsets[a + 1] - offsets[a];
+            NSUInteger bLength = offsets[b + 1] - offsets[b];
+            for (NSUInteger i = 0 ; i < MIN(aLength, bLength) ; i++) {
+                unichar ac = characters[offsets[a] + i];
+                unichar bc = characters[offsets[b] + i];
+                if (ac != bc) {
+                    return (ac < bc ? NSOrderedAscending : NSOrderedDescending);
+                }
+            }
+            
+            if (aLength != bLength) {
+                return (aLength < bLength ? NSOrderedAscending : NSOrderedDescending);
+            }
+            
+            return [lhs compare:rhs];
+        }];
+        
+        uint32_t *keys = malloc(MAX(count, 1UL) * sizeof(uint32_t));
+        for (NSUInteger i = 0 ; i < count ; i++) {
+            keys[i] = sortedKeys[i].unsignedIntValue;
+        }
+        
+        [self _buildNodeWithKeys:keys count:count depth:0];
+        free(keys);
+        
+        free(_characters);
+        free(_offsets);
+        _characters = NULL;
+        _offsets = NULL;
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_nodes);
+    free(_children);
+}
+
+- (uint32_t)_buildNodeWithKeys:(const uint32_t *)keys count:(NSUInteger)count depth:(NSUInteger)depth
+{
+    uint32_t nodeIndex = _nodeCount++;
+    CLKPTNode *node = &_nodes[nodeIndex];
+    node->value = CLKPTValueNone;
+    node->character = (depth > 0 ? _characters[_offsets[keys[0]] + depth - 1] : 0);
+    
+    // keys are sorted, so the ones that end at this depth come first
+    NSUInteger i = 0;
+    while (i < count && (_offsets[keys[i] + 1] - _offsets[keys[i]]) == depth) {
+        if (node->value == CLKPTValueNone) {
+            node->value = keys[i];
+        }
+        
+        i++;
+    }
+    
+    // the child table entries for this node are written after its subtrees, so collect them first
+    uint32_t *childIndexes = malloc(MAX(count - i, 1UL) * sizeof(uint32_t));
+    uint32_t childCount = 0;
+    while (i < count) {
+        unichar character = _characters[_offsets[keys[i]] + depth];
+        NSUInteger groupEnd = i + 1;
+        while (groupEnd < count && _characters[_offsets[keys[groupEnd]] + depth] == character) {
+            groupEnd++;
+        }
+        
+        childIndexes[childCount++] = [self _buildNodeWithKeys:(keys + i) count:(groupEnd - i) depth:(depth + 1)];
+        i = groupEnd;
+    }
+    
+    // _nodes doesn't move (it was allocated for the worst case), but re-derive the pointer for clarity
+    node = &_nodes[nodeIndex];
+    node->childOffset = _childCount;
+    node->childCount = childCount;
+    node->subtreeEnd = _nodeCount;
+    
+    // every child leads to at least one string, so a node has a sole string only if it has one child
+    // with a sole string and none of its own, or a string of its own and no children
+    if (node->value != CLKPTValueNone) {
+        node->soleValue = (childCount == 0 ? node->value : CLKPTValueNone);
+    } else {
+        node->soleValue = (childCount == 1 ? _nodes[childIndexes[0]].soleValue : CLKPTValueNone);
+    }
+    
+    memcpy((_children + _childCount), childIndexes, (childCount * sizeof(uint32_t)));
+    _childCount += childCount;
+    free(childIndexes);
+    
+    return nodeIndex;
+}
+
+#pragma mark -
+
+- (NSUInteger)nodeCount
+{
+    return _nodeCount;
+}
+
+- (uint32_t)_childOfNode:(uint32_t)nodeIndex withCharacter:(unichar)character
+{
+    const CLKPTNode *node = &_nodes[nodeIndex];
+    const uint32_t *children = (_children + node->childOffset);
+    uint32_t low = 0;
+    uint32_t high = node->childCount;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        unichar midCharacter = _nodes[children[mid]].character;
+        if (midCharacter == character) {
+            return children[mid];
+        } else if (midCharacter < character) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    return CLKPTValueNone;
+}
+
+- (uint32_t)_nodeForPrefix:(NSString *)prefix
+{
+    uint32_t nodeIndex = 0;
+    NSUInteger length = prefix.length;
+    for (NSUInteger i = 0 ; i < length && nodeIndex != CLKPTValueNone ; i++) {
+        nodeIndex = [self _childOfNode:nodeIndex withCharacter:[prefix characterAtIndex:i]];
+    }
+    
+    return nodeIndex;
+}
+
+- (uint32_t)_nodeForPrefixCharacters:(const unichar *)characters length:(NSUInteger)length
+{
+    uint32_t nodeIndex = 0;
+    for (NSUInteger i = 0 ; i < length && nodeIndex != CLKPTValueNone ; i++) {
+        nodeIndex = [self _childOfNode:nodeIndex withCharacter:characters[i]];
+    }
+    
+    return nodeIndex;
+}
+
+- (NSUInteger)indexOfString:(NSString *)string
+{
+    CLKHardParameterAssert(string != nil);
+    
+    uint32_t nodeIndex = [self _nodeForPrefix:string];
+    if (nodeIndex == CLKPTValueNone || _nodes[nodeIndex].value == CLKPTValueNone) {
+        return NSNotFound;
+    }
+    
+    return _nodes[nodeIndex].value;
+}
+
+- (NSUInteger)indexOfStringWithUniquePrefix:(NSString *)prefix
+{
+    CLKHardParameterAssert(prefix != nil);
+    
+    uint32_t nodeIndex = [self _nodeForPrefix:prefix];
+    if (nodeIndex == CLKPTValueNone || _nodes[nodeIndex].soleValue == CLKPTValueNone) {
+        return NSNotFound;
+    }
+    
+    return _nodes[nodeIndex].soleValue;
+}
+
+- (NSUInteger)indexOfStringWithUniquePrefixCharacters:(const unichar *)characters length:(NSUInteger)length
+{
+    NSParameterAssert(characters != NULL || length == 0);
+    
+    uint32_t nodeIndex = [self _nodeForPrefixCharacters:characters length:length];
+    if (nodeIndex == CLKPTValueNone || _nodes[nodeIndex].soleValue == CLKPTValueNone) {
+        return NSNotFound;
+    }
+    
+    return _nodes[nodeIndex].soleValue;
+}
+
+- (void)enumerateIndexesOfStringsWithPrefix:(NSString *)prefix usingBlock:(NS_NOESCAPE void (^)(NSUInteger, BOOL *))block
+{
+    CLKHardParameterAssert(prefix != nil);
+    CLKHardParameterAssert(block != nil);
+    
+    uint32_t nodeIndex = [self _nodeForPrefix:prefix];
+    if (nodeIndex == CLKPTValueNone) {
+        return;
+    }
+    
+    BOOL stop = NO;
+    for (uint32_t i = nodeIndex ; i < _nodes[nodeIndex].subtreeEnd && !stop ; i++) {
+        if (_nodes[i].value != CLKPTValueNone) {
+            block(_nodes[i].value, &stop);
+        }
+    }
+}
+
+@end
@@ -0,0 +1,51 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class CLKVerbDescriptor;
+@class CLKVerbFamily;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// a verb tree's compiled schemas in one binary blob: each verb's flag and name lookup tables and
+// constraint program, and the tables that map verb and family names to verbs.
+//
+// archives are meant to be written at build time and loaded when the program starts. loading only
+// checks the archive's header, so it costs the same however many verbs and options the archive
+// holds. a depot created with an archive finds the dispatched verb through the archive's tables
+// and uses the archived tables as the verb's schema instead of compiling its options, and skips
+// the checks the archive's verbs passed when it was written.
+//
+// the verbs themselves are still created when they are dispatched: options carry transformers,
+// which can't be archived. archived tables are only used for a verb whose options and constraints
+// are the ones it was archived with; verbs that have changed since are compiled as usual, as are
+// verbs and families missing from the archive. a stale archive is slower, not wrong.
+//
+// the format is position-independent (every reference is an offset from the start of the archive)
+// and versioned. archives are only readable by builds with the same byte order and word size as the
+// one that wrote them. archives are immutable and safe to share across threads.
+@interface CLKSchemaArchive : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
+// creates every verb in the tree and compiles its schema. raises under the same conditions as
+// -[CLKVerbDepot initWithArgumentVector:verbDescriptors:verbFamilies:].
++ (NSData *)archiveDataWithVerbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors verbFamilies:(nullable NSArray<CLKVerbFamily *> *)verbFamilies;
+
+// maps the file into memory rather than reading it. answers nil and an error if the file can't be
+// mapped or isn't an archive this build can read (CLKErrorInvalidSchemaArchive).
++ (nullable instancetype)archiveWithContentsOfFile:(NSString *)path error:(NSError **)outError;
+
+// reads the archive in place. `data` is copied only if its bytes aren't suitably aligned.
++ (nullable instancetype)archiveWithData:(NSData *)data error:(NSError **)outError;
+
+// every verb and family in the tree, including the verbs of families and subfamilies
+@property (readonly) NSUInteger verbCount;
+@property (readonly) NSUInteger verbFamilyCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
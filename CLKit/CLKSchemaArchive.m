@@ -0,0 +1,722 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKSchemaArchive_Private.h"
+
+#import <fcntl.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
+#import "CLKArgumentManifestConstraint.h"
+#import "CLKAssert.h"
+#import "CLKBitset.h"
+#import "CLKConstraintProgram.h"
+#import "CLKError.h"
+#import "CLKMappedImage.h"
+#import "CLKOption.h"
+#import "CLKOptionRegistry.h"
+#import "CLKOptionSchema_Private.h"
+#import "CLKVerbDepot.h"
+#import "CLKVerbDescriptor.h"
+#import "CLKVerbFamily_Private.h"
+#import "NSError+CLKAdditions.h"
+
+// an archive is a header followed by sections, each aligned to CLKSchemaArchiveAlignment. sections
+// are referred to by their offset from the start of the archive. there is one verb record per verb
+// (a verb in several places gets several records) holding its registry tables and constraint program,
+// and one dispatch table for the top level and each family, with entries sorted by name. a verb that
+// inherits options from its families is recorded with them folded into its own tables.
+
+#define CLKSchemaArchiveVersion 1U
+#define CLKSchemaArchiveByteOrderMark 0x01020304U
+#define CLKSchemaArchiveAlignment CLKMappedImageAlignment
+
+static const uint8_t CLKSchemaArchiveMagic[4] = { 'C', 'L', 'K', 'S' };
+
+typedef struct {
+    uint64_t entriesOffset;
+    uint32_t entryCount;
+    uint32_t reserved;
+} CLKSchemaArchiveTable;
+
+typedef struct {
+    uint8_t magic[4];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint32_t wordSize; // sizeof(NSUInteger)
+    uint32_t instructionSize; // sizeof(CLKConstraintInstruction)
+    uint32_t flagTableLength;
+    uint64_t length;
+    uint32_t verbCount;
+    uint32_t familyCount;
+    CLKSchemaArchiveTable topLevelTable;
+    uint64_t familyTablesOffset; // familyCount tables
+    uint64_t verbRecordsOffset; // verbCount records
+    uint64_t stringsOffset;
+    uint64_t stringsLength; // UTF-16 code units
+} CLKSchemaArchiveHeader;
+
+typedef struct {
+    uint64_t fingerprint; // see CLKSchemaArchiveFingerprint()
+    uint32_t optionCount;
+    uint32_t constraintCount; // before deduplication
+    uint32_t instructionCount;
+    uint32_t nonASCIIFlagCount;
+    uint64_t nameCharacterCount;
+    uint64_t bandStorageWordCount;
+    uint64_t flagTableOffset;
+    uint64_t nonASCIIFlagsOffset;
+    uint64_t nameDisplacementsOffset;
+    uint64_t nameSlotsOffset;
+    uint64_t nameOffsetsOffset;
+    uint64_t nameCharactersOffset;
+    uint64_t instructionsOffset;
+    uint64_t constraintIndexesOffset; // instruction -> constraint, uint32_t
+    uint64_t bandsOffset;
+} CLKSchemaArchiveVerbRecord;
+
+#pragma mark -
+#pragma mark Fingerprints
+
+// FNV-1a, 64-bit
+#define CLKSchemaArchiveFingerprintBasis 0xcbf29ce484222325ULL
+
+static inline uint64_t CLKSchemaArchiveHashBytes(uint64_t h, const void *bytes, size_t length)
+{
+    const uint8_t *cursor = (const uint8_t *)bytes;
+    for (size_t i = 0 ; i < length ; i++) {
+        h ^= cursor[i];
+        h *= 0x100000001b3ULL;
+    }
+    
+    return h;
+}
+
+static inline uint64_t CLKSchemaArchiveHashInteger(uint64_t h, uint64_t value)
+{
+    return CLKSchemaArchiveHashBytes(h, &value, sizeof(value));
+}
+
+static uint64_t CLKSchemaArchiveHashString(uint64_t h, NSString * _Nullable string)
+{
+    if (string == nil) {
+        return CLKSchemaArchiveHashInteger(h, UINT64_MAX);
+    }
+    
+    NSUInteger length = string.length;
+    h = CLKSchemaArchiveHashInteger(h, length);
+    
+    unichar buffer[64];
+    for (NSUInteger location = 0 ; location < length ; location += 64) {
+        NSRange range = NSMakeRange(location, MIN(64UL, (length - location)));
+        [string getCharacters:buffer range:range];
+        h = CLKSchemaArchiveHashBytes(h, buffer, (range.length * sizeof(unichar)));
+    }
+    
+    return h;
+}
+
+// covers everything the registry tables and constraint program are compiled from, so a verb whose
+// options have changed since it was archived doesn't match its record
+static uint64_t CLKSchemaArchiveFingerprint(NSArray<CLKOption *> *options, NSArray<CLKArgumentManifestConstraint *> *constraints)
+{
+    uint64_t h = CLKSchemaArchiveHashInteger(CLKSchemaArchiveFingerprintBasis, options.count);
+    for (CLKOption *option in options) {
+        h = CLKSchemaArchiveHashInteger(h, option.type);
+        h = CLKSchemaArchiveHashInteger(h, ((uint64_t)option.required | ((uint64_t)option.recurrent << 1) | ((uint64_t)option.standalone << 2)));
+        h = CLKSchemaArchiveHashString(h, option.name);
+        h = CLKSchemaArchiveHashString(h, option.flag);
+    }
+    
+    h = CLKSchemaArchiveHashInteger(h, constraints.count);
+    for (CLKArgumentManifestConstraint *constraint in constraints) {
+        h = CLKSchemaArchiveHashInteger(h, constraint.type);
+        h = CLKSchemaArchiveHashString(h, constraint.significantOption);
+        h = CLKSchemaArchiveHashString(h, constraint.predicatingOption);
+        h = CLKSchemaArchiveHashInteger(h, constraint.bandedOptions.count);
+        for (NSString *optionName in constraint.bandedOptions) {
+            h = CLKSchemaArchiveHashString(h, optionName);
+        }
+    }
+    
+    return h;
+}
+
+#pragma mark -
+#pragma mark Names
+
+// dispatch tables are sorted by UTF-16 code unit, which is not necessarily -compare:'s order
+static NSComparisonResult CLKSchemaArchiveCompareNames(NSString *lhs, NSString *rhs)
+{
+    NSUInteger lhsLength = lhs.length;
+    NSUInteger rhsLength = rhs.length;
+    unichar *lhsCharacters = malloc(MAX(lhsLength, 1UL) * sizeof(unichar));
+    unichar *rhsCharacters = malloc(MAX(rhsLength, 1UL) * sizeof(unichar));
+    [lhs getCharacters:lhsCharacters range:NSMakeRange(0, lhsLength)];
+    [rhs getCharacters:rhsCharacters range:NSMakeRange(0, rhsLength)];
+    int result = CLKMappedImageCompareCharacters(lhsCharacters, lhsLength, rhsCharacters, rhsLength);
+    free(lhsCharacters);
+    free(rhsCharacters);
+    return (NSComparisonResult)result;
+}
+
+#pragma mark -
+#pragma mark Writing
+
+NS_ASSUME_NONNULL_BEGIN
+
+// accumulates an archive's sections
+@interface CLKSchemaArchiveWriter : NSObject
+
+- (uint64_t)appendSection:(const void *)bytes length:(size_t)length;
+- (uint64_t)appendVerbRecordForDescriptor:(CLKVerbDescriptor *)descriptor family:(nullable CLKVerbFamily *)family;
+- (uint64_t)appendString:(NSString *)string length:(uint32_t *)outLength;
+- (CLKSchemaArchiveTable)appendTableWithNames:(NSArray<NSString *> *)names kinds:(NSArray<NSNumber *> *)kinds indexes:(NSArray<NSNumber *> *)indexes targets:(NSArray<NSNumber *> *)targets;
+
+// appends the records of the family's verbs and the dispatch tables of the family and its subfamilies,
+// and answers the index of the family's table
+- (uint32_t)appendFamily:(CLKVerbFamily *)family;
+
+- (NSData *)finishWithTopLevelTable:(CLKSchemaArchiveTable)topLevelTable;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation CLKSchemaArchiveWriter
+{
+    NSMutableData *_data;
+    NSMutableData *_records;
+    NSMutableData *_strings;
+    NSMutableData *_familyTables;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self != nil) {
+        _data = [[NSMutableData alloc] initWithLength:sizeof(CLKSchemaArchiveHeader)];
+        _records = [[NSMutableData alloc] init];
+        _strings = [[NSMutableData alloc] init];
+        _familyTables = [[NSMutableData alloc] init];
+    }
+    
+    return self;
+}
+
+- (uint64_t)appendSection:(const void *)bytes length:(size_t)length
+{
+    NSUInteger padding = ((CLKSchemaArchiveAlignment - (_data.length % CLKSchemaArchiveAlignment)) % CLKSchemaArchiveAlignment);
+    [_data increaseLengthBy:padding];
+    uint64_t offset = _data.length;
+    [_data appendBytes:bytes length:length];
+    return offset;
+}
+
+- (uint64_t)appendVerbRecordForDescriptor:(CLKVerbDescriptor *)descriptor family:(CLKVerbFamily *)family
+{
+    CLKOptionSchema *schema = (family != nil ? [family _schemaForVerbDescriptor:descriptor archive:nil verbRecord:0] : descriptor.schema);
+    CLKOptionRegistry *registry = schema.optionRegistry;
+    CLKConstraintProgram *program = schema.constraintProgram;
+    
+    // a registry that inherits options only has tables for its own. inherited options come first in
+    // either registry, so the program's option indexes hold for the flattened tables too.
+    if (registry.parentRegistry != nil) {
+        registry = [CLKOptionRegistry registryWithOptions:schema.options];
+    }
+    
+    CLKOptionRegistryTables tables = registry.tables;
+    NSUInteger optionCount = schema.options.count;
+    
+    // the program deduplicates its constraints. record which of the schema's constraints each
+    // instruction came from, so the loaded program reports the same constraints.
+    NSArray<CLKArgumentManifestConstraint *> *constraints = [CLKOptionSchema _constraintsForOptions:schema.options optionGroups:schema.optionGroups];
+    NSUInteger instructionCount = program.instructionCount;
+    uint32_t *constraintIndexes = malloc(MAX(instructionCount, 1UL) * sizeof(uint32_t));
+    for (NSUInteger i = 0 ; i < instructionCount ; i++) {
+        NSUInteger constraintIndex = [constraints indexOfObject:[program constraintAtIndex:i]];
+        CLKHardAssert((constraintIndex != NSNotFound), NSInternalInconsistencyException, @"constraint program for verb '%@' doesn't match its options", descriptor.name);
+        constraintIndexes[i] = (uint32_t)constraintIndex;
+    }
+    
+    CLKSchemaArchiveVerbRecord record = {
+        .fingerprint = CLKSchemaArchiveFingerprint(schema.options, constraints),
+        .optionCount = (uint32_t)optionCount,
+        .constraintCount = (uint32_t)constraints.count,
+        .instructionCount = (uint32_t)instructionCount,
+        .nonASCIIFlagCount = (uint32_t)tables.nonASCIIFlagCount,
+        .nameCharacterCount = tables.nameOffsets[optionCount],
+        .bandStorageWordCount = program.bandStorageWordCount
+    };
+    
+    record.flagTableOffset = [self appendSection:tables.flagTable length:(CLKOptionFlagTableLength * sizeof(uint32_t))];
+    record.nonASCIIFlagsOffset = [self appendSection:tables.nonASCIIFlags length:(tables.nonASCIIFlagCount * sizeof(uint64_t))];
+    record.nameDisplacementsOffset = [self appendSection:tables.nameDisplacements length:(optionCount * sizeof(int32_t))];
+    record.nameSlotsOffset = [self appendSection:tables.nameSlots length:(optionCount * sizeof(uint32_t))];
+    record.nameOffsetsOffset = [self appendSection:tables.nameOffsets length:((optionCount + 1) * sizeof(NSUInteger))];
+    record.nameCharactersOffset = [self appendSection:tables.nameCharacters length:(record.nameCharacterCount * sizeof(unichar))];
+    record.instructionsOffset = [self appendSection:program.instructions length:(instructionCount * sizeof(CLKConstraintInstruction))];
+    record.constraintIndexesOffset = [self appendSection:constraintIndexes length:(instructionCount * sizeof(uint32_t))];
+    record.bandsOffset = [self appendSection:program.bands length:(program.bandStorageWordCount * sizeof(uint64_t))];
+    free(constraintIndexes);
+    
+    uint64_t recordIndex = (_records.length / sizeof(CLKSchemaArchiveVerbRecord));
+    [_records appendBytes:&record length:sizeof(record)];
+    return recordIndex;
+}
+
+- (uint64_t)appendString:(NSString *)string length:(uint32_t *)outLength
+{
+    NSUInteger length = string.length;
+    uint64_t offset = (_strings.length / sizeof(unichar));
+    [_strings increaseLengthBy:(length * sizeof(unichar))];
+    [string getCharacters:((unichar *)_strings.mutableBytes + offset) range:NSMakeRange(0, length)];
+    *outLength = (uint32_t)length;
+    return offset;
+}
+
+- (CLKSchemaArchiveTable)appendTableWithNames:(NSArray<NSString *> *)names kinds:(NSArray<NSNumber *> *)kinds indexes:(NSArray<NSNumber *> *)indexes targets:(NSArray<NSNumber *> *)targets
+{
+    NSMutableArray<NSNumber *> *order = [[NSMutableArray alloc] initWithCapacity:names.count];
+    for (NSUInteger i = 0 ; i < names.count ; i++) {
+        [order addObject:@(i)];
+    }
+    
+    [order sortUsingComparator:^(NSNumber *lhs, NSNumber *rhs) {
+        return CLKSchemaArchiveCompareNames(names[lhs.unsignedIntegerValue], names[rhs.unsignedIntegerValue]);
+    }];
+    
+    CLKSchemaArchiveEntry *entries = calloc(MAX(names.count, 1UL), sizeof(CLKSchemaArchiveEntry));
+    for (NSUInteger i = 0 ; i < order.count ; i++) {
+        NSUInteger idx = order[i].unsignedIntegerValue;
+        CLKSchemaArchiveEntry *entry = &entries[i];
+        entry->nameOffset = [self appendString:names[idx] length:&entry->nameLength];
+        entry->kind = kinds[idx].unsignedIntValue;
+        entry->index = indexes[idx].unsignedIntValue;
+        entry->target = targets[idx].unsignedIntValue;
+    }
+    
+    CLKSchemaArchiveTable table = {
+        .entriesOffset = [self appendSection:entries length:(names.count * sizeof(CLKSchemaArchiveEntry))],
+        .entryCount = (uint32_t)names.count
+    };
+    
+    free(entries);
+    return table;
+}
+
+- (uint32_t)appendFamily:(CLKVerbFamily *)family
+{
+    NSMutableArray<NSString *> *names = [[NSMutableArray alloc] init];
+    NSMutableArray<NSNumber *> *kinds = [[NSMutableArray alloc] init];
+    NSMutableArray<NSNumber *> *indexes = [[NSMutableArray alloc] init];
+    NSMutableArray<NSNumber *> *targets = [[NSMutableArray alloc] init];
+    [family.verbDescriptors enumerateObjectsUsingBlock:^(CLKVerbDescriptor *descriptor, NSUInteger idx, __unused BOOL *outStop) {
+        [names addObject:descriptor.name];
+        [kinds addObject:@(CLKSchemaArchiveEntryKindVerb)];
+        [indexes addObject:@(idx)];
+        [targets addObject:@([self appendVerbRecordForDescriptor:descriptor family:family])];
+    }];
+    
+    // subfamilies' tables come before their family's, so the family's entries can refer to them
+    [family.subfamilies enumerateObjectsUsingBlock:^(CLKVerbFamily *subfamily, NSUInteger idx, __unused BOOL *outStop) {
+        [names addObject:subfamily.name];
+        [kinds addObject:@(CLKSchemaArchiveEntryKindFamily)];
+        [indexes addObject:@(idx)];
+        [targets addObject:@([self appendFamily:subfamily])];
+    }];
+    
+    CLKSchemaArchiveTable table = [self appendTableWithNames:names kinds:kinds indexes:indexes targets:targets];
+    uint32_t tableIndex = (uint32_t)(_familyTables.length / sizeof(CLKSchemaArchiveTable));
+    [_familyTables appendBytes:&table length:sizeof(table)];
+    return tableIndex;
+}
+
+- (NSData *)finishWithTopLevelTable:(CLKSchemaArchiveTable)topLevelTable
+{
+    CLKSchemaArchiveHeader header = {
+        .version = CLKSchemaArchiveVersion,
+        .byteOrderMark = CLKSchemaArchiveByteOrderMark,
+        .wordSize = sizeof(NSUInteger),
+        .instructionSize = sizeof(CLKConstraintInstruction),
+        .flagTableLength = CLKOptionFlagTableLength,
+        .verbCount = (uint32_t)(_records.length / sizeof(CLKSchemaArchiveVerbRecord)),
+        .familyCount = (uint32_t)(_familyTables.length / sizeof(CLKSchemaArchiveTable)),
+        .topLevelTable = topLevelTable
+    };
+    
+    memcpy(header.magic, CLKSchemaArchiveMagic, sizeof(header.magic));
+    header.familyTablesOffset = [self appendSection:_familyTables.bytes length:_familyTables.length];
+    header.verbRecordsOffset = [self appendSection:_records.bytes length:_records.length];
+    header.stringsOffset = [self appendSection:_strings.bytes length:_strings.length];
+    header.stringsLength = (_strings.length / sizeof(unichar));
+    header.length = _data.length;
+    [_data replaceBytesInRange:NSMakeRange(0, sizeof(header)) withBytes:&header];
+    return _data;
+}
+
+@end
+
+#pragma mark -
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKSchemaArchive ()
+
+- (instancetype)_initWithData:(NSData *)data NS_DESIGNATED_INITIALIZER;
+
++ (nullable NSError *)_errorForInvalidHeaderOfData:(NSData *)data;
+- (BOOL)_isValidVerbRecord:(const CLKSchemaArchiveVerbRecord *)record;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation CLKSchemaArchive
+{
+    NSData *_data; // the mapped file or a copy of the data, either way the storage every schema uses
+    const uint8_t *_bytes;
+    const CLKSchemaArchiveHeader *_header;
+    const CLKSchemaArchiveTable *_familyTables;
+    const CLKSchemaArchiveVerbRecord *_verbRecords;
+    const unichar *_strings;
+}
+
++ (NSData *)archiveDataWithVerbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors verbFamilies:(NSArray<CLKVerbFamily *> *)verbFamilies
+{
+    // a depot makes the same checks of verb and family names as loading the archive would have skipped
+    (void)[[CLKVerbDepot alloc] initWithArgumentVector:@[] verbDescriptors:verbDescriptors verbFamilies:verbFamilies];
+    
+    CLKSchemaArchiveWriter *writer = [[CLKSchemaArchiveWriter alloc] init];
+    
+    NSMutableArray<NSString *> *names = [[NSMutableArray alloc] init];
+    NSMutableArray<NSNumber *> *kinds = [[NSMutableArray alloc] init];
+    NSMutableArray<NSNumber *> *indexes = [[NSMutableArray alloc] init];
+    NSMutableArray<NSNumber *> *targets = [[NSMutableArray alloc] init];
+    [verbDescriptors enumerateObjectsUsingBlock:^(CLKVerbDescriptor *descriptor, NSUInteger idx, __unused BOOL *outStop) {
+        [names addObject:descriptor.name];
+        [kinds addObject:@(CLKSchemaArchiveEntryKindVerb)];
+        [indexes addObject:@(idx)];
+        [targets addObject:@([writer appendVerbRecordForDescriptor:descriptor family:nil])];
+    }];
+    
+    [verbFamilies enumerateObjectsUsingBlock:^(CLKVerbFamily *family, NSUInteger familyIndex, __unused BOOL *outStop) {
+        [names addObject:family.name];
+        [kinds addObject:@(CLKSchemaArchiveEntryKindFamily)];
+        [indexes addObject:@(familyIndex)];
+        [targets addObject:@([writer appendFamily:family])];
+    }];
+    
+    CLKSchemaArchiveTable topLevelTable = [writer appendTableWithNames:names kinds:kinds indexes:indexes targets:targets];
+    return [writer finishWithTopLevelTable:topLevelTable];
+}
+
++ (instancetype)archiveWithContentsOfFile:(NSString *)path error:(NSError **)outError
+{
+    CLKHardParameterAssert(path != nil);
+    
+    int fd = open(path.fileSystemRepresentation, (O_RDONLY | O_CLOEXEC));
+    if (fd < 0) {
+        if (outError != nil) {
+            *outError = [NSError clk_POSIXErrorWithCode:errno description:@"%@: %s", path, strerror(errno)];
+        }
+        
+        return nil;
+    }
+    
+    struct stat info;
+    void *bytes = MAP_FAILED;
+    if (fstat(fd, &info) == 0) {
+        // an empty file can't be mapped, but an empty mapping would be rejected anyway
+        bytes = (info.st_size > 0 ? mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL);
+    }
+    
+    int code = errno;
+    close(fd);
+    if (bytes == MAP_FAILED) {
+        if (outError != nil) {
+            *outError = [NSError clk_POSIXErrorWithCode:code description:@"%@: %s", path, strerror(code)];
+        }
+        
+        return nil;
+    }
+    
+    size_t length = (size_t)info.st_size;
+    NSData *data;
+    if (bytes == NULL) {
+        data = [NSData data];
+    } else {
+        data = [[NSData alloc] initWithBytesNoCopy:bytes length:length deallocator:^(void *mappedBytes, NSUInteger mappedLength) {
+            munmap(mappedBytes, mappedLength);
+        }];
+    }
+    
+    return [self archiveWithData:data error:outError];
+}
+
++ (instancetype)archiveWithData:(NSData *)data error:(NSError **)outError
+{
+    CLKHardParameterAssert(data != nil);
+    
+    if ((((uintptr_t)data.bytes) % CLKSchemaArchiveAlignment) != 0) {
+        data = [[NSData alloc] initWithBytes:data.bytes length:data.length];
+    }
+    
+    NSError *error = [self _errorForInvalidHeaderOfData:data];
+    if (error != nil) {
+        if (outError != nil) {
+            *outError = error;
+        }
+        
+        return nil;
+    }
+    
+    return [[self alloc] _initWithData:data];
+}
+
++ (NSError *)_errorForInvalidHeaderOfData:(NSData *)data
+{
+    NSUInteger length = data.length;
+    if (length < sizeof(CLKSchemaArchiveHeader)) {
+        return [NSError clk_CLKErrorWithCode:CLKErrorInvalidSchemaArchive description:@"Schema archive is truncated."];
+    }
+    
+    const CLKSchemaArchiveHeader *header = data.bytes;
+    if (memcmp(header->magic, CLKSchemaArchiveMagic, sizeof(header->magic)) != 0) {
+        return [NSError clk_CLKErrorWithCode:CLKErrorInvalidSchemaArchive description:@"Not a schema archive."];
+    }
+    
+    if (header->version != CLKSchemaArchiveVersion) {
+        return [NSError clk_CLKErrorWithCode:CLKErrorInvalidSchemaArchive description:@"Unsupported schema archive version %u.", header->version];
+    }
+    
+    if (header->byteOrderMark != CLKSchemaArchiveByteOrderMark
+        || header->wordSize != sizeof(NSUInteger)
+        || header->instructionSize != sizeof(CLKConstraintInstruction)
+        || header->flagTableLength != CLKOptionFlagTableLength)
+    {
+        return [NSError clk_CLKErrorWithCode:CLKErrorInvalidSchemaArchive description:@"Schema archive was written for a different architecture."];
+    }
+    
+    if (header->length != length
+        || !CLKMappedImageSectionIsValid(header->topLevelTable.entriesOffset, header->topLevelTable.entryCount, sizeof(CLKSchemaArchiveEntry), length)
+        || !CLKMappedImageSectionIsValid(header->familyTablesOffset, header->familyCount, sizeof(CLKSchemaArchiveTable), length)
+        || !CLKMappedImageSectionIsValid(header->verbRecordsOffset, header->verbCount, sizeof(CLKSchemaArchiveVerbRecord), length)
+        || !CLKMappedImageSectionIsValid(header->stringsOffset, header->stringsLength, sizeof(unichar), length))
+    {
+        return [NSError clk_CLKErrorWithCode:CLKErrorInvalidSchemaArchive description:@"Schema archive is truncated."];
+    }
+    
+    return nil;
+}
+
+- (instancetype)_initWithData:(NSData *)data
+{
+    CLKHardParameterAssert(data != nil);
+    
+    self = [super init];
+    if (self != nil) {
+        _data = data;
+        _bytes = data.bytes;
+        _header = (const CLKSchemaArchiveHeader *)_bytes;
+        _familyTables = (const CLKSchemaArchiveTable *)(_bytes + _header->familyTablesOffset);
+        _verbRecords = (const CLKSchemaArchiveVerbRecord *)(_bytes + _header->verbRecordsOffset);
+        _strings = (const unichar *)(_bytes + _header->stringsOffset);
+    }
+    
+    return self;
+}
+
+- (NSUInteger)verbCount
+{
+    return _header->verbCount;
+}
+
+- (NSUInteger)verbFamilyCount
+{
+    return _header->familyCount;
+}
+
+#pragma mark -
+#pragma mark Dispatch Tables
+
+- (const CLKSchemaArchiveEntry *)_entryForName:(NSString *)name inTable:(uint32_t)tableIndex
+{
+    NSParameterAssert(name != nil);
+    
+    const CLKSchemaArchiveTable *table;
+    if (tableIndex == CLKSchemaArchiveTopLevelTable) {
+        table = &_header->topLevelTable;
+    } else {
+        CLKHardParameterAssert(tableIndex < _header->familyCount);
+        table = &_familyTables[tableIndex];
+        if (!CLKMappedImageSectionIsValid(table->entriesOffset, table->entryCount, sizeof(CLKSchemaArchiveEntry), _header->length)) {
+            return NULL;
+        }
+    }
+    
+    NSUInteger length = name.length;
+    unichar stackBuffer[64];
+    unichar *characters = (length > 64 ? malloc(length * sizeof(unichar)) : stackBuffer);
+    [name getCharacters:characters range:NSMakeRange(0, length)];
+    
+    const CLKSchemaArchiveEntry *entries = (const CLKSchemaArchiveEntry *)(_bytes + table->entriesOffset);
+    const CLKSchemaArchiveEntry *match = NULL;
+    NSUInteger low = 0;
+    NSUInteger high = table->entryCount;
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        const CLKSchemaArchiveEntry *entry = &entries[mid];
+        if (entry->nameOffset > _header->stringsLength || entry->nameLength > (_header->stringsLength - entry->nameOffset)) {
+            break;
+        }
+        
+        int result = CLKMappedImageCompareCharacters((_strings + entry->nameOffset), entry->nameLength, characters, length);
+        if (result == 0) {
+            match = entry;
+            break;
+        } else if (result < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    if (characters != stackBuffer) {
+        free(characters);
+    }
+    
+    if (match == NULL) {
+        return NULL;
+    }
+    
+    BOOL valid = ((match->kind == CLKSchemaArchiveEntryKindVerb && match->target < _header->verbCount)
+        || (match->kind == CLKSchemaArchiveEntryKindFamily && match->target < _header->familyCount));
+    
+    return (valid ? match : NULL);
+}
+
+#pragma mark -
+#pragma mark Schemas
+
+- (CLKOptionSchema *)_schemaForVerbRecord:(uint32_t)recordIndex options:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)groups
+{
+    CLKHardParameterAssert(options != nil);
+    
+    if (recordIndex >= _header->verbCount) {
+        return nil;
+    }
+    
+    const CLKSchemaArchiveVerbRecord *record = &_verbRecords[recordIndex];
+    NSArray<CLKArgumentManifestConstraint *> *constraints = [CLKOptionSchema _constraintsForOptions:options optionGroups:groups];
+    if (record->optionCount != options.count
+        || record->constraintCount != constraints.count
+        || record->fingerprint != CLKSchemaArchiveFingerprint(options, constraints)
+        || ![self _isValidVerbRecord:record])
+    {
+        return nil;
+    }
+    
+    CLKOptionRegistryTables tables = {
+        .flagTable = (const uint32_t *)(_bytes + record->flagTableOffset),
+        .nonASCIIFlags = (const uint64_t *)(_bytes + record->nonASCIIFlagsOffset),
+        .nonASCIIFlagCount = record->nonASCIIFlagCount,
+        .nameDisplacements = (const int32_t *)(_bytes + record->nameDisplacementsOffset),
+        .nameSlots = (const uint32_t *)(_bytes + record->nameSlotsOffset),
+        .nameOffsets = (const NSUInteger *)(_bytes + record->nameOffsetsOffset),
+        .nameCharacters = (const unichar *)(_bytes + record->nameCharactersOffset)
+    };
+    
+    CLKOptionRegistry *registry = [[CLKOptionRegistry alloc] initWithOptions:options tables:tables tablesOwner:self];
+    CLKConstraintProgram *program = [CLKConstraintProgram programWithConstraints:constraints
+                                                                    instructions:(const CLKConstraintInstruction *)(_bytes + record->instructionsOffset)
+                                                               constraintIndexes:(const uint32_t *)(_bytes + record->constraintIndexesOffset)
+                                                                instructionCount:record->instructionCount
+                                                                           bands:(const uint64_t *)(_bytes + record->bandsOffset)
+                                                                  optionRegistry:registry
+                                                                     tablesOwner:self];
+    
+    return [[CLKOptionSchema alloc] _initWithOptions:options optionGroups:groups optionRegistry:registry constraintProgram:program];
+}
+
+// a record whose fingerprint matches was almost certainly written for the verb, but the tables are
+// read without further checks, so make sure a damaged archive can't send a lookup out of bounds.
+// this is linear in the size of the verb's schema, and only done for the verbs that are dispatched.
+- (BOOL)_isValidVerbRecord:(const CLKSchemaArchiveVerbRecord *)record
+{
+    uint64_t length = _header->length;
+    uint32_t optionCount = record->optionCount;
+    if (!CLKMappedImageSectionIsValid(record->flagTableOffset, CLKOptionFlagTableLength, sizeof(uint32_t), length)
+        || !CLKMappedImageSectionIsValid(record->nonASCIIFlagsOffset, record->nonASCIIFlagCount, sizeof(uint64_t), length)
+        || !CLKMappedImageSectionIsValid(record->nameDisplacementsOffset, optionCount, sizeof(int32_t), length)
+        || !CLKMappedImageSectionIsValid(record->nameSlotsOffset, optionCount, sizeof(uint32_t), length)
+        || !CLKMappedImageSectionIsValid(record->nameOffsetsOffset, ((uint64_t)optionCount + 1), sizeof(NSUInteger), length)
+        || !CLKMappedImageSectionIsValid(record->nameCharactersOffset, record->nameCharacterCount, sizeof(unichar), length)
+        || !CLKMappedImageSectionIsValid(record->instructionsOffset, record->instructionCount, sizeof(CLKConstraintInstruction), length)
+        || !CLKMappedImageSectionIsValid(record->constraintIndexesOffset, record->instructionCount, sizeof(uint32_t), length)
+        || !CLKMappedImageSectionIsValid(record->bandsOffset, record->bandStorageWordCount, sizeof(uint64_t), length))
+    {
+        return NO;
+    }
+    
+    const uint32_t *flagTable = (const uint32_t *)(_bytes + record->flagTableOffset);
+    for (NSUInteger i = 0 ; i < CLKOptionFlagTableLength ; i++) {
+        if (flagTable[i] != CLKOptionIndexNone && flagTable[i] >= optionCount) {
+            return NO;
+        }
+    }
+    
+    const uint64_t *nonASCIIFlags = (const uint64_t *)(_bytes + record->nonASCIIFlagsOffset);
+    for (NSUInteger i = 0 ; i < record->nonASCIIFlagCount ; i++) {
+        if ((uint32_t)nonASCIIFlags[i] >= optionCount || (i > 0 && (nonASCIIFlags[i] >> 32) <= (nonASCIIFlags[i - 1] >> 32))) {
+            return NO;
+        }
+    }
+    
+    const int32_t *displacements = (const int32_t *)(_bytes + record->nameDisplacementsOffset);
+    const uint32_t *slots = (const uint32_t *)(_bytes + record->nameSlotsOffset);
+    for (NSUInteger i = 0 ; i < optionCount ; i++) {
+        if ((displacements[i] < 0 && (-(int64_t)displacements[i] - 1) >= optionCount) || slots[i] >= optionCount) {
+            return NO;
+        }
+    }
+    
+    const NSUInteger *nameOffsets = (const NSUInteger *)(_bytes + record->nameOffsetsOffset);
+    for (NSUInteger i = 0 ; i < optionCount ; i++) {
+        if (nameOffsets[i] > nameOffsets[i + 1]) {
+            return NO;
+        }
+    }
+    
+    if (nameOffsets[0] != 0 || nameOffsets[optionCount] != record->nameCharacterCount) {
+        return NO;
+    }
+    
+    NSUInteger bitsetWordCount = CLKBitsetWordCount(optionCount);
+    const CLKConstraintInstruction *instructions = (const CLKConstraintInstruction *)(_bytes + record->instructionsOffset);
+    const uint32_t *constraintIndexes = (const uint32_t *)(_bytes + record->constraintIndexesOffset);
+    for (NSUInteger i = 0 ; i < record->instructionCount ; i++) {
+        const CLKConstraintInstruction *instruction = &instructions[i];
+        if (instruction->type > CLKConstraintTypeOccurrencesLimited
+            || (instruction->significantOption != CLKConstraintOptionNone && instruction->significantOption >= optionCount)
+            || (instruction->predicatingOption != CLKConstraintOptionNone && instruction->predicatingOption >= optionCount)
+            || constraintIndexes[i] >= record->constraintCount)
+        {
+            return NO;
+        }
+        
+        BOOL banded = (instruction->type == CLKConstraintTypeAnyRequired
+            || instruction->type == CLKConstraintTypeMutuallyExclusive
+            || instruction->type == CLKConstraintTypeStandalone);
+        
+        if (banded && (instruction->bandOffset > record->bandStorageWordCount || bitsetWordCount > (record->bandStorageWordCount - instruction->bandOffset))) {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+@end
@@ -0,0 +1,46 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKSchemaArchive.h"
+
+@class CLKOption;
+@class CLKOptionGroup;
+@class CLKOptionSchema;
+
+typedef NS_ENUM(uint32_t, CLKSchemaArchiveEntryKind) {
+    CLKSchemaArchiveEntryKindVerb = 1,
+    CLKSchemaArchiveEntryKindFamily = 2
+};
+
+// a name in one of an archive's dispatch tables, as stored in the archive
+typedef struct {
+    uint64_t nameOffset; // UTF-16 code units into the archive's strings
+    uint32_t nameLength;
+    CLKSchemaArchiveEntryKind kind;
+    
+    // the verb's position in the top-level verb descriptors or its family's verb descriptors,
+    // or the family's position in the top-level verb families or its superfamily's subfamilies
+    uint32_t index;
+    
+    // the verb's record or the family's dispatch table
+    uint32_t target;
+} CLKSchemaArchiveEntry;
+
+// the table of top-level verbs and families
+#define CLKSchemaArchiveTopLevelTable UINT32_MAX
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKSchemaArchive ()
+
+// answers NULL if the table has no entry for `name`. `table` is CLKSchemaArchiveTopLevelTable or
+// the target of a family entry.
+- (nullable const CLKSchemaArchiveEntry *)_entryForName:(NSString *)name inTable:(uint32_t)table;
+
+// answers nil if the record wasn't written for these options and groups
+- (nullable CLKOptionSchema *)_schemaForVerbRecord:(uint32_t)record options:(NSArray<CLKOption *> *)options optionGroups:(nullable NSArray<CLKOptionGroup *> *)groups;
+
+@end
+
+NS_ASSUME_NONNULL_END
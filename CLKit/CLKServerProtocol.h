@@ -0,0 +1,157 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+// the wire protocol between CLKVerbServer and its client shim. plain C, so the shim doesn't have to
+// load Foundation.
+//
+// every message is a frame: a one-byte type, a four-byte payload length in network byte order and
+// the payload. a request is a Hello frame followed by a WorkingDirectory frame, any number of
+// Argument and Environment frames (in order), and a Run frame. the server answers with any number of
+// Output and ErrorOutput frames followed by one Exit frame, then closes the connection.
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define CLKServerProtocolVersion 1U
+#define CLKServerFrameHeaderLength 5U
+#define CLKServerMaximumFrameLength (16U * 1024U * 1024U)
+
+// the client shim reads the server's socket path from this variable
+#define CLKServerSocketEnvironmentVariable "CLK_SERVER_SOCKET"
+
+typedef uint8_t CLKServerFrameType;
+
+enum {
+    // client to server
+    CLKServerFrameTypeHello = 'H', // payload: the protocol version, four bytes in network byte order
+    CLKServerFrameTypeWorkingDirectory = 'C',
+    CLKServerFrameTypeArgument = 'A',
+    CLKServerFrameTypeEnvironment = 'V', // payload: NAME=value
+    CLKServerFrameTypeRun = 'R', // no payload
+    
+    // server to client
+    CLKServerFrameTypeOutput = 'O',
+    CLKServerFrameTypeErrorOutput = 'E',
+    CLKServerFrameTypeExit = 'X' // payload: the exit status, four bytes in network byte order
+};
+
+// keeps writes to a closed peer from raising SIGPIPE
+static inline void CLKServerConfigureSocket(int fd)
+{
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    (void)setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    (void)fd;
+#endif
+}
+
+// answers 0 on success or -1 with errno set. a peer that closes early reads as ECONNRESET.
+static inline int CLKServerReadFully(int fd, void *buffer, size_t length)
+{
+    uint8_t *cursor = (uint8_t *)buffer;
+    while (length > 0) {
+        ssize_t count = read(fd, cursor, length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        
+        if (count <= 0) {
+            if (count == 0) {
+                errno = ECONNRESET;
+            }
+            
+            return -1;
+        }
+        
+        cursor += count;
+        length -= (size_t)count;
+    }
+    
+    return 0;
+}
+
+static inline int CLKServerWriteFully(int fd, const void *buffer, size_t length)
+{
+#ifdef MSG_NOSIGNAL
+    int flags = MSG_NOSIGNAL;
+#else
+    int flags = 0;
+#endif
+    
+    const uint8_t *cursor = (const uint8_t *)buffer;
+    while (length > 0) {
+        ssize_t count = send(fd, cursor, length, flags);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        
+        if (count < 0) {
+            return -1;
+        }
+        
+        cursor += count;
+        length -= (size_t)count;
+    }
+    
+    return 0;
+}
+
+static inline int CLKServerWriteFrame(int fd, CLKServerFrameType type, const void *payload, uint32_t length)
+{
+    if (length > CLKServerMaximumFrameLength) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    
+    uint8_t header[CLKServerFrameHeaderLength];
+    uint32_t networkLength = htonl(length);
+    header[0] = type;
+    memcpy(header + 1, &networkLength, sizeof(networkLength));
+    if (CLKServerWriteFully(fd, header, sizeof(header)) != 0) {
+        return -1;
+    }
+    
+    return (length > 0 ? CLKServerWriteFully(fd, payload, length) : 0);
+}
+
+static inline int CLKServerWriteIntegerFrame(int fd, CLKServerFrameType type, int32_t value)
+{
+    uint32_t networkValue = htonl((uint32_t)value);
+    return CLKServerWriteFrame(fd, type, &networkValue, sizeof(networkValue));
+}
+
+// frames longer than CLKServerMaximumFrameLength are rejected with EMSGSIZE
+static inline int CLKServerReadFrameHeader(int fd, CLKServerFrameType *outType, uint32_t *outLength)
+{
+    uint8_t header[CLKServerFrameHeaderLength];
+    if (CLKServerReadFully(fd, header, sizeof(header)) != 0) {
+        return -1;
+    }
+    
+    uint32_t networkLength;
+    memcpy(&networkLength, header + 1, sizeof(networkLength));
+    uint32_t length = ntohl(networkLength);
+    if (length > CLKServerMaximumFrameLength) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    
+    *outType = header[0];
+    *outLength = length;
+    return 0;
+}
+
+static inline int32_t CLKServerDecodeInteger(const uint8_t *payload)
+{
+    uint32_t networkValue;
+    memcpy(&networkValue, payload, sizeof(networkValue));
+    return (int32_t)ntohl(networkValue);
+}
@@ -0,0 +1,35 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// the most suggestions offered for one misspelling
+#define CLKSuggestionLimit 3
+
+// an immutable index of names for suggesting corrections to misspelled ones ("did you mean"),
+// safe to share across threads. a name is suggested when its edit distance from the misspelling
+// is the smallest of any name's and at most a third of the misspelling's length, and at most three.
+@interface CLKSuggestionIndex : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
++ (instancetype)indexWithStrings:(NSArray<NSString *> *)strings;
+
+// answers up to CLKSuggestionLimit of the closest strings, those sharing the first character of
+// `string` first and then in the order they were given. answers an empty array if no string is
+// close enough, or if `string` is one of the strings.
+- (NSArray<NSString *> *)suggestionsForString:(NSString *)string;
+
+@end
+
+// the edit distance between two strings, by UTF-16 code unit
+NSUInteger CLKEditDistance(NSString *string, NSString *otherString);
+
+// a list of suggestions for an error description: `'alpha'`, `'alpha' or 'bravo'`, `'alpha', 'bravo' or 'charlie'`
+NSString *CLKSuggestionListDescription(NSArray<NSString *> *suggestions);
+
+NS_ASSUME_NONNULL_END
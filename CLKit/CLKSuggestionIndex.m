@@ -0,0 +1,481 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKSuggestionIndex.h"
+
+#import "CLKAssert.h"
+
+// misspellings up to this long are read into a buffer on the stack
+#define CLKSIStackBufferLength 64
+
+// the longest pattern the bit-parallel distance handles: one bit per character in a 64-bit word
+#define CLKSIWordLength 64
+
+typedef struct {
+    uint32_t offset; // of the string's characters in the character table
+    uint32_t length;
+    uint32_t index; // of the string in the list it was given in
+    unichar first;
+} CLKSIEntry;
+
+// the misspelling, as a bit mask of its positions for each character it contains
+typedef struct {
+    NSUInteger length;
+    uint64_t asciiMasks[128];
+    unichar otherCharacters[CLKSIWordLength];
+    uint64_t otherMasks[CLKSIWordLength];
+    NSUInteger otherCount;
+} CLKSIPattern;
+
+typedef struct {
+    uint32_t index;
+    BOOL sharesFirstCharacter;
+} CLKSICandidate;
+
+// the candidates at the best distance seen so far, in the order they'll be suggested
+typedef struct {
+    NSUInteger distance;
+    CLKSICandidate candidates[CLKSuggestionLimit];
+    NSUInteger count;
+} CLKSIResult;
+
+static NSUInteger CLKSIDistanceLimit(NSUInteger length);
+static void CLKSIPatternInit(CLKSIPattern *pattern, const unichar *characters, NSUInteger length);
+static NSUInteger CLKSIBitParallelDistance(const CLKSIPattern *pattern, const unichar *text, NSUInteger textLength, NSUInteger limit);
+static NSUInteger CLKSITableDistance(const unichar *pattern, NSUInteger patternLength, const unichar *text, NSUInteger textLength, NSUInteger limit);
+static void CLKSIResultOffer(CLKSIResult *result, NSUInteger distance, CLKSICandidate candidate);
+static int CLKSIEntryCompare(const void *a, const void *b);
+
+#pragma mark -
+
+// a third of the length, up to three: enough for a transposition or two in a long name without
+// suggesting unrelated short ones. nothing is suggested for misspellings shorter than three characters.
+static NSUInteger CLKSIDistanceLimit(NSUInteger length)
+{
+    return MIN(3UL, (length / 3));
+}
+
+static void CLKSIPatternInit(CLKSIPattern *pattern, const unichar *characters, NSUInteger length)
+{
+    NSCParameterAssert(length > 0 && length <= CLKSIWordLength);
+    
+    memset(pattern->asciiMasks, 0, sizeof(pattern->asciiMasks));
+    pattern->length = length;
+    pattern->otherCount = 0;
+    
+    for (NSUInteger i = 0 ; i < length ; i++) {
+        unichar c = characters[i];
+        uint64_t bit = (1ULL << i);
+        if (c < 128) {
+            pattern->asciiMasks[c] |= bit;
+            continue;
+        }
+        
+        NSUInteger k = 0;
+        while (k < pattern->otherCount && pattern->otherCharacters[k] != c) {
+            k++;
+        }
+        
+        if (k == pattern->otherCount) {
+            pattern->otherCharacters[k] = c;
+            pattern->otherMasks[k] = 0;
+            pattern->otherCount++;
+        }
+        
+        pattern->otherMasks[k] |= bit;
+    }
+}
+
+static inline uint64_t CLKSIPatternMask(const CLKSIPattern *pattern, unichar c)
+{
+    if (c < 128) {
+        return pattern->asciiMasks[c];
+    }
+    
+    for (NSUInteger k = 0 ; k < pattern->otherCount ; k++) {
+        if (pattern->otherCharacters[k] == c) {
+            return pattern->otherMasks[k];
+        }
+    }
+    
+    return 0;
+}
+
+// Myers' algorithm as formulated by Hyyrö for global distance: one column of the distance table per
+// character of the text, held as vertical deltas in two words. `score` tracks the last row. answers
+// some value above `limit` once the distance is sure to exceed it.
+static NSUInteger CLKSIBitParallelDistance(const CLKSIPattern *pattern, const unichar *text, NSUInteger textLength, NSUInteger limit)
+{
+    NSUInteger m = pattern->length;
+    uint64_t pv = (m == CLKSIWordLength ? UINT64_MAX : ((1ULL << m) - 1));
+    uint64_t mv = 0;
+    uint64_t last = (1ULL << (m - 1));
+    NSUInteger score = m;
+    
+    for (NSUInteger j = 0 ; j < textLength ; j++) {
+        uint64_t eq = CLKSIPatternMask(pattern, text[j]);
+        uint64_t xv = (eq | mv);
+        uint64_t xh = ((((eq & pv) + pv) ^ pv) | eq);
+        uint64_t ph = (mv | ~(xh | pv));
+        uint64_t mh = (pv & xh);
+        
+        if (ph & last) {
+            score++;
+        } else if (mh & last) {
+            score--;
+        }
+        
+        // the top row of the table counts up by one per column
+        ph = ((ph << 1) | 1);
+        mh <<= 1;
+        pv = (mh | ~(xv | ph));
+        mv = (ph & xv);
+        
+        // the score falls by at most one per remaining character
+        if (score > (limit + (textLength - j - 1))) {
+            return (limit + 1);
+        }
+    }
+    
+    return score;
+}
+
+// the distance table a row at a time, for patterns too long for a word
+static NSUInteger CLKSITableDistance(const unichar *pattern, NSUInteger patternLength, const unichar *text, NSUInteger textLength, NSUInteger limit)
+{
+    NSUInteger *row = malloc((textLength + 1) * sizeof(NSUInteger));
+    for (NSUInteger j = 0 ; j <= textLength ; j++) {
+        row[j] = j;
+    }
+    
+    for (NSUInteger i = 1 ; i <= patternLength ; i++) {
+        NSUInteger diagonal = row[0];
+        row[0] = i;
+        for (NSUInteger j = 1 ; j <= textLength ; j++) {
+            NSUInteger above = row[j];
+            NSUInteger substitution = (diagonal + (pattern[i - 1] != text[j - 1]));
+            row[j] = MIN(substitution, (MIN(above, row[j - 1]) + 1));
+            diagonal = above;
+        }
+    }
+    
+    NSUInteger distance = row[textLength];
+    free(row);
+    return MIN(distance, (limit + 1));
+}
+
+static void CLKSIResultOffer(CLKSIResult *result, NSUInteger distance, CLKSICandidate candidate)
+{
+    if (distance > result->distance) {
+        return;
+    }
+    
+    if (distance < result->distance) {
+        result->distance = distance;
+        result->count = 0;
+    }
+    
+    // candidates sharing the first character come first, then by index
+    NSUInteger position = result->count;
+    while (position > 0) {
+        CLKSICandidate previous = result->candidates[position - 1];
+        BOOL precedes = ((candidate.sharesFirstCharacter && !previous.sharesFirstCharacter)
+                         || (candidate.sharesFirstCharacter == previous.sharesFirstCharacter && candidate.index < previous.index));
+        if (!precedes) {
+            break;
+        }
+        
+        position--;
+    }
+    
+    if (position == CLKSuggestionLimit) {
+        return;
+    }
+    
+    NSUInteger count = MIN((result->count + 1), (NSUInteger)CLKSuggestionLimit);
+    for (NSUInteger k = (count - 1) ; k > position ; k--) {
+        result->candidates[k] = result->candidates[k - 1];
+    }
+    
+    result->candidates[position] = candidate;
+    result->count = count;
+}
+
+static int CLKSIEntryCompare(const void *a, const void *b)
+{
+    const CLKSIEntry *entryA = a;
+    const CLKSIEntry *entryB = b;
+    
+    if (entryA->length != entryB->length) {
+        return (entryA->length < entryB->length ? -1 : 1);
+    }
+    
+    if (entryA->first != entryB->first) {
+        return (entryA->first < entryB->first ? -1 : 1);
+    }
+    
+    return (entryA->index < entryB->index ? -1 : (entryA->index > entryB->index));
+}
+
+#pragma mark -
+
+NSUInteger CLKEditDistance(NSString *string, NSString *otherString)
+{
+    NSCParameterAssert(string != nil);
+    NSCParameterAssert(otherString != nil);
+    
+    NSUInteger length = string.length;
+    NSUInteger otherLength = otherString.length;
+    if (length == 0 || otherLength == 0) {
+        return MAX(length, otherLength);
+    }
+    
+    unichar *characters = malloc((length + otherLength) * sizeof(unichar));
+    unichar *otherCharacters = (characters + length);
+    [string getCharacters:characters range:NSMakeRange(0, length)];
+    [otherString getCharacters:otherCharacters range:NSMakeRange(0, otherLength)];
+    
+    NSUInteger limit = MAX(length, otherLength);
+    NSUInteger distance;
+    if (length <= CLKSIWordLength) {
+        CLKSIPattern pattern;
+        CLKSIPatternInit(&pattern, characters, length);
+        distance = CLKSIBitParallelDistance(&pattern, otherCharacters, otherLength, limit);
+    } else {
+        distance = CLKSITableDistance(characters, length, otherCharacters, otherLength, limit);
+    }
+    
+    free(characters);
+    return distance;
+}
+
+NSString *CLKSuggestionListDescription(NSArray<NSString *> *suggestions)
+{
+    NSCParameterAssert(suggestions.count > 0);
+    
+    NSMutableString *description = [NSMutableString string];
+    NSUInteger count = suggestions.count;
+    [suggestions enumerateObjectsUsingBlock:^(NSString *suggestion, NSUInteger idx, __unused BOOL *outStop) {
+        if (idx > 0) {
+            [description appendString:(idx == (count - 1) ? @" or " : @", ")];
+        }
+        
+        [description appendFormat:@"'%@'", suggestion];
+    }];
+    
+    return description;
+}
+
+#pragma mark -
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKSuggestionIndex ()
+
+- (instancetype)_initWithStrings:(NSArray<NSString *> *)strings NS_DESIGNATED_INITIALIZER;
+
+// `pattern` is NULL for misspellings too long for the bit-parallel distance
+- (void)_scoreEntriesFromIndex:(NSUInteger)start
+                       toIndex:(NSUInteger)end
+                 forCharacters:(const unichar *)characters
+                        length:(NSUInteger)length
+                       pattern:(nullable const CLKSIPattern *)pattern
+                        result:(CLKSIResult *)result;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+// distances are Levenshtein distances (insertions, deletions and substitutions), computed with Myers'
+// bit-parallel algorithm at one word operation per character of the name. a name is abandoned as soon
+// as it can't come within the best distance found so far. names are stored by length and, within a
+// length, by first character: lengths are visited nearest first and stop once the difference in length
+// alone exceeds the best distance, and names sharing the misspelling's first character are scored
+// first so that the bound tightens early.
+@implementation CLKSuggestionIndex
+{
+    NSArray<NSString *> *_strings;
+    CLKSIEntry *_entries; // by length, then first character, then index
+    NSUInteger _entryCount;
+    unichar *_characters;
+    
+    // _lengthStarts[n] is the first entry at least n characters long, for n up to one past the longest
+    NSUInteger *_lengthStarts;
+    NSUInteger _maximumLength;
+}
+
++ (instancetype)indexWithStrings:(NSArray<NSString *> *)strings
+{
+    return [[self alloc] _initWithStrings:strings];
+}
+
+- (instancetype)_initWithStrings:(NSArray<NSString *> *)strings
+{
+    CLKHardParameterAssert(strings != nil);
+    CLKHardParameterAssert(strings.count < UINT32_MAX);
+    
+    self = [super init];
+    if (self != nil) {
+        _strings = [strings copy];
+        
+        // empty strings are never suggested
+        NSUInteger totalLength = 0;
+        for (NSString *string in _strings) {
+            totalLength += string.length;
+            _maximumLength = MAX(_maximumLength, string.length);
+            _entryCount += (string.length > 0);
+        }
+        
+        CLKHardAssert((totalLength < UINT32_MAX), NSInvalidArgumentException, @"too many characters for a suggestion index");
+        
+        _entries = malloc(MAX(_entryCount, 1UL) * sizeof(CLKSIEntry));
+        _characters = malloc(MAX(totalLength, 1UL) * sizeof(unichar));
+        
+        uint32_t offset = 0;
+        NSUInteger entryIndex = 0;
+        for (NSUInteger i = 0 ; i < _strings.count ; i++) {
+            NSString *string = _strings[i];
+            NSUInteger length = string.length;
+            if (length == 0) {
+                continue;
+            }
+            
+            [string getCharacters:(_characters + offset) range:NSMakeRange(0, length)];
+            _entries[entryIndex++] = (CLKSIEntry){
+                .offset = offset,
+                .length = (uint32_t)length,
+                .index = (uint32_t)i,
+                .first = _characters[offset]
+            };
+            
+            offset += (uint32_t)length;
+        }
+        
+        qsort(_entries, _entryCount, sizeof(CLKSIEntry), CLKSIEntryCompare);
+        
+        _lengthStarts = malloc((_maximumLength + 2) * sizeof(NSUInteger));
+        NSUInteger e = 0;
+        for (NSUInteger length = 0 ; length <= (_maximumLength + 1) ; length++) {
+            while (e < _entryCount && _entries[e].length < length) {
+                e++;
+            }
+            
+            _lengthStarts[length] = e;
+        }
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_entries);
+    free(_characters);
+    free(_lengthStarts);
+}
+
+#pragma mark -
+
+- (NSArray<NSString *> *)suggestionsForString:(NSString *)string
+{
+    CLKParameterAssert(string != nil);
+    
+    NSUInteger length = string.length;
+    if (CLKSIDistanceLimit(length) == 0 || _entryCount == 0) {
+        return @[];
+    }
+    
+    unichar stackBuffer[CLKSIStackBufferLength];
+    unichar *characters = stackBuffer;
+    if (length > CLKSIStackBufferLength) {
+        characters = malloc(length * sizeof(unichar));
+    }
+    
+    [string getCharacters:characters range:NSMakeRange(0, length)];
+    
+    CLKSIPattern pattern;
+    BOOL bitParallel = (length <= CLKSIWordLength);
+    if (bitParallel) {
+        CLKSIPatternInit(&pattern, characters, length);
+    }
+    
+    CLKSIResult result = { .distance = CLKSIDistanceLimit(length), .count = 0 };
+    
+    // strings differing in length by more than the best distance can't match it
+    for (NSUInteger delta = 0 ; delta <= result.distance ; delta++) {
+        for (int longer = 0 ; longer <= 1 ; longer++) {
+            if (delta == 0 && longer) {
+                continue;
+            }
+            
+            if (!longer && delta >= length) {
+                continue;
+            }
+            
+            NSUInteger runLength = (longer ? (length + delta) : (length - delta));
+            if (runLength > _maximumLength) {
+                continue;
+            }
+            
+            NSUInteger start = _lengthStarts[runLength];
+            NSUInteger end = _lengthStarts[runLength + 1];
+            
+            // the run's strings sharing the first character lie together; score them first
+            NSUInteger firstStart = start;
+            while (firstStart < end && _entries[firstStart].first < characters[0]) {
+                firstStart++;
+            }
+            
+            NSUInteger firstEnd = firstStart;
+            while (firstEnd < end && _entries[firstEnd].first == characters[0]) {
+                firstEnd++;
+            }
+            
+            const CLKSIPattern *runPattern = (bitParallel ? &pattern : NULL);
+            [self _scoreEntriesFromIndex:firstStart toIndex:firstEnd forCharacters:characters length:length pattern:runPattern result:&result];
+            [self _scoreEntriesFromIndex:start toIndex:firstStart forCharacters:characters length:length pattern:runPattern result:&result];
+            [self _scoreEntriesFromIndex:firstEnd toIndex:end forCharacters:characters length:length pattern:runPattern result:&result];
+        }
+    }
+    
+    if (characters != stackBuffer) {
+        free(characters);
+    }
+    
+    // a string that is in the index isn't misspelled
+    if (result.count == 0 || result.distance == 0) {
+        return @[];
+    }
+    
+    NSMutableArray<NSString *> *suggestions = [[NSMutableArray alloc] initWithCapacity:result.count];
+    for (NSUInteger i = 0 ; i < result.count ; i++) {
+        [suggestions addObject:_strings[result.candidates[i].index]];
+    }
+    
+    return suggestions;
+}
+
+- (void)_scoreEntriesFromIndex:(NSUInteger)start
+                       toIndex:(NSUInteger)end
+                 forCharacters:(const unichar *)characters
+                        length:(NSUInteger)length
+                       pattern:(const CLKSIPattern *)pattern
+                        result:(CLKSIResult *)result
+{
+    for (NSUInteger e = start ; e < end ; e++) {
+        const CLKSIEntry *entry = &_entries[e];
+        const unichar *text = (_characters + entry->offset);
+        NSUInteger distance;
+        if (pattern != NULL) {
+            distance = CLKSIBitParallelDistance(pattern, text, entry->length, result->distance);
+        } else {
+            distance = CLKSITableDistance(characters, length, text, entry->length, result->distance);
+        }
+        
+        CLKSICandidate candidate = { .index = entry->index, .sharesFirstCharacter = (entry->first == characters[0]) };
+        CLKSIResultOffer(result, distance, candidate);
+    }
+}
+
+@end
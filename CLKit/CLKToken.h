@@ -15,8 +15,28 @@ typedef NS_ENUM(uint32_t, CLKTokenForm) {
     CLKTokenFormMalformedOption = 7
 };
 
+// the result of classifying a token in a single pass.
+//
+// optionRange covers the option segment without its leading dashes: the name of `--name`
+// and `--name=value`, the flag of `-x` and `-x=y`, or the flags of `-xyz`.
+// argumentRange covers the argument segment of assignment forms and may be zero-length.
+// ranges that don't apply to a token's form have a location of NSNotFound.
+typedef struct {
+    CLKTokenForm form;
+    NSRange optionRange;
+    NSRange argumentRange;
+} CLKTokenAnalysis;
+
 NS_ASSUME_NONNULL_BEGIN
 
+CLKTokenAnalysis CLKTokenAnalyze(NSString *token);
+CLKTokenAnalysis CLKTokenAnalyzeCharacters(const unichar *characters, NSUInteger length);
+
+// classifies a UTF-8 token without decoding it. answers NO if the token is option-like and
+// contains non-ASCII bytes, in which case the caller should decode it and use CLKTokenAnalyze().
+// when this answers YES, the ranges in outAnalysis are valid as both byte and character offsets.
+BOOL CLKTokenAnalyzeUTF8(const char *bytes, size_t length, CLKTokenAnalysis *outAnalysis);
+
 CLKTokenForm CLKTokenFormForToken(NSString *token);
 
 BOOL CLKTokenIsOptionName(NSString *token);
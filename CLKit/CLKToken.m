@@ -4,111 +4,312 @@
 
 #import "CLKToken.h"
 
+#if defined(__SSE2__)
+    #import <emmintrin.h>
+    #define CLK_TOKEN_SCAN_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #import <arm_neon.h>
+    #define CLK_TOKEN_SCAN_NEON 1
+#endif
+
 #import "NSCharacterSet+CLKAdditions.h"
-#import "NSString+CLKAdditions.h"
 
-CLKTokenForm CLKTokenFormForToken(NSString *token)
+typedef NS_OPTIONS(uint8_t, CLKCharacterClass) {
+    CLKCharacterClassOrdinary = 0,
+    CLKCharacterClassDash = 1 << 0,
+    CLKCharacterClassAssignment = 1 << 1,
+    CLKCharacterClassWhitespace = 1 << 2,
+    
+    // mirrors clk_optionNameIllegalCharacterSet and clk_optionFlagIllegalCharacterSet
+    CLKCharacterClassOptionNameIllegal = (CLKCharacterClassAssignment | CLKCharacterClassWhitespace),
+    CLKCharacterClassOptionFlagIllegal = (CLKCharacterClassDash | CLKCharacterClassAssignment | CLKCharacterClassWhitespace)
+};
+
+// classes for the ASCII range. everything not listed here is ordinary.
+static const uint8_t CLKCharacterClassTable[128] = {
+    ['\t'] = CLKCharacterClassWhitespace,
+    ['\n'] = CLKCharacterClassWhitespace,
+    ['\v'] = CLKCharacterClassWhitespace,
+    ['\f'] = CLKCharacterClassWhitespace,
+    ['\r'] = CLKCharacterClassWhitespace,
+    [' '] = CLKCharacterClassWhitespace,
+    ['-'] = CLKCharacterClassDash,
+    [':'] = CLKCharacterClassAssignment,
+    ['='] = CLKCharacterClassAssignment
+};
+
+// tokens up to this length are classified out of a stack buffer
+#define CLKTokenStackBufferLength 256
+
+NS_ASSUME_NONNULL_BEGIN
+
+static inline CLKTokenAnalysis CLKTokenAnalysisMake(CLKTokenForm form);
+static inline CLKCharacterClass CLKCharacterClassForCharacter(unichar c);
+static NSUInteger CLKTokenScan(const unichar *characters, NSUInteger start, NSUInteger end, CLKCharacterClass mask);
+
+NS_ASSUME_NONNULL_END
+
+static inline CLKTokenAnalysis CLKTokenAnalysisMake(CLKTokenForm form)
 {
-    if (token.length < 2) {
-        // a zero-length argument is technically still an argument.
-        // this also catches `-`, which has no special meaning to CLKit.
-        return CLKTokenFormArgument;
+    CLKTokenAnalysis analysis = {
+        .form = form,
+        .optionRange = NSMakeRange(NSNotFound, 0),
+        .argumentRange = NSMakeRange(NSNotFound, 0)
+    };
+    
+    return analysis;
+}
+
+static inline CLKCharacterClass CLKCharacterClassForCharacter(unichar c)
+{
+    if (c < 128) {
+        return CLKCharacterClassTable[c];
     }
     
-    if (CLKTokenIsOptionName(token)) {
-        return CLKTokenFormOptionName;
+    // the only non-ASCII characters of interest are whitespace. they are rare enough in
+    // option tokens that deferring to the character set is cheaper than carrying a table.
+    if ([NSCharacterSet.clk_optionNameIllegalCharacterSet characterIsMember:c]) {
+        return CLKCharacterClassWhitespace;
     }
     
-    if (CLKTokenIsOptionFlag(token)) {
-        return CLKTokenFormOptionFlag;
+    return CLKCharacterClassOrdinary;
+}
+
+#pragma mark -
+#pragma mark Scanning
+
+#if CLK_TOKEN_SCAN_SSE2 || CLK_TOKEN_SCAN_NEON
+
+#define CLKTokenScanBlockLength 8
+
+// conservative filter: answers YES for any block containing a character that could be in `mask`.
+// space and control characters, assignment characters, non-ASCII characters, and (if requested)
+// dashes all count. the caller confirms hits with the scalar classifier.
+static inline BOOL CLKTokenBlockMayContainClass(const unichar *characters, CLKCharacterClass mask)
+{
+    // when dashes are not of interest, probe for `=` a second time rather than branching
+    unichar dashProbe = ((mask & CLKCharacterClassDash) ? '-' : '=');
+    
+#if CLK_TOKEN_SCAN_SSE2
+    __m128i v = _mm_loadu_si128((const __m128i *)characters);
+    __m128i zero = _mm_setzero_si128();
+    __m128i hits = _mm_cmpeq_epi16(_mm_subs_epu16(v, _mm_set1_epi16(0x20)), zero); // c <= 0x20
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi16(v, _mm_set1_epi16('=')));
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi16(v, _mm_set1_epi16(':')));
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi16(v, _mm_set1_epi16((short)dashProbe)));
+    __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16((short)0xFF80)), zero);
+    hits = _mm_or_si128(hits, _mm_andnot_si128(ascii, _mm_set1_epi16(-1))); // c >= 0x80
+    return (_mm_movemask_epi8(hits) != 0);
+#else
+    uint16x8_t v = vld1q_u16(characters);
+    uint16x8_t hits = vcleq_u16(v, vdupq_n_u16(0x20));
+    hits = vorrq_u16(hits, vceqq_u16(v, vdupq_n_u16('=')));
+    hits = vorrq_u16(hits, vceqq_u16(v, vdupq_n_u16(':')));
+    hits = vorrq_u16(hits, vceqq_u16(v, vdupq_n_u16(dashProbe)));
+    hits = vorrq_u16(hits, vcgeq_u16(v, vdupq_n_u16(0x80)));
+    return (vmaxvq_u16(hits) != 0);
+#endif
+}
+
+#endif
+
+// returns the index of the first character in [start, end) with a class in `mask`, or `end` if there is none
+static NSUInteger CLKTokenScan(const unichar *characters, NSUInteger start, NSUInteger end, CLKCharacterClass mask)
+{
+    NSUInteger i = start;
+    
+#if CLK_TOKEN_SCAN_SSE2 || CLK_TOKEN_SCAN_NEON
+    while ((end - i) >= CLKTokenScanBlockLength) {
+        if (CLKTokenBlockMayContainClass(characters + i, mask)) {
+            for (NSUInteger j = i ; j < (i + CLKTokenScanBlockLength) ; j++) {
+                if (CLKCharacterClassForCharacter(characters[j]) & mask) {
+                    return j;
+                }
+            }
+        }
+        
+        i += CLKTokenScanBlockLength;
     }
+#endif
     
-    if (CLKTokenIsOptionFlagSet(token)) {
-        return CLKTokenFormOptionFlagSet;
+    for ( ; i < end ; i++) {
+        if (CLKCharacterClassForCharacter(characters[i]) & mask) {
+            return i;
+        }
     }
     
-    if (CLKTokenIsParameterOptionNameAssignment(token)) {
-        return CLKTokenFormParameterOptionNameAssignment;
+    return end;
+}
+
+#pragma mark -
+#pragma mark Classification
+
+CLKTokenAnalysis CLKTokenAnalyze(NSString *token)
+{
+    NSUInteger length = token.length;
+    
+    // a zero-length argument is technically still an argument.
+    // this also catches `-`, which has no special meaning to CLKit.
+    // every other form begins with a dash, so most positional arguments
+    // (e.g., long paths) are classified without looking past the first character.
+    if (length < 2 || [token characterAtIndex:0] != '-') {
+        return CLKTokenAnalysisMake(CLKTokenFormArgument);
     }
     
-    if (CLKTokenIsParameterOptionFlagAssignment(token)) {
-        return CLKTokenFormParameterOptionFlagAssignment;
+    unichar stackBuffer[CLKTokenStackBufferLength];
+    unichar *characters = stackBuffer;
+    if (length > CLKTokenStackBufferLength) {
+        characters = malloc(length * sizeof(unichar));
     }
     
-    if ([token isEqualToString:@"--"]) {
-        return CLKTokenFormOptionParsingSentinel;
+    [token getCharacters:characters range:NSMakeRange(0, length)];
+    CLKTokenAnalysis analysis = CLKTokenAnalyzeCharacters(characters, length);
+    
+    if (characters != stackBuffer) {
+        free(characters);
     }
     
-    // if the token has a leading dash and has failed all of the option form checks,
-    // it looks like an option but is malformed somehow. (e.g., the option segment
-    // contains whitespace after the dash.) this is an order-dependent check.
-    if ([token hasPrefix:@"-"]) {
-        return CLKTokenFormMalformedOption;
+    return analysis;
+}
+
+CLKTokenAnalysis CLKTokenAnalyzeCharacters(const unichar *characters, NSUInteger length)
+{
+    CLKTokenAnalysis analysis = CLKTokenAnalysisMake(CLKTokenFormArgument);
+    if (length < 2 || characters[0] != '-') {
+        return analysis;
     }
     
-    return CLKTokenFormArgument;
+    if (characters[1] == '-') {
+        if (length == 2) {
+            analysis.form = CLKTokenFormOptionParsingSentinel;
+            return analysis;
+        }
+        
+        // `--flarn`, `--flarn=barf`, `--flarn:barf`
+        //
+        // the first assignment character splits the name from the argument.
+        // whitespace before the split, or an empty name segment (e.g., `--=barf`),
+        // makes the token malformed.
+        NSUInteger split = CLKTokenScan(characters, 2, length, CLKCharacterClassOptionNameIllegal);
+        if (split == length) {
+            analysis.form = CLKTokenFormOptionName;
+            analysis.optionRange = NSMakeRange(2, (length - 2));
+        } else if (split > 2 && (CLKCharacterClassForCharacter(characters[split]) & CLKCharacterClassAssignment)) {
+            analysis.form = CLKTokenFormParameterOptionNameAssignment;
+            analysis.optionRange = NSMakeRange(2, (split - 2));
+            analysis.argumentRange = NSMakeRange((split + 1), (length - split - 1));
+        } else {
+            analysis.form = CLKTokenFormMalformedOption;
+        }
+        
+        return analysis;
+    }
+    
+    // `-x`, `-xyz`, `-x=y`, `-x:y`
+    if (CLKCharacterClassForCharacter(characters[1]) & CLKCharacterClassOptionFlagIllegal) {
+        analysis.form = CLKTokenFormMalformedOption;
+        return analysis;
+    }
+    
+    if (length == 2) {
+        analysis.form = CLKTokenFormOptionFlag;
+        analysis.optionRange = NSMakeRange(1, 1);
+        return analysis;
+    }
+    
+    if (CLKCharacterClassForCharacter(characters[2]) & CLKCharacterClassAssignment) {
+        analysis.form = CLKTokenFormParameterOptionFlagAssignment;
+        analysis.optionRange = NSMakeRange(1, 1);
+        analysis.argumentRange = NSMakeRange(3, (length - 3));
+        return analysis;
+    }
+    
+    // if the token has a leading dash and an illegal character somewhere in the run of flags,
+    // it looks like an option but is malformed somehow. (e.g., `-x z`, `-q-one`)
+    if (CLKTokenScan(characters, 2, length, CLKCharacterClassOptionFlagIllegal) == length) {
+        analysis.form = CLKTokenFormOptionFlagSet;
+        analysis.optionRange = NSMakeRange(1, (length - 1));
+    } else {
+        analysis.form = CLKTokenFormMalformedOption;
+    }
+    
+    return analysis;
+}
+
+BOOL CLKTokenAnalyzeUTF8(const char *bytes, size_t length, CLKTokenAnalysis *outAnalysis)
+{
+    NSCParameterAssert(outAnalysis != NULL);
+    
+    // same fast path as CLKTokenAnalyze(): positional arguments are never inspected past the first byte
+    if (length < 2 || bytes[0] != '-') {
+        *outAnalysis = CLKTokenAnalysisMake(CLKTokenFormArgument);
+        return YES;
+    }
+    
+    // an all-ASCII token has the same offsets in bytes and in characters, so widening
+    // it in place lets the unichar classifier do the work without building a string.
+    // non-ASCII option tokens are rare and might contain multibyte whitespace; punt on those.
+    unichar stackBuffer[CLKTokenStackBufferLength];
+    unichar *characters = stackBuffer;
+    if (length > CLKTokenStackBufferLength) {
+        characters = malloc(length * sizeof(unichar));
+    }
+    
+    BOOL ascii = YES;
+    for (size_t i = 0 ; i < length ; i++) {
+        uint8_t c = (uint8_t)bytes[i];
+        if (c >= 0x80) {
+            ascii = NO;
+            break;
+        }
+        
+        characters[i] = c;
+    }
+    
+    if (ascii) {
+        *outAnalysis = CLKTokenAnalyzeCharacters(characters, length);
+    }
+    
+    if (characters != stackBuffer) {
+        free(characters);
+    }
+    
+    return ascii;
+}
+
+CLKTokenForm CLKTokenFormForToken(NSString *token)
+{
+    return CLKTokenAnalyze(token).form;
 }
 
 BOOL CLKTokenIsOptionName(NSString *token)
 {
     // `--xyzzy`
-    return (token.length > 2
-            && [token hasPrefix:@"--"]
-            && ![token clk_containsCharacterFromSet:NSCharacterSet.clk_optionNameIllegalCharacterSet range:NSMakeRange(2, (token.length - 2))]
-    );
+    return (CLKTokenFormForToken(token) == CLKTokenFormOptionName);
 }
 
 BOOL CLKTokenIsOptionFlag(NSString *token)
 {
     // `-x`
-    return (token.length == 2
-            && [token characterAtIndex:0] == '-'
-            && ![NSCharacterSet.clk_optionFlagIllegalCharacterSet characterIsMember:[token characterAtIndex:1]]
-    );
+    return (CLKTokenFormForToken(token) == CLKTokenFormOptionFlag);
 }
 
 BOOL CLKTokenIsOptionFlagSet(NSString *token)
 {
     // `-xyz`
-    return (token.length > 2
-            && [token characterAtIndex:0] == '-'
-            && ![token clk_containsCharacterFromSet:NSCharacterSet.clk_optionFlagIllegalCharacterSet range:NSMakeRange(1, (token.length - 1))]
-    );
+    return (CLKTokenFormForToken(token) == CLKTokenFormOptionFlagSet);
 }
 
 BOOL CLKTokenIsParameterOptionNameAssignment(NSString *token)
 {
-    /* `--flarn=barf`, `--flarn:barf` */
-    
-    // name assignment forms contain at least two leading dashes, an assignment character, and at least one option name character.
-    // this check does not differentiate between (e.g.,) `--f=` (acceptable) and `--=f` (malformed); the latter will be
-    // detected as part of option name extraction below.
-    if (!(token.length > 3 && [token hasPrefix:@"--"])) {
-        return NO;
-    }
-    
-    // find the first occurence of an assignment operator and verify there is an option name segment preceding it
-    // (e.g., `--=barf` is malformed)
-    NSRange r = NSMakeRange(2, (token.length - 2));
-    NSUInteger loc = [token rangeOfCharacterFromSet:NSCharacterSet.clk_parameterOptionAssignmentCharacterSet options:NSLiteralSearch range:r].location;
-    if (loc == NSNotFound || loc == 2) {
-        return NO;
-    }
-    
-    // validate the form of the option name segment
-    NSUInteger s = (loc - 2);
-    r = NSMakeRange(2, s);
-    return ![token clk_containsCharacterFromSet:NSCharacterSet.clk_optionNameIllegalCharacterSet range:r];
+    // `--flarn=barf`, `--flarn:barf`
+    return (CLKTokenFormForToken(token) == CLKTokenFormParameterOptionNameAssignment);
 }
 
 BOOL CLKTokenIsParameterOptionFlagAssignment(NSString *token)
 {
     // `-x=y`, `-x:y`
-    return (token.length > 2
-            && [token characterAtIndex:0] == '-'
-            && ![NSCharacterSet.clk_optionFlagIllegalCharacterSet characterIsMember:[token characterAtIndex:1]]
-            && [NSCharacterSet.clk_parameterOptionAssignmentCharacterSet characterIsMember:[token characterAtIndex:2]]
-    );
+    return (CLKTokenFormForToken(token) == CLKTokenFormParameterOptionFlagAssignment);
 }
 
 BOOL CLKTokenFormIsKindOfOption(CLKTokenForm tokenForm)
@@ -5,6 +5,8 @@
 #import <Foundation/Foundation.h>
 
 @class CLKCommandResult;
+@class CLKSchemaArchive;
+@class CLKVerbDescriptor;
 @class CLKVerbFamily;
 @protocol CLKVerb;
 
@@ -18,10 +20,64 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithArgumentVector:(NSArray<NSString *> *)argumentVector verbs:(NSArray<id<CLKVerb>> *)verbs;
 - (instancetype)initWithArgumentVector:(NSArray<NSString *> *)argumentVector
                                  verbs:(NSArray<id<CLKVerb>> *)verbs
-                          verbFamilies:(nullable NSArray<CLKVerbFamily *> *)verbFamilies NS_DESIGNATED_INITIALIZER;
+                          verbFamilies:(nullable NSArray<CLKVerbFamily *> *)verbFamilies;
+
+// reads a C argument vector in place. see +[CLKArgumentParser parserWithArgv:argc:options:] for lifetime requirements.
+- (instancetype)initWithArgv:(const char *_Nonnull [_Nonnull])argv argc:(int)argc verbs:(NSArray<id<CLKVerb>> *)verbs;
+- (instancetype)initWithArgv:(const char *_Nonnull [_Nonnull])argv
+                        argc:(int)argc
+                       verbs:(NSArray<id<CLKVerb>> *)verbs
+                verbFamilies:(nullable NSArray<CLKVerbFamily *> *)verbFamilies;
+
+// verbs registered by descriptor are only created if they are dispatched (see CLKVerbDescriptor)
+- (instancetype)initWithArgumentVector:(NSArray<NSString *> *)argumentVector
+                       verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors
+                          verbFamilies:(nullable NSArray<CLKVerbFamily *> *)verbFamilies;
+
+- (instancetype)initWithArgv:(const char *_Nonnull [_Nonnull])argv
+                        argc:(int)argc
+             verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors
+                verbFamilies:(nullable NSArray<CLKVerbFamily *> *)verbFamilies;
+
+// finds the dispatched verb and its schema through an archive written for these verbs, skipping the
+// work of indexing and checking the verb names up front (see CLKSchemaArchive). `schemaArchive` may be nil.
+- (instancetype)initWithArgumentVector:(NSArray<NSString *> *)argumentVector
+                       verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors
+                          verbFamilies:(nullable NSArray<CLKVerbFamily *> *)verbFamilies
+                         schemaArchive:(nullable CLKSchemaArchive *)schemaArchive;
+
+- (instancetype)initWithArgv:(const char *_Nonnull [_Nonnull])argv
+                        argc:(int)argc
+             verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors
+                verbFamilies:(nullable NSArray<CLKVerbFamily *> *)verbFamilies
+               schemaArchive:(nullable CLKSchemaArchive *)schemaArchive;
+
+// YES to profile the dispatched verb's parse and attach the profile to its result (see CLKParseProfile).
+// the default is YES if the CLK_PARSE_PROFILE environment variable is set.
+@property BOOL profilingEnabled;
+
+// YES to let the dispatched verb's options be abbreviated (see -[CLKArgumentParser abbreviatedOptionNamesEnabled]).
+// verb and family names are always spelled out. the default is NO.
+@property BOOL abbreviatedOptionNamesEnabled;
 
 - (CLKCommandResult *)dispatchVerb;
 
+// point the depot at a new argument vector, as for each line read by an interactive shell. the depot
+// keeps a parser for each verb it dispatches and resets it for the verb's next dispatch rather than
+// creating another (see -[CLKArgumentParser resetWithArgumentVector:]), so the manifest a verb runs with
+// is emptied by the verb's next dispatch. copy anything from it that has to outlive that.
+- (void)resetWithArgumentVector:(NSArray<NSString *> *)argumentVector;
+- (void)resetWithArgv:(const char *_Nonnull [_Nonnull])argv argc:(int)argc;
+
+// shell completion. the argument vector is the words of a partially typed command line (without the
+// program name) and `argumentIndex` is the word under the cursor, which may be the vector's count
+// when the cursor is on a new word. words after the cursor are ignored.
+//
+// answers the verb and verb family names, or a family's verb and subfamily names, that begin with the word.
+// after a verb, answers the verb's options that begin with the word and can still be used given
+// the options already present (see CLKOptionCompleter). only the verb being completed is created.
+- (NSArray<NSString *> *)completionsForArgumentAtIndex:(NSUInteger)argumentIndex;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -6,20 +6,40 @@
 
 #import <sysexits.h>
 
-#import "CLKArgumentParser.h"
+#import "CLKArgumentParser_Internal.h"
+#import "CLKArgumentVector.h"
 #import "CLKAssert.h"
-#import "CLKCommandResult.h"
+#import "CLKCommandResult_Private.h"
 #import "CLKError.h"
+#import "CLKOptionCompleter.h"
+#import "CLKParseProfile_Private.h"
+#import "CLKPrefixTrie.h"
+#import "CLKSchemaArchive_Private.h"
+#import "CLKSuggestionIndex.h"
 #import "CLKVerb.h"
-#import "CLKVerbFamily.h"
+#import "CLKVerbDescriptor_Private.h"
+#import "CLKVerbFamily_Private.h"
 #import "NSError+CLKAdditions.h"
-#import "NSMutableArray+CLKAdditions.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+static NSString * const CLKVDTopLevelFamilyName = @"(top-level verbs)";
+
 @interface CLKVerbDepot ()
 
-- (CLKCommandResult *)_runVerb:(id<CLKVerb>)verb withArgumentVector:(NSArray<NSString *> *)argumentVector;
+- (instancetype)_initWithArgumentVector:(CLKArgumentVector *)argumentVector
+                         verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors
+                            verbFamilies:(nullable NSArray<CLKVerbFamily *> *)verbFamilies
+                           schemaArchive:(nullable CLKSchemaArchive *)schemaArchive NS_DESIGNATED_INITIALIZER;
+
++ (NSArray<CLKVerbDescriptor *> *)_descriptorsForVerbs:(NSArray<id<CLKVerb>> *)verbs;
+- (void)_buildVerbMaps;
+
+- (nullable CLKCommandResult *)_dispatchVerbWithSchemaArchive;
+- (CLKCommandResult *)_runVerb:(CLKVerbDescriptor *)verbDescriptor schema:(CLKOptionSchema *)schema withArgumentVector:(CLKArgumentVector *)argumentVector;
+
+- (NSArray<NSString *> *)_completionsForTopLevelWord:(NSString *)word;
+- (NSArray<NSString *> *)_suggestionsForTopLevelName:(NSString *)name;
 
 @end
 
@@ -27,12 +47,27 @@ NS_ASSUME_NONNULL_END
 
 @implementation CLKVerbDepot
 {
-    NSArray<NSString *> *_argumentVector;
+    CLKArgumentVector *_argumentVector;
+    NSArray<CLKVerbDescriptor *> *_verbDescriptors;
+    NSArray<CLKVerbFamily *> *_verbFamilies;
+    CLKSchemaArchive *_schemaArchive;
+    BOOL _profilingEnabled;
+    BOOL _abbreviatedOptionNamesEnabled;
+    
+    // a parser for each verb that has been dispatched, reset for the verb's next dispatch
+    NSMapTable<CLKVerbDescriptor *, CLKArgumentParser *> *_parsers;
+    
+    // built by -_buildVerbMaps. a depot with an archive only builds these if the archive can't dispatch.
+    // top-level verbs and families share a namespace, so their names are indexed together.
     CLKVerbFamily *_topLevelVerbFamily;
     NSMutableDictionary<NSString *, CLKVerbFamily *> *_verbFamilyMap;
+    NSArray<NSString *> *_topLevelNames;
+    CLKPrefixTrie *_topLevelNameTrie;
+    CLKSuggestionIndex *_topLevelNameSuggestionIndex; // built the first time a name is misspelled
 }
 
-//- (instancetype)initWithArgv:(const char * _Nonnull [])argv argc:(int)argc verbs:(NSArray<CLKVerb> *)verbs
+@synthesize profilingEnabled = _profilingEnabled;
+@synthesize abbreviatedOptionNamesEnabled = _abbreviatedOptionNamesEnabled;
 
 - (instancetype)initWithArgumentVector:(NSArray<NSString *> *)argumentVector verbs:(NSArray<id<CLKVerb>> *)verbs
 {
@@ -43,24 +78,119 @@ NS_ASSUME_NONNULL_END
 {
     CLKHardParameterAssert(argumentVector != nil);
     CLKHardParameterAssert(verbs.count > 0);
+    NSArray<CLKVerbDescriptor *> *verbDescriptors = [[self class] _descriptorsForVerbs:verbs];
+    return [self _initWithArgumentVector:[CLKArgumentVector vectorWithArguments:argumentVector] verbDescriptors:verbDescriptors verbFamilies:verbFamilies schemaArchive:nil];
+}
+
+- (instancetype)initWithArgumentVector:(NSArray<NSString *> *)argumentVector verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors verbFamilies:(NSArray<CLKVerbFamily *> *)verbFamilies
+{
+    return [self initWithArgumentVector:argumentVector verbDescriptors:verbDescriptors verbFamilies:verbFamilies schemaArchive:nil];
+}
+
+- (instancetype)initWithArgumentVector:(NSArray<NSString *> *)argumentVector verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors verbFamilies:(NSArray<CLKVerbFamily *> *)verbFamilies schemaArchive:(CLKSchemaArchive *)schemaArchive
+{
+    CLKHardParameterAssert(argumentVector != nil);
+    CLKHardParameterAssert(verbDescriptors.count > 0);
+    return [self _initWithArgumentVector:[CLKArgumentVector vectorWithArguments:argumentVector] verbDescriptors:verbDescriptors verbFamilies:verbFamilies schemaArchive:schemaArchive];
+}
+
+- (instancetype)initWithArgv:(const char *[])argv argc:(int)argc verbs:(NSArray<id<CLKVerb>> *)verbs
+{
+    return [self initWithArgv:argv argc:argc verbs:verbs verbFamilies:nil];
+}
+
+- (instancetype)initWithArgv:(const char *[])argv argc:(int)argc verbs:(NSArray<id<CLKVerb>> *)verbs verbFamilies:(NSArray<CLKVerbFamily *> *)verbFamilies
+{
+    CLKHardParameterAssert(verbs.count > 0);
+    NSArray<CLKVerbDescriptor *> *verbDescriptors = [[self class] _descriptorsForVerbs:verbs];
+    return [self _initWithArgumentVector:[CLKArgumentVector vectorWithArgv:argv argc:argc] verbDescriptors:verbDescriptors verbFamilies:verbFamilies schemaArchive:nil];
+}
+
+- (instancetype)initWithArgv:(const char *[])argv argc:(int)argc verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors verbFamilies:(NSArray<CLKVerbFamily *> *)verbFamilies
+{
+    return [self initWithArgv:argv argc:argc verbDescriptors:verbDescriptors verbFamilies:verbFamilies schemaArchive:nil];
+}
+
+- (instancetype)initWithArgv:(const char *[])argv argc:(int)argc verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors verbFamilies:(NSArray<CLKVerbFamily *> *)verbFamilies schemaArchive:(CLKSchemaArchive *)schemaArchive
+{
+    CLKHardParameterAssert(verbDescriptors.count > 0);
+    return [self _initWithArgumentVector:[CLKArgumentVector vectorWithArgv:argv argc:argc] verbDescriptors:verbDescriptors verbFamilies:verbFamilies schemaArchive:schemaArchive];
+}
+
+- (instancetype)_initWithArgumentVector:(CLKArgumentVector *)argumentVector verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors verbFamilies:(NSArray<CLKVerbFamily *> *)verbFamilies schemaArchive:(CLKSchemaArchive *)schemaArchive
+{
+    CLKHardParameterAssert(argumentVector != nil);
+    CLKHardParameterAssert(verbDescriptors.count > 0);
     
     self = [super init];
     if (self != nil) {
-        _argumentVector = [argumentVector copy];
-        _topLevelVerbFamily = [CLKVerbFamily familyWithName:@"(top-level verbs)" verbs:verbs];
-        _verbFamilyMap = [[NSMutableDictionary alloc] init];
+        _argumentVector = argumentVector;
+        _verbDescriptors = [verbDescriptors copy];
+        _verbFamilies = [verbFamilies copy];
+        _schemaArchive = schemaArchive;
+        _profilingEnabled = CLKParseProfileIsEnabledByEnvironment();
+        _parsers = [NSMapTable mapTableWithKeyOptions:(NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality) valueOptions:NSPointerFunctionsStrongMemory];
         
-        for (CLKVerbFamily *family in verbFamilies) {
-            CLKHardAssert(([_topLevelVerbFamily verbNamed:family.name] == nil), NSInvalidArgumentException, @"encountered identically named top-level verb and verb family: '%@'", family.name);
-            CLKHardAssert((_verbFamilyMap[family.name] == nil), NSInvalidArgumentException, @"encountered multiple verb families named '%@'", family.name);
-            _verbFamilyMap[family.name] = family;
+        // the archive's verbs passed these checks when it was written
+        if (_schemaArchive == nil) {
+            [self _buildVerbMaps];
         }
     }
     
     return self;
 }
 
++ (NSArray<CLKVerbDescriptor *> *)_descriptorsForVerbs:(NSArray<id<CLKVerb>> *)verbs
+{
+    NSMutableArray<CLKVerbDescriptor *> *verbDescriptors = [[NSMutableArray alloc] initWithCapacity:verbs.count];
+    for (id<CLKVerb> verb in verbs) {
+        [verbDescriptors addObject:[CLKVerbDescriptor descriptorWithVerb:verb]];
+    }
+    
+    return verbDescriptors;
+}
+
+- (void)_buildVerbMaps
+{
+    if (_topLevelVerbFamily != nil) {
+        return;
+    }
+    
+    _topLevelVerbFamily = [CLKVerbFamily familyWithName:CLKVDTopLevelFamilyName verbDescriptors:_verbDescriptors];
+    _verbFamilyMap = [[NSMutableDictionary alloc] init];
+    
+    for (CLKVerbFamily *family in _verbFamilies) {
+        CLKHardAssert((family.superfamily == nil), NSInvalidArgumentException, @"encountered subfamily '%@' of '%@' as a top-level verb family", family.name, family.superfamily.name);
+        CLKHardAssert(([_topLevelVerbFamily verbDescriptorNamed:family.name] == nil), NSInvalidArgumentException, @"encountered identically named top-level verb and verb family: '%@'", family.name);
+        CLKHardAssert((_verbFamilyMap[family.name] == nil), NSInvalidArgumentException, @"encountered multiple verb families named '%@'", family.name);
+        _verbFamilyMap[family.name] = family;
+    }
+    
+    _topLevelNames = [[_verbDescriptors valueForKey:@"name"] arrayByAddingObjectsFromArray:[_verbFamilies valueForKey:@"name"]];
+    _topLevelNameTrie = [CLKPrefixTrie trieWithStrings:_topLevelNames];
+}
+
+#pragma mark -
+#pragma mark Resetting
+
+- (void)resetWithArgumentVector:(NSArray<NSString *> *)argumentVector
+{
+    CLKHardParameterAssert(argumentVector != nil);
+    
+    if (![_argumentVector resetWithArguments:argumentVector]) {
+        _argumentVector = [CLKArgumentVector vectorWithArguments:argumentVector];
+    }
+}
+
+- (void)resetWithArgv:(const char *[])argv argc:(int)argc
+{
+    if (![_argumentVector resetWithArgv:argv argc:argc]) {
+        _argumentVector = [CLKArgumentVector vectorWithArgv:argv argc:argc];
+    }
+}
+
 #pragma mark -
+#pragma mark Dispatch
 
 - (CLKCommandResult *)dispatchVerb
 {
@@ -69,42 +199,215 @@ NS_ASSUME_NONNULL_END
         return [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ error ]];
     }
     
-    id<CLKVerb> verb = nil;
-    NSMutableArray<NSString *> *remainingArguments = [_argumentVector mutableCopy];
-    NSString *verbOrFamilyName = [remainingArguments clk_popFirstObject];
+    if (_schemaArchive != nil) {
+        CLKCommandResult *result = [self _dispatchVerbWithSchemaArchive];
+        if (result != nil) {
+            return result;
+        }
+    }
     
+    [self _buildVerbMaps];
+    
+    NSUInteger argumentIndex = 0;
+    NSString *verbOrFamilyName = [_argumentVector argumentAtIndex:argumentIndex++];
     CLKVerbFamily *family = _verbFamilyMap[verbOrFamilyName];
-    if (family != nil) {
-        verbOrFamilyName = [remainingArguments clk_popFirstObject];
-        verb = [family verbNamed:verbOrFamilyName];
-    } else {
-        verb = [_topLevelVerbFamily verbNamed:verbOrFamilyName];
+    CLKVerbDescriptor *verb = (family == nil ? [_topLevelVerbFamily verbDescriptorNamed:verbOrFamilyName] : nil);
+    
+    // walk down the family tree, one name per level: each name after a family's is one of its subfamilies or verbs
+    while (family != nil) {
+        verbOrFamilyName = (argumentIndex < _argumentVector.count ? [_argumentVector argumentAtIndex:argumentIndex++] : nil);
+        CLKVerbFamily *subfamily = (verbOrFamilyName != nil ? [family subfamilyNamed:verbOrFamilyName] : nil);
+        if (subfamily == nil) {
+            verb = (verbOrFamilyName != nil ? [family verbDescriptorNamed:verbOrFamilyName] : nil);
+            break;
+        }
+        
+        family = subfamily;
     }
     
     if (verb == nil) {
+        // an option where a verb was expected isn't a misspelled verb
+        NSArray<NSString *> *suggestions = nil;
+        if (verbOrFamilyName != nil && ![verbOrFamilyName hasPrefix:@"-"]) {
+            suggestions = (family != nil ? [family.childNameSuggestionIndex suggestionsForString:verbOrFamilyName] : [self _suggestionsForTopLevelName:verbOrFamilyName]);
+        }
+        
+        NSString *unrecognized = (family != nil ? [NSString stringWithFormat:@"%@: Unrecognized %@ verb.", verbOrFamilyName, family.path] : [NSString stringWithFormat:@"%@: Unrecognized verb.", verbOrFamilyName]);
         NSError *error;
-        if (family != nil) {
-            error = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb description:@"%@: Unrecognized %@ verb.", verbOrFamilyName, family.name];
+        if (suggestions.count > 0) {
+            error = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb suggestions:suggestions description:@"%@ Did you mean %@?", unrecognized, CLKSuggestionListDescription(suggestions)];
         } else {
-            error = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb description:@"%@: Unrecognized verb.", verbOrFamilyName];
+            error = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb description:@"%@", unrecognized];
         }
         
         return [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ error ]];
     }
     
-    return [self _runVerb:verb withArgumentVector:remainingArguments];
+    // the verb's parser reads the rest of the vector in place rather than a copy of it.
+    // creates the verb and compiles its schema, or reuses those from an earlier dispatch.
+    CLKOptionSchema *schema = (family != nil ? [family _schemaForVerbDescriptor:verb archive:nil verbRecord:0] : verb.schema);
+    CLKArgumentVector *remainingArguments = [_argumentVector subvectorFromIndex:argumentIndex];
+    return [self _runVerb:verb schema:schema withArgumentVector:remainingArguments];
+}
+
+// answers nil if the archive can't say which verb to run: the verb isn't in the archive, the archive
+// is older than the verbs, or there is no verb to run. the caller then looks the verb up as usual.
+- (CLKCommandResult *)_dispatchVerbWithSchemaArchive
+{
+    NSUInteger argumentIndex = 0;
+    NSString *name = [_argumentVector argumentAtIndex:argumentIndex++];
+    const CLKSchemaArchiveEntry *entry = [_schemaArchive _entryForName:name inTable:CLKSchemaArchiveTopLevelTable];
+    NSArray<CLKVerbDescriptor *> *verbDescriptors = _verbDescriptors;
+    NSArray<CLKVerbFamily *> *families = _verbFamilies;
+    CLKVerbFamily *family = nil;
+    
+    // each family entry consumes a name, so a damaged archive can't send this around in circles
+    while (entry != NULL && entry->kind == CLKSchemaArchiveEntryKindFamily) {
+        if (entry->index >= families.count || argumentIndex >= _argumentVector.count) {
+            return nil;
+        }
+        
+        family = families[entry->index];
+        if (![family.name isEqualToString:name]) {
+            return nil;
+        }
+        
+        verbDescriptors = family.verbDescriptors;
+        families = family.subfamilies;
+        name = [_argumentVector argumentAtIndex:argumentIndex++];
+        entry = [_schemaArchive _entryForName:name inTable:entry->target];
+    }
+    
+    if (entry == NULL || entry->index >= verbDescriptors.count) {
+        return nil;
+    }
+    
+    CLKVerbDescriptor *verb = verbDescriptors[entry->index];
+    if (![verb.name isEqualToString:name]) {
+        return nil;
+    }
+    
+    CLKOptionSchema *schema;
+    if (family != nil) {
+        schema = [family _schemaForVerbDescriptor:verb archive:_schemaArchive verbRecord:entry->target];
+    } else {
+        schema = [verb _schemaWithArchive:_schemaArchive verbRecord:entry->target];
+    }
+    
+    return [self _runVerb:verb schema:schema withArgumentVector:[_argumentVector subvectorFromIndex:argumentIndex]];
 }
 
-- (CLKCommandResult *)_runVerb:(id<CLKVerb>)verb withArgumentVector:(NSArray<NSString *> *)argumentVector
+- (CLKCommandResult *)_runVerb:(CLKVerbDescriptor *)verbDescriptor schema:(CLKOptionSchema *)schema withArgumentVector:(CLKArgumentVector *)argumentVector
 {
-    NSArray<CLKOption *> *options = (verb.options != nil ? verb.options : @[]);
-    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argumentVector options:options optionGroups:verb.optionGroups];
+    // a verb in several families has a schema in each, so its parser is only reused for the same schema
+    CLKArgumentParser *parser = [_parsers objectForKey:verbDescriptor];
+    if (parser != nil && parser.schema == schema) {
+        [parser _resetWithArgumentVector:argumentVector];
+    } else {
+        parser = [[CLKArgumentParser alloc] _initWithArgumentVector:argumentVector schema:schema];
+        [_parsers setObject:parser forKey:verbDescriptor];
+    }
+    
+    parser.profilingEnabled = _profilingEnabled;
+    parser.abbreviatedOptionNamesEnabled = _abbreviatedOptionNamesEnabled;
     CLKArgumentManifest *manifest = [parser parseArguments];
+    CLKCommandResult *result;
     if (manifest == nil) {
-        return [CLKCommandResult resultWithExitStatus:EX_USAGE errors:parser.errors];
+        result = [[CLKCommandResult alloc] _initWithExitStatus:EX_USAGE issues:parser.issues];
+    } else {
+        result = [verbDescriptor.verb runWithManifest:manifest];
+    }
+    
+    CLKParseProfile *profile = parser.profile;
+    if (profile != nil) {
+        result.parseProfile = profile;
+    }
+    
+    return result;
+}
+
+#pragma mark -
+#pragma mark Completion
+
+- (NSArray<NSString *> *)completionsForArgumentAtIndex:(NSUInteger)argumentIndex
+{
+    CLKHardParameterAssert(argumentIndex <= _argumentVector.count);
+    
+    [self _buildVerbMaps];
+    
+    NSString *word = (argumentIndex < _argumentVector.count ? [_argumentVector argumentAtIndex:argumentIndex] : @"");
+    if (argumentIndex == 0) {
+        return [self _completionsForTopLevelWord:word];
+    }
+    
+    NSUInteger verbIndex = 0;
+    NSString *verbOrFamilyName = [_argumentVector argumentAtIndex:verbIndex];
+    CLKVerbFamily *family = _verbFamilyMap[verbOrFamilyName];
+    CLKVerbDescriptor *verb = (family == nil ? [_topLevelVerbFamily verbDescriptorNamed:verbOrFamilyName] : nil);
+    
+    // the archive's entries are followed alongside the families so that the verb's schema can be read from it
+    const CLKSchemaArchiveEntry *entry = [_schemaArchive _entryForName:verbOrFamilyName inTable:CLKSchemaArchiveTopLevelTable];
+    while (family != nil) {
+        verbIndex++;
+        if (verbIndex == argumentIndex) {
+            // the word names one of the family's verbs or subfamilies
+            NSMutableArray<NSString *> *completions = [NSMutableArray array];
+            NSArray<NSString *> *childNames = family.childNames;
+            [family.childNameTrie enumerateIndexesOfStringsWithPrefix:word usingBlock:^(NSUInteger idx, __unused BOOL *outStop) {
+                [completions addObject:childNames[idx]];
+            }];
+            
+            return completions;
+        }
+        
+        verbOrFamilyName = [_argumentVector argumentAtIndex:verbIndex];
+        entry = (entry != NULL && entry->kind == CLKSchemaArchiveEntryKindFamily ? [_schemaArchive _entryForName:verbOrFamilyName inTable:entry->target] : NULL);
+        CLKVerbFamily *subfamily = [family subfamilyNamed:verbOrFamilyName];
+        if (subfamily == nil) {
+            verb = [family verbDescriptorNamed:verbOrFamilyName];
+            break;
+        }
+        
+        family = subfamily;
+    }
+    
+    if (verb == nil) {
+        return @[];
+    }
+    
+    NSMutableArray<NSString *> *precedingWords = [NSMutableArray array];
+    for (NSUInteger i = verbIndex + 1 ; i < argumentIndex ; i++) {
+        [precedingWords addObject:[_argumentVector argumentAtIndex:i]];
+    }
+    
+    // an entry that doesn't lead to this verb, as in an archive older than the verbs, is ignored
+    NSArray<CLKVerbDescriptor *> *verbDescriptors = (family != nil ? family.verbDescriptors : _verbDescriptors);
+    BOOL archived = (entry != NULL && entry->kind == CLKSchemaArchiveEntryKindVerb && entry->index < verbDescriptors.count && verbDescriptors[entry->index] == verb);
+    CLKSchemaArchive *archive = (archived ? _schemaArchive : nil);
+    uint32_t record = (archived ? entry->target : 0);
+    CLKOptionSchema *schema = (family != nil ? [family _schemaForVerbDescriptor:verb archive:archive verbRecord:record] : [verb _schemaWithArchive:archive verbRecord:record]);
+    CLKOptionCompleter *completer = [CLKOptionCompleter completerWithSchema:schema];
+    return [completer completionsForWord:word precedingWords:precedingWords];
+}
+
+- (NSArray<NSString *> *)_completionsForTopLevelWord:(NSString *)word
+{
+    NSArray<NSString *> *names = _topLevelNames;
+    NSMutableArray<NSString *> *completions = [NSMutableArray array];
+    [_topLevelNameTrie enumerateIndexesOfStringsWithPrefix:word usingBlock:^(NSUInteger idx, __unused BOOL *outStop) {
+        [completions addObject:names[idx]];
+    }];
+    
+    return completions;
+}
+
+- (NSArray<NSString *> *)_suggestionsForTopLevelName:(NSString *)name
+{
+    if (_topLevelNameSuggestionIndex == nil) {
+        _topLevelNameSuggestionIndex = [CLKSuggestionIndex indexWithStrings:_topLevelNames];
     }
     
-    return [verb runWithManifest:manifest];
+    return [_topLevelNameSuggestionIndex suggestionsForString:name];
 }
 
 @end
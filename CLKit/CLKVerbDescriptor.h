@@ -0,0 +1,36 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class CLKOptionSchema;
+@protocol CLKVerb;
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef id<CLKVerb> _Nonnull (^CLKVerbFactory)(void);
+
+// a verb registered by name. the verb is created the first time it is needed, so a depot
+// or family with many verbs only constructs the one that is dispatched. the verb's options
+// are compiled into a schema once and reused for every dispatch of the verb.
+//
+// descriptors can be shared by several depots, and across threads.
+@interface CLKVerbDescriptor : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
+// the verb created by `factory` or `verbClass` must have the name it was registered under.
+// `verbClass` must conform to CLKVerb and is instantiated with -init.
++ (instancetype)descriptorWithName:(NSString *)name factory:(CLKVerbFactory)factory;
++ (instancetype)descriptorWithName:(NSString *)name verbClass:(Class)verbClass;
++ (instancetype)descriptorWithVerb:(id<CLKVerb>)verb;
+
+@property (readonly) NSString *name;
+@property (readonly) id<CLKVerb> verb;
+@property (readonly) CLKOptionSchema *schema;
+
+@end
+
+NS_ASSUME_NONNULL_END
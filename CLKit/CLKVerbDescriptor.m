@@ -0,0 +1,116 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKVerbDescriptor_Private.h"
+
+#import "CLKAssert.h"
+#import "CLKOptionSchema.h"
+#import "CLKSchemaArchive_Private.h"
+#import "CLKVerb.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKVerbDescriptor ()
+
+- (instancetype)_initWithName:(NSString *)name factory:(nullable CLKVerbFactory)factory verb:(nullable id<CLKVerb>)verb NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation CLKVerbDescriptor
+{
+    NSString *_name;
+    CLKVerbFactory _factory; // released once the verb has been created
+    id<CLKVerb> _verb;
+    CLKOptionSchema *_schema;
+}
+
+@synthesize name = _name;
+
++ (instancetype)descriptorWithName:(NSString *)name factory:(CLKVerbFactory)factory
+{
+    CLKHardParameterAssert(factory != nil);
+    return [[self alloc] _initWithName:name factory:factory verb:nil];
+}
+
++ (instancetype)descriptorWithName:(NSString *)name verbClass:(Class)verbClass
+{
+    CLKHardParameterAssert(verbClass != nil);
+    CLKHardAssert([verbClass conformsToProtocol:@protocol(CLKVerb)], NSInvalidArgumentException, @"%@ does not conform to CLKVerb", verbClass);
+    
+    return [[self alloc] _initWithName:name factory:^{
+        return (id<CLKVerb>)[[verbClass alloc] init];
+    } verb:nil];
+}
+
++ (instancetype)descriptorWithVerb:(id<CLKVerb>)verb
+{
+    CLKHardParameterAssert(verb != nil);
+    return [[self alloc] _initWithName:verb.name factory:nil verb:verb];
+}
+
+- (instancetype)_initWithName:(NSString *)name factory:(CLKVerbFactory)factory verb:(id<CLKVerb>)verb
+{
+    CLKHardParameterAssert(name != nil);
+    
+    self = [super init];
+    if (self != nil) {
+        _name = [name copy];
+        _factory = [factory copy];
+        _verb = verb;
+    }
+    
+    return self;
+}
+
+- (NSString *)debugDescription
+{
+    return [NSString stringWithFormat:@"%@ { name: %@, instantiated: %@ }", super.debugDescription, _name, (_factory == nil ? @"YES" : @"NO")];
+}
+
+- (id<CLKVerb>)verb
+{
+    @synchronized (self) {
+        if (_verb == nil) {
+            id<CLKVerb> verb = _factory();
+            CLKHardAssert((verb != nil), NSGenericException, @"factory for verb '%@' returned nil", _name);
+            CLKHardAssert([verb.name isEqualToString:_name], NSGenericException, @"verb registered as '%@' is named '%@'", _name, verb.name);
+            _verb = verb;
+            _factory = nil;
+        }
+        
+        return _verb;
+    }
+}
+
+- (CLKOptionSchema *)schema
+{
+    return [self _schemaWithArchive:nil verbRecord:0];
+}
+
+- (CLKOptionSchema *)_schemaWithArchive:(CLKSchemaArchive *)archive verbRecord:(uint32_t)record
+{
+    id<CLKVerb> verb = self.verb;
+    
+    @synchronized (self) {
+        if (_schema == nil) {
+            // verbs may build their options on every read, so each is read once
+            NSArray<CLKOption *> *options = verb.options;
+            if (options == nil) {
+                options = @[];
+            }
+            
+            NSArray<CLKOptionGroup *> *groups = verb.optionGroups;
+            _schema = [archive _schemaForVerbRecord:record options:options optionGroups:groups];
+            if (_schema == nil) {
+                _schema = [CLKOptionSchema schemaWithOptions:options optionGroups:groups];
+            }
+        }
+        
+        return _schema;
+    }
+}
+
+@end
@@ -0,0 +1,19 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKVerbDescriptor.h"
+
+@class CLKSchemaArchive;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKVerbDescriptor ()
+
+// like `schema`, but adopts the archive's tables for the verb instead of compiling its options if
+// the record was written for them. `archive` may be nil.
+- (CLKOptionSchema *)_schemaWithArchive:(nullable CLKSchemaArchive *)archive verbRecord:(uint32_t)record;
+
+@end
+
+NS_ASSUME_NONNULL_END
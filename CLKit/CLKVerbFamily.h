@@ -4,10 +4,23 @@
 
 #import <Foundation/Foundation.h>
 
+@class CLKOption;
+@class CLKOptionGroup;
+@class CLKVerbDescriptor;
 @protocol CLKVerb;
 
 NS_ASSUME_NONNULL_BEGIN
 
+// a named set of verbs, dispatched by the family's name followed by the verb's (`remote add`).
+//
+// families can contain subfamilies, nested to any depth (`remote branch track`). a family's verbs
+// and subfamilies share a namespace. a subfamily belongs to the one family it was created in.
+//
+// options and option groups declared by a family are inherited by every verb below it, including
+// the verbs of its subfamilies, and can be used after any of those verbs. they are compiled once
+// for the family and shared by all of those verbs (see CLKOptionRegistry), rather than declared
+// by each verb. groups declared by a family or a verb may refer to inherited options. a verb's
+// options may not share a name or flag with the options it inherits.
 @interface CLKVerbFamily : NSObject
 
 + (instancetype)new NS_UNAVAILABLE;
@@ -15,10 +28,39 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)familyWithName:(NSString *)name verbs:(NSArray<id<CLKVerb>> *)verbs;
 
+// verbs registered by descriptor are created when they are looked up (see CLKVerbDescriptor)
++ (instancetype)familyWithName:(NSString *)name verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors;
+
+// a family must have at least one verb or subfamily
++ (instancetype)familyWithName:(NSString *)name
+                       options:(nullable NSArray<CLKOption *> *)options
+                  optionGroups:(nullable NSArray<CLKOptionGroup *> *)optionGroups
+                         verbs:(NSArray<id<CLKVerb>> *)verbs
+                   subfamilies:(nullable NSArray<CLKVerbFamily *> *)subfamilies;
+
++ (instancetype)familyWithName:(NSString *)name
+                       options:(nullable NSArray<CLKOption *> *)options
+                  optionGroups:(nullable NSArray<CLKOptionGroup *> *)optionGroups
+               verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors
+                   subfamilies:(nullable NSArray<CLKVerbFamily *> *)subfamilies;
+
 @property (readonly) NSString *name;
+@property (readonly) NSArray<CLKVerbDescriptor *> *verbDescriptors;
+@property (readonly) NSArray<CLKVerbFamily *> *subfamilies;
+
+// the family this family is a subfamily of, if any
+@property (nullable, readonly, weak) CLKVerbFamily *superfamily;
+
+// the options and groups declared by this family, not including those it inherits
+@property (nullable, readonly) NSArray<CLKOption *> *options;
+@property (nullable, readonly) NSArray<CLKOptionGroup *> *optionGroups;
+
+// reading this creates every verb in the family
 @property (readonly) NSArray<id<CLKVerb>> *verbs;
 
 - (nullable id<CLKVerb>)verbNamed:(NSString *)verbName;
+- (nullable CLKVerbDescriptor *)verbDescriptorNamed:(NSString *)verbName;
+- (nullable CLKVerbFamily *)subfamilyNamed:(NSString *)familyName;
 
 @end
 
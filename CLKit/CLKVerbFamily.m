@@ -2,16 +2,27 @@
 //  Copyright (c) 2018 Plastic Pulse. All rights reserved.
 //
 
-#import "CLKVerbFamily.h"
+#import "CLKVerbFamily_Private.h"
 
 #import "CLKAssert.h"
+#import "CLKOptionSchema_Private.h"
+#import "CLKPrefixTrie.h"
+#import "CLKSchemaArchive_Private.h"
+#import "CLKSuggestionIndex.h"
 #import "CLKVerb.h"
+#import "CLKVerbDescriptor_Private.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 @interface CLKVerbFamily ()
 
-- (instancetype)_initWithName:(NSString *)name verbs:(NSArray<id<CLKVerb>> *)verbs NS_DESIGNATED_INITIALIZER;
+- (instancetype)_initWithName:(NSString *)name
+                      options:(nullable NSArray<CLKOption *> *)options
+                 optionGroups:(nullable NSArray<CLKOptionGroup *> *)optionGroups
+              verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors
+                  subfamilies:(nullable NSArray<CLKVerbFamily *> *)subfamilies NS_DESIGNATED_INITIALIZER;
+
++ (NSArray<CLKVerbDescriptor *> *)_descriptorsForVerbs:(NSArray<id<CLKVerb>> *)verbs;
 
 @end
 
@@ -20,41 +31,224 @@ NS_ASSUME_NONNULL_END
 @implementation CLKVerbFamily
 {
     NSString *_name;
-    NSArray<id<CLKVerb>> *_verbs;
-    NSMutableDictionary<NSString *, id<CLKVerb>> *_verbMap;
+    NSArray<CLKVerbDescriptor *> *_verbDescriptors;
+    NSArray<CLKVerbFamily *> *_subfamilies;
+    __weak CLKVerbFamily *_superfamily; // set by the superfamily when it is created
+    NSArray<CLKOption *> *_options;
+    NSArray<CLKOptionGroup *> *_optionGroups;
+    NSMutableDictionary<NSString *, CLKVerbDescriptor *> *_verbMap;
+    NSMutableDictionary<NSString *, CLKVerbFamily *> *_subfamilyMap;
+    
+    // built on demand: tries and indexes for completion and errors, schemas for dispatch
+    CLKPrefixTrie *_childNameTrie;
+    CLKSuggestionIndex *_childNameSuggestionIndex;
+    BOOL _optionSchemaCompiled;
+    CLKOptionSchema *_optionSchema;
+    NSMutableDictionary<NSString *, CLKOptionSchema *> *_verbSchemas; // verb name -> schema, when there is an option schema
 }
 
 @synthesize name = _name;
-@synthesize verbs = _verbs;
+@synthesize verbDescriptors = _verbDescriptors;
+@synthesize subfamilies = _subfamilies;
+@synthesize superfamily = _superfamily;
+@synthesize options = _options;
+@synthesize optionGroups = _optionGroups;
 
 + (instancetype)familyWithName:(NSString *)name verbs:(NSArray<id<CLKVerb>> *)verbs
 {
-    return [[self alloc] _initWithName:name verbs:verbs];
+    CLKHardParameterAssert(verbs != nil);
+    return [[self alloc] _initWithName:name options:nil optionGroups:nil verbDescriptors:[self _descriptorsForVerbs:verbs] subfamilies:nil];
+}
+
++ (instancetype)familyWithName:(NSString *)name verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors
+{
+    return [[self alloc] _initWithName:name options:nil optionGroups:nil verbDescriptors:verbDescriptors subfamilies:nil];
 }
 
-- (instancetype)_initWithName:(NSString *)name verbs:(NSArray<id<CLKVerb>> *)verbs
++ (instancetype)familyWithName:(NSString *)name options:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)optionGroups verbs:(NSArray<id<CLKVerb>> *)verbs subfamilies:(NSArray<CLKVerbFamily *> *)subfamilies
+{
+    CLKHardParameterAssert(verbs != nil);
+    return [[self alloc] _initWithName:name options:options optionGroups:optionGroups verbDescriptors:[self _descriptorsForVerbs:verbs] subfamilies:subfamilies];
+}
+
++ (instancetype)familyWithName:(NSString *)name options:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)optionGroups verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors subfamilies:(NSArray<CLKVerbFamily *> *)subfamilies
+{
+    return [[self alloc] _initWithName:name options:options optionGroups:optionGroups verbDescriptors:verbDescriptors subfamilies:subfamilies];
+}
+
++ (NSArray<CLKVerbDescriptor *> *)_descriptorsForVerbs:(NSArray<id<CLKVerb>> *)verbs
+{
+    NSMutableArray<CLKVerbDescriptor *> *verbDescriptors = [[NSMutableArray alloc] initWithCapacity:verbs.count];
+    for (id<CLKVerb> verb in verbs) {
+        [verbDescriptors addObject:[CLKVerbDescriptor descriptorWithVerb:verb]];
+    }
+    
+    return verbDescriptors;
+}
+
+- (instancetype)_initWithName:(NSString *)name options:(NSArray<CLKOption *> *)options optionGroups:(NSArray<CLKOptionGroup *> *)optionGroups verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors subfamilies:(NSArray<CLKVerbFamily *> *)subfamilies
 {
     CLKHardParameterAssert(name != nil);
-    CLKHardParameterAssert(verbs.count > 0);
+    CLKHardParameterAssert(verbDescriptors != nil);
+    CLKHardParameterAssert((verbDescriptors.count + subfamilies.count) > 0);
     
     self = [super init];
     if (self != nil) {
         _name = [name copy];
-        _verbs = [verbs copy];
+        _verbDescriptors = [verbDescriptors copy];
+        _subfamilies = (subfamilies != nil ? [subfamilies copy] : @[]);
+        _options = [options copy];
+        _optionGroups = [optionGroups copy];
         _verbMap = [[NSMutableDictionary alloc] init];
         
-        for (id<CLKVerb> verb in verbs) {
-            CLKHardAssert((_verbMap[verb.name] == nil), NSInvalidArgumentException, @"encountered multiple verbs named '%@' for verb family '%@'", verb.name, _name);
-            _verbMap[verb.name] = verb;
+        for (CLKVerbDescriptor *descriptor in verbDescriptors) {
+            CLKHardAssert((_verbMap[descriptor.name] == nil), NSInvalidArgumentException, @"encountered multiple verbs named '%@' for verb family '%@'", descriptor.name, _name);
+            _verbMap[descriptor.name] = descriptor;
+        }
+        
+        if (_subfamilies.count > 0) {
+            _subfamilyMap = [[NSMutableDictionary alloc] init];
+            for (CLKVerbFamily *subfamily in _subfamilies) {
+                CLKHardAssert((_verbMap[subfamily.name] == nil), NSInvalidArgumentException, @"encountered identically named verb and subfamily '%@' for verb family '%@'", subfamily.name, _name);
+                CLKHardAssert((_subfamilyMap[subfamily.name] == nil), NSInvalidArgumentException, @"encountered multiple subfamilies named '%@' for verb family '%@'", subfamily.name, _name);
+                CLKHardAssert((subfamily.superfamily == nil), NSInvalidArgumentException, @"verb family '%@' is already a subfamily of '%@'", subfamily.name, subfamily.superfamily.name);
+                _subfamilyMap[subfamily.name] = subfamily;
+                subfamily->_superfamily = self;
+            }
         }
     }
     
     return self;
 }
 
+- (NSArray<id<CLKVerb>> *)verbs
+{
+    NSMutableArray<id<CLKVerb>> *verbs = [[NSMutableArray alloc] initWithCapacity:_verbDescriptors.count];
+    for (CLKVerbDescriptor *descriptor in _verbDescriptors) {
+        [verbs addObject:descriptor.verb];
+    }
+    
+    return verbs;
+}
+
 - (nullable id<CLKVerb>)verbNamed:(NSString *)verbName
+{
+    return [self verbDescriptorNamed:verbName].verb;
+}
+
+- (nullable CLKVerbDescriptor *)verbDescriptorNamed:(NSString *)verbName
 {
     return _verbMap[verbName];
 }
 
+- (nullable CLKVerbFamily *)subfamilyNamed:(NSString *)familyName
+{
+    return _subfamilyMap[familyName];
+}
+
+#pragma mark -
+
+- (NSString *)path
+{
+    CLKVerbFamily *superfamily = _superfamily;
+    return (superfamily != nil ? [NSString stringWithFormat:@"%@ %@", superfamily.path, _name] : _name);
+}
+
+- (NSArray<NSString *> *)childNames
+{
+    NSArray<NSString *> *names = [_verbDescriptors valueForKey:@"name"];
+    if (_subfamilies.count > 0) {
+        names = [names arrayByAddingObjectsFromArray:[_subfamilies valueForKey:@"name"]];
+    }
+    
+    return names;
+}
+
+- (CLKPrefixTrie *)childNameTrie
+{
+    @synchronized (self) {
+        if (_childNameTrie == nil) {
+            _childNameTrie = [CLKPrefixTrie trieWithStrings:self.childNames];
+        }
+        
+        return _childNameTrie;
+    }
+}
+
+- (CLKSuggestionIndex *)childNameSuggestionIndex
+{
+    @synchronized (self) {
+        if (_childNameSuggestionIndex == nil) {
+            _childNameSuggestionIndex = [CLKSuggestionIndex indexWithStrings:self.childNames];
+        }
+        
+        return _childNameSuggestionIndex;
+    }
+}
+
+- (CLKOptionSchema *)optionSchema
+{
+    // superfamilies never lock their subfamilies, so taking the superfamily's lock under ours can't deadlock
+    @synchronized (self) {
+        if (!_optionSchemaCompiled) {
+            CLKOptionSchema *inheritedSchema = _superfamily.optionSchema;
+            if (_options.count > 0 || _optionGroups.count > 0) {
+                _optionSchema = [[CLKOptionSchema alloc] _initWithOptions:(_options != nil ? _options : @[]) optionGroups:_optionGroups inheritedSchema:inheritedSchema];
+            } else {
+                _optionSchema = inheritedSchema;
+            }
+            
+            _optionSchemaCompiled = YES;
+        }
+        
+        return _optionSchema;
+    }
+}
+
+- (CLKOptionSchema *)_schemaForVerbDescriptor:(CLKVerbDescriptor *)descriptor archive:(CLKSchemaArchive *)archive verbRecord:(uint32_t)record
+{
+    NSParameterAssert(_verbMap[descriptor.name] == descriptor);
+    
+    CLKOptionSchema *familySchema = self.optionSchema;
+    if (familySchema == nil) {
+        return [descriptor _schemaWithArchive:archive verbRecord:record];
+    }
+    
+    // the descriptor may be in other families too, so the schema is kept here rather than by the descriptor
+    id<CLKVerb> verb = descriptor.verb;
+    @synchronized (self) {
+        CLKOptionSchema *schema = _verbSchemas[descriptor.name];
+        if (schema == nil) {
+            // verbs may build their options on every read, so each is read once
+            NSArray<CLKOption *> *options = verb.options;
+            if (options == nil) {
+                options = @[];
+            }
+            
+            NSArray<CLKOptionGroup *> *groups = verb.optionGroups;
+            if (archive != nil) {
+                // archives hold the verb's tables with the inherited options folded in
+                NSArray<CLKOptionGroup *> *allGroups = familySchema.optionGroups;
+                if (groups != nil) {
+                    allGroups = (allGroups != nil ? [allGroups arrayByAddingObjectsFromArray:groups] : groups);
+                }
+                
+                schema = [archive _schemaForVerbRecord:record options:[familySchema.options arrayByAddingObjectsFromArray:options] optionGroups:allGroups];
+            }
+            
+            if (schema == nil) {
+                schema = [[CLKOptionSchema alloc] _initWithOptions:options optionGroups:groups inheritedSchema:familySchema];
+            }
+            
+            if (_verbSchemas == nil) {
+                _verbSchemas = [[NSMutableDictionary alloc] init];
+            }
+            
+            _verbSchemas[descriptor.name] = schema;
+        }
+        
+        return schema;
+    }
+}
+
 @end
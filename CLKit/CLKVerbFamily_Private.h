@@ -0,0 +1,40 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKVerbFamily.h"
+
+@class CLKOptionSchema;
+@class CLKPrefixTrie;
+@class CLKSchemaArchive;
+@class CLKSuggestionIndex;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKVerbFamily ()
+
+// the names of the family and its superfamilies, outermost first and separated by spaces (`remote branch`)
+@property (readonly) NSString *path;
+
+// the names of the family's verbs, in order, followed by the names of its subfamilies
+@property (readonly) NSArray<NSString *> *childNames;
+
+// a prefix index over the verb and subfamily names, by position in `childNames`. built the first time it is read.
+@property (readonly) CLKPrefixTrie *childNameTrie;
+
+// an index of the verb and subfamily names for suggesting corrections to misspelled ones, by position
+// in `childNames`. built the first time it is read.
+@property (readonly) CLKSuggestionIndex *childNameSuggestionIndex;
+
+// the options and groups of the family and its superfamilies, compiled the first time this is read.
+// nil if none of them declare any.
+@property (nullable, readonly) CLKOptionSchema *optionSchema;
+
+// the schema of one of the family's verbs: the verb's own schema (see CLKVerbDescriptor) if the family
+// has no `optionSchema`, else the verb's options compiled on top of it. compiled once per verb, or
+// adopted from the archive's record if it was written for the same options (`archive` may be nil).
+- (CLKOptionSchema *)_schemaForVerbDescriptor:(CLKVerbDescriptor *)descriptor archive:(nullable CLKSchemaArchive *)archive verbRecord:(uint32_t)record;
+
+@end
+
+NS_ASSUME_NONNULL_END
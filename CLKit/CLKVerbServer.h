@@ -0,0 +1,45 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class CLKVerbDescriptor;
+@class CLKVerbFamily;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// a resident verb depot. the server listens on a Unix domain socket for argument vectors sent by
+// the client shim (clkclient), dispatches each one as CLKVerbDepot would and sends the result back:
+// the verb's output, the result's errors and its exit status. verbs and their schemas are created
+// once and reused by every request, so a request skips process and Foundation startup.
+//
+// requests are dispatched concurrently, so verbs must be safe to run on several threads at once.
+// a verb sees the client's working directory and environment and writes to the client's stdout
+// and stderr through +[CLKCommandContext currentContext].
+//
+// the socket is only accessible to the user running the server. see CLKServerProtocol.h for the
+// wire format.
+@interface CLKVerbServer : NSObject
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
++ (instancetype)serverWithSocketPath:(NSString *)socketPath
+                     verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors
+                        verbFamilies:(nullable NSArray<CLKVerbFamily *> *)verbFamilies;
+
+@property (readonly) NSString *socketPath;
+@property (readonly, getter=isListening) BOOL listening;
+
+// creates the socket and begins accepting requests in the background. a stale socket left at
+// the path by an earlier server is replaced. answers NO and a POSIX error if the socket can't be
+// created.
+- (BOOL)startListening:(NSError **)outError;
+
+// stops accepting requests and removes the socket. requests in progress run to completion.
+- (void)stopListening;
+
+@end
+
+NS_ASSUME_NONNULL_END
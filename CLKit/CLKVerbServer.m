@@ -0,0 +1,390 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKVerbServer.h"
+
+#import <dispatch/dispatch.h>
+#import <fcntl.h>
+#import <sys/stat.h>
+#import <sysexits.h>
+
+#import "CLKAssert.h"
+#import "CLKCommandContext_Private.h"
+#import "CLKCommandResult.h"
+#import "CLKServerProtocol.h"
+#import "CLKVerbDepot.h"
+#import "NSError+CLKAdditions.h"
+
+// how long a client may take to send its request, or to read a frame of the response
+static const time_t CLKVSSocketTimeout = 30;
+
+// arguments and environment variables per request
+static const NSUInteger CLKVSMaximumRequestFrameCount = (1 << 20);
+
+// bytes per request, frame headers included. a client forwards a command line it was exec'd
+// with, so this is a few times the ARG_MAX of common systems.
+static const uint64_t CLKVSMaximumRequestLength = (8 * 1024 * 1024);
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface CLKVerbServer ()
+
+- (instancetype)_initWithSocketPath:(NSString *)socketPath
+                    verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors
+                       verbFamilies:(nullable NSArray<CLKVerbFamily *> *)verbFamilies NS_DESIGNATED_INITIALIZER;
+
+- (BOOL)_removeStaleSocket:(NSError **)outError;
+- (void)_acceptConnectionsOnSocket:(int)listeningSocket;
+- (void)_serveConnection:(int)fd;
+
+// answers nil and a description of the problem if the request is malformed or the client goes away
+- (nullable NSArray<NSString *> *)_readRequestFromConnection:(int)fd
+                                            workingDirectory:(NSString * _Nullable * _Nonnull)outWorkingDirectory
+                                                 environment:(NSDictionary<NSString *, NSString *> * _Nullable * _Nonnull)outEnvironment
+                                          failureDescription:(NSString * _Nullable * _Nonnull)outFailureDescription;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation CLKVerbServer
+{
+    NSString *_socketPath;
+    NSArray<CLKVerbDescriptor *> *_verbDescriptors;
+    NSArray<CLKVerbFamily *> *_verbFamilies;
+    dispatch_queue_t _requestQueue;
+    dispatch_source_t _acceptSource; // guarded by self
+}
+
+@synthesize socketPath = _socketPath;
+
++ (instancetype)serverWithSocketPath:(NSString *)socketPath verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors verbFamilies:(NSArray<CLKVerbFamily *> *)verbFamilies
+{
+    return [[self alloc] _initWithSocketPath:socketPath verbDescriptors:verbDescriptors verbFamilies:verbFamilies];
+}
+
+- (instancetype)_initWithSocketPath:(NSString *)socketPath verbDescriptors:(NSArray<CLKVerbDescriptor *> *)verbDescriptors verbFamilies:(NSArray<CLKVerbFamily *> *)verbFamilies
+{
+    CLKHardParameterAssert(socketPath.length > 0);
+    CLKHardParameterAssert(verbDescriptors.count > 0);
+    
+    self = [super init];
+    if (self != nil) {
+        _socketPath = [socketPath copy];
+        _verbDescriptors = [verbDescriptors copy];
+        _verbFamilies = [verbFamilies copy];
+        _requestQueue = dispatch_queue_create("com.plasticpulse.CLKit.CLKVerbServer.requests", DISPATCH_QUEUE_CONCURRENT);
+        
+        // surface conflicting verb and family names now rather than on the first request
+        (void)[[CLKVerbDepot alloc] initWithArgumentVector:@[] verbDescriptors:_verbDescriptors verbFamilies:_verbFamilies];
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    [self stopListening];
+}
+
+#pragma mark -
+#pragma mark Listening
+
+- (BOOL)isListening
+{
+    @synchronized (self) {
+        return (_acceptSource != nil);
+    }
+}
+
+- (BOOL)startListening:(NSError **)outError
+{
+    @synchronized (self) {
+        CLKHardAssert((_acceptSource == nil), NSGenericException, @"server is already listening");
+        
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        const char *path = _socketPath.fileSystemRepresentation;
+        if (strlen(path) >= sizeof(address.sun_path)) {
+            if (outError != nil) {
+                *outError = [NSError clk_POSIXErrorWithCode:ENAMETOOLONG description:@"%@: Socket path is too long.", _socketPath];
+            }
+            
+            return NO;
+        }
+        
+        strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+        
+        if (![self _removeStaleSocket:outError]) {
+            return NO;
+        }
+        
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            if (outError != nil) {
+                *outError = [NSError clk_POSIXErrorWithCode:errno description:@"%@: %s", _socketPath, strerror(errno)];
+            }
+            
+            return NO;
+        }
+        
+        // accept() is driven by the dispatch source, so it must never block
+        (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+        (void)fcntl(fd, F_SETFL, (fcntl(fd, F_GETFL) | O_NONBLOCK));
+        
+        // the socket runs verbs with the server's privileges, so only its owner may connect.
+        // nobody can connect before listen(), so there's no window where the socket is open to others.
+        BOOL bound = (bind(fd, (struct sockaddr *)&address, sizeof(address)) == 0);
+        if (!bound || chmod(path, (S_IRUSR | S_IWUSR)) != 0 || listen(fd, SOMAXCONN) != 0) {
+            int code = errno;
+            close(fd);
+            if (bound) {
+                unlink(path);
+            }
+            
+            if (outError != nil) {
+                *outError = [NSError clk_POSIXErrorWithCode:code description:@"%@: %s", _socketPath, strerror(code)];
+            }
+            
+            return NO;
+        }
+        
+        _acceptSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _requestQueue);
+        
+        // the cancel handler runs after the last event handler returns, so the socket outlives every accept()
+        __weak typeof(self) weakSelf = self;
+        dispatch_source_set_event_handler(_acceptSource, ^{
+            [weakSelf _acceptConnectionsOnSocket:fd];
+        });
+        
+        dispatch_source_set_cancel_handler(_acceptSource, ^{
+            close(fd);
+        });
+        
+        dispatch_resume(_acceptSource);
+        return YES;
+    }
+}
+
+- (void)stopListening
+{
+    @synchronized (self) {
+        if (_acceptSource == nil) {
+            return;
+        }
+        
+        dispatch_source_cancel(_acceptSource);
+        _acceptSource = nil;
+        unlink(_socketPath.fileSystemRepresentation);
+    }
+}
+
+- (BOOL)_removeStaleSocket:(NSError **)outError
+{
+    const char *path = _socketPath.fileSystemRepresentation;
+    struct stat status;
+    if (lstat(path, &status) != 0 || !S_ISSOCK(status.st_mode)) {
+        // nothing there, or something bind() will refuse to replace
+        return YES;
+    }
+    
+    // a socket nobody is listening on was left behind by a server that didn't stop cleanly
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    int connectResult = (probe >= 0 ? connect(probe, (struct sockaddr *)&address, sizeof(address)) : -1);
+    if (probe >= 0) {
+        close(probe);
+    }
+    
+    if (connectResult == 0) {
+        if (outError != nil) {
+            *outError = [NSError clk_POSIXErrorWithCode:EADDRINUSE description:@"%@: Another server is listening on this socket.", _socketPath];
+        }
+        
+        return NO;
+    }
+    
+    unlink(path);
+    return YES;
+}
+
+#pragma mark -
+#pragma mark Requests
+
+- (void)_acceptConnectionsOnSocket:(int)listeningSocket
+{
+    for (;;) {
+        int fd = accept(listeningSocket, NULL, NULL);
+        if (fd < 0) {
+            // EAGAIN once the backlog is drained
+            return;
+        }
+        
+        // accepted sockets inherit O_NONBLOCK on some systems. connections are served with blocking I/O.
+        (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+        (void)fcntl(fd, F_SETFL, (fcntl(fd, F_GETFL) & ~O_NONBLOCK));
+        
+        struct timeval timeout = { .tv_sec = CLKVSSocketTimeout, .tv_usec = 0 };
+        (void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        (void)setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        CLKServerConfigureSocket(fd);
+        
+        dispatch_async(_requestQueue, ^{
+            @autoreleasepool {
+                [self _serveConnection:fd];
+                close(fd);
+            }
+        });
+    }
+}
+
+- (void)_serveConnection:(int)fd
+{
+    NSString *workingDirectory = nil;
+    NSDictionary<NSString *, NSString *> *environment = nil;
+    NSString *failureDescription = nil;
+    NSArray<NSString *> *arguments = [self _readRequestFromConnection:fd workingDirectory:&workingDirectory environment:&environment failureDescription:&failureDescription];
+    if (arguments == nil) {
+        NSData *description = [[failureDescription stringByAppendingString:@"\n"] dataUsingEncoding:NSUTF8StringEncoding];
+        (void)CLKServerWriteFrame(fd, CLKServerFrameTypeErrorOutput, description.bytes, (uint32_t)description.length);
+        (void)CLKServerWriteIntegerFrame(fd, CLKServerFrameTypeExit, EX_PROTOCOL);
+        return;
+    }
+    
+    // the verb may write from several threads. once a write fails the client is gone and the rest
+    // of the output is dropped.
+    NSObject *writeLock = [[NSObject alloc] init];
+    __block BOOL clientGone = NO;
+    CLKCommandContextWriter writer = ^(int stream, NSData *data) {
+        CLKServerFrameType type = (stream == STDERR_FILENO ? CLKServerFrameTypeErrorOutput : CLKServerFrameTypeOutput);
+        @synchronized (writeLock) {
+            const uint8_t *bytes = data.bytes;
+            for (NSUInteger offset = 0 ; offset < data.length && !clientGone ; offset += CLKServerMaximumFrameLength) {
+                uint32_t length = (uint32_t)MIN((data.length - offset), (NSUInteger)CLKServerMaximumFrameLength);
+                clientGone = (CLKServerWriteFrame(fd, type, (bytes + offset), length) != 0);
+            }
+        }
+    };
+    
+    CLKCommandContext *context = [[CLKCommandContext alloc] _initWithWorkingDirectory:workingDirectory environment:environment writer:writer];
+    __block CLKCommandResult *result = nil;
+    [context _performAsCurrentContext:^{
+        CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:arguments verbDescriptors:self->_verbDescriptors verbFamilies:self->_verbFamilies];
+        result = [depot dispatchVerb];
+    }];
+    
+    // reported the way a standalone tool reports them
+    NSString *errorDescription = result.errorDescription;
+    if (errorDescription != nil) {
+        [context printError:@"%@\n", errorDescription];
+    }
+    
+    @synchronized (writeLock) {
+        if (!clientGone) {
+            (void)CLKServerWriteIntegerFrame(fd, CLKServerFrameTypeExit, result.exitStatus);
+        }
+    }
+}
+
+- (NSArray<NSString *> *)_readRequestFromConnection:(int)fd
+                                   workingDirectory:(NSString **)outWorkingDirectory
+                                        environment:(NSDictionary<NSString *, NSString *> **)outEnvironment
+                                 failureDescription:(NSString **)outFailureDescription
+{
+    NSString *workingDirectory = nil;
+    NSMutableArray<NSString *> *arguments = [NSMutableArray array];
+    NSMutableDictionary<NSString *, NSString *> *environment = [NSMutableDictionary dictionary];
+    BOOL greeted = NO;
+    uint64_t requestLength = 0;
+    
+    for (NSUInteger frameCount = 0 ; frameCount < CLKVSMaximumRequestFrameCount ; frameCount++) {
+        CLKServerFrameType type;
+        uint32_t length;
+        if (CLKServerReadFrameHeader(fd, &type, &length) != 0) {
+            *outFailureDescription = [NSString stringWithFormat:@"Failed to read request: %s", strerror(errno)];
+            return nil;
+        }
+        
+        // checked before the payload is read, so an oversized request costs no more than the limit
+        requestLength += (CLKServerFrameHeaderLength + (uint64_t)length);
+        if (requestLength > CLKVSMaximumRequestLength) {
+            *outFailureDescription = @"Malformed request: too large.";
+            return nil;
+        }
+        
+        NSMutableData *payload = [NSMutableData dataWithLength:length];
+        if (length > 0 && CLKServerReadFully(fd, payload.mutableBytes, length) != 0) {
+            *outFailureDescription = [NSString stringWithFormat:@"Failed to read request: %s", strerror(errno)];
+            return nil;
+        }
+        
+        if (!greeted) {
+            if (type != CLKServerFrameTypeHello || length != sizeof(uint32_t)) {
+                *outFailureDescription = @"Malformed request: expected a protocol version.";
+                return nil;
+            }
+            
+            uint32_t version = (uint32_t)CLKServerDecodeInteger(payload.bytes);
+            if (version != CLKServerProtocolVersion) {
+                *outFailureDescription = [NSString stringWithFormat:@"Unsupported protocol version %u (the server speaks version %u).", version, CLKServerProtocolVersion];
+                return nil;
+            }
+            
+            greeted = YES;
+            continue;
+        }
+        
+        if (type == CLKServerFrameTypeRun) {
+            if (workingDirectory == nil) {
+                *outFailureDescription = @"Malformed request: missing working directory.";
+                return nil;
+            }
+            
+            *outWorkingDirectory = workingDirectory;
+            *outEnvironment = environment;
+            return arguments;
+        }
+        
+        NSString *string = [[NSString alloc] initWithData:payload encoding:NSUTF8StringEncoding];
+        if (string == nil) {
+            *outFailureDescription = @"Malformed request: a string is not valid UTF-8.";
+            return nil;
+        }
+        
+        switch (type) {
+            case CLKServerFrameTypeWorkingDirectory:
+                workingDirectory = string;
+                break;
+            
+            case CLKServerFrameTypeArgument:
+                [arguments addObject:string];
+                break;
+            
+            case CLKServerFrameTypeEnvironment: {
+                NSRange separator = [string rangeOfString:@"="];
+                if (separator.location == NSNotFound || separator.location == 0) {
+                    *outFailureDescription = [NSString stringWithFormat:@"Malformed request: '%@' is not an environment variable.", string];
+                    return nil;
+                }
+                
+                environment[[string substringToIndex:separator.location]] = [string substringFromIndex:(separator.location + 1)];
+                break;
+            }
+            
+            default:
+                *outFailureDescription = [NSString stringWithFormat:@"Malformed request: unexpected frame type 0x%02x.", type];
+                return nil;
+        }
+    }
+    
+    *outFailureDescription = @"Malformed request: too many arguments.";
+    return nil;
+}
+
+@end
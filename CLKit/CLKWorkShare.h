@@ -0,0 +1,27 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// a worker's share of a job: the half-open index range [begin, end) packed as (begin << 32) | end.
+// the owner takes from the front and thieves take from the back, each with a compare-and-swap
+// on the whole range. every index is handed out exactly once, so a range never returns to a
+// value a stale reader could mistake for current.
+typedef struct {
+    _Atomic uint64_t range;
+    char padding[64 - sizeof(uint64_t)]; // keep each worker's range on its own cache line
+} CLKWorkShare;
+
+BOOL CLKWorkShareTakeFront(CLKWorkShare *share, uint32_t *outIndex);
+BOOL CLKWorkShareSteal(CLKWorkShare *shares, NSUInteger shareCount, NSUInteger thiefIndex);
+
+// calls `block` once for every index in [0, count) from at most `workerCount` threads and returns when
+// all of the calls have. the indexes start out divided evenly among the workers; a worker that finishes
+// its share steals half of the remaining share of another, so a few expensive indexes don't leave the
+// rest of the pool idle. each call runs in its own autorelease pool.
+void CLKWorkShareApply(uint32_t count, NSUInteger workerCount, NS_NOESCAPE void (^block)(uint32_t idx));
+
+NS_ASSUME_NONNULL_END
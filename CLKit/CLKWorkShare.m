@@ -0,0 +1,113 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import "CLKWorkShare.h"
+
+#import <dispatch/dispatch.h>
+#import <stdatomic.h>
+
+#import "CLKAssert.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static inline uint64_t CLKWorkRangeMake(uint32_t begin, uint32_t end);
+static inline uint32_t CLKWorkRangeBegin(uint64_t range);
+static inline uint32_t CLKWorkRangeEnd(uint64_t range);
+
+NS_ASSUME_NONNULL_END
+
+static inline uint64_t CLKWorkRangeMake(uint32_t begin, uint32_t end)
+{
+    return (((uint64_t)begin << 32) | end);
+}
+
+static inline uint32_t CLKWorkRangeBegin(uint64_t range)
+{
+    return (uint32_t)(range >> 32);
+}
+
+static inline uint32_t CLKWorkRangeEnd(uint64_t range)
+{
+    return (uint32_t)range;
+}
+
+BOOL CLKWorkShareTakeFront(CLKWorkShare *share, uint32_t *outIndex)
+{
+    uint64_t range = atomic_load_explicit(&share->range, memory_order_acquire);
+    for (;;) {
+        uint32_t begin = CLKWorkRangeBegin(range);
+        uint32_t end = CLKWorkRangeEnd(range);
+        if (begin >= end) {
+            return NO;
+        }
+        
+        // on failure `range` is reloaded with the current value
+        if (atomic_compare_exchange_weak_explicit(&share->range, &range, CLKWorkRangeMake(begin + 1, end), memory_order_acq_rel, memory_order_acquire)) {
+            *outIndex = begin;
+            return YES;
+        }
+    }
+}
+
+BOOL CLKWorkShareSteal(CLKWorkShare *shares, NSUInteger shareCount, NSUInteger thiefIndex)
+{
+    for (NSUInteger i = 1 ; i < shareCount ; i++) {
+        CLKWorkShare *victim = &shares[(thiefIndex + i) % shareCount];
+        uint64_t range = atomic_load_explicit(&victim->range, memory_order_acquire);
+        for (;;) {
+            uint32_t begin = CLKWorkRangeBegin(range);
+            uint32_t end = CLKWorkRangeEnd(range);
+            if (begin >= end) {
+                break;
+            }
+            
+            // take the back half, rounding up so a single remaining item can be stolen
+            uint32_t split = end - ((end - begin + 1) / 2);
+            if (atomic_compare_exchange_weak_explicit(&victim->range, &range, CLKWorkRangeMake(begin, split), memory_order_acq_rel, memory_order_acquire)) {
+                // the thief's own share is empty, so no other worker can be taking from it
+                atomic_store_explicit(&shares[thiefIndex].range, CLKWorkRangeMake(split, end), memory_order_release);
+                return YES;
+            }
+        }
+    }
+    
+    // every share looked empty. work in flight between a victim and a thief may have been missed,
+    // but its new owner will finish it.
+    return NO;
+}
+
+void CLKWorkShareApply(uint32_t count, NSUInteger workerCount, void (^block)(uint32_t))
+{
+    CLKHardParameterAssert(workerCount > 0);
+    
+    if (count == 0) {
+        return;
+    }
+    
+    workerCount = MIN(workerCount, (NSUInteger)count);
+    CLKWorkShare *shares = calloc(workerCount, sizeof(CLKWorkShare));
+    for (NSUInteger w = 0 ; w < workerCount ; w++) {
+        uint32_t begin = (uint32_t)((count * w) / workerCount);
+        uint32_t end = (uint32_t)((count * (w + 1)) / workerCount);
+        atomic_init(&shares[w].range, CLKWorkRangeMake(begin, end));
+    }
+    
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_apply(workerCount, queue, ^(size_t workerIndex) {
+        for (;;) {
+            uint32_t idx;
+            while (CLKWorkShareTakeFront(&shares[workerIndex], &idx)) {
+                @autoreleasepool {
+                    block(idx);
+                }
+            }
+            
+            if (!CLKWorkShareSteal(shares, workerCount, workerIndex)) {
+                break;
+            }
+        }
+    });
+    
+    free(shares);
+}
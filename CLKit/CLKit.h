@@ -2,14 +2,23 @@
 //  Copyright (c) 2018 Plastic Pulse. All rights reserved.
 //
 
+#import "CLKArgumentEvent.h"
 #import "CLKArgumentManifest.h"
 #import "CLKArgumentParser.h"
 #import "CLKArgumentTransformer.h"
+#import "CLKBatchParser.h"
+#import "CLKCommandContext.h"
 #import "CLKCommandResult.h"
 #import "CLKError.h"
 #import "CLKOption.h"
 #import "CLKOptionGroup.h"
+#import "CLKOptionSchema.h"
+#import "CLKOptionSource.h"
+#import "CLKParseProfile.h"
+#import "CLKSchemaArchive.h"
 #import "CLKVerb.h"
 #import "CLKVerbDepot.h"
+#import "CLKVerbDescriptor.h"
 #import "CLKVerbFamily.h"
+#import "CLKVerbServer.h"
 #import "NSArray+CLKAdditions.h"
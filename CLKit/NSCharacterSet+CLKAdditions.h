@@ -8,6 +8,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface NSCharacterSet (CLKAdditions)
 
+// these are immutable copies, so they can be read from any thread
 @property (class, readonly) NSCharacterSet *clk_optionFlagIllegalCharacterSet;
 @property (class, readonly) NSCharacterSet *clk_optionNameIllegalCharacterSet;
 @property (class, readonly) NSCharacterSet *clk_parameterOptionAssignmentCharacterSet;
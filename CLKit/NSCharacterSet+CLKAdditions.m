@@ -4,17 +4,20 @@
 
 #import "NSCharacterSet+CLKAdditions.h"
 
+#import <dispatch/dispatch.h>
+
 @implementation NSCharacterSet (CLKAdditions)
 
 + (NSCharacterSet *)clk_optionFlagIllegalCharacterSet
 {
-    static NSMutableCharacterSet *optionFlagIllegalCharacterSet;
+    static NSCharacterSet *optionFlagIllegalCharacterSet;
     static dispatch_once_t once;
     dispatch_once(&once, ^{
-        optionFlagIllegalCharacterSet = [NSMutableCharacterSet characterSetWithCharactersInString:@"-"];
-        [optionFlagIllegalCharacterSet formUnionWithCharacterSet:self.clk_parameterOptionAssignmentCharacterSet];
+        NSMutableCharacterSet *set = [NSMutableCharacterSet characterSetWithCharactersInString:@"-"];
+        [set formUnionWithCharacterSet:self.clk_parameterOptionAssignmentCharacterSet];
         // [?] should decimalDigitCharacterSet be illegal?
-        [optionFlagIllegalCharacterSet formUnionWithCharacterSet:NSCharacterSet.whitespaceAndNewlineCharacterSet];
+        [set formUnionWithCharacterSet:NSCharacterSet.whitespaceAndNewlineCharacterSet];
+        optionFlagIllegalCharacterSet = [set copy];
     });
     
     return optionFlagIllegalCharacterSet;
@@ -22,11 +25,12 @@
 
 + (NSCharacterSet *)clk_optionNameIllegalCharacterSet
 {
-    static NSMutableCharacterSet *optionNameIllegalCharacterSet;
+    static NSCharacterSet *optionNameIllegalCharacterSet;
     static dispatch_once_t once;
     dispatch_once(&once, ^{
-        optionNameIllegalCharacterSet = NSMutableCharacterSet.whitespaceAndNewlineCharacterSet;
-        [optionNameIllegalCharacterSet formUnionWithCharacterSet:self.clk_parameterOptionAssignmentCharacterSet];
+        NSMutableCharacterSet *set = NSMutableCharacterSet.whitespaceAndNewlineCharacterSet;
+        [set formUnionWithCharacterSet:self.clk_parameterOptionAssignmentCharacterSet];
+        optionNameIllegalCharacterSet = [set copy];
     });
     
     return optionNameIllegalCharacterSet;
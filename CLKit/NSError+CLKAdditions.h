@@ -13,6 +13,10 @@ NS_ASSUME_NONNULL_BEGIN
 + (instancetype)clk_POSIXErrorWithCode:(int)code description:(NSString *)fmt, ... NS_FORMAT_FUNCTION(2, 3);
 + (instancetype)clk_CLKErrorWithCode:(CLKError)code description:(NSString *)fmt, ... NS_FORMAT_FUNCTION(2, 3);
 
+// as above, with `suggestions` under CLKSuggestionsErrorKey when there are any
++ (instancetype)clk_POSIXErrorWithCode:(int)code suggestions:(nullable NSArray<NSString *> *)suggestions description:(NSString *)fmt, ... NS_FORMAT_FUNCTION(3, 4);
++ (instancetype)clk_CLKErrorWithCode:(CLKError)code suggestions:(nullable NSArray<NSString *> *)suggestions description:(NSString *)fmt, ... NS_FORMAT_FUNCTION(3, 4);
+
 @end
 
 NS_ASSUME_NONNULL_END
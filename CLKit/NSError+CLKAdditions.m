@@ -28,4 +28,26 @@
     return [self errorWithDomain:CLKErrorDomain code:code userInfo:info];
 }
 
++ (instancetype)clk_POSIXErrorWithCode:(int)code suggestions:(NSArray<NSString *> *)suggestions description:(NSString *)fmt, ...
+{
+    va_list ap;
+    va_start(ap, fmt);
+    NSString *description = [[NSString alloc] initWithFormat: fmt arguments: ap];
+    va_end(ap);
+    
+    NSDictionary *info = (suggestions.count > 0 ? @{ NSLocalizedDescriptionKey : description, CLKSuggestionsErrorKey : [suggestions copy] } : @{ NSLocalizedDescriptionKey : description });
+    return [self errorWithDomain:NSPOSIXErrorDomain code:code userInfo:info];
+}
+
++ (instancetype)clk_CLKErrorWithCode:(CLKError)code suggestions:(NSArray<NSString *> *)suggestions description:(NSString *)fmt, ...
+{
+    va_list ap;
+    va_start(ap, fmt);
+    NSString *description = [[NSString alloc] initWithFormat: fmt arguments: ap];
+    va_end(ap);
+    
+    NSDictionary *info = (suggestions.count > 0 ? @{ NSLocalizedDescriptionKey : description, CLKSuggestionsErrorKey : [suggestions copy] } : @{ NSLocalizedDescriptionKey : description });
+    return [self errorWithDomain:CLKErrorDomain code:code userInfo:info];
+}
+
 @end
@@ -5,6 +5,7 @@
 #import <XCTest/XCTest.h>
 
 #import "CLKArgumentTransformer.h"
+#import "NSError+CLKAdditions.h"
 
 @interface Test_ArgumentTransformers : XCTestCase
 
@@ -98,4 +99,211 @@
     XCTAssertNil(num);
 }
 
+- (void)testInt64ArgumentTransformer
+{
+    CLKInt64ArgumentTransformer *transformer = [[CLKInt64ArgumentTransformer alloc] init];
+    
+    NSDictionary<NSString *, NSNumber *> *values = @{
+        @"0" : @(0),
+        @"-666" : @(-666),
+        @"+666" : @(666),
+        @"010" : @(10),
+        @"0x1F" : @(31),
+        @"-0x10" : @(-16),
+        @"0o777" : @(511),
+        @"9223372036854775807" : @(INT64_MAX),
+        @"-9223372036854775808" : @(INT64_MIN)
+    };
+    
+    [values enumerateKeysAndObjectsUsingBlock:^(NSString *argument, NSNumber *expectedValue, __unused BOOL *outStop) {
+        NSError *error = nil;
+        NSNumber *num = [transformer transformedArgument:argument error:&error];
+        XCTAssertEqual(num.longLongValue, expectedValue.longLongValue, @"%@", argument);
+        XCTAssertNil(error);
+    }];
+    
+    for (NSString *argument in @[ @"", @"-", @"6.66", @"barf", @"666barf", @" 666", @"666 ", @"0x", @"0o8", @"0b101", @"--5" ]) {
+        NSError *error = nil;
+        XCTAssertNil([transformer transformedArgument:argument error:&error], @"%@", argument);
+        XCTAssertEqualObjects(error, ([NSError clk_POSIXErrorWithCode:EINVAL description:@"couldn't coerce '%@' to a 64-bit integer value", argument]));
+    }
+    
+    for (NSString *argument in @[ @"9223372036854775808", @"-9223372036854775809", @"0x8000000000000000", @"99999999999999999999999999" ]) {
+        NSError *error = nil;
+        XCTAssertNil([transformer transformedArgument:argument error:&error], @"%@", argument);
+        XCTAssertEqualObjects(error, ([NSError clk_POSIXErrorWithCode:ERANGE description:@"couldn't coerce '%@' to a 64-bit integer value: value out of range", argument]));
+    }
+    
+    XCTAssertNil([transformer transformedArgument:@"barf" error:nil]);
+}
+
+- (void)testUInt64ArgumentTransformer
+{
+    CLKUInt64ArgumentTransformer *transformer = [[CLKUInt64ArgumentTransformer alloc] init];
+    
+    // every power of ten and its predecessor, which puts the end of the number at every offset
+    // relative to the eight-digit blocks
+    uint64_t power = 1;
+    for (int i = 0 ; i < 20 ; i++) {
+        for (uint64_t value = (power - 1) ; value <= power ; value++) {
+            NSString *argument = [NSString stringWithFormat:@"%llu", (unsigned long long)value];
+            NSNumber *num = [transformer transformedArgument:argument error:nil];
+            XCTAssertEqual(num.unsignedLongLongValue, value, @"%@", argument);
+        }
+        
+        if (i < 19) {
+            power *= 10;
+        }
+    }
+    
+    NSError *error = nil;
+    NSNumber *num = [transformer transformedArgument:@"18446744073709551615" error:&error];
+    XCTAssertEqual(num.unsignedLongLongValue, UINT64_MAX);
+    XCTAssertNil(error);
+    
+    num = [transformer transformedArgument:@"0xFFFFFFFFFFFFFFFF" error:&error];
+    XCTAssertEqual(num.unsignedLongLongValue, UINT64_MAX);
+    XCTAssertNil(error);
+    
+    num = [transformer transformedArgument:@"00000000000000000000000042" error:&error];
+    XCTAssertEqual(num.unsignedLongLongValue, 42ULL);
+    XCTAssertNil(error);
+    
+    // a non-digit inside an eight-digit block
+    num = [transformer transformedArgument:@"1234567x90" error:&error];
+    XCTAssertNil(num);
+    XCTAssertEqualObjects(error, [NSError clk_POSIXErrorWithCode:EINVAL description:@"couldn't coerce '1234567x90' to an unsigned 64-bit integer value"]);
+    
+    num = [transformer transformedArgument:@"-1" error:&error];
+    XCTAssertNil(num);
+    XCTAssertEqualObjects(error, [NSError clk_POSIXErrorWithCode:EINVAL description:@"couldn't coerce '-1' to an unsigned 64-bit integer value"]);
+    
+    num = [transformer transformedArgument:@"18446744073709551616" error:&error];
+    XCTAssertNil(num);
+    XCTAssertEqualObjects(error, [NSError clk_POSIXErrorWithCode:ERANGE description:@"couldn't coerce '18446744073709551616' to an unsigned 64-bit integer value: value out of range"]);
+    
+    num = [transformer transformedArgument:@"0x10000000000000000" error:&error];
+    XCTAssertNil(num);
+    XCTAssertEqualObjects(error, [NSError clk_POSIXErrorWithCode:ERANGE description:@"couldn't coerce '0x10000000000000000' to an unsigned 64-bit integer value: value out of range"]);
+}
+
+- (void)testDoubleArgumentTransformer
+{
+    CLKDoubleArgumentTransformer *transformer = [[CLKDoubleArgumentTransformer alloc] init];
+    
+    NSDictionary<NSString *, NSNumber *> *values = @{
+        @"0.7" : @(0.7),
+        @"-8.19" : @(-8.19),
+        @"7" : @(7.0),
+        @"7." : @(7.0),
+        @".25" : @(0.25),
+        @"1e3" : @(1000.0),
+        @"2.5E-1" : @(0.25),
+        @"16777217" : @(16777217.0) // not representable as a float
+    };
+    
+    [values enumerateKeysAndObjectsUsingBlock:^(NSString *argument, NSNumber *expectedValue, __unused BOOL *outStop) {
+        NSError *error = nil;
+        NSNumber *num = [transformer transformedArgument:argument error:&error];
+        XCTAssertEqual(num.doubleValue, expectedValue.doubleValue, @"%@", argument);
+        XCTAssertNil(error);
+    }];
+    
+    for (NSString *argument in @[ @"", @".", @"6.6.6", @"barf", @"6.66barf", @"1e", @" 1", @"inf", @"nan", @"0x1p3" ]) {
+        NSError *error = nil;
+        XCTAssertNil([transformer transformedArgument:argument error:&error], @"%@", argument);
+        XCTAssertEqualObjects(error, ([NSError clk_POSIXErrorWithCode:EINVAL description:@"couldn't coerce '%@' to a floating-point value", argument]));
+    }
+    
+    NSError *error = nil;
+    XCTAssertNil([transformer transformedArgument:@"1e999" error:&error]);
+    XCTAssertEqualObjects(error, [NSError clk_POSIXErrorWithCode:ERANGE description:@"couldn't coerce '1e999' to a floating-point value: value out of range"]);
+}
+
+- (void)testByteSizeArgumentTransformer
+{
+    CLKByteSizeArgumentTransformer *transformer = [[CLKByteSizeArgumentTransformer alloc] init];
+    
+    NSDictionary<NSString *, NSNumber *> *values = @{
+        @"512" : @(512),
+        @"512B" : @(512),
+        @"64K" : @(64 * 1024),
+        @"64k" : @(64 * 1024),
+        @"64KiB" : @(64 * 1024),
+        @"1500KB" : @(1500 * 1000),
+        @"2GiB" : @(2ULL * 1024 * 1024 * 1024),
+        @"3M" : @(3 * 1024 * 1024),
+        @"3mb" : @(3 * 1000 * 1000),
+        @"15E" : @(15ULL << 60)
+    };
+    
+    [values enumerateKeysAndObjectsUsingBlock:^(NSString *argument, NSNumber *expectedValue, __unused BOOL *outStop) {
+        NSError *error = nil;
+        NSNumber *num = [transformer transformedArgument:argument error:&error];
+        XCTAssertEqual(num.unsignedLongLongValue, expectedValue.unsignedLongLongValue, @"%@", argument);
+        XCTAssertNil(error);
+    }];
+    
+    for (NSString *argument in @[ @"", @"K", @"1.5G", @"-1K", @"1X", @"1KiBs", @"1BB", @"1 K" ]) {
+        NSError *error = nil;
+        XCTAssertNil([transformer transformedArgument:argument error:&error], @"%@", argument);
+        XCTAssertEqualObjects(error, ([NSError clk_POSIXErrorWithCode:EINVAL description:@"couldn't coerce '%@' to a byte size", argument]));
+    }
+    
+    NSError *error = nil;
+    XCTAssertNil([transformer transformedArgument:@"16EiB" error:&error]);
+    XCTAssertEqualObjects(error, [NSError clk_POSIXErrorWithCode:ERANGE description:@"couldn't coerce '16EiB' to a byte size: value out of range"]);
+}
+
+- (void)testDurationArgumentTransformer
+{
+    CLKDurationArgumentTransformer *transformer = [[CLKDurationArgumentTransformer alloc] init];
+    
+    NSDictionary<NSString *, NSNumber *> *values = @{
+        @"0" : @(0),
+        @"250ms" : @(0.25),
+        @"1h30m" : @(5400),
+        @"1.5s" : @(1.5),
+        @".5s" : @(0.5),
+        @"2d" : @(172800),
+        @"1m1ms" : @(60.001),
+        @"10us" : @(0.00001),
+        @"10\u00B5s" : @(0.00001),
+        @"3ns" : @(0.000000003)
+    };
+    
+    [values enumerateKeysAndObjectsUsingBlock:^(NSString *argument, NSNumber *expectedValue, __unused BOOL *outStop) {
+        NSError *error = nil;
+        NSNumber *num = [transformer transformedArgument:argument error:&error];
+        XCTAssertEqualWithAccuracy(num.doubleValue, expectedValue.doubleValue, 1e-12, @"%@", argument);
+        XCTAssertNil(error);
+    }];
+    
+    for (NSString *argument in @[ @"", @"5", @"s", @"5.s", @"1x", @"1n", @"-5s", @"5s " ]) {
+        NSError *error = nil;
+        XCTAssertNil([transformer transformedArgument:argument error:&error], @"%@", argument);
+        XCTAssertEqualObjects(error, ([NSError clk_POSIXErrorWithCode:EINVAL description:@"couldn't coerce '%@' to a duration", argument]));
+    }
+    
+    NSError *error = nil;
+    XCTAssertNil([transformer transformedArgument:@"200000d" error:&error]);
+    XCTAssertEqualObjects(error, [NSError clk_POSIXErrorWithCode:ERANGE description:@"couldn't coerce '200000d' to a duration: value out of range"]);
+}
+
+- (void)testNumericTransformerPerformance
+{
+    // a recurrent numeric option with a value for every one of 100k occurrences
+    NSMutableArray<NSString *> *arguments = [NSMutableArray arrayWithCapacity:100000];
+    for (NSUInteger i = 0 ; i < 100000 ; i++) {
+        [arguments addObject:[NSString stringWithFormat:@"%lu", (unsigned long)(i * 7919)]];
+    }
+    
+    CLKInt64ArgumentTransformer *transformer = [[CLKInt64ArgumentTransformer alloc] init];
+    [self measureBlock:^{
+        for (NSString *argument in arguments) {
+            [transformer transformedArgument:argument error:nil];
+        }
+    }];
+}
+
 @end
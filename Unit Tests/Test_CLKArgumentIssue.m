@@ -103,6 +103,58 @@ NS_ASSUME_NONNULL_END
     XCTAssertEqualObjects(issue.salientOptions, (@[ @"flarn", @"barf" ]));
 }
 
+- (void)testDeferredDescription
+{
+    CLKArgumentIssue *issue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL salientOption:@"flarn" description:@"expected argument for option '%@'" argument:@"--flarn"];
+    XCTAssertEqualObjects(issue.domain, NSPOSIXErrorDomain);
+    XCTAssertEqual(issue.code, EINVAL);
+    XCTAssertEqualObjects(issue.salientOptions, @[ @"flarn" ]);
+    XCTAssertFalse(issue.isValidationIssue);
+    NSError *expectedError = [NSError clk_POSIXErrorWithCode:EINVAL description:@"expected argument for option '--flarn'"];
+    XCTAssertEqualObjects(issue.error, expectedError);
+    XCTAssertEqualObjects(issue, [CLKArgumentIssue issueWithError:expectedError salientOption:@"flarn"]);
+    XCTAssertEqual(issue.hash, [CLKArgumentIssue issueWithError:expectedError salientOption:@"flarn"].hash);
+    
+    // the error is built once
+    XCTAssertTrue(issue.error == issue.error);
+    
+    issue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL salientOption:nil description:@"encountered zero-length argument" argument:nil];
+    XCTAssertNil(issue.salientOptions);
+    XCTAssertEqualObjects(issue.error, [NSError clk_POSIXErrorWithCode:EINVAL description:@"encountered zero-length argument"]);
+    
+    // arrays of option names are written as lists
+    NSArray *options = @[ @"flarn", @"barf", @"quone" ];
+    issue = [CLKArgumentIssue issueWithCLKErrorCode:CLKErrorMutuallyExclusiveOptionsPresent salientOptions:options description:@"--%@: mutually exclusive options encountered" argument:options argument:nil];
+    XCTAssertEqualObjects(issue.domain, CLKErrorDomain);
+    XCTAssertEqual(issue.code, CLKErrorMutuallyExclusiveOptionsPresent);
+    XCTAssertTrue(issue.isValidationIssue);
+    expectedError = [NSError clk_CLKErrorWithCode:CLKErrorMutuallyExclusiveOptionsPresent description:@"--flarn --barf --quone: mutually exclusive options encountered"];
+    XCTAssertEqualObjects(issue.error, expectedError);
+    
+    issue = [CLKArgumentIssue issueWithCLKErrorCode:CLKErrorRequiredOptionNotProvided salientOptions:@[ @"flarn" ] description:@"--%@ is required when using --%@" argument:@"flarn" argument:@"barf"];
+    expectedError = [NSError clk_CLKErrorWithCode:CLKErrorRequiredOptionNotProvided description:@"--flarn is required when using --barf"];
+    XCTAssertEqualObjects(issue.error, expectedError);
+}
+
+- (void)testSuggestions
+{
+    CLKArgumentIssue *issue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL description:@"unrecognized option: '%@'" argument:@"--flarm" suggestions:@[ @"--flarn", @"--flark" ]];
+    XCTAssertNil(issue.salientOptions);
+    XCTAssertEqualObjects(issue.suggestions, (@[ @"--flarn", @"--flark" ]));
+    NSError *expectedError = [NSError clk_POSIXErrorWithCode:EINVAL suggestions:@[ @"--flarn", @"--flark" ] description:@"unrecognized option: '--flarm'; did you mean '--flarn' or '--flark'?"];
+    XCTAssertEqualObjects(issue.error, expectedError);
+    XCTAssertEqualObjects(issue.error.userInfo[CLKSuggestionsErrorKey], (@[ @"--flarn", @"--flark" ]));
+    
+    // issues built from errors take the errors' suggestions
+    XCTAssertEqualObjects([CLKArgumentIssue issueWithError:expectedError].suggestions, (@[ @"--flarn", @"--flark" ]));
+    
+    // no suggestions, no offer
+    issue = [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL description:@"unrecognized option: '%@'" argument:@"--xyzzy" suggestions:@[]];
+    XCTAssertNil(issue.suggestions);
+    XCTAssertEqualObjects(issue.error, [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '--xyzzy'"]);
+    XCTAssertNil([CLKArgumentIssue issueWithError:[self flarnError]].suggestions);
+}
+
 - (void)testDebugDescription
 {
     CLKArgumentIssue *issue = [CLKArgumentIssue issueWithError:[self flarnError]];
@@ -5,6 +5,7 @@
 #import <XCTest/XCTest.h>
 
 #import "CLKArgumentManifest_Private.h"
+#import "CLKBitset.h"
 #import "CLKOption.h"
 #import "CLKOptionRegistry.h"
 
@@ -118,6 +119,45 @@ NS_ASSUME_NONNULL_END
     XCTAssertNil(manifest[@"xyzzy"]);
 }
 
+- (void)testInterleavedParameterOptions
+{
+    CLKOption *lorem = [CLKOption parameterOptionWithName:@"lorem" flag:@"l" required:NO recurrent:YES transformer:nil];
+    CLKOption *ipsum = [CLKOption parameterOptionWithName:@"ipsum" flag:@"i" required:NO recurrent:YES transformer:nil];
+    CLKOption *oneshot = [CLKOption parameterOptionWithName:@"oneshot" flag:nil];
+    CLKArgumentManifest *manifest = [self manifestWithRegisteredOptions:@[ lorem, ipsum, oneshot ]];
+    CLKOptionHandle ipsumHandle = [manifest handleForOptionNamed:@"ipsum"];
+    
+    [manifest accumulateArgument:@"alpha" forParameterOptionNamed:ipsum.name];
+    [manifest accumulateArgument:@"bravo" forParameterOptionNamed:lorem.name];
+    [manifest accumulateArgument:@"charlie" forParameterOptionNamed:ipsum.name];
+    [manifest accumulateArgument:@"bang" forParameterOptionNamed:oneshot.name];
+    [manifest accumulateArgument:@"delta" forParameterOptionNamed:lorem.name];
+    XCTAssertEqualObjects(manifest[@"lorem"], (@[ @"bravo", @"delta" ]));
+    XCTAssertEqualObjects(manifest[@"ipsum"], (@[ @"alpha", @"charlie" ]));
+    XCTAssertEqualObjects(manifest[@"oneshot"], @"bang");
+    
+    // arguments accumulated after a read follow the ones grouped by it
+    [manifest accumulateArgument:@"echo" forParameterOptionNamed:ipsum.name];
+    [manifest accumulateArgument:@"foxtrot" forParameterOptionNamed:lorem.name];
+    [manifest accumulateArgument:@"golf" forParameterOptionNamed:ipsum.name];
+    XCTAssertEqualObjects([manifest argumentAtIndex:3 forOption:ipsumHandle], @"golf");
+    XCTAssertEqualObjects(manifest[@"lorem"], (@[ @"bravo", @"delta", @"foxtrot" ]));
+    XCTAssertEqualObjects(manifest[@"ipsum"], (@[ @"alpha", @"charlie", @"echo", @"golf" ]));
+    XCTAssertEqualObjects(manifest[@"oneshot"], @"bang");
+    
+    // grouping explicitly leaves nothing for reads to do
+    [manifest accumulateArgument:@"hotel" forParameterOptionNamed:lorem.name];
+    [manifest groupAccumulatedArguments];
+    [manifest groupAccumulatedArguments];
+    NSDictionary *expectedDict = @{
+        @"lorem" : @[ @"bravo", @"delta", @"foxtrot", @"hotel" ],
+        @"ipsum" : @[ @"alpha", @"charlie", @"echo", @"golf" ],
+        @"oneshot" : @[ @"bang" ]
+    };
+    
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, expectedDict);
+}
+
 - (void)testPositionalArguments
 {
     CLKOption *parameterOption = [CLKOption parameterOptionWithName:@"parameter" flag:@"p"];
@@ -184,4 +224,126 @@ NS_ASSUME_NONNULL_END
     XCTAssertEqual([manifest occurrencesOfOptionNamed:switchOptionBravo.name], 0UL);
 }
 
+- (void)testTypedAccess
+{
+    CLKOption *flarn = [CLKOption optionWithName:@"flarn" flag:nil];
+    CLKOption *lorem = [CLKOption parameterOptionWithName:@"lorem" flag:@"l" required:NO recurrent:YES transformer:nil];
+    CLKOption *ipsum = [CLKOption parameterOptionWithName:@"ipsum" flag:@"i" required:NO recurrent:YES transformer:nil];
+    CLKOption *never = [CLKOption parameterOptionWithName:@"never" flag:nil];
+    CLKArgumentManifest *manifest = [self manifestWithRegisteredOptions:@[ flarn, lorem, ipsum, never ]];
+    
+    CLKOptionHandle flarnHandle = [manifest handleForOptionNamed:@"flarn"];
+    CLKOptionHandle loremHandle = [manifest handleForOptionNamed:@"lorem"];
+    CLKOptionHandle ipsumHandle = [manifest handleForOptionNamed:@"ipsum"];
+    CLKOptionHandle neverHandle = [manifest handleForOptionNamed:@"never"];
+    CLKOptionHandle xyzzyHandle = [manifest handleForOptionNamed:@"xyzzy"];
+    XCTAssertEqual(xyzzyHandle, CLKOptionHandleNone);
+    
+    XCTAssertFalse([manifest hasOption:flarnHandle]);
+    XCTAssertEqual([manifest switchCountForOption:flarnHandle], 0UL);
+    XCTAssertEqual([manifest argumentCountForOption:loremHandle], 0UL);
+    
+    // interleave the arguments of different options to exercise the shared slab
+    [manifest accumulateArgument:@"alpha" forParameterOptionNamed:@"ipsum"];
+    [manifest accumulateArgument:@"bravo" forParameterOptionNamed:@"lorem"];
+    [manifest accumulateSwitchOptionNamed:@"flarn"];
+    [manifest accumulateArgument:@"charlie" forParameterOptionNamed:@"ipsum"];
+    [manifest accumulateArgument:@"delta" forParameterOptionNamed:@"lorem"];
+    [manifest accumulateArgument:@"echo" forParameterOptionNamed:@"ipsum"];
+    [manifest accumulateSwitchOptionNamed:@"flarn"];
+    
+    XCTAssertTrue([manifest hasOption:flarnHandle]);
+    XCTAssertTrue([manifest hasOption:loremHandle]);
+    XCTAssertFalse([manifest hasOption:neverHandle]);
+    XCTAssertFalse([manifest hasOption:xyzzyHandle]);
+    
+    XCTAssertEqual([manifest switchCountForOption:flarnHandle], 2UL);
+    XCTAssertEqual([manifest switchCountForOption:xyzzyHandle], 0UL);
+    XCTAssertEqual([manifest argumentCountForOption:loremHandle], 2UL);
+    XCTAssertEqual([manifest argumentCountForOption:ipsumHandle], 3UL);
+    XCTAssertEqual([manifest argumentCountForOption:neverHandle], 0UL);
+    XCTAssertEqual([manifest argumentCountForOption:xyzzyHandle], 0UL);
+    
+    XCTAssertEqualObjects([manifest argumentAtIndex:0 forOption:loremHandle], @"bravo");
+    XCTAssertEqualObjects([manifest argumentAtIndex:1 forOption:loremHandle], @"delta");
+    XCTAssertEqualObjects([manifest argumentAtIndex:0 forOption:ipsumHandle], @"alpha");
+    XCTAssertEqualObjects([manifest argumentAtIndex:1 forOption:ipsumHandle], @"charlie");
+    XCTAssertEqualObjects([manifest argumentAtIndex:2 forOption:ipsumHandle], @"echo");
+    XCTAssertThrows([manifest argumentAtIndex:2 forOption:loremHandle]);
+    XCTAssertThrows([manifest argumentAtIndex:0 forOption:neverHandle]);
+    XCTAssertThrows([manifest argumentAtIndex:0 forOption:xyzzyHandle]);
+    XCTAssertThrows([manifest argumentAtIndex:0 forOption:flarnHandle]);
+    XCTAssertThrows([manifest switchCountForOption:loremHandle]);
+    XCTAssertThrows([manifest argumentCountForOption:flarnHandle]);
+    
+    // the keyed-subscript layer reads the same storage
+    XCTAssertEqualObjects(manifest[@"lorem"], (@[ @"bravo", @"delta" ]));
+    XCTAssertEqualObjects(manifest[@"ipsum"], (@[ @"alpha", @"charlie", @"echo" ]));
+    XCTAssertEqualObjects(manifest[@"flarn"], @(2));
+}
+
+- (void)testCountedOccurrences
+{
+    CLKOption *lorem = [CLKOption parameterOptionWithName:@"lorem" flag:@"l" required:NO recurrent:YES transformer:nil];
+    CLKOption *ipsum = [CLKOption parameterOptionWithName:@"ipsum" flag:@"i" required:NO recurrent:YES transformer:nil];
+    CLKOption *oneshot = [CLKOption parameterOptionWithName:@"oneshot" flag:nil];
+    CLKArgumentManifest *manifest = [self manifestWithRegisteredOptions:@[ lorem, ipsum, oneshot ]];
+    CLKOptionHandle loremHandle = [manifest handleForOptionNamed:@"lorem"];
+    CLKOptionHandle ipsumHandle = [manifest handleForOptionNamed:@"ipsum"];
+    
+    // occurrences counted without their arguments are reported as occurrences, but the
+    // arguments stored after them must not be read from the counted occurrences' positions
+    [manifest accumulateOccurrenceOfParameterOptionNamed:@"lorem"];
+    [manifest accumulateOccurrenceOfParameterOptionNamed:@"oneshot"];
+    [manifest accumulateOccurrenceOfParameterOptionNamed:@"lorem"];
+    [manifest accumulateArgument:@"alpha" forParameterOptionNamed:@"ipsum"];
+    
+    XCTAssertTrue([manifest hasOption:loremHandle]);
+    XCTAssertEqual([manifest occurrencesOfOptionNamed:@"lorem"], 2UL);
+    XCTAssertEqual([manifest occurrencesOfOptionNamed:@"oneshot"], 1UL);
+    XCTAssertTrue(CLKBitsetTest(manifest.recurringOptions, loremHandle));
+    
+    XCTAssertEqual([manifest argumentCountForOption:loremHandle], 0UL);
+    XCTAssertEqual([manifest argumentCountForOption:ipsumHandle], 1UL);
+    XCTAssertThrows([manifest argumentAtIndex:0 forOption:loremHandle]);
+    XCTAssertEqualObjects([manifest argumentAtIndex:0 forOption:ipsumHandle], @"alpha");
+    XCTAssertNil(manifest[@"lorem"]);
+    XCTAssertNil(manifest[@"oneshot"]);
+    XCTAssertEqualObjects(manifest[@"ipsum"], @[ @"alpha" ]);
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, (@{ @"ipsum" : @[ @"alpha" ] }));
+}
+
+- (void)testReset
+{
+    CLKOption *flarn = [CLKOption optionWithName:@"flarn" flag:nil];
+    CLKOption *lorem = [CLKOption parameterOptionWithName:@"lorem" flag:@"l" required:NO recurrent:YES transformer:nil];
+    CLKOption *ipsum = [CLKOption parameterOptionWithName:@"ipsum" flag:@"i" required:NO recurrent:YES transformer:nil];
+    CLKArgumentManifest *manifest = [self manifestWithRegisteredOptions:@[ flarn, lorem, ipsum ]];
+    
+    [manifest accumulateArgument:@"alpha" forParameterOptionNamed:@"ipsum"];
+    [manifest accumulateArgument:@"bravo" forParameterOptionNamed:@"lorem"];
+    [manifest accumulateSwitchOptionNamed:@"flarn"];
+    [manifest accumulateSwitchOptionNamed:@"flarn"];
+    [manifest accumulatePositionalArgument:@"charlie"];
+    
+    [manifest reset];
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, @{});
+    XCTAssertEqualObjects(manifest.accumulatedOptionNames, [NSSet set]);
+    XCTAssertEqualObjects(manifest.positionalArguments, @[]);
+    XCTAssertFalse([manifest hasOptionNamed:@"flarn"]);
+    XCTAssertEqual([manifest occurrencesOfOptionNamed:@"lorem"], 0UL);
+    XCTAssertNil(manifest[@"ipsum"]);
+    
+    // a reset manifest is built as a new one would be, including which options recur
+    [manifest accumulateArgument:@"delta" forParameterOptionNamed:@"lorem"];
+    [manifest accumulateSwitchOptionNamed:@"flarn"];
+    [manifest accumulatePositionalArgument:@"echo"];
+    XCTAssertEqualObjects(manifest[@"lorem"], @[ @"delta" ]);
+    XCTAssertNil(manifest[@"ipsum"]);
+    XCTAssertEqualObjects(manifest[@"flarn"], @(1));
+    XCTAssertEqualObjects(manifest.positionalArguments, @[ @"echo" ]);
+    
+    XCTAssertFalse(CLKBitsetTest(manifest.recurringOptions, [manifest handleForOptionNamed:@"flarn"]));
+}
+
 @end
@@ -4,12 +4,20 @@
 
 #import <XCTest/XCTest.h>
 
+#import <fcntl.h>
+#import <unistd.h>
+
 #import "AssignmentFormParsingSpec.h"
 #import "ArgumentParsingResultSpec.h"
-#import "CLKArgumentParser.h"
+#import "CLKArgumentManifest.h"
+#import "CLKArgumentManifest_Private.h"
+#import "CLKArgumentParser_Internal.h"
+#import "CLKArgumentStream.h"
 #import "CLKArgumentTransformer.h"
+#import "CLKArgumentVector.h"
 #import "CLKOption.h"
 #import "CLKOptionGroup.h"
+#import "CLKOptionSchema.h"
 #import "NSError+CLKAdditions.h"
 #import "StuntTransformer.h"
 #import "XCTestCase+CLKAdditions.h"
@@ -89,6 +97,112 @@
     [self performTestWithArgumentVector:@[ @"--foo", @"quone", @"-b", @"-f", @"flarn" ] options:options spec:spec];
 }
 
+- (void)testUnrecognizedOption_suggestions
+{
+    NSArray *options = @[
+         [CLKOption optionWithName:@"verbose" flag:@"v"],
+         [CLKOption optionWithName:@"version" flag:nil],
+         [CLKOption parameterOptionWithName:@"output" flag:@"o"],
+         [CLKOption parameterOptionWithName:@"outputs" flag:nil]
+    ];
+    
+    NSArray *argv = @[ @"--verbos", @"--outptu=flarn", @"--xyzzy", @"-x", @"-vx" ];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    XCTAssertNil([parser parseArguments]);
+    
+    // flags aren't offered suggestions
+    NSArray *expectedErrors = @[
+        [NSError clk_POSIXErrorWithCode:EINVAL suggestions:@[ @"--verbose" ] description:@"unrecognized option: '--verbos'; did you mean '--verbose'?"],
+        [NSError clk_POSIXErrorWithCode:EINVAL suggestions:@[ @"--output", @"--outputs" ] description:@"unrecognized option: '--outptu'; did you mean '--output' or '--outputs'?"],
+        [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '--xyzzy'"],
+        [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '-x'"],
+        [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '-x'"]
+    ];
+    
+    XCTAssertEqualObjects(parser.errors, expectedErrors);
+    XCTAssertEqualObjects(parser.errors[0].userInfo[CLKSuggestionsErrorKey], @[ @"--verbose" ]);
+    XCTAssertNil(parser.errors[2].userInfo[CLKSuggestionsErrorKey]);
+}
+
+- (void)testAbbreviatedOptionNames
+{
+    NSArray *options = @[
+         [CLKOption optionWithName:@"verbose" flag:@"v"],
+         [CLKOption optionWithName:@"version" flag:nil],
+         [CLKOption parameterOptionWithName:@"output" flag:@"o"],
+         [CLKOption parameterOptionWithName:@"outputs" flag:nil],
+         [CLKOption parameterOptionWithName:@"count" flag:@"c" required:NO recurrent:YES transformer:[CLKInt64ArgumentTransformer new]]
+    ];
+    
+    // off by default
+    NSArray *argv = @[ @"--verb", @"--cou", @"7" ];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    XCTAssertFalse(parser.abbreviatedOptionNamesEnabled);
+    XCTAssertNil([parser parseArguments]);
+    XCTAssertEqualObjects(parser.errors[0].localizedDescription, @"unrecognized option: '--verb'; did you mean '--verbose'?");
+    
+    parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    parser.abbreviatedOptionNamesEnabled = YES;
+    CLKArgumentManifest *manifest = [parser parseArguments];
+    XCTAssertNotNil(manifest);
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, (@{ @"verbose" : @(1), @"count" : @[ @(7) ] }));
+    XCTAssertThrows(parser.abbreviatedOptionNamesEnabled = NO);
+    
+    // full names that begin longer ones, assignments, and names spelled out alongside their abbreviations
+    argv = @[ @"--output=flarn", @"--outputs", @"barf", @"--c=1", @"--count", @"2", @"--vers", @"-v", @"quone" ];
+    parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    parser.abbreviatedOptionNamesEnabled = YES;
+    manifest = [parser parseArguments];
+    NSDictionary *expectedOptions = @{
+        @"output" : @[ @"flarn" ],
+        @"outputs" : @[ @"barf" ],
+        @"count" : @[ @(1), @(2) ],
+        @"version" : @(1),
+        @"verbose" : @(1)
+    };
+    
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, expectedOptions);
+    XCTAssertEqualObjects(manifest.positionalArguments, @[ @"quone" ]);
+    
+    // ambiguous prefixes name every option they could be; prefixes of nothing are unrecognized as before
+    argv = @[ @"--ver", @"--o=flarn", @"--xyzzy", @"--verbos" ];
+    parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    parser.abbreviatedOptionNamesEnabled = YES;
+    XCTAssertNil([parser parseArguments]);
+    NSArray *expectedErrors = @[
+        [NSError clk_POSIXErrorWithCode:EINVAL suggestions:@[ @"--verbose", @"--version" ] description:@"ambiguous option: '--ver'; did you mean '--verbose' or '--version'?"],
+        [NSError clk_POSIXErrorWithCode:EINVAL suggestions:@[ @"--output", @"--outputs" ] description:@"ambiguous option: '--o'; did you mean '--output' or '--outputs'?"],
+        [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '--xyzzy'"]
+    ];
+    
+    XCTAssertEqualObjects(parser.errors, expectedErrors);
+    XCTAssertEqualObjects(parser.errors[0].userInfo[CLKSuggestionsErrorKey], (@[ @"--verbose", @"--version" ]));
+    
+    // the setting carries over a reset
+    [parser resetWithArgumentVector:@[ @"--verbo" ]];
+    XCTAssertTrue(parser.abbreviatedOptionNamesEnabled);
+    XCTAssertEqualObjects([parser parseArguments][@"verbose"], @(1));
+    
+    // flags are never abbreviations
+    parser = [CLKArgumentParser parserWithArgumentVector:@[ @"-x" ] options:options];
+    parser.abbreviatedOptionNamesEnabled = YES;
+    XCTAssertNil([parser parseArguments]);
+    XCTAssertEqualObjects(parser.errors, @[ [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '-x'"] ]);
+    
+    // a prefix of many names only names a few of them
+    NSMutableArray<CLKOption *> *manyOptions = [NSMutableArray array];
+    for (NSUInteger i = 0 ; i < 100 ; i++) {
+        [manyOptions addObject:[CLKOption optionWithName:[NSString stringWithFormat:@"ribbon-%02lu", (unsigned long)i] flag:nil]];
+    }
+    
+    parser = [CLKArgumentParser parserWithArgumentVector:@[ @"--rib" ] options:manyOptions];
+    parser.abbreviatedOptionNamesEnabled = YES;
+    XCTAssertNil([parser parseArguments]);
+    NSArray<NSString *> *expectedCandidates = @[ @"--ribbon-00", @"--ribbon-01", @"--ribbon-02" ];
+    NSError *expectedError = [NSError clk_POSIXErrorWithCode:EINVAL suggestions:expectedCandidates description:@"ambiguous option: '--rib'; did you mean '--ribbon-00', '--ribbon-01', '--ribbon-02' …and 97 more?"];
+    XCTAssertEqualObjects(parser.errors, @[ expectedError ]);
+}
+
 - (void)testEmptyOptionsArray
 {
     ArgumentParsingResultSpec *spec = [ArgumentParsingResultSpec specWithEmptyManifest];
@@ -424,6 +538,52 @@
     [self performTestWithArgumentVector:@[ @"--flarn=what", @"--barf:what", @"-q=what", @"-x:what" ] options:options spec:spec];
 }
 
+- (void)testParameterOptionAssignmentForm_nonASCIIArguments
+{
+    NSArray *options = @[
+        [CLKOption parameterOptionWithName:@"flarn" flag:@"f" required:NO recurrent:YES transformer:nil],
+    ];
+    
+    NSDictionary *expectedManifest = @{
+        @"flarn" : @[ @"bärf", @"🐉", @"quöne=" ]
+    };
+    
+    ArgumentParsingResultSpec *spec = [ArgumentParsingResultSpec specWithOptionManifest:expectedManifest];
+    [self performTestWithArgumentVector:@[ @"--flarn=bärf", @"-f:🐉", @"--flarn:quöne=" ] options:options spec:spec];
+}
+
+- (void)testFlagSets_long
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"flarn" flag:@"f"],
+        [CLKOption optionWithName:@"barf" flag:@"b"],
+        [CLKOption parameterOptionWithName:@"quone" flag:@"q"]
+    ];
+    
+    // longer than the parser's inline flag storage
+    NSMutableString *flagSet = [NSMutableString stringWithString:@"-"];
+    for (NSUInteger i = 0 ; i < 50 ; i++) {
+        [flagSet appendString:@"fb"];
+    }
+    
+    NSDictionary *expectedManifest = @{
+        @"flarn" : @(51),
+        @"barf" : @(51),
+        @"quone" : @[ @"xyzzy" ]
+    };
+    
+    ArgumentParsingResultSpec *spec = [ArgumentParsingResultSpec specWithOptionManifest:expectedManifest];
+    [self performTestWithArgumentVector:@[ [flagSet stringByAppendingString:@"q"], @"xyzzy", @"-bf" ] options:options spec:spec];
+    
+    NSArray *errors = @[
+        [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '-x'"],
+        [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '-y'"]
+    ];
+    
+    spec = [ArgumentParsingResultSpec specWithErrors:errors];
+    [self performTestWithArgumentVector:@[ [flagSet stringByAppendingString:@"xfb"], @"-fyb" ] options:options spec:spec];
+}
+
 - (void)testPositionalArguments_withRegisteredOptions
 {
     NSArray *argv = @[ @"--foo", @"bar", @"/flarn.txt", @"/bort.txt" ];
@@ -763,6 +923,64 @@
     [self performTestWithArgumentVector:@[ @"--confound", @"-a" ] options:options error:earlyError];
 }
 
+- (void)testConcurrentTransformation
+{
+    CLKInt64ArgumentTransformer *countTransformer = [[CLKInt64ArgumentTransformer alloc] init];
+    CLKByteSizeArgumentTransformer *sizeTransformer = [[CLKByteSizeArgumentTransformer alloc] init];
+    StuntTransformer *modeTransformer = [StuntTransformer transformerWithTransformedObject:@"quone"];
+    XCTAssertTrue(countTransformer.threadSafe);
+    XCTAssertFalse(modeTransformer.threadSafe);
+    
+    NSArray *options = @[
+        [CLKOption parameterOptionWithName:@"count" flag:@"c" required:NO recurrent:YES transformer:countTransformer],
+        [CLKOption parameterOptionWithName:@"size" flag:@"s" required:NO recurrent:YES transformer:sizeTransformer],
+        [CLKOption parameterOptionWithName:@"mode" flag:@"m" required:NO recurrent:YES transformer:modeTransformer],
+        [CLKOption optionWithName:@"verbose" flag:@"v"]
+    ];
+    
+    // failures of deferred and inline transformations, interleaved with other parsing issues
+    NSMutableArray *argv = [NSMutableArray array];
+    for (int i = 0 ; i < 2000 ; i++) {
+        [argv addObjectsFromArray:@[ @"--count", (i % 97 == 0 ? [NSString stringWithFormat:@"x%d", i] : @(i).stringValue) ]];
+        [argv addObjectsFromArray:@[ @"-s", (i % 131 == 0 ? @"7Q" : [NSString stringWithFormat:@"%dK", i]) ]];
+        if (i % 50 == 0) {
+            [argv addObjectsFromArray:@[ @"--mode", @"flarn", @"--bogus", @"-v", @"acme" ]];
+        }
+    }
+    
+    CLKArgumentParser *serialParser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    XCTAssertNil([serialParser parseArguments]);
+    XCTAssertGreaterThan(serialParser.errors.count, 0UL);
+    
+    CLKArgumentParser *concurrentParser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    concurrentParser.transformerConcurrency = 4;
+    XCTAssertNil([concurrentParser parseArguments]);
+    XCTAssertEqualObjects(concurrentParser.errors, serialParser.errors);
+    XCTAssertThrows(concurrentParser.transformerConcurrency = 2);
+    
+    // without failures the manifests match
+    [argv removeAllObjects];
+    for (int i = 0 ; i < 2000 ; i++) {
+        [argv addObjectsFromArray:@[ @"--count", @(i).stringValue, @"-s", [NSString stringWithFormat:@"%dK", i] ]];
+        if (i % 50 == 0) {
+            [argv addObjectsFromArray:@[ @"--mode", @"flarn", @"-v", @"acme" ]];
+        }
+    }
+    
+    serialParser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    concurrentParser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    concurrentParser.transformerConcurrency = 4;
+    CLKArgumentManifest *serialManifest = [serialParser parseArguments];
+    CLKArgumentManifest *concurrentManifest = [concurrentParser parseArguments];
+    XCTAssertNotNil(concurrentManifest);
+    XCTAssertEqualObjects(concurrentManifest.dictionaryRepresentationForAccumulatedOptions, serialManifest.dictionaryRepresentationForAccumulatedOptions);
+    XCTAssertEqualObjects(concurrentManifest.positionalArguments, serialManifest.positionalArguments);
+    
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    XCTAssertEqual(parser.transformerConcurrency, 1UL);
+    XCTAssertThrows(parser.transformerConcurrency = 0);
+}
+
 - (void)testComplexMix
 {
     CLKIntArgumentTransformer *synTransformer = [[CLKIntArgumentTransformer alloc] init];
@@ -815,6 +1033,91 @@
     [self performTestWithArgumentVector:argv options:options optionGroups:groups spec:spec];
 }
 
+- (void)testLargeArgumentVector
+{
+    // parsing must be linear in the length of argv. a parser that shifts the remaining
+    // vector for every token consumed (or every flag expanded) takes hours on input of
+    // this size; a linear parser takes a few seconds even in an unoptimized build.
+    NSUInteger const tokenCount = 1000000;
+    NSTimeInterval const timeBudget = 30.0;
+    
+    NSArray *options = @[
+        [CLKOption parameterOptionWithName:@"input" flag:@"i" required:NO recurrent:YES transformer:nil],
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption optionWithName:@"quone" flag:@"q"]
+    ];
+    
+    // each stanza is four tokens: a parameter option, its argument, a flag set, and a positional argument
+    NSUInteger const stanzaCount = (tokenCount / 4);
+    NSMutableArray<NSString *> *argv = [NSMutableArray arrayWithCapacity:tokenCount];
+    for (NSUInteger i = 0 ; i < stanzaCount ; i++) {
+        [argv addObject:@"--input"];
+        [argv addObject:[NSString stringWithFormat:@"/flarn/barf/input-%lu.txt", (unsigned long)i]];
+        [argv addObject:@"-vq"];
+        [argv addObject:[NSString stringWithFormat:@"/flarn/barf/positional-%lu.txt", (unsigned long)i]];
+    }
+    
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    NSDate *start = [NSDate date];
+    CLKArgumentManifest *manifest = [parser parseArguments];
+    NSTimeInterval elapsed = -start.timeIntervalSinceNow;
+    
+    XCTAssertNotNil(manifest);
+    XCTAssertNil(parser.errors);
+    XCTAssertLessThan(elapsed, timeBudget, @"parsing %lu tokens took %.2fs", (unsigned long)tokenCount, elapsed);
+    XCTAssertEqual([manifest[@"input"] count], stanzaCount);
+    XCTAssertEqualObjects(manifest[@"verbose"], @(stanzaCount));
+    XCTAssertEqualObjects(manifest[@"quone"], @(stanzaCount));
+    XCTAssertEqual(manifest.positionalArguments.count, stanzaCount);
+    XCTAssertEqualObjects(manifest.positionalArguments.lastObject, ([NSString stringWithFormat:@"/flarn/barf/positional-%lu.txt", (unsigned long)(stanzaCount - 1)]));
+}
+
+- (void)testArgumentSources
+{
+    NSArray *options = @[
+        [CLKOption parameterOptionWithName:@"input" flag:@"i" required:YES recurrent:YES transformer:nil],
+        [CLKOption optionWithName:@"verbose" flag:@"v"]
+    ];
+    
+    CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:options];
+    
+    /* response files feed the same token stream as argv */
+    
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+    XCTAssertTrue([@"-i\nflarn\n--input\nbarf\n--\nquone\n" writeToFile:path atomically:NO encoding:NSUTF8StringEncoding error:nil]);
+    NSString *responseFileArgument = [@"@" stringByAppendingString:path];
+    const char *argv[] = { "-v", responseFileArgument.UTF8String, "xyzzy" };
+    
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgv:argv argc:3 schema:schema sourceOptions:CLKArgumentSourceExpandResponseFiles];
+    CLKArgumentManifest *manifest = [parser parseArguments];
+    XCTAssertNil(parser.errors);
+    XCTAssertEqualObjects(manifest[@"verbose"], @(1));
+    XCTAssertEqualObjects(manifest[@"input"], (@[ @"flarn", @"barf" ]));
+    XCTAssertEqualObjects(manifest.positionalArguments, (@[ @"quone", @"xyzzy" ]));
+    [NSFileManager.defaultManager removeItemAtPath:path error:nil];
+    
+    /* an unreadable response file fails the parse without validation errors piling on */
+    
+    parser = [CLKArgumentParser parserWithArgv:argv argc:3 schema:schema sourceOptions:CLKArgumentSourceExpandResponseFiles];
+    XCTAssertNil([parser parseArguments]);
+    NSError *error = [NSError clk_POSIXErrorWithCode:ENOENT description:@"%@: %s", responseFileArgument, strerror(ENOENT)];
+    XCTAssertEqualObjects(parser.errors, @[ error ]);
+    
+    /* a read error on a stream fails the parse, even though the arguments read so far were fine */
+    
+    // read(2) on a directory fails with EISDIR
+    int fd = open(NSTemporaryDirectory().fileSystemRepresentation, O_RDONLY);
+    XCTAssertGreaterThanOrEqual(fd, 0);
+    const char *streamArgv[] = { "-i", "flarn" };
+    CLKArgumentStream *stream = [CLKArgumentStream streamWithFileDescriptor:fd];
+    CLKArgumentVector *vector = [CLKArgumentVector vectorWithArgv:streamArgv argc:2 expandingResponseFiles:NO stream:stream];
+    parser = [[CLKArgumentParser alloc] _initWithArgumentVector:vector schema:schema];
+    XCTAssertNil([parser parseArguments]);
+    error = [NSError clk_POSIXErrorWithCode:EISDIR description:@"error reading arguments: %s", strerror(EISDIR)];
+    XCTAssertEqualObjects(parser.errors, @[ error ]);
+    close(fd);
+}
+
 - (void)testMultipleMixedErrors
 {
     CLKOption *flarn = [CLKOption parameterOptionWithName:@"flarn" flag:@"f" required:NO recurrent:YES transformer:nil];
@@ -856,6 +1159,96 @@
     XCTAssertThrows([parser parseArguments]);
 }
 
+- (void)testReset
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption requiredParameterOptionWithName:@"file" flag:@"f"],
+        [CLKOption parameterOptionWithName:@"count" flag:@"c" required:NO recurrent:YES transformer:[CLKInt64ArgumentTransformer new]]
+    ];
+    
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:@[ @"-v", @"--file", @"alpha", @"bravo" ] options:options];
+    CLKArgumentManifest *manifest = [parser parseArguments];
+    XCTAssertNotNil(manifest);
+    XCTAssertThrows([parser parseArguments]);
+    
+    // the manifest is refilled rather than replaced
+    [parser resetWithArgumentVector:@[ @"-c", @"7", @"--file=charlie", @"-c=8" ]];
+    XCTAssertEqual([parser parseArguments], manifest);
+    XCTAssertNil(parser.errors);
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, (@{ @"file" : @[ @"charlie" ], @"count" : @[ @(7), @(8) ] }));
+    XCTAssertEqualObjects(manifest.positionalArguments, @[]);
+    
+    // the issues of one run don't leak into the next. a missing argument for --file elides the
+    // required option issue for --file, but only in the run it happens in.
+    [parser resetWithArgumentVector:@[ @"-c", @"barf", @"--xyzzy", @"--file" ]];
+    XCTAssertNil([parser parseArguments]);
+    NSArray *errors = @[
+        [NSError clk_POSIXErrorWithCode:EINVAL description:@"couldn't coerce 'barf' to a 64-bit integer value"],
+        [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '--xyzzy'"],
+        [NSError clk_POSIXErrorWithCode:EINVAL description:@"expected argument for option '--file'"]
+    ];
+    
+    XCTAssertEqualObjects(parser.errors, errors);
+    
+    [parser resetWithArgumentVector:@[ @"-v" ]];
+    XCTAssertNil([parser parseArguments]);
+    XCTAssertEqualObjects(parser.errors, @[ [NSError clk_CLKErrorWithCode:CLKErrorRequiredOptionNotProvided description:@"--file: required option not provided"] ]);
+    
+    // a parser created from an array can be reset with a C argument vector, and vice versa
+    const char *argv[] = { "-vv", "--file", "delta", "echo" };
+    [parser resetWithArgv:argv argc:4];
+    XCTAssertNotNil([parser parseArguments]);
+    XCTAssertNil(parser.errors);
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, (@{ @"verbose" : @(2), @"file" : @[ @"delta" ] }));
+    XCTAssertEqualObjects(manifest.positionalArguments, @[ @"echo" ]);
+    
+    [parser resetWithArgv:argv argc:1];
+    XCTAssertNil([parser parseArguments]);
+    [parser resetWithArgumentVector:@[ @"-f", @"foxtrot" ]];
+    XCTAssertEqualObjects([parser parseArguments][@"file"], @"foxtrot");
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    XCTAssertThrows([parser resetWithArgumentVector:nil]);
+#pragma clang diagnostic pop
+}
+
+- (void)testReset_settings
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption parameterOptionWithName:@"count" flag:@"c" required:NO recurrent:YES transformer:[CLKInt64ArgumentTransformer new]]
+    ];
+    
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:@[ @"-c", @"1" ] options:options];
+    parser.transformerConcurrency = 2;
+    XCTAssertNotNil([parser parseArguments]);
+    XCTAssertThrows(parser.transformerConcurrency = 4);
+    
+    // settings carry over, and can be changed again until the next run begins
+    [parser resetWithArgumentVector:@[ @"-c", @"2", @"-c", @"3", @"-c", @"barf", @"-c", @"5" ]];
+    XCTAssertEqual(parser.transformerConcurrency, 2UL);
+    parser.transformerConcurrency = 4;
+    XCTAssertNil([parser parseArguments]);
+    XCTAssertEqualObjects(parser.errors, @[ [NSError clk_POSIXErrorWithCode:EINVAL description:@"couldn't coerce 'barf' to a 64-bit integer value"] ]);
+    
+    [parser resetWithArgumentVector:@[ @"-c", @"6", @"-c", @"7" ]];
+    XCTAssertEqualObjects([parser parseArguments][@"count"], (@[ @(6), @(7) ]));
+    
+    // flag sets longer than the inline storage reuse their buffer across runs
+    NSMutableString *flagSet = [NSMutableString stringWithString:@"-"];
+    for (NSUInteger i = 0 ; i < 40 ; i++) {
+        [flagSet appendString:@"v"];
+    }
+    
+    for (NSUInteger i = 0 ; i < 3 ; i++) {
+        NSString *set = [flagSet substringToIndex:(flagSet.length - (i * 5))];
+        [parser resetWithArgumentVector:@[ set, @"-vv" ]];
+        XCTAssertEqualObjects([parser parseArguments][@"verbose"], @(set.length - 1 + 2));
+    }
+}
+
 - (void)testUnregisteredGroupOptions
 {
     NSArray *options = @[
@@ -0,0 +1,184 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import <stdatomic.h>
+
+#import "CLKArgumentManifest_Private.h"
+#import "CLKArgumentParser.h"
+#import "CLKArgumentTransformer.h"
+#import "CLKOption.h"
+#import "CLKOptionGroup.h"
+#import "CLKOptionRegistry.h"
+#import "CLKOptionSchema_Private.h"
+#import "CLKOptionSource.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// the number of threads parsing at once, and how many times each parses every vector
+static const NSUInteger ThreadCount = 8;
+static const NSUInteger RoundCount = 50;
+
+@interface Test_CLKArgumentParser_Concurrency : XCTestCase
+
+- (CLKOptionSchema *)_schema;
+- (NSArray<NSArray<NSString *> *> *)_argumentVectors;
+- (id)_outcomeOfParser:(CLKArgumentParser *)parser manifest:(nullable CLKArgumentManifest *)manifest;
+- (void)_performOnThreads:(void (^)(NSUInteger thread))block;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation Test_CLKArgumentParser_Concurrency
+
+- (CLKOptionSchema *)_schema
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption optionWithName:@"quiet" flag:@"q"],
+        [CLKOption parameterOptionWithName:@"input" flag:@"i" required:NO recurrent:YES transformer:nil],
+        [CLKOption parameterOptionWithName:@"count" flag:@"c" required:NO recurrent:YES transformer:[CLKInt64ArgumentTransformer new]],
+        [CLKOption parameterOptionWithName:@"output" flag:@"o"]
+    ];
+    
+    NSArray *groups = @[
+        [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"verbose", @"quiet" ]],
+        [CLKOptionGroup groupForOptionNamed:@"output" requiringDependency:@"input"]
+    ];
+    
+    return [CLKOptionSchema schemaWithOptions:options optionGroups:groups];
+}
+
+// successful parses, usage errors, transformer errors and constraint violations
+- (NSArray<NSArray<NSString *> *> *)_argumentVectors
+{
+    return @[
+        @[ @"-v", @"--input", @"alpha", @"-c", @"7", @"bravo" ],
+        @[ @"-q", @"-i", @"alpha", @"-i", @"bravo", @"--output=charlie", @"--", @"-v" ],
+        @[ @"-vq" ],
+        @[ @"--count", @"barf", @"--xyzzy" ],
+        @[ @"--output", @"alpha" ],
+        @[ @"-c=1", @"-c=2", @"-c=3", @"-c=4", @"delta" ],
+        @[]
+    ];
+}
+
+// what a parse produced, read before the parser is reset
+- (id)_outcomeOfParser:(CLKArgumentParser *)parser manifest:(CLKArgumentManifest *)manifest
+{
+    if (manifest == nil) {
+        return [parser.errors valueForKey:@"localizedDescription"];
+    }
+    
+    return @[ manifest.dictionaryRepresentationForAccumulatedOptions, manifest.positionalArguments ];
+}
+
+- (void)_performOnThreads:(void (^)(NSUInteger thread))block
+{
+    dispatch_group_t group = dispatch_group_create();
+    for (NSUInteger t = 0 ; t < ThreadCount ; t++) {
+        dispatch_group_enter(group);
+        [NSThread detachNewThreadWithBlock:^{
+            block(t);
+            dispatch_group_leave(group);
+        }];
+    }
+    
+    XCTAssertEqual(dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, (60 * NSEC_PER_SEC))), 0L);
+}
+
+- (void)testSharedSchema
+{
+    CLKOptionSchema *schema = [self _schema];
+    NSArray<NSArray<NSString *> *> *vectors = [self _argumentVectors];
+    NSUInteger vectorCount = vectors.count;
+    
+    NSMutableArray *expectedOutcomes = [NSMutableArray array];
+    for (NSArray<NSString *> *argv in vectors) {
+        CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv schema:schema];
+        [expectedOutcomes addObject:[self _outcomeOfParser:parser manifest:[parser parseArguments]]];
+    }
+    
+    __block _Atomic NSUInteger parseCount = 0;
+    __block _Atomic NSUInteger mismatchCount = 0;
+    [self _performOnThreads:^(NSUInteger thread) {
+        // each thread keeps one parser and resets it between vectors, and parses each vector with a new parser too
+        CLKArgumentParser *resetParser = [CLKArgumentParser parserWithArgumentVector:@[] schema:schema];
+        (void)[resetParser parseArguments];
+        
+        for (NSUInteger round = 0 ; round < RoundCount ; round++) {
+            for (NSUInteger j = 0 ; j < vectorCount ; j++) {
+                // threads start at different vectors so that different parses overlap
+                NSUInteger v = ((thread + j) % vectorCount);
+                @autoreleasepool {
+                    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:vectors[v] schema:schema];
+                    id outcome = [self _outcomeOfParser:parser manifest:[parser parseArguments]];
+                    [resetParser resetWithArgumentVector:vectors[v]];
+                    id resetOutcome = [self _outcomeOfParser:resetParser manifest:[resetParser parseArguments]];
+                    
+                    atomic_fetch_add_explicit(&parseCount, 2, memory_order_relaxed);
+                    if (![outcome isEqual:expectedOutcomes[v]] || ![resetOutcome isEqual:expectedOutcomes[v]]) {
+                        atomic_fetch_add_explicit(&mismatchCount, 1, memory_order_relaxed);
+                    }
+                }
+            }
+        }
+    }];
+    
+    XCTAssertEqual(parseCount, (ThreadCount * RoundCount * vectorCount * 2));
+    XCTAssertEqual(mismatchCount, 0UL);
+}
+
+- (void)testSharedOptionsAndSources
+{
+    // parsers given the same options and groups build their own registries from them
+    CLKOptionSchema *schema = [self _schema];
+    NSArray<CLKOption *> *options = schema.options;
+    NSArray<CLKOptionGroup *> *groups = schema.optionGroups;
+    NSArray<CLKOptionSource *> *sources = @[ [CLKOptionSource sourceWithEnvironment:@{ @"CLKIT_VERBOSE" : @"yes", @"CLKIT_COUNT" : @"9" }] ];
+    NSArray<NSString *> *argv = @[ @"-i", @"alpha", @"-c", @"1" ];
+    
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options optionGroups:groups];
+    parser.optionSources = sources;
+    id expectedOutcome = [self _outcomeOfParser:parser manifest:[parser parseArguments]];
+    XCTAssertTrue([expectedOutcome isKindOfClass:[NSArray class]]);
+    XCTAssertEqualObjects(expectedOutcome[0][@"verbose"], @(1));
+    
+    __block _Atomic NSUInteger mismatchCount = 0;
+    [self _performOnThreads:^(__unused NSUInteger thread) {
+        for (NSUInteger round = 0 ; round < RoundCount ; round++) {
+            @autoreleasepool {
+                CLKArgumentParser *threadParser = [CLKArgumentParser parserWithArgumentVector:argv options:options optionGroups:groups];
+                threadParser.optionSources = sources;
+                if (![[self _outcomeOfParser:threadParser manifest:[threadParser parseArguments]] isEqual:expectedOutcome]) {
+                    atomic_fetch_add_explicit(&mismatchCount, 1, memory_order_relaxed);
+                }
+            }
+        }
+    }];
+    
+    XCTAssertEqual(mismatchCount, 0UL);
+}
+
+- (void)testNameTrie
+{
+    // the trie is built on demand, once, however many threads ask for it first
+    CLKOptionRegistry *registry = [self _schema].optionRegistry;
+    NSMutableArray *tries = [NSMutableArray array];
+    [self _performOnThreads:^(__unused NSUInteger thread) {
+        CLKPrefixTrie *trie = registry.nameTrie;
+        @synchronized (tries) {
+            [tries addObject:trie];
+        }
+    }];
+    
+    XCTAssertEqual(tries.count, ThreadCount);
+    for (CLKPrefixTrie *trie in tries) {
+        XCTAssertEqual(trie, registry.nameTrie);
+    }
+}
+
+@end
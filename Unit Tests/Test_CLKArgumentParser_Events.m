@@ -0,0 +1,288 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "CLKArgumentEvent.h"
+#import "CLKArgumentManifest_Private.h"
+#import "CLKArgumentParser.h"
+#import "CLKArgumentParser_Internal.h"
+#import "CLKOption.h"
+#import "CLKOptionGroup.h"
+#import "NSError+CLKAdditions.h"
+
+@interface Test_CLKArgumentParser_Events : XCTestCase
+
+- (NSArray<CLKArgumentEvent *> *)_eventsFromParser:(CLKArgumentParser *)parser;
+- (void)_verifyEvent:(CLKArgumentEvent *)event type:(CLKArgumentEventType)type option:(NSString *)optionName value:(id)value;
+- (void)_verifyEvent:(CLKArgumentEvent *)event error:(NSError *)error;
+
+@end
+
+@implementation Test_CLKArgumentParser_Events
+
+- (NSArray<CLKArgumentEvent *> *)_eventsFromParser:(CLKArgumentParser *)parser
+{
+    NSMutableArray<CLKArgumentEvent *> *events = [NSMutableArray array];
+    CLKArgumentEvent *event;
+    while ((event = [parser nextEvent]) != nil) {
+        [events addObject:event];
+    }
+    
+    return events;
+}
+
+- (void)_verifyEvent:(CLKArgumentEvent *)event type:(CLKArgumentEventType)type option:(NSString *)optionName value:(id)value
+{
+    XCTAssertEqual(event.type, type);
+    XCTAssertEqualObjects(event.option.name, optionName);
+    XCTAssertEqualObjects(event.value, value);
+    XCTAssertNil(event.error);
+}
+
+- (void)_verifyEvent:(CLKArgumentEvent *)event error:(NSError *)error
+{
+    XCTAssertEqual(event.type, CLKArgumentEventTypeIssue);
+    XCTAssertNil(event.option);
+    XCTAssertNil(event.value);
+    XCTAssertEqualObjects(event.error, error);
+}
+
+- (void)testEvents
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption optionWithName:@"quiet" flag:@"q"],
+        [CLKOption parameterOptionWithName:@"file" flag:@"f"]
+    ];
+    
+    NSArray *argv = @[ @"-vq", @"--file=alpha", @"bravo", @"--flarn", @"-f", @"charlie", @"--", @"--verbose" ];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    NSArray<CLKArgumentEvent *> *events = [self _eventsFromParser:parser];
+    XCTAssertEqual(events.count, 7UL);
+    if (events.count != 7) {
+        return;
+    }
+    
+    [self _verifyEvent:events[0] type:CLKArgumentEventTypeSwitchOption option:@"verbose" value:nil];
+    [self _verifyEvent:events[1] type:CLKArgumentEventTypeSwitchOption option:@"quiet" value:nil];
+    [self _verifyEvent:events[2] type:CLKArgumentEventTypeParameterOption option:@"file" value:@"alpha"];
+    [self _verifyEvent:events[3] type:CLKArgumentEventTypePositionalArgument option:nil value:@"bravo"];
+    [self _verifyEvent:events[4] error:[NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '--flarn'"]];
+    [self _verifyEvent:events[5] type:CLKArgumentEventTypeParameterOption option:@"file" value:@"charlie"];
+    [self _verifyEvent:events[6] type:CLKArgumentEventTypePositionalArgument option:nil value:@"--verbose"];
+    
+    // issues delivered as events are not collected
+    XCTAssertNil(parser.errors);
+    
+    parser = [CLKArgumentParser parserWithArgumentVector:@[] options:options];
+    XCTAssertNil([parser nextEvent]);
+}
+
+- (void)testIncrementalValidation
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption optionWithName:@"quiet" flag:@"q"],
+        [CLKOption parameterOptionWithName:@"flarn" flag:@"f"],
+        [CLKOption requiredParameterOptionWithName:@"bravo" flag:@"b"]
+    ];
+    
+    NSArray *groups = @[
+        [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"verbose", @"quiet" ]]
+    ];
+    
+    // the mutex issue arrives as soon as the second option is seen, ahead of the tokens that follow.
+    // the required option can only be known to be missing once the tokens run out.
+    NSArray *argv = @[ @"--verbose", @"--quiet", @"alpha", @"--verbose" ];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options optionGroups:groups];
+    NSArray<CLKArgumentEvent *> *events = [self _eventsFromParser:parser];
+    XCTAssertEqual(events.count, 6UL);
+    if (events.count != 6) {
+        return;
+    }
+    
+    [self _verifyEvent:events[0] type:CLKArgumentEventTypeSwitchOption option:@"verbose" value:nil];
+    [self _verifyEvent:events[1] type:CLKArgumentEventTypeSwitchOption option:@"quiet" value:nil];
+    [self _verifyEvent:events[2] error:[NSError clk_CLKErrorWithCode:CLKErrorMutuallyExclusiveOptionsPresent description:@"--verbose --quiet: mutually exclusive options encountered"]];
+    [self _verifyEvent:events[3] type:CLKArgumentEventTypePositionalArgument option:nil value:@"alpha"];
+    
+    // a violated constraint is reported once
+    [self _verifyEvent:events[4] type:CLKArgumentEventTypeSwitchOption option:@"verbose" value:nil];
+    [self _verifyEvent:events[5] error:[NSError clk_CLKErrorWithCode:CLKErrorRequiredOptionNotProvided description:@"--bravo: required option not provided"]];
+    
+    argv = @[ @"--flarn", @"alpha", @"--flarn", @"bravo", @"charlie" ];
+    parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    events = [self _eventsFromParser:parser];
+    XCTAssertEqual(events.count, 5UL);
+    if (events.count != 5) {
+        return;
+    }
+    
+    [self _verifyEvent:events[0] type:CLKArgumentEventTypeParameterOption option:@"flarn" value:@"alpha"];
+    [self _verifyEvent:events[1] type:CLKArgumentEventTypeParameterOption option:@"flarn" value:@"bravo"];
+    [self _verifyEvent:events[2] error:[NSError clk_CLKErrorWithCode:CLKErrorTooManyOccurrencesOfOption description:@"--flarn may not be provided more than once"]];
+    [self _verifyEvent:events[3] type:CLKArgumentEventTypePositionalArgument option:nil value:@"charlie"];
+    [self _verifyEvent:events[4] error:[NSError clk_CLKErrorWithCode:CLKErrorRequiredOptionNotProvided description:@"--bravo: required option not provided"]];
+    
+    // a standalone option is broken by whichever option comes after it, not only by options it is grouped with
+    options = @[
+        [CLKOption standaloneOptionWithName:@"version" flag:nil],
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption optionWithName:@"quiet" flag:@"q"]
+    ];
+    
+    argv = @[ @"--version", @"--quiet", @"--verbose" ];
+    parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    events = [self _eventsFromParser:parser];
+    XCTAssertEqual(events.count, 4UL);
+    if (events.count != 4) {
+        return;
+    }
+    
+    [self _verifyEvent:events[0] type:CLKArgumentEventTypeSwitchOption option:@"version" value:nil];
+    [self _verifyEvent:events[1] type:CLKArgumentEventTypeSwitchOption option:@"quiet" value:nil];
+    [self _verifyEvent:events[2] error:[NSError clk_CLKErrorWithCode:CLKErrorMutuallyExclusiveOptionsPresent description:@"--version may not be provided with other options"]];
+    [self _verifyEvent:events[3] type:CLKArgumentEventTypeSwitchOption option:@"verbose" value:nil];
+}
+
+- (void)testEventsMatchManifest
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption parameterOptionWithName:@"file" flag:@"f" required:NO recurrent:YES transformer:nil],
+        [CLKOption parameterOptionWithName:@"mode" flag:@"m"]
+    ];
+    
+    NSArray *argv = @[ @"-vv", @"-f", @"alpha", @"bravo", @"--mode=charlie", @"--file", @"delta", @"--", @"-v", @"echo" ];
+    CLKArgumentManifest *manifest = [[CLKArgumentParser parserWithArgumentVector:argv options:options] parseArguments];
+    XCTAssertNotNil(manifest);
+    
+    NSMutableDictionary<NSString *, id> *optionManifest = [NSMutableDictionary dictionary];
+    NSMutableArray<NSString *> *positionalArguments = [NSMutableArray array];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    for (CLKArgumentEvent *event in [self _eventsFromParser:parser]) {
+        switch (event.type) {
+            case CLKArgumentEventTypeSwitchOption:
+                optionManifest[event.option.name] = @([optionManifest[event.option.name] intValue] + 1);
+                break;
+            
+            case CLKArgumentEventTypeParameterOption:
+                optionManifest[event.option.name] = [(optionManifest[event.option.name] ?: @[]) arrayByAddingObject:event.value];
+                break;
+            
+            case CLKArgumentEventTypePositionalArgument:
+                [positionalArguments addObject:event.value];
+                break;
+            
+            case CLKArgumentEventTypeIssue:
+                XCTFail(@"unexpected issue: %@", event.error);
+                break;
+        }
+    }
+    
+    XCTAssertEqualObjects(optionManifest, manifest.dictionaryRepresentationForAccumulatedOptions);
+    XCTAssertEqualObjects(positionalArguments, manifest.positionalArguments);
+}
+
+- (void)testManifestAfterEvents
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption parameterOptionWithName:@"file" flag:@"f" required:NO recurrent:YES transformer:nil],
+        [CLKOption parameterOptionWithName:@"name" flag:@"n"]
+    ];
+    
+    // the parser's manifest only counts parameter options in event mode. reading it has to
+    // report their occurrences without reaching for arguments it never stored.
+    NSArray *argv = @[ @"-v", @"--file", @"alpha", @"--name", @"bravo", @"-f", @"charlie", @"delta" ];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
+    XCTAssertEqual([self _eventsFromParser:parser].count, 5UL);
+    
+    CLKArgumentManifest *manifest = parser.manifest;
+    CLKOptionHandle fileHandle = [manifest handleForOptionNamed:@"file"];
+    CLKOptionHandle nameHandle = [manifest handleForOptionNamed:@"name"];
+    XCTAssertEqual([manifest occurrencesOfOptionNamed:@"verbose"], 1UL);
+    XCTAssertEqual([manifest occurrencesOfOptionNamed:@"file"], 2UL);
+    XCTAssertEqual([manifest occurrencesOfOptionNamed:@"name"], 1UL);
+    XCTAssertTrue([manifest hasOption:nameHandle]);
+    XCTAssertEqual([manifest argumentCountForOption:fileHandle], 0UL);
+    XCTAssertThrows([manifest argumentAtIndex:0 forOption:fileHandle]);
+    XCTAssertThrows([manifest argumentAtIndex:0 forOption:nameHandle]);
+    XCTAssertNil(manifest[@"file"]);
+    XCTAssertNil(manifest[@"name"]);
+    XCTAssertEqualObjects(manifest[@"verbose"], @(1));
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, (@{ @"verbose" : @(1) }));
+    XCTAssertEqualObjects(manifest.positionalArguments, @[]);
+}
+
+- (void)testModeExclusivity
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"]
+    ];
+    
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:@[ @"-v" ] options:options];
+    XCTAssertNotNil([parser nextEvent]);
+    XCTAssertThrows([parser parseArguments]);
+    XCTAssertNil([parser nextEvent]);
+    XCTAssertNil([parser nextEvent]);
+    
+    parser = [CLKArgumentParser parserWithArgumentVector:@[ @"-v" ] options:options];
+    XCTAssertNotNil([parser parseArguments]);
+    XCTAssertThrows([parser nextEvent]);
+}
+
+- (void)testReset
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption optionWithName:@"quiet" flag:@"q"],
+        [CLKOption parameterOptionWithName:@"file" flag:@"f"]
+    ];
+    
+    NSArray *groups = @[
+        [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"verbose", @"quiet" ]]
+    ];
+    
+    NSError *mutexError = [NSError clk_CLKErrorWithCode:CLKErrorMutuallyExclusiveOptionsPresent description:@"--verbose --quiet: mutually exclusive options encountered"];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:@[ @"-vq", @"alpha" ] options:options optionGroups:groups];
+    
+    // a reset part of the way through drops the pending events. each run reports its own violations.
+    [self _verifyEvent:[parser nextEvent] type:CLKArgumentEventTypeSwitchOption option:@"verbose" value:nil];
+    [parser resetWithArgumentVector:@[ @"--quiet", @"--verbose", @"--file", @"bravo" ]];
+    NSArray<CLKArgumentEvent *> *events = [self _eventsFromParser:parser];
+    XCTAssertEqual(events.count, 4UL);
+    if (events.count != 4) {
+        return;
+    }
+    
+    [self _verifyEvent:events[0] type:CLKArgumentEventTypeSwitchOption option:@"quiet" value:nil];
+    [self _verifyEvent:events[1] type:CLKArgumentEventTypeSwitchOption option:@"verbose" value:nil];
+    [self _verifyEvent:events[2] error:mutexError];
+    [self _verifyEvent:events[3] type:CLKArgumentEventTypeParameterOption option:@"file" value:@"bravo"];
+    
+    [parser resetWithArgumentVector:@[ @"-vq" ]];
+    events = [self _eventsFromParser:parser];
+    XCTAssertEqual(events.count, 3UL);
+    if (events.count != 3) {
+        return;
+    }
+    
+    [self _verifyEvent:events[2] error:mutexError];
+    
+    // a parser can change modes between runs
+    [parser resetWithArgumentVector:@[ @"-v", @"--file=charlie" ]];
+    CLKArgumentManifest *manifest = [parser parseArguments];
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, (@{ @"verbose" : @(1), @"file" : @[ @"charlie" ] }));
+    XCTAssertThrows([parser nextEvent]);
+    
+    [parser resetWithArgumentVector:@[ @"delta" ]];
+    events = [self _eventsFromParser:parser];
+    XCTAssertEqual(events.count, 1UL);
+    [self _verifyEvent:events.firstObject type:CLKArgumentEventTypePositionalArgument option:nil value:@"delta"];
+    XCTAssertNil(parser.errors);
+}
+
+@end
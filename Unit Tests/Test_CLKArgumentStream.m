@@ -0,0 +1,123 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import <fcntl.h>
+#import <unistd.h>
+
+#import "CLKArgumentStream.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface Test_CLKArgumentStream : XCTestCase
+
+- (CLKArgumentStream *)_streamWithInput:(NSData *)input;
+- (NSArray<NSString *> *)_readAllArgumentsFromStream:(CLKArgumentStream *)stream;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation Test_CLKArgumentStream
+
+// writes `input` into a pipe on another thread, so inputs larger than the pipe's buffer work
+- (CLKArgumentStream *)_streamWithInput:(NSData *)input
+{
+    int fds[2];
+    XCTAssertEqual(pipe(fds), 0);
+    
+    int readFD = fds[0];
+    int writeFD = fds[1];
+    [NSThread detachNewThreadWithBlock:^{
+        const char *bytes = input.bytes;
+        NSUInteger written = 0;
+        while (written < input.length) {
+            ssize_t result = write(writeFD, (bytes + written), (input.length - written));
+            if (result <= 0) {
+                break;
+            }
+            
+            written += (NSUInteger)result;
+        }
+        
+        close(writeFD);
+    }];
+    
+    CLKArgumentStream *stream = [CLKArgumentStream streamWithFileDescriptor:readFD];
+    [self addTeardownBlock:^{
+        close(readFD);
+    }];
+    
+    return stream;
+}
+
+- (NSArray<NSString *> *)_readAllArgumentsFromStream:(CLKArgumentStream *)stream
+{
+    NSMutableArray<NSString *> *arguments = [NSMutableArray array];
+    CLKArgumentSpan span;
+    while ([stream readArgument:&span]) {
+        NSString *argument = [[NSString alloc] initWithBytes:span.bytes length:span.length encoding:NSUTF8StringEncoding];
+        XCTAssertNotNil(argument);
+        if (argument != nil) {
+            [arguments addObject:argument];
+        }
+    }
+    
+    return arguments;
+}
+
+- (void)testReadArguments
+{
+    const char inputBytes[] = "--flarn\0barf\0\0qu\xc3\xb6ne\0";
+    NSData *input = [NSData dataWithBytes:inputBytes length:(sizeof(inputBytes) - 1)];
+    CLKArgumentStream *stream = [self _streamWithInput:input];
+    XCTAssertEqualObjects([self _readAllArgumentsFromStream:stream], (@[ @"--flarn", @"barf", @"", @"quöne" ]));
+    XCTAssertNil(stream.error);
+    
+    // a final argument doesn't need a trailing NUL
+    const char unterminatedInputBytes[] = "flarn\0barf";
+    input = [NSData dataWithBytes:unterminatedInputBytes length:(sizeof(unterminatedInputBytes) - 1)];
+    stream = [self _streamWithInput:input];
+    XCTAssertEqualObjects([self _readAllArgumentsFromStream:stream], (@[ @"flarn", @"barf" ]));
+    
+    stream = [self _streamWithInput:[NSData data]];
+    XCTAssertEqualObjects([self _readAllArgumentsFromStream:stream], @[]);
+    XCTAssertNil(stream.error);
+}
+
+- (void)testChunkBoundaries
+{
+    // enough input to fill many chunks, with arguments straddling them and a few longer than a chunk
+    NSMutableData *input = [NSMutableData data];
+    NSMutableArray<NSString *> *expectedArguments = [NSMutableArray array];
+    for (NSUInteger i = 0 ; i < 50000 ; i++) {
+        NSString *argument = [NSString stringWithFormat:@"argument-%lu", (unsigned long)i];
+        if (i % 10000 == 0) {
+            argument = [@"" stringByPaddingToLength:(150 * 1024) withString:@"x" startingAtIndex:0];
+        }
+        
+        [expectedArguments addObject:argument];
+        [input appendData:[argument dataUsingEncoding:NSUTF8StringEncoding]];
+        [input appendBytes:"\0" length:1];
+    }
+    
+    CLKArgumentStream *stream = [self _streamWithInput:input];
+    XCTAssertEqualObjects([self _readAllArgumentsFromStream:stream], expectedArguments);
+}
+
+- (void)testReadError
+{
+    // read(2) on a directory fails with EISDIR
+    int fd = open(NSTemporaryDirectory().fileSystemRepresentation, O_RDONLY);
+    XCTAssertGreaterThanOrEqual(fd, 0);
+    
+    CLKArgumentStream *stream = [CLKArgumentStream streamWithFileDescriptor:fd];
+    XCTAssertEqualObjects([self _readAllArgumentsFromStream:stream], @[]);
+    XCTAssertEqualObjects(stream.error.domain, NSPOSIXErrorDomain);
+    XCTAssertEqual(stream.error.code, EISDIR);
+    close(fd);
+}
+
+@end
@@ -0,0 +1,293 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import <unistd.h>
+
+#import "CLKArgumentStream.h"
+#import "CLKArgumentVector.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface Test_CLKArgumentVector : XCTestCase
+
+- (NSString *)_responseFileWithContents:(NSString *)contents;
+- (CLKArgumentStream *)_streamWithContents:(const char *)bytes length:(size_t)length;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation Test_CLKArgumentVector
+
+- (NSString *)_responseFileWithContents:(NSString *)contents
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+    XCTAssertTrue([contents writeToFile:path atomically:NO encoding:NSUTF8StringEncoding error:nil]);
+    [self addTeardownBlock:^{
+        [NSFileManager.defaultManager removeItemAtPath:path error:nil];
+    }];
+    
+    return path;
+}
+
+// the contents must fit in the pipe's buffer
+- (CLKArgumentStream *)_streamWithContents:(const char *)bytes length:(size_t)length
+{
+    int fds[2];
+    XCTAssertEqual(pipe(fds), 0);
+    XCTAssertEqual(write(fds[1], bytes, length), (ssize_t)length);
+    close(fds[1]);
+    
+    int readFD = fds[0];
+    [self addTeardownBlock:^{
+        close(readFD);
+    }];
+    
+    return [CLKArgumentStream streamWithFileDescriptor:readFD];
+}
+
+- (void)testInit
+{
+    const char *argv[] = { "--flarn", "barf" };
+    XCTAssertNotNil([CLKArgumentVector vectorWithArgv:argv argc:2]);
+    XCTAssertNotNil([CLKArgumentVector vectorWithArgv:argv argc:0]);
+    XCTAssertNotNil([CLKArgumentVector vectorWithArguments:@[ @"--flarn", @"barf" ]]);
+    XCTAssertNotNil([CLKArgumentVector vectorWithArguments:@[]]);
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    XCTAssertThrows([CLKArgumentVector vectorWithArguments:nil]);
+    XCTAssertThrows([CLKArgumentVector vectorWithArgv:argv argc:-1]);
+#pragma clang diagnostic pop
+}
+
+- (void)testArguments
+{
+    const char *argv[] = { "--flarn", "barf", "qu\xc3\xb6ne", "" };
+    NSArray *expectedArguments = @[ @"--flarn", @"barf", @"quöne", @"" ];
+    
+    NSArray *vectors = @[
+        [CLKArgumentVector vectorWithArgv:argv argc:4],
+        [CLKArgumentVector vectorWithArguments:expectedArguments]
+    ];
+    
+    for (CLKArgumentVector *vector in vectors) {
+        XCTAssertEqual(vector.count, 4UL);
+        for (NSUInteger i = 0 ; i < expectedArguments.count ; i++) {
+            XCTAssertEqualObjects([vector argumentAtIndex:i], expectedArguments[i]);
+        }
+        
+        XCTAssertEqualObjects([vector argumentsFromIndex:0], expectedArguments);
+        XCTAssertEqualObjects([vector argumentsFromIndex:2], (@[ @"quöne", @"" ]));
+        XCTAssertEqualObjects([vector argumentsFromIndex:4], @[]);
+    }
+}
+
+- (void)testInvalidUTF8
+{
+    const char *argv[] = { "flarn", "\xff\xfe" };
+    CLKArgumentVector *vector = [CLKArgumentVector vectorWithArgv:argv argc:2];
+    XCTAssertEqualObjects([vector argumentAtIndex:0], @"flarn");
+    XCTAssertThrowsSpecificNamed([vector argumentAtIndex:1], NSException, NSInvalidArgumentException);
+}
+
+- (void)testSubvector
+{
+    const char *argv[] = { "thrud", "flarn", "--barf", "quone" };
+    NSArray *arguments = @[ @"thrud", @"flarn", @"--barf", @"quone" ];
+    
+    NSArray *vectors = @[
+        [CLKArgumentVector vectorWithArgv:argv argc:4],
+        [CLKArgumentVector vectorWithArguments:arguments]
+    ];
+    
+    for (CLKArgumentVector *vector in vectors) {
+        CLKArgumentVector *subvector = [vector subvectorFromIndex:1];
+        XCTAssertEqual(subvector.count, 3UL);
+        XCTAssertEqualObjects([subvector argumentAtIndex:0], @"flarn");
+        XCTAssertEqual([subvector analysisOfArgumentAtIndex:1].form, CLKTokenFormOptionName);
+        
+        CLKArgumentVector *subsubvector = [subvector subvectorFromIndex:2];
+        XCTAssertEqual(subsubvector.count, 1UL);
+        XCTAssertEqualObjects([subsubvector argumentAtIndex:0], @"quone");
+        XCTAssertEqual([vector subvectorFromIndex:4].count, 0UL);
+    }
+}
+
+- (void)testAnalysis
+{
+    // every token must be classified the same way whether the vector is backed by strings or by UTF-8 bytes
+    NSArray<NSString *> *tokens = @[
+        @"--flarn", @"-f", @"-xyz", @"--flarn=barf", @"--flarn:", @"-q=one", @"--", @"-", @"",
+        @"barf", @"--fl arn", @"-q-", @"--=barf", @"--flärn", @"--flärn=barf", @"--flarn=bärf",
+        @"-ä", @"-xä", @"--fl　arn", @"-x　", @"bärf", @"--　"
+    ];
+    
+    const char **argv = calloc(tokens.count, sizeof(char *));
+    for (NSUInteger i = 0 ; i < tokens.count ; i++) {
+        argv[i] = tokens[i].UTF8String;
+    }
+    
+    CLKArgumentVector *bytesVector = [CLKArgumentVector vectorWithArgv:argv argc:(int)tokens.count];
+    CLKArgumentVector *stringsVector = [CLKArgumentVector vectorWithArguments:tokens];
+    for (NSUInteger i = 0 ; i < tokens.count ; i++) {
+        CLKTokenAnalysis expected = CLKTokenAnalyze(tokens[i]);
+        CLKTokenAnalysis analyses[] = {
+            [bytesVector analysisOfArgumentAtIndex:i],
+            [stringsVector analysisOfArgumentAtIndex:i]
+        };
+        
+        for (size_t j = 0 ; j < 2 ; j++) {
+            XCTAssertEqual(analyses[j].form, expected.form, @"token: '%@'", tokens[i]);
+            XCTAssertTrue(NSEqualRanges(analyses[j].optionRange, expected.optionRange), @"token: '%@'", tokens[i]);
+            XCTAssertTrue(NSEqualRanges(analyses[j].argumentRange, expected.argumentRange), @"token: '%@'", tokens[i]);
+        }
+    }
+    
+    free(argv);
+}
+
+- (void)testResponseFiles
+{
+    NSString *alphaPath = [self _responseFileWithContents:@"--flarn\nbarf quone\r\n\n@nested\n-x"];
+    NSString *bravoPath = [self _responseFileWithContents:@""];
+    NSString *alphaArgument = [@"@" stringByAppendingString:alphaPath];
+    NSString *bravoArgument = [@"@" stringByAppendingString:bravoPath];
+    const char *argv[] = { "thrud", alphaArgument.UTF8String, "@", bravoArgument.UTF8String, "--xyzzy" };
+    
+    // blank lines are skipped, CRLF line endings are accepted, and nested response files aren't expanded
+    NSArray *expectedArguments = @[ @"thrud", @"--flarn", @"barf quone", @"@nested", @"-x", @"@", @"--xyzzy" ];
+    CLKArgumentVector *vector = [CLKArgumentVector vectorWithArgv:argv argc:5 expandingResponseFiles:YES stream:nil];
+    XCTAssertNil(vector.error);
+    XCTAssertEqual(vector.count, expectedArguments.count);
+    XCTAssertEqualObjects([vector argumentsFromIndex:0], expectedArguments);
+    XCTAssertEqual([vector analysisOfArgumentAtIndex:1].form, CLKTokenFormOptionName);
+    XCTAssertEqual([vector analysisOfArgumentAtIndex:4].form, CLKTokenFormOptionFlag);
+    XCTAssertEqualObjects([[vector subvectorFromIndex:2] argumentsFromIndex:0], [expectedArguments subarrayWithRange:NSMakeRange(2, 5)]);
+    
+    // strings read from a response file remain valid after the vector is gone
+    NSString *argument;
+    @autoreleasepool {
+        CLKArgumentVector *transientVector = [CLKArgumentVector vectorWithArgv:argv argc:5 expandingResponseFiles:YES stream:nil];
+        argument = [transientVector argumentAtIndex:2];
+    }
+    
+    XCTAssertEqualObjects(argument, @"barf quone");
+    
+    // without expansion the arguments are read as-is
+    vector = [CLKArgumentVector vectorWithArgv:argv argc:5 expandingResponseFiles:NO stream:nil];
+    XCTAssertEqualObjects([vector argumentAtIndex:1], alphaArgument);
+}
+
+- (void)testMissingResponseFile
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+    NSString *responseFileArgument = [@"@" stringByAppendingString:path];
+    const char *argv[] = { "--flarn", responseFileArgument.UTF8String };
+    
+    CLKArgumentVector *vector = [CLKArgumentVector vectorWithArgv:argv argc:2 expandingResponseFiles:YES stream:nil];
+    XCTAssertEqual(vector.count, 0UL);
+    XCTAssertFalse([vector hasArgumentAtIndex:0]);
+    XCTAssertEqualObjects(vector.error.domain, NSPOSIXErrorDomain);
+    XCTAssertEqual(vector.error.code, ENOENT);
+    XCTAssertTrue([vector.error.localizedDescription hasPrefix:responseFileArgument]);
+}
+
+- (void)testStream
+{
+    const char *argv[] = { "--flarn", "barf" };
+    const char streamBytes[] = "--quone\0xyzzy\0\0-q";
+    CLKArgumentStream *stream = [self _streamWithContents:streamBytes length:(sizeof(streamBytes) - 1)];
+    CLKArgumentVector *vector = [CLKArgumentVector vectorWithArgv:argv argc:2 expandingResponseFiles:NO stream:stream];
+    XCTAssertEqual(vector.count, 2UL);
+    
+    NSArray *expectedArguments = @[ @"--flarn", @"barf", @"--quone", @"xyzzy", @"", @"-q" ];
+    NSMutableArray *arguments = [NSMutableArray array];
+    NSUInteger idx = 0;
+    while ([vector hasArgumentAtIndex:idx]) {
+        // the current stream argument can be read as many times as needed
+        XCTAssertEqual([vector analysisOfArgumentAtIndex:idx].form, CLKTokenAnalyze(expectedArguments[idx]).form);
+        XCTAssertTrue([vector hasArgumentAtIndex:idx]);
+        [arguments addObject:[vector argumentAtIndex:idx]];
+        idx++;
+    }
+    
+    XCTAssertEqualObjects(arguments, expectedArguments);
+    XCTAssertNil(vector.error);
+    XCTAssertFalse([vector hasArgumentAtIndex:idx]);
+    
+    // earlier stream arguments are gone
+    XCTAssertThrows([vector argumentAtIndex:2]);
+    XCTAssertEqualObjects([vector argumentsFromIndex:1], (@[ @"barf", @"-q" ]));
+    XCTAssertThrows([vector subvectorFromIndex:1]);
+}
+
+- (void)testReset
+{
+    const char *argv[] = { "--flarn", "barf", "-q" };
+    const char *longerArgv[] = { "thrud", "-x", "--xyzzy", "quone", "-abc" };
+    
+    CLKArgumentVector *vector = [CLKArgumentVector vectorWithArgv:argv argc:3];
+    NSString *argument = [vector argumentAtIndex:1];
+    XCTAssertTrue([vector resetWithArgv:longerArgv argc:5]);
+    XCTAssertEqualObjects([vector argumentsFromIndex:0], (@[ @"thrud", @"-x", @"--xyzzy", @"quone", @"-abc" ]));
+    XCTAssertEqual([vector analysisOfArgumentAtIndex:4].form, CLKTokenFormOptionFlagSet);
+    XCTAssertEqualObjects(argument, @"barf");
+    XCTAssertTrue([vector resetWithArgv:argv argc:1]);
+    XCTAssertEqualObjects([vector argumentsFromIndex:0], @[ @"--flarn" ]);
+    XCTAssertTrue([vector resetWithArgv:argv argc:0]);
+    XCTAssertEqual(vector.count, 0UL);
+    XCTAssertFalse([vector resetWithArguments:@[ @"--flarn" ]]);
+    
+    vector = [CLKArgumentVector vectorWithArguments:@[ @"--flarn" ]];
+    XCTAssertTrue([vector resetWithArguments:@[ @"thrud", @"quone" ]]);
+    XCTAssertEqualObjects([vector argumentsFromIndex:0], (@[ @"thrud", @"quone" ]));
+    XCTAssertFalse([vector resetWithArgv:argv argc:3]);
+    XCTAssertEqualObjects([vector argumentsFromIndex:0], (@[ @"thrud", @"quone" ]));
+    
+    // neither a vector nor its subvectors can be reset once they share storage
+    CLKArgumentVector *subvector = [vector subvectorFromIndex:1];
+    XCTAssertFalse([vector resetWithArguments:@[]]);
+    XCTAssertFalse([subvector resetWithArguments:@[]]);
+    XCTAssertEqualObjects([subvector argumentAtIndex:0], @"quone");
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    XCTAssertThrows([[CLKArgumentVector vectorWithArguments:@[]] resetWithArguments:nil]);
+    XCTAssertThrows([[CLKArgumentVector vectorWithArgv:argv argc:3] resetWithArgv:argv argc:-1]);
+#pragma clang diagnostic pop
+}
+
+- (void)testReset_argumentSources
+{
+    NSString *path = [self _responseFileWithContents:@"--flarn\nbarf"];
+    NSString *responseFileArgument = [@"@" stringByAppendingString:path];
+    NSString *missingArgument = [@"@" stringByAppendingString:[NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString]];
+    const char *argv[] = { "thrud", responseFileArgument.UTF8String };
+    const char *missingArgv[] = { missingArgument.UTF8String };
+    
+    // response files are still expanded after a reset, and a reset clears the error of the last vector
+    CLKArgumentVector *vector = [CLKArgumentVector vectorWithArgv:missingArgv argc:1 expandingResponseFiles:YES stream:nil];
+    XCTAssertNotNil(vector.error);
+    XCTAssertTrue([vector resetWithArgv:argv argc:2]);
+    XCTAssertNil(vector.error);
+    XCTAssertEqualObjects([vector argumentsFromIndex:0], (@[ @"thrud", @"--flarn", @"barf" ]));
+    XCTAssertTrue([vector resetWithArgv:missingArgv argc:1]);
+    XCTAssertEqual(vector.error.code, ENOENT);
+    XCTAssertEqual(vector.count, 0UL);
+    
+    // the stream is read by the first vector only
+    const char streamBytes[] = "--quone\0xyzzy";
+    CLKArgumentStream *stream = [self _streamWithContents:streamBytes length:(sizeof(streamBytes) - 1)];
+    vector = [CLKArgumentVector vectorWithArgv:argv argc:1 expandingResponseFiles:NO stream:stream];
+    XCTAssertTrue([vector hasArgumentAtIndex:1]);
+    XCTAssertEqualObjects([vector argumentAtIndex:1], @"--quone");
+    XCTAssertTrue([vector resetWithArgv:argv argc:2]);
+    XCTAssertEqualObjects([vector argumentsFromIndex:0], (@[ @"thrud", responseFileArgument ]));
+    XCTAssertFalse([vector hasArgumentAtIndex:2]);
+}
+
+@end
@@ -0,0 +1,164 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "CLKArgumentManifest_Private.h"
+#import "CLKArgumentParser.h"
+#import "CLKBatchParser.h"
+#import "CLKOption.h"
+#import "CLKOptionGroup.h"
+#import "CLKOptionSchema.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface Test_CLKBatchParser : XCTestCase
+
+- (CLKOptionSchema *)_schema;
+- (NSArray<NSArray<NSString *> *> *)_argumentVectorsWithCount:(NSUInteger)count;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation Test_CLKBatchParser
+
+- (CLKOptionSchema *)_schema
+{
+    NSArray *options = @[
+         [CLKOption parameterOptionWithName:@"input" flag:@"i" required:NO recurrent:YES transformer:nil],
+         [CLKOption parameterOptionWithName:@"output" flag:@"o"],
+         [CLKOption optionWithName:@"verbose" flag:@"v"],
+         [CLKOption optionWithName:@"quiet" flag:@"q"]
+    ];
+    
+    CLKOptionGroup *group = [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"verbose", @"quiet" ]];
+    return [CLKOptionSchema schemaWithOptions:options optionGroups:@[ group ]];
+}
+
+// a mix of valid vectors, usage errors, and vectors of different lengths so shares finish unevenly
+- (NSArray<NSArray<NSString *> *> *)_argumentVectorsWithCount:(NSUInteger)count
+{
+    NSMutableArray *vectors = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0 ; i < count ; i++) {
+        NSMutableArray *argv = [NSMutableArray array];
+        switch (i % 5) {
+            case 0:
+                [argv addObjectsFromArray:@[ @"-v", @"--output", [NSString stringWithFormat:@"out%lu", (unsigned long)i] ]];
+                break;
+            case 1:
+                [argv addObjectsFromArray:@[ @"-vq" ]];
+                break;
+            case 2:
+                for (NSUInteger j = 0 ; j < (i % 50) ; j++) {
+                    [argv addObjectsFromArray:@[ @"-i", [NSString stringWithFormat:@"in%lu", (unsigned long)j] ]];
+                }
+                
+                break;
+            case 3:
+                [argv addObjectsFromArray:@[ @"--xyzzy" ]];
+                break;
+            case 4:
+                [argv addObjectsFromArray:@[ @"--", [NSString stringWithFormat:@"%lu", (unsigned long)i] ]];
+                break;
+        }
+        
+        [vectors addObject:argv];
+    }
+    
+    return vectors;
+}
+
+- (void)testInit
+{
+    CLKOptionSchema *schema = [self _schema];
+    
+    CLKBatchParser *parser = [CLKBatchParser batchParserWithSchema:schema];
+    XCTAssertNotNil(parser);
+    XCTAssertEqual(parser.schema, schema);
+    XCTAssertEqual(parser.workerCount, NSProcessInfo.processInfo.activeProcessorCount);
+    
+    parser = [CLKBatchParser batchParserWithSchema:schema workerCount:3];
+    XCTAssertEqual(parser.workerCount, 3UL);
+    
+    parser = [CLKBatchParser batchParserWithOptions:schema.options optionGroups:nil];
+    XCTAssertEqualObjects(parser.schema.options, schema.options);
+    XCTAssertNil(parser.schema.optionGroups);
+    
+    XCTAssertThrows([CLKBatchParser batchParserWithSchema:schema workerCount:0]);
+    
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    XCTAssertThrows([CLKBatchParser batchParserWithSchema:nil]);
+#pragma clang diagnostic pop
+}
+
+- (void)testEmptyBatch
+{
+    CLKBatchParser *parser = [CLKBatchParser batchParserWithSchema:[self _schema]];
+    XCTAssertEqualObjects([parser parseArgumentVectors:@[]], @[]);
+}
+
+- (void)testResultOrder
+{
+    CLKOptionSchema *schema = [self _schema];
+    NSArray<NSArray<NSString *> *> *vectors = [self _argumentVectorsWithCount:2000];
+    
+    // more workers than vectors, one worker, and a pool that has to steal
+    for (NSNumber *workerCount in @[ @(1), @(3), @(8), @(4096) ]) {
+        CLKBatchParser *batchParser = [CLKBatchParser batchParserWithSchema:schema workerCount:workerCount.unsignedIntegerValue];
+        NSArray<CLKParsingResult *> *results = [batchParser parseArgumentVectors:vectors];
+        XCTAssertEqual(results.count, vectors.count);
+        
+        [vectors enumerateObjectsUsingBlock:^(NSArray<NSString *> *argv, NSUInteger idx, __unused BOOL *outStop) {
+            CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv schema:schema];
+            CLKArgumentManifest *expectedManifest = [parser parseArguments];
+            CLKParsingResult *result = results[idx];
+            XCTAssertEqual(result.errorCount, parser.errors.count);
+            XCTAssertEqualObjects(result.errorCodes, [parser.errors valueForKey:@"code"]);
+            XCTAssertEqualObjects(result.errors, parser.errors);
+            XCTAssertEqualObjects(result.manifest.dictionaryRepresentationForAccumulatedOptions, expectedManifest.dictionaryRepresentationForAccumulatedOptions);
+            XCTAssertEqualObjects(result.manifest.positionalArguments, expectedManifest.positionalArguments);
+            XCTAssertEqual((result.manifest == nil), (expectedManifest == nil));
+        }];
+    }
+}
+
+#pragma mark -
+#pragma mark Benchmarks
+
+// the per-vector overhead of batching is the difference between this and -testPerformance_batchSingleWorker
+- (void)testPerformance_serialParsers
+{
+    CLKOptionSchema *schema = [self _schema];
+    NSArray<NSArray<NSString *> *> *vectors = [self _argumentVectorsWithCount:20000];
+    [self measureBlock:^{
+        for (NSArray<NSString *> *argv in vectors) {
+            @autoreleasepool {
+                CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv schema:schema];
+                (void)[parser parseArguments];
+            }
+        }
+    }];
+}
+
+- (void)testPerformance_batchSingleWorker
+{
+    CLKBatchParser *parser = [CLKBatchParser batchParserWithSchema:[self _schema] workerCount:1];
+    NSArray<NSArray<NSString *> *> *vectors = [self _argumentVectorsWithCount:20000];
+    [self measureBlock:^{
+        (void)[parser parseArgumentVectors:vectors];
+    }];
+}
+
+- (void)testPerformance_batchAllWorkers
+{
+    CLKBatchParser *parser = [CLKBatchParser batchParserWithSchema:[self _schema]];
+    NSArray<NSArray<NSString *> *> *vectors = [self _argumentVectorsWithCount:20000];
+    [self measureBlock:^{
+        (void)[parser parseArgumentVectors:vectors];
+    }];
+}
+
+@end
@@ -4,7 +4,8 @@
 
 #import <XCTest/XCTest.h>
 
-#import "CLKCommandResult.h"
+#import "CLKArgumentIssue.h"
+#import "CLKCommandResult_Private.h"
 #import "NSError+CLKAdditions.h"
 
 @interface Test_CLKCommandResult : XCTestCase
@@ -29,7 +30,7 @@
     XCTAssertEqual(result.exitStatus, 7);
     XCTAssertEqualObjects(result.errors, @[]);
     XCTAssertEqualObjects(result.userInfo, @{});
-
+    
     result = [[CLKCommandResult alloc] initWithExitStatus:7 errors:errors userInfo:nil];
     XCTAssertNotNil(result);
     XCTAssertEqual(result.exitStatus, 7);
@@ -79,4 +80,27 @@
     XCTAssertEqualObjects(result.errorDescription, @"aye mak sicur\nne cede malis");
 }
 
+- (void)test_errorDescription_issues
+{
+    NSArray *issues = @[
+        [CLKArgumentIssue issueWithPOSIXErrorCode:EINVAL salientOption:nil description:@"unrecognized option: '%@'" argument:@"--flarn"],
+        [CLKArgumentIssue issueWithCLKErrorCode:CLKErrorRequiredOptionNotProvided salientOptions:@[ @"barf" ] description:@"--%@: required option not provided" argument:@"barf" argument:nil]
+    ];
+    
+    CLKCommandResult *result = [[CLKCommandResult alloc] _initWithExitStatus:64 issues:issues];
+    XCTAssertEqual(result.exitStatus, 64);
+    XCTAssertEqualObjects(result.errorDescription, @"unrecognized option: '--flarn'\n--barf: required option not provided");
+    
+    NSArray *expectedErrors = @[
+        [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '--flarn'"],
+        [NSError clk_CLKErrorWithCode:CLKErrorRequiredOptionNotProvided description:@"--barf: required option not provided"]
+    ];
+    
+    XCTAssertEqualObjects(result.errors, expectedErrors);
+    
+    result = [[CLKCommandResult alloc] _initWithExitStatus:0 issues:@[]];
+    XCTAssertNil(result.errors);
+    XCTAssertNil(result.errorDescription);
+}
+
 @end
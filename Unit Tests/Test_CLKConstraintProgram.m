@@ -0,0 +1,164 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "CLKArgumentIssue.h"
+#import "CLKArgumentManifest_Private.h"
+#import "CLKArgumentManifestConstraint.h"
+#import "CLKArgumentManifestValidator.h"
+#import "CLKConstraintProgram.h"
+#import "CLKError.h"
+#import "CLKOption.h"
+#import "CLKOptionRegistry.h"
+#import "NSError+CLKAdditions.h"
+
+@interface Test_CLKConstraintProgram : XCTestCase
+
+@end
+
+@implementation Test_CLKConstraintProgram
+
+- (void)testCompilation
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"flarn" flag:@"f"],
+        [CLKOption optionWithName:@"barf" flag:@"b"],
+        [CLKOption optionWithName:@"quone" flag:@"q"]
+    ];
+    
+    CLKOptionRegistry *registry = [CLKOptionRegistry registryWithOptions:options];
+    NSOrderedSet *band = [NSOrderedSet orderedSetWithArray:@[ @"flarn", @"quone", @"xyzzy" ]];
+    NSArray *constraints = @[
+        [[CLKArgumentManifestConstraint alloc] initWithType:CLKConstraintTypeRequired bandedOptions:nil significantOption:@"barf" predicatingOption:@"quone"],
+        [[CLKArgumentManifestConstraint alloc] initWithType:CLKConstraintTypeMutuallyExclusive bandedOptions:band significantOption:nil predicatingOption:nil],
+        [[CLKArgumentManifestConstraint alloc] initWithType:CLKConstraintTypeRequired bandedOptions:nil significantOption:@"barf" predicatingOption:@"quone"],
+        [[CLKArgumentManifestConstraint alloc] initWithType:CLKConstraintTypeStandalone bandedOptions:nil significantOption:@"barf" predicatingOption:@"xyzzy"]
+    ];
+    
+    CLKConstraintProgram *program = [CLKConstraintProgram programWithConstraints:constraints optionRegistry:registry];
+    XCTAssertEqual(program.optionRegistry, registry);
+    XCTAssertEqual(program.bitsetWordCount, 1UL);
+    
+    // identical constraints are compiled once, in order of first appearance
+    XCTAssertEqual(program.instructionCount, 3UL);
+    XCTAssertEqualObjects([program constraintAtIndex:0], constraints[0]);
+    XCTAssertEqualObjects([program constraintAtIndex:1], constraints[1]);
+    XCTAssertEqualObjects([program constraintAtIndex:2], constraints[3]);
+    
+    const CLKConstraintInstruction *required = [program instructionAtIndex:0];
+    XCTAssertEqual(required->type, CLKConstraintTypeRequired);
+    XCTAssertEqual(required->significantOption, 1UL);
+    XCTAssertTrue(required->predicated);
+    XCTAssertEqual(required->predicatingOption, 2UL);
+    
+    // unregistered options are left out of bands
+    const CLKConstraintInstruction *mutex = [program instructionAtIndex:1];
+    XCTAssertFalse(mutex->predicated);
+    const uint64_t *mutexBand = [program bandForInstruction:mutex];
+    XCTAssertEqual(mutexBand[0], (uint64_t)0x5);
+    
+    // standalone bands include the significant option. unregistered predicates are still predicates.
+    const CLKConstraintInstruction *standalone = [program instructionAtIndex:2];
+    XCTAssertTrue(standalone->predicated);
+    XCTAssertEqual(standalone->predicatingOption, (NSUInteger)CLKConstraintOptionNone);
+    XCTAssertEqual([program bandForInstruction:standalone][0], (uint64_t)0x2);
+}
+
+- (void)testMonotonicInstructionIndexes
+{
+    NSArray *options = @[
+        [CLKOption optionWithName:@"flarn" flag:@"f"],
+        [CLKOption optionWithName:@"barf" flag:@"b"],
+        [CLKOption optionWithName:@"quone" flag:@"q"],
+        [CLKOption optionWithName:@"xyzzy" flag:@"x"]
+    ];
+    
+    CLKOptionRegistry *registry = [CLKOptionRegistry registryWithOptions:options];
+    NSOrderedSet *band = [NSOrderedSet orderedSetWithArray:@[ @"flarn", @"quone" ]];
+    NSOrderedSet *whitelist = [NSOrderedSet orderedSetWithArray:@[ @"flarn" ]];
+    NSArray *constraints = @[
+        [[CLKArgumentManifestConstraint alloc] initWithType:CLKConstraintTypeMutuallyExclusive bandedOptions:band significantOption:nil predicatingOption:nil],
+        [[CLKArgumentManifestConstraint alloc] initWithType:CLKConstraintTypeRequired bandedOptions:nil significantOption:@"barf" predicatingOption:@"xyzzy"],
+        [[CLKArgumentManifestConstraint alloc] initWithType:CLKConstraintTypeStandalone bandedOptions:whitelist significantOption:@"barf" predicatingOption:nil],
+        [[CLKArgumentManifestConstraint alloc] initWithType:CLKConstraintTypeOccurrencesLimited bandedOptions:nil significantOption:@"quone" predicatingOption:@"xyzzy"]
+    ];
+    
+    CLKConstraintProgram *program = [CLKConstraintProgram programWithConstraints:constraints optionRegistry:registry];
+    
+    // banded options, significant options and predicating options index their monotonic instructions, in program order.
+    // whitelisted options don't, and neither does anything involved only in a non-monotonic instruction.
+    NSArray<NSArray<NSNumber *> *> *expectedIndexes = @[ @[ @(0) ], @[ @(2) ], @[ @(0), @(3) ], @[ @(3) ] ];
+    for (NSUInteger i = 0 ; i < options.count ; i++) {
+        NSUInteger count;
+        const uint32_t *instructionIndexes = [program monotonicInstructionIndexesForOption:i count:&count];
+        NSMutableArray<NSNumber *> *indexes = [NSMutableArray array];
+        for (NSUInteger j = 0 ; j < count ; j++) {
+            [indexes addObject:@(instructionIndexes[j])];
+        }
+        
+        XCTAssertEqualObjects(indexes, expectedIndexes[i], @"option: %@", [options[i] name]);
+    }
+}
+
+- (void)testManyOptions
+{
+    // a large generated tool: one program, validated against several manifests
+    NSUInteger const optionCount = 2000;
+    NSMutableArray<CLKOption *> *options = [NSMutableArray array];
+    for (NSUInteger i = 0 ; i < optionCount ; i++) {
+        NSString *name = [NSString stringWithFormat:@"option-%lu", (unsigned long)i];
+        [options addObject:[CLKOption parameterOptionWithName:name flag:nil]];
+    }
+    
+    // mutex neighboring pairs of options; limit occurrences of every option
+    NSMutableArray<CLKArgumentManifestConstraint *> *constraints = [NSMutableArray array];
+    for (NSUInteger i = 0 ; i < optionCount ; i += 2) {
+        NSOrderedSet *band = [NSOrderedSet orderedSetWithArray:@[ options[i].name, options[i + 1].name ]];
+        [constraints addObject:[[CLKArgumentManifestConstraint alloc] initWithType:CLKConstraintTypeMutuallyExclusive bandedOptions:band significantOption:nil predicatingOption:nil]];
+    }
+    
+    for (CLKOption *option in options) {
+        [constraints addObject:[[CLKArgumentManifestConstraint alloc] initWithType:CLKConstraintTypeOccurrencesLimited bandedOptions:nil significantOption:option.name predicatingOption:nil]];
+    }
+    
+    CLKOptionRegistry *registry = [CLKOptionRegistry registryWithOptions:options];
+    CLKConstraintProgram *program = [CLKConstraintProgram programWithConstraints:constraints optionRegistry:registry];
+    XCTAssertEqual(program.bitsetWordCount, 32UL);
+    
+    CLKArgumentManifest *passingManifest = [[CLKArgumentManifest alloc] initWithOptionRegistry:registry];
+    CLKArgumentManifest *failingManifest = [[CLKArgumentManifest alloc] initWithOptionRegistry:registry];
+    for (NSUInteger i = 0 ; i < optionCount ; i += 2) {
+        [passingManifest accumulateArgument:@"flarn" forParameterOptionNamed:options[i].name];
+    }
+    
+    [failingManifest accumulateArgument:@"flarn" forParameterOptionNamed:@"option-1998"];
+    [failingManifest accumulateArgument:@"flarn" forParameterOptionNamed:@"option-1999"];
+    [failingManifest accumulateArgument:@"flarn" forParameterOptionNamed:@"option-7"];
+    [failingManifest accumulateArgument:@"barf" forParameterOptionNamed:@"option-7"];
+    
+    NSMutableArray<CLKArgumentIssue *> *issues = [NSMutableArray array];
+    CLKArgumentManifestValidator *validator = [[CLKArgumentManifestValidator alloc] initWithManifest:passingManifest];
+    [validator validateConstraintProgram:program issueHandler:^(CLKArgumentIssue *issue) {
+        [issues addObject:issue];
+    }];
+    
+    XCTAssertEqualObjects(issues, @[]);
+    
+    validator = [[CLKArgumentManifestValidator alloc] initWithManifest:failingManifest];
+    [validator validateConstraintProgram:program issueHandler:^(CLKArgumentIssue *issue) {
+        [issues addObject:issue];
+    }];
+    
+    NSError *mutexError = [NSError clk_CLKErrorWithCode:CLKErrorMutuallyExclusiveOptionsPresent description:@"--option-1998 --option-1999: mutually exclusive options encountered"];
+    NSError *limitError = [NSError clk_CLKErrorWithCode:CLKErrorTooManyOccurrencesOfOption description:@"--option-7 may not be provided more than once"];
+    NSArray *expectedIssues = @[
+        [CLKArgumentIssue issueWithError:mutexError salientOptions:@[ @"option-1998", @"option-1999" ]],
+        [CLKArgumentIssue issueWithError:limitError salientOption:@"option-7"]
+    ];
+    
+    XCTAssertEqualObjects(issues, expectedIssues);
+}
+
+@end
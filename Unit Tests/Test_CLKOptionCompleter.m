@@ -0,0 +1,105 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "CLKOption.h"
+#import "CLKOptionCompleter.h"
+#import "CLKOptionGroup.h"
+#import "CLKOptionSchema.h"
+
+@interface Test_CLKOptionCompleter : XCTestCase
+
+@end
+
+@implementation Test_CLKOptionCompleter
+
+- (void)testInit
+{
+    CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:@[ [CLKOption optionWithName:@"flarn" flag:@"f"] ]];
+    CLKOptionCompleter *completer = [CLKOptionCompleter completerWithSchema:schema];
+    XCTAssertNotNil(completer);
+    XCTAssertEqual(completer.schema, schema);
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    XCTAssertThrows([CLKOptionCompleter completerWithSchema:nil]);
+    XCTAssertThrows([completer completionsForWord:nil precedingWords:@[]]);
+    XCTAssertThrows([completer completionsForWord:@"" precedingWords:nil]);
+#pragma clang diagnostic pop
+}
+
+- (void)testCompletions
+{
+    NSArray<CLKOption *> *options = @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption optionWithName:@"version" flag:nil],
+        [CLKOption parameterOptionWithName:@"alpha" flag:@"a"],
+        [CLKOption parameterOptionWithName:@"bravo" flag:@"b" required:NO recurrent:YES transformer:nil],
+        [CLKOption optionWithName:@"quiet" flag:@"q"]
+    ];
+    
+    CLKOptionCompleter *completer = [CLKOptionCompleter completerWithSchema:[CLKOptionSchema schemaWithOptions:options]];
+    XCTAssertEqualObjects([completer completionsForWord:@"" precedingWords:@[]], (@[ @"--alpha", @"--bravo", @"--quiet", @"--verbose", @"--version" ]));
+    XCTAssertEqualObjects([completer completionsForWord:@"-" precedingWords:@[]], (@[ @"-a", @"-b", @"-q", @"-v", @"--alpha", @"--bravo", @"--quiet", @"--verbose", @"--version" ]));
+    XCTAssertEqualObjects([completer completionsForWord:@"--" precedingWords:@[]], (@[ @"--alpha", @"--bravo", @"--quiet", @"--verbose", @"--version" ]));
+    XCTAssertEqualObjects([completer completionsForWord:@"--ver" precedingWords:@[]], (@[ @"--verbose", @"--version" ]));
+    XCTAssertEqualObjects([completer completionsForWord:@"--verb" precedingWords:@[]], @[ @"--verbose" ]);
+    XCTAssertEqualObjects([completer completionsForWord:@"--verbose" precedingWords:@[]], @[ @"--verbose" ]);
+    XCTAssertEqualObjects([completer completionsForWord:@"-q" precedingWords:@[]], @[ @"-q" ]);
+    XCTAssertEqualObjects([completer completionsForWord:@"-x" precedingWords:@[]], @[]);
+    XCTAssertEqualObjects([completer completionsForWord:@"--x" precedingWords:@[]], @[]);
+    XCTAssertEqualObjects([completer completionsForWord:@"--alpha=" precedingWords:@[]], @[]);
+    XCTAssertEqualObjects([completer completionsForWord:@"-qv" precedingWords:@[]], @[]);
+    XCTAssertEqualObjects([completer completionsForWord:@"flarn" precedingWords:@[]], @[]);
+    
+    // non-recurrent parameter options are offered once; switches and recurrent parameter options remain
+    NSArray<NSString *> *expected = @[ @"--bravo", @"--quiet", @"--verbose", @"--version" ];
+    XCTAssertEqualObjects([completer completionsForWord:@"" precedingWords:@[ @"--alpha", @"flarn", @"--bravo", @"barf", @"-v" ]], expected);
+    XCTAssertEqualObjects([completer completionsForWord:@"" precedingWords:@[ @"-a", @"flarn" ]], expected);
+    XCTAssertEqualObjects([completer completionsForWord:@"" precedingWords:@[ @"--alpha=flarn" ]], expected);
+    XCTAssertEqualObjects([completer completionsForWord:@"" precedingWords:@[ @"-qa", @"flarn" ]], expected);
+    XCTAssertEqualObjects([completer completionsForWord:@"-" precedingWords:@[ @"positional", @"-a", @"flarn" ]], (@[ @"-b", @"-q", @"-v", @"--bravo", @"--quiet", @"--verbose", @"--version" ]));
+    
+    // the word is a parameter option's argument
+    XCTAssertEqualObjects([completer completionsForWord:@"" precedingWords:@[ @"--alpha" ]], @[]);
+    XCTAssertEqualObjects([completer completionsForWord:@"-" precedingWords:@[ @"-qb" ]], @[]);
+    
+    // the word follows the remainder sentinel
+    XCTAssertEqualObjects([completer completionsForWord:@"--" precedingWords:@[ @"-q", @"--" ]], @[]);
+}
+
+- (void)testCompletions_constraints
+{
+    NSArray<CLKOption *> *options = @[
+        [CLKOption optionWithName:@"alpha" flag:@"a"],
+        [CLKOption optionWithName:@"bravo" flag:@"b"],
+        [CLKOption optionWithName:@"charlie" flag:@"c"],
+        [CLKOption optionWithName:@"delta" flag:@"d"],
+        [CLKOption standaloneOptionWithName:@"help" flag:@"h"],
+        [CLKOption optionWithName:@"echo" flag:@"e"]
+    ];
+    
+    NSArray<CLKOptionGroup *> *groups = @[
+        [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"alpha", @"bravo", @"charlie" ]],
+        [CLKOptionGroup standaloneGroupForOptionNamed:@"delta" allowing:@[ @"echo" ]]
+    ];
+    
+    CLKOptionCompleter *completer = [CLKOptionCompleter completerWithSchema:[CLKOptionSchema schemaWithOptions:options optionGroups:groups]];
+    XCTAssertEqualObjects([completer completionsForWord:@"" precedingWords:@[]], (@[ @"--alpha", @"--bravo", @"--charlie", @"--delta", @"--echo", @"--help" ]));
+    
+    // once a mutexed option is present the others in its group are left out (but it isn't)
+    // and standalone options can no longer be used
+    XCTAssertEqualObjects([completer completionsForWord:@"" precedingWords:@[ @"--bravo" ]], (@[ @"--bravo", @"--echo" ]));
+    XCTAssertEqualObjects([completer completionsForWord:@"-" precedingWords:@[ @"-b" ]], (@[ @"-b", @"-e", @"--bravo", @"--echo" ]));
+    
+    // a present standalone option only allows its whitelist
+    XCTAssertEqualObjects([completer completionsForWord:@"" precedingWords:@[ @"--delta" ]], (@[ @"--delta", @"--echo" ]));
+    XCTAssertEqualObjects([completer completionsForWord:@"" precedingWords:@[ @"-h" ]], @[ @"--help" ]);
+    
+    // options in a standalone option's whitelist don't rule it out
+    XCTAssertEqualObjects([completer completionsForWord:@"" precedingWords:@[ @"--echo" ]], (@[ @"--alpha", @"--bravo", @"--charlie", @"--delta", @"--echo" ]));
+}
+
+@end
@@ -6,6 +6,7 @@
 
 #import "CLKOption.h"
 #import "CLKOptionRegistry.h"
+#import "CLKSuggestionIndex.h"
 
 @interface Test_CLKOptionRegistry : XCTestCase
 
@@ -36,7 +37,7 @@
     ];
     
     XCTAssertThrowsSpecificNamed([[CLKOptionRegistry alloc] initWithOptions:options], NSException, NSInvalidArgumentException);
-
+    
     // flag collision: two -x opt flags, different names
     options = @[
          [CLKOption parameterOptionWithName:@"xyzzy" flag:@"x"],
@@ -45,6 +46,14 @@
     ];
     
     XCTAssertThrowsSpecificNamed([[CLKOptionRegistry alloc] initWithOptions:options], NSException, NSInvalidArgumentException);
+    
+    // flag collision outside the ASCII range
+    options = @[
+         [CLKOption optionWithName:@"flarn" flag:@"\u00e4"],
+         [CLKOption optionWithName:@"barf" flag:@"\u00e4"],
+    ];
+    
+    XCTAssertThrowsSpecificNamed([[CLKOptionRegistry alloc] initWithOptions:options], NSException, NSInvalidArgumentException);
 }
 
 - (void)testOptionLookup
@@ -62,6 +71,167 @@
     XCTAssertNil([registry optionForFlag:@"x"]);
 }
 
+- (void)testOptionLookup_manyOptions
+{
+    // enough names to exercise multi-name buckets in the name hash
+    NSMutableArray<CLKOption *> *options = [NSMutableArray array];
+    for (NSUInteger i = 0 ; i < 2000 ; i++) {
+        NSString *name = [NSString stringWithFormat:@"option-%lu", (unsigned long)i];
+        [options addObject:[CLKOption optionWithName:name flag:nil]];
+    }
+    
+    CLKOptionRegistry *registry = [[CLKOptionRegistry alloc] initWithOptions:options];
+    for (CLKOption *option in options) {
+        XCTAssertEqual([registry optionNamed:option.name], option);
+    }
+    
+    for (NSUInteger i = 2000 ; i < 4000 ; i++) {
+        NSString *name = [NSString stringWithFormat:@"option-%lu", (unsigned long)i];
+        XCTAssertNil([registry optionNamed:name]);
+    }
+    
+    XCTAssertNil([registry optionNamed:@"option-"]);
+    XCTAssertNil([registry optionNamed:@"option-1999-"]);
+}
+
+- (void)testOptionLookup_substrings
+{
+    CLKOption *flarn = [CLKOption optionWithName:@"flarn" flag:@"f"];
+    CLKOption *umlautFlarn = [CLKOption optionWithName:@"flärn" flag:@"ä"];
+    CLKOptionRegistry *registry = [[CLKOptionRegistry alloc] initWithOptions:@[ flarn, umlautFlarn ]];
+    
+    XCTAssertEqual([registry optionNamedInString:@"--flarn" range:NSMakeRange(2, 5)], flarn);
+    XCTAssertEqual([registry optionNamedInString:@"--flarn=barf" range:NSMakeRange(2, 5)], flarn);
+    XCTAssertEqual([registry optionNamedInString:@"--flärn" range:NSMakeRange(2, 5)], umlautFlarn);
+    XCTAssertNil([registry optionNamedInString:@"--flarn" range:NSMakeRange(2, 4)]);
+    XCTAssertNil([registry optionNamedInString:@"--flarn" range:NSMakeRange(1, 6)]);
+    
+    NSString *longName = [@"" stringByPaddingToLength:300 withString:@"flarn" startingAtIndex:0];
+    XCTAssertNil([registry optionNamed:longName]);
+    
+    XCTAssertEqual([registry optionForFlagCharacter:'f'], flarn);
+    XCTAssertEqual([registry optionForFlagCharacter:0x00e4], umlautFlarn);
+    XCTAssertEqual([registry optionForFlag:@"ä"], umlautFlarn);
+    XCTAssertNil([registry optionForFlagCharacter:'x']);
+    XCTAssertNil([registry optionForFlagCharacter:0x00e5]);
+}
+
+- (void)testOptionLookup_empty
+{
+    CLKOptionRegistry *registry = [[CLKOptionRegistry alloc] initWithOptions:@[]];
+    XCTAssertNil([registry optionNamed:@"flarn"]);
+    XCTAssertNil([registry optionForFlag:@"f"]);
+    XCTAssertEqualObjects(registry.options, @[]);
+}
+
+- (void)testOptionLookup_prefixes
+{
+    CLKOption *verbose = [CLKOption optionWithName:@"verbose" flag:@"v"];
+    CLKOption *version = [CLKOption optionWithName:@"version" flag:nil];
+    CLKOption *verb = [CLKOption parameterOptionWithName:@"verb" flag:nil];
+    CLKOption *output = [CLKOption parameterOptionWithName:@"output" flag:@"o"];
+    CLKOptionRegistry *registry = [CLKOptionRegistry registryWithOptions:@[ verbose, version, verb, output ]];
+    
+    XCTAssertEqual([registry optionNamedWithPrefix:@"verbo"], verbose);
+    XCTAssertEqual([registry optionNamedWithPrefix:@"vers"], version);
+    XCTAssertEqual([registry optionNamedWithPrefix:@"o"], output);
+    
+    // a full name wins over the longer names it begins
+    XCTAssertEqual([registry optionNamedWithPrefix:@"verb"], verb);
+    XCTAssertEqual([registry optionNamedWithPrefix:@"verbose"], verbose);
+    
+    XCTAssertNil([registry optionNamedWithPrefix:@"ver"]);
+    XCTAssertNil([registry optionNamedWithPrefix:@"outputs"]);
+    XCTAssertNil([registry optionNamedWithPrefix:@"x"]);
+    XCTAssertNil([registry optionNamed:@"verbo"]);
+    
+    const unichar characters[] = { 'o', 'u', 't' };
+    XCTAssertEqual([registry optionNamedWithPrefixCharacters:characters length:3], output);
+    
+    // inherited names are abbreviated too, and make abbreviations of their heirs' names ambiguous
+    CLKOption *verify = [CLKOption optionWithName:@"verify" flag:nil];
+    CLKOption *quiet = [CLKOption optionWithName:@"quiet" flag:@"q"];
+    CLKOptionRegistry *parent = [CLKOptionRegistry registryWithOptions:@[ quiet, verify ]];
+    CLKOptionRegistry *child = [[CLKOptionRegistry alloc] initWithOptions:@[ verbose ] parentRegistry:parent];
+    XCTAssertEqual([child optionNamedWithPrefix:@"q"], quiet);
+    XCTAssertEqual([child optionNamedWithPrefix:@"verb"], verbose);
+    XCTAssertEqual([child optionNamedWithPrefix:@"veri"], verify);
+    XCTAssertNil([child optionNamedWithPrefix:@"ver"]);
+    XCTAssertEqual([parent optionNamedWithPrefix:@"ver"], verify);
+    
+    // names longer than the stack buffer
+    NSString *longName = [@"" stringByPaddingToLength:(CLKOptionNameStackBufferLength + 10) withString:@"long-option-" startingAtIndex:0];
+    CLKOption *longOption = [CLKOption optionWithName:longName flag:nil];
+    CLKOptionRegistry *longRegistry = [CLKOptionRegistry registryWithOptions:@[ verbose, longOption ]];
+    XCTAssertEqual([longRegistry optionNamedWithPrefix:[longName substringToIndex:(CLKOptionNameStackBufferLength + 5)]], longOption);
+    XCTAssertEqual([longRegistry optionNamedWithPrefix:@"l"], longOption);
+}
+
+- (void)testParentRegistry
+{
+    CLKOption *verbose = [CLKOption optionWithName:@"verbose" flag:@"v"];
+    CLKOption *umlaut = [CLKOption optionWithName:@"ärger" flag:@"ä"];
+    CLKOptionRegistry *grandparent = [[CLKOptionRegistry alloc] initWithOptions:@[ verbose, umlaut ]];
+    
+    CLKOption *quiet = [CLKOption optionWithName:@"quiet" flag:@"q"];
+    CLKOptionRegistry *parent = [[CLKOptionRegistry alloc] initWithOptions:@[ quiet ] parentRegistry:grandparent];
+    
+    CLKOption *flarn = [CLKOption optionWithName:@"flarn" flag:@"f"];
+    CLKOption *barf = [CLKOption parameterOptionWithName:@"barf" flag:nil];
+    CLKOptionRegistry *registry = [[CLKOptionRegistry alloc] initWithOptions:@[ flarn, barf ] parentRegistry:parent];
+    XCTAssertEqual(registry.parentRegistry, parent);
+    XCTAssertEqual(registry.inheritedOptionCount, 3UL);
+    XCTAssertEqual(parent.inheritedOptionCount, 2UL);
+    XCTAssertEqual(grandparent.inheritedOptionCount, 0UL);
+    XCTAssertNil(grandparent.parentRegistry);
+    
+    // inherited options come first, at the same indexes as in the registries they come from
+    XCTAssertEqualObjects(registry.options, (@[ verbose, umlaut, quiet, flarn, barf ]));
+    XCTAssertEqual([registry indexOfOptionNamed:@"verbose"], 0UL);
+    XCTAssertEqual([registry indexOfOptionNamed:@"quiet"], 2UL);
+    XCTAssertEqual([registry indexOfOptionNamed:@"quiet"], [parent indexOfOptionNamed:@"quiet"]);
+    XCTAssertEqual([registry indexOfOptionNamed:@"barf"], 4UL);
+    XCTAssertEqual([registry indexOfOptionNamed:@"xyzzy"], NSNotFound);
+    
+    XCTAssertEqual([registry optionNamed:@"flarn"], flarn);
+    XCTAssertEqual([registry optionNamed:@"quiet"], quiet);
+    XCTAssertEqual([registry optionNamedInString:@"--verbose" range:NSMakeRange(2, 7)], verbose);
+    XCTAssertEqual([registry optionForFlag:@"f"], flarn);
+    XCTAssertEqual([registry optionForFlag:@"q"], quiet);
+    XCTAssertEqual([registry optionForFlag:@"v"], verbose);
+    XCTAssertEqual([registry optionForFlagCharacter:0x00e4], umlaut);
+    XCTAssertNil([registry optionForFlag:@"x"]);
+    XCTAssertNil([registry optionForFlagCharacter:0x00e5]);
+    XCTAssertTrue([registry hasOptionNamed:@"ärger"]);
+    
+    // the parents don't see their children's options
+    XCTAssertNil([parent optionNamed:@"flarn"]);
+    XCTAssertNil([grandparent optionForFlag:@"q"]);
+    XCTAssertEqual(parent.options.count, 3UL);
+    
+    // a registry with no options of its own still finds the inherited ones
+    CLKOptionRegistry *emptyRegistry = [[CLKOptionRegistry alloc] initWithOptions:@[] parentRegistry:parent];
+    XCTAssertEqual([emptyRegistry optionNamed:@"quiet"], quiet);
+    XCTAssertEqual([emptyRegistry optionForFlag:@"v"], verbose);
+    XCTAssertEqualObjects(emptyRegistry.options, parent.options);
+    
+    XCTAssertEqualObjects([registry.nameSuggestionIndex suggestionsForString:@"verbos"], @[ @"verbose" ]);
+}
+
+- (void)testParentRegistry_collisions
+{
+    CLKOptionRegistry *parent = [[CLKOptionRegistry alloc] initWithOptions:@[ [CLKOption optionWithName:@"verbose" flag:@"v"], [CLKOption optionWithName:@"ärger" flag:@"ä"] ]];
+    
+    NSArray *options = @[ [CLKOption optionWithName:@"verbose" flag:@"x"] ];
+    XCTAssertThrowsSpecificNamed([[CLKOptionRegistry alloc] initWithOptions:options parentRegistry:parent], NSException, NSInvalidArgumentException);
+    
+    options = @[ [CLKOption optionWithName:@"vertical" flag:@"v"] ];
+    XCTAssertThrowsSpecificNamed([[CLKOptionRegistry alloc] initWithOptions:options parentRegistry:parent], NSException, NSInvalidArgumentException);
+    
+    options = @[ [CLKOption optionWithName:@"anger" flag:@"ä"] ];
+    XCTAssertThrowsSpecificNamed([[CLKOptionRegistry alloc] initWithOptions:options parentRegistry:parent], NSException, NSInvalidArgumentException);
+}
+
 - (void)test_hasOptionNamed
 {
     CLKOption *flarn = [CLKOption optionWithName:@"flarn" flag:@"f"];
@@ -0,0 +1,122 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "CLKArgumentManifest.h"
+#import "CLKArgumentParser.h"
+#import "CLKOption.h"
+#import "CLKOptionGroup.h"
+#import "CLKOptionSchema.h"
+#import "NSError+CLKAdditions.h"
+
+@interface Test_CLKOptionSchema : XCTestCase
+
+@end
+
+@implementation Test_CLKOptionSchema
+
+- (void)testInit
+{
+    NSArray *options = @[
+         [CLKOption optionWithName:@"flarn" flag:@"f"],
+         [CLKOption optionWithName:@"barf" flag:@"b"]
+    ];
+    
+    CLKOptionGroup *group = [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"flarn", @"barf" ]];
+    CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:options optionGroups:@[ group ]];
+    XCTAssertNotNil(schema);
+    XCTAssertEqualObjects(schema.options, options);
+    XCTAssertEqualObjects(schema.optionGroups, @[ group ]);
+    
+    schema = [CLKOptionSchema schemaWithOptions:options];
+    XCTAssertNotNil(schema);
+    XCTAssertNil(schema.optionGroups);
+    
+    XCTAssertNotNil([CLKOptionSchema schemaWithOptions:@[]]);
+    XCTAssertNotNil([CLKOptionSchema schemaWithOptions:options optionGroups:@[]]);
+    
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    XCTAssertThrows([CLKOptionSchema schemaWithOptions:nil]);
+#pragma clang diagnostic pop
+}
+
+- (void)testInvalidGroups
+{
+    NSArray *options = @[
+         [CLKOption optionWithName:@"flarn" flag:@"f"],
+         [CLKOption optionWithName:@"barf" flag:@"b"]
+    ];
+    
+    CLKOptionGroup *group = [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"flarn", @"quone" ]];
+    XCTAssertThrowsSpecificNamed([CLKOptionSchema schemaWithOptions:options optionGroups:@[ group ]], NSException, NSInvalidArgumentException);
+}
+
+- (void)testSharedSchema
+{
+    NSArray *options = @[
+         [CLKOption parameterOptionWithName:@"input" flag:@"i" required:NO recurrent:YES transformer:nil],
+         [CLKOption optionWithName:@"verbose" flag:@"v"],
+         [CLKOption optionWithName:@"quiet" flag:@"q"]
+    ];
+    
+    CLKOptionGroup *group = [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"verbose", @"quiet" ]];
+    CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:options optionGroups:@[ group ]];
+    
+    CLKArgumentParser *alphaParser = [CLKArgumentParser parserWithArgumentVector:@[ @"-v", @"--input", @"flarn" ] schema:schema];
+    CLKArgumentParser *bravoParser = [CLKArgumentParser parserWithArgumentVector:@[ @"-q", @"-i", @"barf", @"-i", @"quone" ] schema:schema];
+    CLKArgumentParser *charlieParser = [CLKArgumentParser parserWithArgumentVector:@[ @"-vq" ] schema:schema];
+    
+    const char *argv[] = { "--verbose", "-i=xyzzy" };
+    CLKArgumentParser *deltaParser = [CLKArgumentParser parserWithArgv:argv argc:2 schema:schema];
+    
+    CLKArgumentManifest *manifest = [alphaParser parseArguments];
+    XCTAssertEqualObjects(manifest[@"verbose"], @(1));
+    XCTAssertEqualObjects(manifest[@"input"], @[ @"flarn" ]);
+    XCTAssertNil(manifest[@"quiet"]);
+    
+    manifest = [bravoParser parseArguments];
+    XCTAssertEqualObjects(manifest[@"quiet"], @(1));
+    XCTAssertEqualObjects(manifest[@"input"], (@[ @"barf", @"quone" ]));
+    XCTAssertNil(manifest[@"verbose"]);
+    
+    // the schema's group constraints apply to every parser that uses it
+    XCTAssertNil([charlieParser parseArguments]);
+    NSError *expectedError = [NSError clk_CLKErrorWithCode:CLKErrorMutuallyExclusiveOptionsPresent description:@"--verbose --quiet: mutually exclusive options encountered"];
+    XCTAssertEqualObjects(charlieParser.errors, @[ expectedError ]);
+    
+    manifest = [deltaParser parseArguments];
+    XCTAssertEqualObjects(manifest[@"verbose"], @(1));
+    XCTAssertEqualObjects(manifest[@"input"], @[ @"xyzzy" ]);
+}
+
+- (void)testHandles
+{
+    NSArray *options = @[
+         [CLKOption parameterOptionWithName:@"input" flag:@"i" required:NO recurrent:YES transformer:nil],
+         [CLKOption optionWithName:@"verbose" flag:@"v"]
+    ];
+    
+    CLKOptionSchema *schema = [CLKOptionSchema schemaWithOptions:options];
+    CLKOptionHandle input = [schema handleForOptionNamed:@"input"];
+    CLKOptionHandle verbose = [schema handleForOptionNamed:@"verbose"];
+    CLKOptionHandle quone = [schema handleForOptionNamed:@"quone"];
+    XCTAssertNotEqual(input, verbose);
+    XCTAssertEqual(quone, CLKOptionHandleNone);
+    
+    // handles resolved from the schema agree with the manifests of every parser using it
+    NSArray *argvs = @[ @[ @"-vv", @"-i", @"flarn" ], @[ @"-i", @"barf", @"-i", @"quone" ] ];
+    for (NSArray *argv in argvs) {
+        CLKArgumentManifest *manifest = [[CLKArgumentParser parserWithArgumentVector:argv schema:schema] parseArguments];
+        XCTAssertEqual([manifest handleForOptionNamed:@"input"], input);
+        XCTAssertEqual([manifest handleForOptionNamed:@"verbose"], verbose);
+        XCTAssertEqual([manifest argumentCountForOption:input], [manifest[@"input"] count]);
+        XCTAssertEqual([manifest switchCountForOption:verbose], [manifest[@"verbose"] unsignedIntegerValue]);
+        XCTAssertEqualObjects([manifest argumentAtIndex:0 forOption:input], manifest[@"input"][0]);
+        XCTAssertFalse([manifest hasOption:quone]);
+    }
+}
+
+@end
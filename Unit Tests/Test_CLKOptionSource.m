@@ -0,0 +1,355 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "CLKArgumentEvent.h"
+#import "CLKArgumentManifest_Private.h"
+#import "CLKArgumentParser.h"
+#import "CLKArgumentTransformer.h"
+#import "CLKError.h"
+#import "CLKOption.h"
+#import "CLKOptionGroup.h"
+#import "CLKOptionRegistry.h"
+#import "CLKOptionSource_Private.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface Test_CLKOptionSource : XCTestCase
+{
+    NSString *_directory;
+}
+
+- (NSArray<CLKOption *> *)_options;
+- (NSString *)_writeConfigFile:(NSString *)contents named:(NSString *)name;
+- (NSArray *)_settingsOfSource:(CLKOptionSource *)source inRegistry:(CLKOptionRegistry *)registry;
+- (nullable CLKArgumentManifest *)_parseArguments:(NSArray<NSString *> *)argv sources:(NSArray<CLKOptionSource *> *)sources errors:(NSArray<NSError *> *_Nullable *_Nullable)outErrors;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation Test_CLKOptionSource
+
+- (void)setUp
+{
+    [super setUp];
+    _directory = [NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString];
+    [NSFileManager.defaultManager createDirectoryAtPath:_directory withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+- (void)tearDown
+{
+    [NSFileManager.defaultManager removeItemAtPath:_directory error:NULL];
+    [super tearDown];
+}
+
+- (NSArray<CLKOption *> *)_options
+{
+    return @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption optionWithName:@"dry-run" flag:@"n"],
+        [CLKOption parameterOptionWithName:@"output" flag:@"o"],
+        [CLKOption parameterOptionWithName:@"count" flag:@"c" required:NO recurrent:YES transformer:[CLKIntArgumentTransformer new]]
+    ];
+}
+
+- (NSString *)_writeConfigFile:(NSString *)contents named:(NSString *)name
+{
+    NSString *path = [_directory stringByAppendingPathComponent:name];
+    XCTAssertTrue([contents writeToFile:path atomically:NO encoding:NSUTF8StringEncoding error:NULL]);
+    return path;
+}
+
+// [ option index, values ] pairs in the order the source enumerates them
+- (NSArray *)_settingsOfSource:(CLKOptionSource *)source inRegistry:(CLKOptionRegistry *)registry
+{
+    NSMutableArray *settings = [NSMutableArray array];
+    [source _enumerateSettingsInRegistry:registry usingBlock:^(NSUInteger optionIndex, NSArray<NSString *> *values) {
+        [settings addObject:@[ @(optionIndex), values ]];
+    }];
+    
+    return settings;
+}
+
+- (CLKArgumentManifest *)_parseArguments:(NSArray<NSString *> *)argv sources:(NSArray<CLKOptionSource *> *)sources errors:(NSArray<NSError *> **)outErrors
+{
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:[self _options]];
+    parser.optionSources = sources;
+    CLKArgumentManifest *manifest = [parser parseArguments];
+    if (outErrors != NULL) {
+        *outErrors = parser.errors;
+    }
+    
+    return manifest;
+}
+
+#pragma mark -
+
+- (void)testEnvironmentSource
+{
+    NSDictionary *environment = @{
+        @"CLKIT_VERBOSE" : @"2",
+        @"CLKIT_DRY_RUN" : @"",
+        @"CLKIT_OUTPUT" : @"/tmp/flarn",
+        @"CLKIT_" : @"barf",
+        @"CLKITOUTPUT" : @"quone",
+        @"PATH" : @"/bin"
+    };
+    
+    CLKOptionSource *source = [CLKOptionSource sourceWithEnvironment:environment];
+    XCTAssertEqualObjects(source.name, @"environment");
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"verbose"], @[ @"2" ]);
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"dry-run"], @[ @"" ]);
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"output"], @[ @"/tmp/flarn" ]);
+    XCTAssertNil([source valuesForOptionNamed:@"count"]);
+    XCTAssertNil([source valuesForOptionNamed:@"path"]);
+    XCTAssertEqualObjects([source _locationOfOptionNamed:@"dry-run"], @"CLKIT_DRY_RUN");
+    
+    CLKOptionRegistry *registry = [CLKOptionRegistry registryWithOptions:[self _options]];
+    XCTAssertEqualObjects([source _unrecognizedOptionNamesInRegistry:registry], @[]);
+    XCTAssertEqualObjects([self _settingsOfSource:source inRegistry:registry], (@[ @[ @(0), @[ @"2" ] ], @[ @(1), @[ @"" ] ], @[ @(2), @[ @"/tmp/flarn" ] ] ]));
+    
+    // names that differ only in dashes and underscores share a variable
+    registry = [CLKOptionRegistry registryWithOptions:@[ [CLKOption optionWithName:@"dry-run" flag:nil], [CLKOption optionWithName:@"dry_run" flag:nil] ]];
+    XCTAssertEqualObjects(registry.environmentKeyIndex, (@{ @"DRY_RUN" : [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)] }));
+    XCTAssertEqual(registry.environmentKeyIndex, registry.environmentKeyIndex);
+    XCTAssertEqualObjects([self _settingsOfSource:source inRegistry:registry], (@[ @[ @(0), @[ @"" ] ], @[ @(1), @[ @"" ] ] ]));
+    
+    XCTAssertEqual(CLKOptionSource.environmentSource, CLKOptionSource.environmentSource);
+}
+
+- (void)testConfigFileSource
+{
+    NSString *contents = @"# defaults\n"
+                          "\n"
+                          "  verbose\n"
+                          "output = /tmp/flarn = barf  \n"
+                          "count=1\n"
+                          "xyzzy = 7\n"
+                          "count = 2\r\n"
+                          "dry-run=\n";
+    
+    NSString *path = [self _writeConfigFile:contents named:@"flarn.conf"];
+    NSError *error = nil;
+    CLKOptionSource *source = [CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:nil error:&error];
+    XCTAssertNotNil(source, @"%@", error);
+    XCTAssertFalse(source._loadedFromCache);
+    XCTAssertEqualObjects(source.name, path.stringByStandardizingPath);
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"verbose"], @[ @"" ]);
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"output"], @[ @"/tmp/flarn = barf" ]);
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"count"], (@[ @"1", @"2" ]));
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"dry-run"], @[ @"" ]);
+    XCTAssertNil([source valuesForOptionNamed:@"quone"]);
+    XCTAssertNil([source valuesForOptionNamed:@"coun"]);
+    
+    CLKOptionRegistry *registry = [CLKOptionRegistry registryWithOptions:[self _options]];
+    XCTAssertEqualObjects([source _unrecognizedOptionNamesInRegistry:registry], @[ @"xyzzy" ]);
+    NSArray *expectedSettings = @[ @[ @(0), @[ @"" ] ], @[ @(1), @[ @"" ] ], @[ @(2), @[ @"/tmp/flarn = barf" ] ], @[ @(3), @[ @"1", @"2" ] ] ];
+    XCTAssertEqualObjects([self _settingsOfSource:source inRegistry:registry], expectedSettings);
+    
+    path = [self _writeConfigFile:@"" named:@"empty.conf"];
+    source = [CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:nil error:&error];
+    XCTAssertNotNil(source, @"%@", error);
+    XCTAssertNil([source valuesForOptionNamed:@"verbose"]);
+}
+
+- (void)testConfigFileSource_errors
+{
+    NSError *error = nil;
+    NSString *path = [_directory stringByAppendingPathComponent:@"missing.conf"];
+    XCTAssertNil([CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:nil error:&error]);
+    XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+    XCTAssertEqual(error.code, ENOENT);
+    
+    NSArray<NSString *> *malformedContents = @[
+        @"verbose\n= barf\n",
+        @"dry run = yes\n",
+        @"=\n"
+    ];
+    
+    for (NSString *contents in malformedContents) {
+        path = [self _writeConfigFile:contents named:@"malformed.conf"];
+        error = nil;
+        XCTAssertNil([CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:_directory error:&error], @"%@", contents);
+        XCTAssertEqualObjects(error.domain, CLKErrorDomain);
+        XCTAssertEqual(error.code, CLKErrorInvalidConfigFile);
+    }
+    
+    path = [_directory stringByAppendingPathComponent:@"binary.conf"];
+    const uint8_t bytes[] = { 0xff, 0xfe, 0x00 };
+    XCTAssertTrue([[NSData dataWithBytes:bytes length:sizeof(bytes)] writeToFile:path atomically:NO]);
+    XCTAssertNil([CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:nil error:&error]);
+    XCTAssertEqual(error.code, CLKErrorInvalidConfigFile);
+}
+
+- (void)testConfigFileSource_cache
+{
+    NSString *cacheDirectory = [_directory stringByAppendingPathComponent:@"cache/images"];
+    NSString *path = [self _writeConfigFile:@"verbose\noutput = flarn\n" named:@"flarn.conf"];
+    
+    NSError *error = nil;
+    CLKOptionSource *source = [CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:cacheDirectory error:&error];
+    XCTAssertNotNil(source, @"%@", error);
+    XCTAssertFalse(source._loadedFromCache);
+    
+    NSArray<NSString *> *images = [NSFileManager.defaultManager contentsOfDirectoryAtPath:cacheDirectory error:NULL];
+    XCTAssertEqual(images.count, 1UL);
+    
+    source = [CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:cacheDirectory error:&error];
+    XCTAssertTrue(source._loadedFromCache);
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"verbose"], @[ @"" ]);
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"output"], @[ @"flarn" ]);
+    
+    // a changed file is parsed again, replacing its image
+    [self _writeConfigFile:@"output = barf\noutput = quone\n" named:@"flarn.conf"];
+    source = [CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:cacheDirectory error:&error];
+    XCTAssertFalse(source._loadedFromCache);
+    XCTAssertNil([source valuesForOptionNamed:@"verbose"]);
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"output"], (@[ @"barf", @"quone" ]));
+    
+    source = [CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:cacheDirectory error:&error];
+    XCTAssertTrue(source._loadedFromCache);
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"output"], (@[ @"barf", @"quone" ]));
+    
+    // other files get their own images
+    NSString *otherPath = [self _writeConfigFile:@"dry-run\n" named:@"barf.conf"];
+    source = [CLKOptionSource sourceWithContentsOfConfigFile:otherPath cacheDirectory:cacheDirectory error:&error];
+    XCTAssertFalse(source._loadedFromCache);
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"dry-run"], @[ @"" ]);
+    images = [NSFileManager.defaultManager contentsOfDirectoryAtPath:cacheDirectory error:NULL];
+    XCTAssertEqual(images.count, 2UL);
+    
+    // a damaged image is ignored and replaced
+    for (NSString *image in images) {
+        NSString *imagePath = [cacheDirectory stringByAppendingPathComponent:image];
+        NSData *data = [NSData dataWithContentsOfFile:imagePath];
+        XCTAssertTrue([[data subdataWithRange:NSMakeRange(0, (data.length / 2))] writeToFile:imagePath atomically:NO]);
+    }
+    
+    source = [CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:cacheDirectory error:&error];
+    XCTAssertFalse(source._loadedFromCache);
+    XCTAssertEqualObjects([source valuesForOptionNamed:@"output"], (@[ @"barf", @"quone" ]));
+    source = [CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:cacheDirectory error:&error];
+    XCTAssertTrue(source._loadedFromCache);
+}
+
+#pragma mark -
+#pragma mark Parsing
+
+- (void)testParsing_precedence
+{
+    NSString *path = [self _writeConfigFile:@"verbose = 3\ndry-run\noutput = config\ncount = 1\ncount = 2\n" named:@"flarn.conf"];
+    CLKOptionSource *config = [CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:nil error:NULL];
+    CLKOptionSource *environment = [CLKOptionSource sourceWithEnvironment:@{ @"CLKIT_OUTPUT" : @"environment", @"CLKIT_DRY_RUN" : @"no" }];
+    
+    NSArray<NSError *> *errors = nil;
+    CLKArgumentManifest *manifest = [self _parseArguments:@[ @"-c", @"7", @"flarn" ] sources:@[ environment, config ] errors:&errors];
+    XCTAssertNotNil(manifest, @"%@", errors);
+    
+    // `dry-run` is set to nothing by the environment, which masks the config file
+    NSDictionary *expected = @{
+        @"verbose" : @(3),
+        @"output" : @[ @"environment" ],
+        @"count" : @[ @(7) ]
+    };
+    
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, expected);
+    XCTAssertEqualObjects(manifest.positionalArguments, @[ @"flarn" ]);
+    
+    manifest = [self _parseArguments:@[ @"--output=argv", @"-v" ] sources:@[ config, environment ] errors:&errors];
+    XCTAssertNotNil(manifest, @"%@", errors);
+    expected = @{
+        @"verbose" : @(1),
+        @"dry-run" : @(1),
+        @"output" : @[ @"argv" ],
+        @"count" : @[ @(1), @(2) ]
+    };
+    
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, expected);
+    
+    manifest = [self _parseArguments:@[] sources:@[] errors:&errors];
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, @{});
+}
+
+- (void)testParsing_validation
+{
+    CLKOptionSource *environment = [CLKOptionSource sourceWithEnvironment:@{ @"CLKIT_VERBOSE" : @"yes" }];
+    NSArray *groups = @[ [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"verbose", @"dry-run" ]] ];
+    
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:@[ @"--dry-run" ] options:[self _options] optionGroups:groups];
+    parser.optionSources = @[ environment ];
+    XCTAssertNil([parser parseArguments]);
+    XCTAssertEqual(parser.errors.count, 1UL);
+    XCTAssertEqual(parser.errors.firstObject.code, CLKErrorMutuallyExclusiveOptionsPresent);
+    
+    // required options can be supplied by a source
+    CLKOption *required = [CLKOption parameterOptionWithName:@"output" flag:@"o" required:YES recurrent:NO transformer:nil];
+    environment = [CLKOptionSource sourceWithEnvironment:@{ @"CLKIT_OUTPUT" : @"flarn" }];
+    parser = [CLKArgumentParser parserWithArgumentVector:@[] options:@[ required ]];
+    parser.optionSources = @[ environment ];
+    CLKArgumentManifest *manifest = [parser parseArguments];
+    XCTAssertEqualObjects(manifest[@"output"], @"flarn");
+    
+    XCTAssertThrows(parser.optionSources = @[]);
+}
+
+- (void)testParsing_issues
+{
+    NSString *path = [self _writeConfigFile:@"xyzzy\ncount = barf\n" named:@"flarn.conf"];
+    CLKOptionSource *config = [CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:nil error:NULL];
+    CLKOptionSource *environment = [CLKOptionSource sourceWithEnvironment:@{ @"CLKIT_VERBOSE" : @"many", @"CLKIT_OUTPUT" : @"", @"CLKIT_XYZZY" : @"1" }];
+    
+    NSArray<NSError *> *errors = nil;
+    XCTAssertNil([self _parseArguments:@[] sources:@[ environment, config ] errors:&errors]);
+    
+    NSArray<NSString *> *descriptions = [errors valueForKey:@"localizedDescription"];
+    NSString *configPath = config.name;
+    XCTAssertEqual(descriptions.count, 4UL, @"%@", descriptions);
+    XCTAssertTrue([descriptions containsObject:@"CLKIT_VERBOSE: expected a count for option '--verbose' but found 'many'"]);
+    XCTAssertTrue([descriptions containsObject:@"CLKIT_OUTPUT: expected argument for option '--output'"]);
+    XCTAssertTrue([descriptions containsObject:([NSString stringWithFormat:@"%@: unrecognized option: 'xyzzy'", configPath])]);
+    XCTAssertTrue([descriptions containsObject:@"couldn't coerce 'barf' to an integer value"]);
+    
+    // a switch source can't set more than a bounded number of occurrences
+    environment = [CLKOptionSource sourceWithEnvironment:@{ @"CLKIT_VERBOSE" : @"1000000000" }];
+    XCTAssertNil([self _parseArguments:@[] sources:@[ environment ] errors:&errors]);
+    XCTAssertEqual(errors.count, 1UL);
+}
+
+- (void)testParsing_suggestions
+{
+    // config files name options without dashes, so they are suggested that way
+    NSString *path = [self _writeConfigFile:@"verbos\ndryrun\n" named:@"flarn.conf"];
+    CLKOptionSource *config = [CLKOptionSource sourceWithContentsOfConfigFile:path cacheDirectory:nil error:NULL];
+    
+    NSArray<NSError *> *errors = nil;
+    XCTAssertNil([self _parseArguments:@[] sources:@[ config ] errors:&errors]);
+    XCTAssertEqual(errors.count, 2UL);
+    XCTAssertEqualObjects(errors[0].localizedDescription, ([NSString stringWithFormat:@"%@: unrecognized option: 'verbos'; did you mean 'verbose'?", config.name]));
+    XCTAssertEqualObjects(errors[0].userInfo[CLKSuggestionsErrorKey], @[ @"verbose" ]);
+    XCTAssertEqualObjects(errors[1].userInfo[CLKSuggestionsErrorKey], @[ @"dry-run" ]);
+}
+
+- (void)testEvents
+{
+    CLKOptionSource *environment = [CLKOptionSource sourceWithEnvironment:@{ @"CLKIT_OUTPUT" : @"flarn", @"CLKIT_VERBOSE" : @"1" }];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:@[ @"-v", @"barf" ] options:[self _options]];
+    parser.optionSources = @[ environment ];
+    
+    NSMutableArray<CLKArgumentEvent *> *events = [NSMutableArray array];
+    CLKArgumentEvent *event;
+    while ((event = [parser nextEvent]) != nil) {
+        [events addObject:event];
+    }
+    
+    XCTAssertEqual(events.count, 3UL);
+    XCTAssertEqual(events[0].type, CLKArgumentEventTypeSwitchOption);
+    XCTAssertEqual(events[1].type, CLKArgumentEventTypePositionalArgument);
+    XCTAssertEqual(events[2].type, CLKArgumentEventTypeParameterOption);
+    XCTAssertEqualObjects(events[2].option.name, @"output");
+    XCTAssertEqualObjects(events[2].value, @"flarn");
+}
+
+@end
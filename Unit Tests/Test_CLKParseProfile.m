@@ -0,0 +1,234 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "CLKArgumentManifest.h"
+#import "CLKArgumentParser.h"
+#import "CLKArgumentTransformer.h"
+#import "CLKCommandResult.h"
+#import "CLKOption.h"
+#import "CLKOptionGroup.h"
+#import "CLKParseProfile_Private.h"
+#import "CLKVerbDepot.h"
+#import "StuntVerb.h"
+
+static uint64_t StuntAllocationCount = 0;
+
+static uint64_t StuntAllocationCounter(void)
+{
+    // every read counts as an allocation, so any measurement with a read inside it sees one
+    return StuntAllocationCount++;
+}
+
+@interface Test_CLKParseProfile : XCTestCase
+
+- (NSArray<CLKOption *> *)_options;
+- (NSArray<CLKOptionGroup *> *)_optionGroups;
+
+@end
+
+@implementation Test_CLKParseProfile
+
+- (NSArray<CLKOption *> *)_options
+{
+    return @[
+        [CLKOption optionWithName:@"verbose" flag:@"v"],
+        [CLKOption optionWithName:@"quiet" flag:@"q"],
+        [CLKOption parameterOptionWithName:@"file" flag:@"f" required:YES recurrent:NO transformer:nil],
+        [CLKOption parameterOptionWithName:@"count" flag:@"c" required:NO recurrent:YES transformer:[CLKIntArgumentTransformer new]]
+    ];
+}
+
+- (NSArray<CLKOptionGroup *> *)_optionGroups
+{
+    return @[ [CLKOptionGroup groupRequiringAnyOfOptionsNamed:@[ @"verbose", @"quiet" ]] ];
+}
+
+- (void)tearDown
+{
+    CLKParseProfileSetAllocationCounter(NULL);
+    [super tearDown];
+}
+
+- (void)testProfilingDisabled
+{
+    NSArray *argv = @[ @"-v", @"--file", @"alpha" ];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:[self _options] optionGroups:[self _optionGroups]];
+    XCTAssertFalse(parser.profilingEnabled);
+    XCTAssertNotNil([parser parseArguments]);
+    XCTAssertNil(parser.profile);
+    
+    parser = [CLKArgumentParser parserWithArgumentVector:argv options:[self _options]];
+    parser.profilingEnabled = YES;
+    parser.profilingEnabled = NO;
+    XCTAssertNotNil([parser parseArguments]);
+    XCTAssertNil(parser.profile);
+    XCTAssertThrows(parser.profilingEnabled = YES);
+}
+
+- (void)testProfile
+{
+    NSArray *argv = @[ @"-v", @"--file", @"alpha", @"-vq", @"--count=7", @"-c", @"8", @"bravo", @"--", @"charlie" ];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:[self _options] optionGroups:[self _optionGroups]];
+    parser.profilingEnabled = YES;
+    XCTAssertNil(parser.profile);
+    XCTAssertNotNil([parser parseArguments]);
+    
+    CLKParseProfile *profile = parser.profile;
+    XCTAssertNotNil(profile);
+    XCTAssertGreaterThan(profile.nanoseconds, 0ULL);
+    XCTAssertFalse(profile.countsAllocations);
+    XCTAssertEqual(profile.allocationCount, 0ULL);
+    
+    // the flags of `-vq` are read as flags after the set
+    NSDictionary *expectedTokenForms = @{
+        @"optionFlag" : @(4),
+        @"optionName" : @(1),
+        @"optionFlagSet" : @(1),
+        @"parameterOptionNameAssignment" : @(1),
+        @"optionParsingSentinel" : @(1),
+        @"argument" : @(4)
+    };
+    
+    XCTAssertEqualObjects(profile.tokenForms, expectedTokenForms);
+    
+    NSDictionary *expectedVisits = @{
+        @"begin" : @(1),
+        @"readNextArgumentToken" : @(9),
+        @"parseOptionFlag" : @(4),
+        @"parseOptionName" : @(1),
+        @"parseOptionFlagSet" : @(1),
+        @"parseParameterOptionNameAssignment" : @(1),
+        @"parseArgument" : @(3),
+        @"parseOptionParsingSentinel" : @(1),
+        @"parseRemainderArguments" : @(2)
+    };
+    
+    XCTAssertEqual(profile.states.count, expectedVisits.count);
+    for (NSString *state in expectedVisits) {
+        XCTAssertEqualObjects(profile.states[state][@"count"], expectedVisits[state], @"%@", state);
+        XCTAssertNotNil(profile.states[state][@"nanoseconds"]);
+        XCTAssertNil(profile.states[state][@"allocations"]);
+    }
+    
+    XCTAssertEqualObjects(profile.transformers.allKeys, @[ @"count" ]);
+    XCTAssertEqualObjects(profile.transformers[@"count"][@"count"], @(2));
+    
+    XCTAssertEqualObjects(profile.constraints[@"required"][@"count"], @(1));
+    XCTAssertEqualObjects(profile.constraints[@"anyRequired"][@"count"], @(1));
+    
+    NSDictionary *dictionary = profile.dictionaryRepresentation;
+    XCTAssertEqualObjects(dictionary[@"nanoseconds"], @(profile.nanoseconds));
+    XCTAssertNil(dictionary[@"allocations"]);
+    XCTAssertEqualObjects(dictionary[@"states"], profile.states);
+    XCTAssertEqualObjects(dictionary[@"tokenForms"], profile.tokenForms);
+    XCTAssertEqualObjects(dictionary[@"transformers"], profile.transformers);
+    XCTAssertEqualObjects(dictionary[@"constraints"], profile.constraints);
+    XCTAssertEqualObjects([NSJSONSerialization JSONObjectWithData:profile.JSONData options:0 error:nil], dictionary);
+}
+
+- (void)testProfile_failedParse
+{
+    NSArray *argv = @[ @"--flarn", @"-c", @"barf" ];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:[self _options] optionGroups:[self _optionGroups]];
+    parser.profilingEnabled = YES;
+    XCTAssertNil([parser parseArguments]);
+    
+    CLKParseProfile *profile = parser.profile;
+    XCTAssertEqualObjects(profile.tokenForms, (@{ @"optionName" : @(1), @"optionFlag" : @(1), @"argument" : @(1) }));
+    XCTAssertEqualObjects(profile.transformers[@"count"][@"count"], @(1));
+    XCTAssertEqualObjects(profile.constraints[@"required"][@"count"], @(1));
+}
+
+- (void)testProfile_allocations
+{
+    CLKParseProfileSetAllocationCounter(StuntAllocationCounter);
+    
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:@[ @"-v", @"-f", @"alpha" ] options:[self _options]];
+    parser.profilingEnabled = YES;
+    XCTAssertNotNil([parser parseArguments]);
+    
+    CLKParseProfile *profile = parser.profile;
+    XCTAssertTrue(profile.countsAllocations);
+    XCTAssertGreaterThan(profile.allocationCount, 0ULL);
+    XCTAssertEqualObjects(profile.states[@"begin"][@"allocations"], @(1));
+    XCTAssertEqualObjects(profile.dictionaryRepresentation[@"allocations"], @(profile.allocationCount));
+}
+
+- (void)testProfile_concurrentTransformation
+{
+    NSArray *argv = @[ @"-v", @"-f", @"alpha", @"-c", @"1", @"-c", @"2", @"-c", @"3" ];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:[self _options]];
+    parser.transformerConcurrency = 4;
+    parser.profilingEnabled = YES;
+    XCTAssertNotNil([parser parseArguments]);
+    XCTAssertEqualObjects(parser.profile.transformers[@"count"][@"count"], @(3));
+}
+
+- (void)testProfile_events
+{
+    NSArray *argv = @[ @"-v", @"-f", @"alpha", @"bravo" ];
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:[self _options] optionGroups:[self _optionGroups]];
+    parser.profilingEnabled = YES;
+    
+    XCTAssertNotNil([parser nextEvent]);
+    XCTAssertNil(parser.profile);
+    while ([parser nextEvent] != nil) {
+    }
+    
+    CLKParseProfile *profile = parser.profile;
+    XCTAssertNotNil(profile);
+    XCTAssertEqualObjects(profile.tokenForms, (@{ @"optionFlag" : @(2), @"argument" : @(2) }));
+    XCTAssertEqualObjects(profile.constraints[@"required"][@"count"], @(1));
+    XCTAssertEqualObjects(profile.constraints[@"anyRequired"][@"count"], @(1));
+    
+    // reading past the end doesn't change the profile
+    XCTAssertNil([parser nextEvent]);
+    XCTAssertEqual(parser.profile, profile);
+}
+
+- (void)testProfile_reset
+{
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:@[ @"-v", @"-f", @"alpha" ] options:[self _options]];
+    parser.profilingEnabled = YES;
+    XCTAssertNotNil([parser parseArguments]);
+    CLKParseProfile *profile = parser.profile;
+    
+    // each run is profiled on its own
+    [parser resetWithArgumentVector:@[ @"--file", @"bravo", @"charlie" ]];
+    XCTAssertNil(parser.profile);
+    XCTAssertNotNil([parser parseArguments]);
+    XCTAssertNotEqual(parser.profile, profile);
+    XCTAssertEqualObjects(profile.tokenForms, (@{ @"optionFlag" : @(2), @"argument" : @(1) }));
+    XCTAssertEqualObjects(parser.profile.tokenForms, (@{ @"optionName" : @(1), @"argument" : @(2) }));
+    XCTAssertEqualObjects(parser.profile.states[@"begin"][@"count"], @(1));
+    
+    [parser resetWithArgumentVector:@[ @"-v" ]];
+    parser.profilingEnabled = NO;
+    XCTAssertNil([parser parseArguments]);
+    XCTAssertNil(parser.profile);
+}
+
+- (void)testCommandResult
+{
+    StuntVerb *verb = [StuntVerb flarnVerb];
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"flarn", @"--alpha" ] verbs:@[ verb ]];
+    XCTAssertFalse(depot.profilingEnabled);
+    XCTAssertNil([depot dispatchVerb].parseProfile);
+    
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"flarn", @"--alpha" ] verbs:@[ verb ]];
+    depot.profilingEnabled = YES;
+    CLKParseProfile *profile = [depot dispatchVerb].parseProfile;
+    XCTAssertEqualObjects(profile.tokenForms, @{ @"optionName" : @(1) });
+    
+    // results of failed parses are created by the depot
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"flarn", @"--xyzzy" ] verbs:@[ verb ]];
+    depot.profilingEnabled = YES;
+    CLKCommandResult *result = [depot dispatchVerb];
+    XCTAssertNotNil(result.errors);
+    XCTAssertNotNil(result.parseProfile);
+}
+
+@end
@@ -0,0 +1,163 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "CLKPrefixTrie.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface Test_CLKPrefixTrie : XCTestCase
+
+- (NSArray<NSString *> *)_stringsWithPrefix:(NSString *)prefix inTrie:(CLKPrefixTrie *)trie strings:(NSArray<NSString *> *)strings;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation Test_CLKPrefixTrie
+
+- (NSArray<NSString *> *)_stringsWithPrefix:(NSString *)prefix inTrie:(CLKPrefixTrie *)trie strings:(NSArray<NSString *> *)strings
+{
+    NSMutableArray<NSString *> *matches = [NSMutableArray array];
+    [trie enumerateIndexesOfStringsWithPrefix:prefix usingBlock:^(NSUInteger idx, __unused BOOL *outStop) {
+        [matches addObject:strings[idx]];
+    }];
+    
+    return matches;
+}
+
+- (void)testLookup
+{
+    NSArray<NSString *> *strings = @[ @"verbose", @"version", @"v", @"alpha", @"al", @"beta", @"x-ray", @"alp", @"ålpha" ];
+    CLKPrefixTrie *trie = [CLKPrefixTrie trieWithStrings:strings];
+    
+    XCTAssertEqualObjects([self _stringsWithPrefix:@"" inTrie:trie strings:strings], (@[ @"al", @"alp", @"alpha", @"beta", @"v", @"verbose", @"version", @"x-ray", @"ålpha" ]));
+    XCTAssertEqualObjects([self _stringsWithPrefix:@"v" inTrie:trie strings:strings], (@[ @"v", @"verbose", @"version" ]));
+    XCTAssertEqualObjects([self _stringsWithPrefix:@"ver" inTrie:trie strings:strings], (@[ @"verbose", @"version" ]));
+    XCTAssertEqualObjects([self _stringsWithPrefix:@"versio" inTrie:trie strings:strings], @[ @"version" ]);
+    XCTAssertEqualObjects([self _stringsWithPrefix:@"alpha" inTrie:trie strings:strings], @[ @"alpha" ]);
+    XCTAssertEqualObjects([self _stringsWithPrefix:@"ålp" inTrie:trie strings:strings], @[ @"ålpha" ]);
+    XCTAssertEqualObjects([self _stringsWithPrefix:@"alphabet" inTrie:trie strings:strings], @[]);
+    XCTAssertEqualObjects([self _stringsWithPrefix:@"z" inTrie:trie strings:strings], @[]);
+    XCTAssertEqualObjects([self _stringsWithPrefix:@"V" inTrie:trie strings:strings], @[]);
+    
+    XCTAssertEqual([trie indexOfString:@"alp"], 7UL);
+    XCTAssertEqual([trie indexOfString:@"v"], 2UL);
+    XCTAssertEqual([trie indexOfString:@"ve"], NSNotFound);
+    XCTAssertEqual([trie indexOfString:@""], NSNotFound);
+    XCTAssertEqual([trie indexOfString:@"alphas"], NSNotFound);
+    
+    __block NSUInteger visits = 0;
+    [trie enumerateIndexesOfStringsWithPrefix:@"" usingBlock:^(__unused NSUInteger idx, BOOL *outStop) {
+        visits++;
+        *outStop = (visits == 2);
+    }];
+    
+    XCTAssertEqual(visits, 2UL);
+}
+
+- (void)testEdgeCases
+{
+    CLKPrefixTrie *trie = [CLKPrefixTrie trieWithStrings:@[]];
+    XCTAssertEqual(trie.nodeCount, 1UL);
+    XCTAssertEqual([trie indexOfString:@"flarn"], NSNotFound);
+    XCTAssertEqualObjects([self _stringsWithPrefix:@"" inTrie:trie strings:@[]], @[]);
+    
+    // duplicates resolve to their first occurrence
+    NSArray<NSString *> *strings = @[ @"flarn", @"", @"barf", @"flarn" ];
+    trie = [CLKPrefixTrie trieWithStrings:strings];
+    XCTAssertEqual([trie indexOfString:@"flarn"], 0UL);
+    XCTAssertEqual([trie indexOfString:@""], 1UL);
+    XCTAssertEqualObjects([self _stringsWithPrefix:@"" inTrie:trie strings:strings], (@[ @"", @"barf", @"flarn" ]));
+    
+    // shared prefixes share nodes
+    trie = [CLKPrefixTrie trieWithStrings:@[ @"abc", @"abd", @"ab" ]];
+    XCTAssertEqual(trie.nodeCount, 5UL);
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    XCTAssertThrows([CLKPrefixTrie trieWithStrings:nil]);
+    XCTAssertThrows([trie indexOfString:nil]);
+    XCTAssertThrows([trie indexOfStringWithUniquePrefix:nil]);
+    XCTAssertThrows([trie enumerateIndexesOfStringsWithPrefix:nil usingBlock:^(__unused NSUInteger idx, __unused BOOL *outStop) {}]);
+#pragma clang diagnostic pop
+}
+
+- (void)testUniquePrefix
+{
+    NSArray<NSString *> *strings = @[ @"verbose", @"version", @"v", @"alpha", @"al", @"beta", @"x-ray", @"ålpha", @"beta" ];
+    CLKPrefixTrie *trie = [CLKPrefixTrie trieWithStrings:strings];
+    
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"verb"], 0UL);
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"verbose"], 0UL);
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"vers"], 1UL);
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"alp"], 3UL);
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"x"], 6UL);
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"å"], 7UL);
+    
+    // duplicates are one string
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"b"], 5UL);
+    
+    // prefixes of several strings, including strings that are prefixes of others
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"ver"], NSNotFound);
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"v"], NSNotFound);
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"al"], NSNotFound);
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@""], NSNotFound);
+    
+    // and of none
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"verbosely"], NSNotFound);
+    XCTAssertEqual([trie indexOfStringWithUniquePrefix:@"z"], NSNotFound);
+    
+    const unichar characters[] = { 'v', 'e', 'r', 's' };
+    XCTAssertEqual([trie indexOfStringWithUniquePrefixCharacters:characters length:4], 1UL);
+    XCTAssertEqual([trie indexOfStringWithUniquePrefixCharacters:characters length:3], NSNotFound);
+    
+    CLKPrefixTrie *single = [CLKPrefixTrie trieWithStrings:@[ @"flarn" ]];
+    XCTAssertEqual([single indexOfStringWithUniquePrefix:@""], 0UL);
+    XCTAssertEqual([[CLKPrefixTrie trieWithStrings:@[]] indexOfStringWithUniquePrefix:@""], NSNotFound);
+}
+
+- (void)testMatchesLinearScan
+{
+    NSMutableArray<NSString *> *strings = [NSMutableArray array];
+    for (NSUInteger i = 0 ; i < 5000 ; i++) {
+        [strings addObject:[NSString stringWithFormat:@"option-%lu-%c", (unsigned long)(i * 7919 % 5000), (char)('a' + (i % 26))]];
+    }
+    
+    CLKPrefixTrie *trie = [CLKPrefixTrie trieWithStrings:strings];
+    for (NSString *prefix in @[ @"", @"o", @"option-1", @"option-12", @"option-123-", @"option-4999", @"q" ]) {
+        NSMutableSet<NSString *> *expected = [NSMutableSet set];
+        for (NSString *string in strings) {
+            if ([string hasPrefix:prefix]) {
+                [expected addObject:string];
+            }
+        }
+        
+        NSArray<NSString *> *matches = [self _stringsWithPrefix:prefix inTrie:trie strings:strings];
+        XCTAssertEqual(matches.count, expected.count);
+        XCTAssertEqualObjects([NSSet setWithArray:matches], expected);
+        XCTAssertEqualObjects(matches, [matches sortedArrayUsingSelector:@selector(compare:)]);
+    }
+}
+
+- (void)testPerformance_lookup
+{
+    NSMutableArray<NSString *> *strings = [NSMutableArray array];
+    for (NSUInteger i = 0 ; i < 5000 ; i++) {
+        [strings addObject:[NSString stringWithFormat:@"option-%lu", (unsigned long)i]];
+    }
+    
+    CLKPrefixTrie *trie = [CLKPrefixTrie trieWithStrings:strings];
+    [self measureBlock:^{
+        for (NSUInteger i = 0 ; i < 10000 ; i++) {
+            __block NSUInteger matches = 0;
+            [trie enumerateIndexesOfStringsWithPrefix:@"option-49" usingBlock:^(__unused NSUInteger idx, __unused BOOL *outStop) {
+                matches++;
+            }];
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,362 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import <sysexits.h>
+
+#import "CLKArgumentManifest_Private.h"
+#import "CLKCommandResult.h"
+#import "CLKError.h"
+#import "CLKOption.h"
+#import "CLKOptionGroup.h"
+#import "CLKOptionRegistry.h"
+#import "CLKOptionSchema_Private.h"
+#import "CLKSchemaArchive.h"
+#import "CLKVerbDepot.h"
+#import "CLKVerbDescriptor.h"
+#import "CLKVerbFamily_Private.h"
+#import "StuntVerb.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface Test_CLKSchemaArchive : XCTestCase
+
+// fresh descriptors on every call, so no schema is shared between depots
+- (NSArray<CLKVerbDescriptor *> *)_topLevelVerbDescriptors;
+- (NSArray<CLKVerbFamily *> *)_verbFamilies;
+
+- (CLKSchemaArchive *)_archive;
+- (void)_verifyArchive:(CLKSchemaArchive *)archive dispatchesLikeDepotForArguments:(NSArray<NSString *> *)arguments;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation Test_CLKSchemaArchive
+
+- (NSArray<CLKVerbDescriptor *> *)_topLevelVerbDescriptors
+{
+    NSArray<CLKOption *> *flarnOptions = @[
+        [CLKOption optionWithName:@"alpha" flag:@"a"],
+        [CLKOption parameterOptionWithName:@"bravo" flag:@"b"],
+        [CLKOption optionWithName:@"charlie" flag:@"ç"],
+        [CLKOption standaloneOptionWithName:@"help" flag:@"h"]
+    ];
+    
+    NSArray<CLKOptionGroup *> *flarnGroups = @[
+        [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"alpha", @"charlie" ]]
+    ];
+    
+    return @[
+        [CLKVerbDescriptor descriptorWithName:@"flarn" factory:^{
+            return [[StuntVerb alloc] initWithName:@"flarn" options:flarnOptions optionGroups:flarnGroups];
+        }],
+        [CLKVerbDescriptor descriptorWithName:@"barf" factory:^{
+            return [StuntVerb barfVerb];
+        }],
+        [CLKVerbDescriptor descriptorWithName:@"quone" factory:^{
+            return [StuntVerb verbWithName:@"quone" options:nil];
+        }]
+    ];
+}
+
+- (NSArray<CLKVerbFamily *> *)_verbFamilies
+{
+    NSArray<CLKVerbDescriptor *> *confoundVerbs = @[
+        [CLKVerbDescriptor descriptorWithName:@"xyzzy" factory:^{
+            return [StuntVerb xyzzyVerb];
+        }],
+        [CLKVerbDescriptor descriptorWithName:@"syn" factory:^{
+            return [StuntVerb verbWithName:@"syn" options:@[ [CLKOption requiredParameterOptionWithName:@"echo" flag:@"e"] ]];
+        }]
+    ];
+    
+    return @[ [CLKVerbFamily familyWithName:@"confound" verbDescriptors:confoundVerbs] ];
+}
+
+- (CLKSchemaArchive *)_archive
+{
+    NSData *data = [CLKSchemaArchive archiveDataWithVerbDescriptors:[self _topLevelVerbDescriptors] verbFamilies:[self _verbFamilies]];
+    NSError *error = nil;
+    CLKSchemaArchive *archive = [CLKSchemaArchive archiveWithData:data error:&error];
+    XCTAssertNotNil(archive);
+    XCTAssertNil(error);
+    return archive;
+}
+
+- (void)_verifyArchive:(CLKSchemaArchive *)archive dispatchesLikeDepotForArguments:(NSArray<NSString *> *)arguments
+{
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:arguments verbDescriptors:[self _topLevelVerbDescriptors] verbFamilies:[self _verbFamilies]];
+    CLKVerbDepot *archivedDepot = [[CLKVerbDepot alloc] initWithArgumentVector:arguments verbDescriptors:[self _topLevelVerbDescriptors] verbFamilies:[self _verbFamilies] schemaArchive:archive];
+    CLKCommandResult *expectedResult = [depot dispatchVerb];
+    CLKCommandResult *result = [archivedDepot dispatchVerb];
+    XCTAssertEqual(result.exitStatus, expectedResult.exitStatus, @"%@", arguments);
+    XCTAssertEqualObjects(result.errors, expectedResult.errors, @"%@", arguments);
+    XCTAssertEqualObjects(result.userInfo[@"verb"], expectedResult.userInfo[@"verb"], @"%@", arguments);
+    
+    CLKArgumentManifest *manifest = result.userInfo[@"manifest"];
+    CLKArgumentManifest *expectedManifest = expectedResult.userInfo[@"manifest"];
+    XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, expectedManifest.dictionaryRepresentationForAccumulatedOptions, @"%@", arguments);
+    XCTAssertEqualObjects(manifest.positionalArguments, expectedManifest.positionalArguments, @"%@", arguments);
+}
+
+#pragma mark -
+
+- (void)testArchive
+{
+    CLKSchemaArchive *archive = [self _archive];
+    XCTAssertEqual(archive.verbCount, 5UL);
+    XCTAssertEqual(archive.verbFamilyCount, 1UL);
+    
+    // writing is deterministic
+    NSData *data = [CLKSchemaArchive archiveDataWithVerbDescriptors:[self _topLevelVerbDescriptors] verbFamilies:[self _verbFamilies]];
+    XCTAssertEqualObjects(data, [CLKSchemaArchive archiveDataWithVerbDescriptors:[self _topLevelVerbDescriptors] verbFamilies:[self _verbFamilies]]);
+    
+    // the same checks as a depot
+    NSArray<CLKVerbFamily *> *families = @[ [CLKVerbFamily familyWithName:@"flarn" verbs:@[ [StuntVerb xyzzyVerb] ]] ];
+    XCTAssertThrowsSpecificNamed([CLKSchemaArchive archiveDataWithVerbDescriptors:[self _topLevelVerbDescriptors] verbFamilies:families], NSException, NSInvalidArgumentException);
+    XCTAssertThrows([CLKSchemaArchive archiveDataWithVerbDescriptors:@[] verbFamilies:nil]);
+}
+
+- (void)testDispatch
+{
+    CLKSchemaArchive *archive = [self _archive];
+    NSArray<NSArray<NSString *> *> *argumentVectors = @[
+        @[ @"flarn" ],
+        @[ @"flarn", @"-a", @"--bravo", @"thrud", @"acme" ],
+        @[ @"flarn", @"ç" ],
+        @[ @"flarn", @"-ç" ],
+        @[ @"flarn", @"-a", @"--charlie" ],
+        @[ @"flarn", @"--help", @"-a" ],
+        @[ @"flarn", @"--bravo" ],
+        @[ @"flarn", @"--delta" ],
+        @[ @"barf", @"-b", @"--bravo" ],
+        @[ @"quone", @"acme" ],
+        @[ @"confound", @"xyzzy", @"-d" ],
+        @[ @"confound", @"syn", @"-e", @"acme" ],
+        @[ @"confound", @"syn" ],
+        @[ @"confound" ],
+        @[ @"confound", @"flarn" ],
+        @[ @"xyzzy" ],
+        @[ @"ack" ],
+        @[ @"--alpha" ],
+        @[]
+    ];
+    
+    for (NSArray<NSString *> *arguments in argumentVectors) {
+        [self _verifyArchive:archive dispatchesLikeDepotForArguments:arguments];
+    }
+}
+
+- (void)testSchema
+{
+    CLKSchemaArchive *archive = [self _archive];
+    NSArray<CLKVerbDescriptor *> *verbDescriptors = [self _topLevelVerbDescriptors];
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"flarn" ] verbDescriptors:verbDescriptors verbFamilies:[self _verbFamilies] schemaArchive:archive];
+    XCTAssertEqual([depot dispatchVerb].exitStatus, 0);
+    
+    // the dispatched verb's schema reads the archive's tables; the others weren't touched
+    CLKOptionSchema *schema = verbDescriptors[0].schema;
+    CLKOptionRegistry *registry = schema.optionRegistry;
+    XCTAssertEqual([registry optionNamed:@"alpha"], schema.options[0]);
+    XCTAssertEqual([registry optionNamed:@"help"], schema.options[3]);
+    XCTAssertNil([registry optionNamed:@"delta"]);
+    XCTAssertEqual([registry optionForFlag:@"b"], schema.options[1]);
+    XCTAssertEqual([registry optionForFlag:@"ç"], schema.options[2]);
+    XCTAssertNil([registry optionForFlag:@"è"]);
+    XCTAssertEqual([schema handleForOptionNamed:@"bravo"], 1UL);
+    XCTAssertEqual(schema.optionGroups.count, 1UL);
+}
+
+- (void)testSubfamilies
+{
+    // fresh families on every call, as with the fixtures above
+    NSArray<CLKVerbFamily *> *(^families)(void) = ^{
+        NSArray<CLKOptionGroup *> *remoteGroups = @[ [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"verbose", @"quiet" ]] ];
+        NSArray<CLKOptionGroup *> *deleteGroups = @[ [CLKOptionGroup groupForOptionNamed:@"bravo" requiringDependency:@"force"] ];
+        CLKVerbFamily *track = [CLKVerbFamily familyWithName:@"track" verbs:@[ [StuntVerb verbWithName:@"set" option:[CLKOption parameterOptionWithName:@"upstream" flag:@"u"]] ]];
+        NSArray<id<CLKVerb>> *branchVerbs = @[
+            [StuntVerb flarnVerb],
+            [[StuntVerb alloc] initWithName:@"delete" options:@[ [CLKOption optionWithName:@"bravo" flag:@"b"] ] optionGroups:deleteGroups]
+        ];
+        
+        CLKVerbFamily *branch = [CLKVerbFamily familyWithName:@"branch" options:@[ [CLKOption optionWithName:@"force" flag:@"f"] ] optionGroups:nil verbs:branchVerbs subfamilies:@[ track ]];
+        NSArray<CLKOption *> *remoteOptions = @[ [CLKOption optionWithName:@"verbose" flag:@"v"], [CLKOption optionWithName:@"quiet" flag:@"q"] ];
+        CLKVerbFamily *remote = [CLKVerbFamily familyWithName:@"remote" options:remoteOptions optionGroups:remoteGroups verbs:@[ [StuntVerb quoneVerb] ] subfamilies:@[ branch ]];
+        return @[ remote, [CLKVerbFamily familyWithName:@"delivery" verbs:@[ [StuntVerb synVerb] ]] ];
+    };
+    
+    NSArray<CLKVerbDescriptor *> *topLevelVerbs = @[ [CLKVerbDescriptor descriptorWithVerb:[StuntVerb xyzzyVerb]] ];
+    NSData *data = [CLKSchemaArchive archiveDataWithVerbDescriptors:topLevelVerbs verbFamilies:families()];
+    CLKSchemaArchive *archive = [CLKSchemaArchive archiveWithData:data error:nil];
+    XCTAssertNotNil(archive);
+    XCTAssertEqual(archive.verbCount, 6UL);
+    XCTAssertEqual(archive.verbFamilyCount, 4UL);
+    
+    NSArray<NSArray<NSString *> *> *argumentVectors = @[
+        @[ @"remote", @"quone", @"-vc" ],
+        @[ @"remote", @"quone", @"-vq" ],
+        @[ @"remote", @"branch", @"flarn", @"-a", @"--force", @"--verbose" ],
+        @[ @"remote", @"branch", @"delete", @"-b" ],
+        @[ @"remote", @"branch", @"delete", @"-bf" ],
+        @[ @"remote", @"branch", @"track", @"set", @"-u", @"origin", @"-qf" ],
+        @[ @"remote", @"branch", @"track", @"sat" ],
+        @[ @"remote", @"branch", @"trakc" ],
+        @[ @"remote", @"branch" ],
+        @[ @"remote", @"track", @"set" ],
+        @[ @"delivery", @"syn", @"-e" ],
+        @[ @"xyzzy", @"-d" ]
+    ];
+    
+    for (NSArray<NSString *> *arguments in argumentVectors) {
+        CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:arguments verbDescriptors:topLevelVerbs verbFamilies:families()];
+        CLKVerbDepot *archivedDepot = [[CLKVerbDepot alloc] initWithArgumentVector:arguments verbDescriptors:topLevelVerbs verbFamilies:families() schemaArchive:archive];
+        CLKCommandResult *expectedResult = [depot dispatchVerb];
+        CLKCommandResult *result = [archivedDepot dispatchVerb];
+        XCTAssertEqual(result.exitStatus, expectedResult.exitStatus, @"%@", arguments);
+        XCTAssertEqualObjects(result.errors, expectedResult.errors, @"%@", arguments);
+        XCTAssertEqualObjects(result.userInfo[@"verb"], expectedResult.userInfo[@"verb"], @"%@", arguments);
+        
+        CLKArgumentManifest *manifest = result.userInfo[@"manifest"];
+        CLKArgumentManifest *expectedManifest = expectedResult.userInfo[@"manifest"];
+        XCTAssertEqualObjects(manifest.dictionaryRepresentationForAccumulatedOptions, expectedManifest.dictionaryRepresentationForAccumulatedOptions, @"%@", arguments);
+        XCTAssertEqualObjects(manifest.positionalArguments, expectedManifest.positionalArguments, @"%@", arguments);
+    }
+    
+    // archived verbs of families read tables with the inherited options folded in
+    NSArray<CLKVerbFamily *> *archivedFamilies = families();
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"branch", @"flarn" ] verbDescriptors:topLevelVerbs verbFamilies:archivedFamilies schemaArchive:archive];
+    XCTAssertEqual([depot dispatchVerb].exitStatus, 0);
+    
+    CLKVerbFamily *branch = [archivedFamilies[0] subfamilyNamed:@"branch"];
+    CLKOptionSchema *schema = [branch _schemaForVerbDescriptor:[branch verbDescriptorNamed:@"flarn"] archive:nil verbRecord:0];
+    CLKOptionRegistry *registry = schema.optionRegistry;
+    XCTAssertNil(registry.parentRegistry);
+    XCTAssertEqualObjects([schema.options valueForKey:@"name"], (@[ @"verbose", @"quiet", @"force", @"alpha" ]));
+    XCTAssertEqual([registry optionForFlag:@"q"], schema.options[1]);
+    XCTAssertEqual([schema handleForOptionNamed:@"alpha"], 3UL);
+    XCTAssertEqual(schema.optionGroups.count, 1UL);
+    
+    // completion reads the same tables
+    archivedFamilies = families();
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"branch", @"flarn", @"--" ] verbDescriptors:topLevelVerbs verbFamilies:archivedFamilies schemaArchive:archive];
+    XCTAssertEqualObjects([depot completionsForArgumentAtIndex:3], (@[ @"--alpha", @"--force", @"--quiet", @"--verbose" ]));
+    
+    branch = [archivedFamilies[0] subfamilyNamed:@"branch"];
+    schema = [branch _schemaForVerbDescriptor:[branch verbDescriptorNamed:@"flarn"] archive:nil verbRecord:0];
+    XCTAssertNil(schema.optionRegistry.parentRegistry);
+    XCTAssertEqualObjects([schema.options valueForKey:@"name"], (@[ @"verbose", @"quiet", @"force", @"alpha" ]));
+}
+
+- (void)testStaleArchive
+{
+    CLKSchemaArchive *archive = [self _archive];
+    
+    // verbs that have changed since the archive was written are compiled from their options
+    NSArray<CLKVerbDescriptor *> *verbDescriptors = @[
+        [CLKVerbDescriptor descriptorWithName:@"flarn" factory:^{
+            return [StuntVerb verbWithName:@"flarn" options:@[ [CLKOption optionWithName:@"alpha" flag:@"z"], [CLKOption requiredParameterOptionWithName:@"delta" flag:nil] ]];
+        }],
+        [CLKVerbDescriptor descriptorWithName:@"ack" factory:^{
+            return [StuntVerb ackVerb];
+        }]
+    ];
+    
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"flarn", @"-z", @"--delta", @"acme" ] verbDescriptors:verbDescriptors verbFamilies:nil schemaArchive:archive];
+    CLKCommandResult *result = [depot dispatchVerb];
+    XCTAssertEqual(result.exitStatus, 0);
+    CLKArgumentManifest *manifest = result.userInfo[@"manifest"];
+    XCTAssertEqualObjects(manifest[@"alpha"], @(1));
+    XCTAssertEqualObjects(manifest[@"delta"], @[ @"acme" ]);
+    
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"flarn" ] verbDescriptors:verbDescriptors verbFamilies:nil schemaArchive:archive];
+    XCTAssertEqual([depot dispatchVerb].exitStatus, EX_USAGE);
+    
+    // as are verbs missing from the archive, or at a different position
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"ack", @"-f" ] verbDescriptors:verbDescriptors verbFamilies:nil schemaArchive:archive];
+    result = [depot dispatchVerb];
+    XCTAssertEqual(result.exitStatus, 0);
+    XCTAssertEqualObjects(result.userInfo[@"verb"], @"ack");
+    
+    // families missing from the depot aren't dispatched
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"confound", @"xyzzy" ] verbDescriptors:verbDescriptors verbFamilies:nil schemaArchive:archive];
+    XCTAssertEqual([depot dispatchVerb].exitStatus, EX_USAGE);
+    
+    // a depot with an archive checks its verbs when it can't use the archive
+    NSArray<CLKVerbFamily *> *families = @[ [CLKVerbFamily familyWithName:@"ack" verbs:@[ [StuntVerb xyzzyVerb] ]] ];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"thrud" ] verbDescriptors:verbDescriptors verbFamilies:families schemaArchive:archive];
+    XCTAssertThrowsSpecificNamed([depot dispatchVerb], NSException, NSInvalidArgumentException);
+}
+
+- (void)testInvalidData
+{
+    NSData *data = [CLKSchemaArchive archiveDataWithVerbDescriptors:[self _topLevelVerbDescriptors] verbFamilies:[self _verbFamilies]];
+    
+    void (^verifyInvalid)(NSData *, NSString *) = ^(NSData *invalidData, NSString *description) {
+        NSError *error = nil;
+        XCTAssertNil([CLKSchemaArchive archiveWithData:invalidData error:&error]);
+        XCTAssertEqualObjects(error.domain, CLKErrorDomain);
+        XCTAssertEqual(error.code, CLKErrorInvalidSchemaArchive);
+        XCTAssertEqualObjects(error.localizedDescription, description);
+    };
+    
+    verifyInvalid([NSData data], @"Schema archive is truncated.");
+    verifyInvalid([data subdataWithRange:NSMakeRange(0, 16)], @"Schema archive is truncated.");
+    verifyInvalid([data subdataWithRange:NSMakeRange(0, (data.length - 8))], @"Schema archive is truncated.");
+    verifyInvalid([@"this is not a schema archive, but it is long enough to be one. really. honestly. definitely." dataUsingEncoding:NSUTF8StringEncoding], @"Not a schema archive.");
+    
+    NSMutableData *mutableData = [data mutableCopy];
+    ((uint32_t *)mutableData.mutableBytes)[1] = 2;
+    verifyInvalid(mutableData, @"Unsupported schema archive version 2.");
+    
+    mutableData = [data mutableCopy];
+    ((uint32_t *)mutableData.mutableBytes)[2] = 0x04030201;
+    verifyInvalid(mutableData, @"Schema archive was written for a different architecture.");
+    
+    // a damaged verb record is ignored in favor of compiling the verb
+    mutableData = [data mutableCopy];
+    memset(((uint8_t *)mutableData.mutableBytes + 88), 0xff, (mutableData.length - 88));
+    NSError *error = nil;
+    CLKSchemaArchive *archive = [CLKSchemaArchive archiveWithData:mutableData error:&error];
+    XCTAssertNotNil(archive);
+    XCTAssertNil(error);
+    [self _verifyArchive:archive dispatchesLikeDepotForArguments:@[ @"flarn", @"-a" ]];
+    [self _verifyArchive:archive dispatchesLikeDepotForArguments:@[ @"confound", @"syn", @"-e", @"acme" ]];
+    
+    // archives at unaligned addresses are copied
+    mutableData = [[NSMutableData alloc] initWithLength:1];
+    [mutableData appendData:data];
+    archive = [CLKSchemaArchive archiveWithData:[mutableData subdataWithRange:NSMakeRange(1, data.length)] error:&error];
+    XCTAssertNotNil(archive);
+    [self _verifyArchive:archive dispatchesLikeDepotForArguments:@[ @"flarn", @"-a", @"--bravo", @"acme" ]];
+}
+
+- (void)testContentsOfFile
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    NSData *data = [CLKSchemaArchive archiveDataWithVerbDescriptors:[self _topLevelVerbDescriptors] verbFamilies:[self _verbFamilies]];
+    XCTAssertTrue([data writeToFile:path atomically:YES]);
+    
+    NSError *error = nil;
+    CLKSchemaArchive *archive = [CLKSchemaArchive archiveWithContentsOfFile:path error:&error];
+    XCTAssertNotNil(archive);
+    XCTAssertNil(error);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+    
+    // the mapping outlives the file
+    [self _verifyArchive:archive dispatchesLikeDepotForArguments:@[ @"flarn", @"-a", @"--bravo", @"acme" ]];
+    [self _verifyArchive:archive dispatchesLikeDepotForArguments:@[ @"confound", @"xyzzy" ]];
+    
+    XCTAssertNil([CLKSchemaArchive archiveWithContentsOfFile:path error:&error]);
+    XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+    XCTAssertEqual(error.code, ENOENT);
+    
+    XCTAssertTrue([[NSData data] writeToFile:path atomically:YES]);
+    XCTAssertNil([CLKSchemaArchive archiveWithContentsOfFile:path error:&error]);
+    XCTAssertEqual(error.code, CLKErrorInvalidSchemaArchive);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+@end
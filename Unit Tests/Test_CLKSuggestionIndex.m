@@ -0,0 +1,193 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "CLKSuggestionIndex.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface Test_CLKSuggestionIndex : XCTestCase
+
+- (NSUInteger)_tableDistanceFromString:(NSString *)string toString:(NSString *)otherString;
+- (NSArray<NSString *> *)_optionNamesWithCount:(NSUInteger)count;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation Test_CLKSuggestionIndex
+
+// the textbook dynamic program, to check the bit-parallel distance against
+- (NSUInteger)_tableDistanceFromString:(NSString *)string toString:(NSString *)otherString
+{
+    NSUInteger m = string.length;
+    NSUInteger n = otherString.length;
+    NSMutableArray<NSNumber *> *row = [NSMutableArray array];
+    for (NSUInteger j = 0 ; j <= n ; j++) {
+        [row addObject:@(j)];
+    }
+    
+    for (NSUInteger i = 1 ; i <= m ; i++) {
+        NSUInteger diagonal = row[0].unsignedIntegerValue;
+        row[0] = @(i);
+        for (NSUInteger j = 1 ; j <= n ; j++) {
+            NSUInteger above = row[j].unsignedIntegerValue;
+            NSUInteger substitution = (diagonal + ([string characterAtIndex:(i - 1)] != [otherString characterAtIndex:(j - 1)]));
+            row[j] = @(MIN(substitution, (MIN(above, row[j - 1].unsignedIntegerValue) + 1)));
+            diagonal = above;
+        }
+    }
+    
+    return row[n].unsignedIntegerValue;
+}
+
+// names like a large command's: a few words joined by dashes
+- (NSArray<NSString *> *)_optionNamesWithCount:(NSUInteger)count
+{
+    NSArray<NSString *> *words = @[ @"output", @"input", @"format", @"cache", @"remote", @"branch", @"depth", @"filter", @"color", @"verbose", @"dry", @"run", @"max", @"min", @"log", @"level", @"path", @"timeout" ];
+    NSMutableArray<NSString *> *names = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0 ; i < count ; i++) {
+        NSString *first = words[i % words.count];
+        NSString *second = words[(i / words.count) % words.count];
+        [names addObject:[NSString stringWithFormat:@"%@-%@-%lu", first, second, (unsigned long)(i / (words.count * words.count))]];
+    }
+    
+    return names;
+}
+
+- (void)testEditDistance
+{
+    XCTAssertEqual(CLKEditDistance(@"", @""), 0UL);
+    XCTAssertEqual(CLKEditDistance(@"", @"flarn"), 5UL);
+    XCTAssertEqual(CLKEditDistance(@"flarn", @""), 5UL);
+    XCTAssertEqual(CLKEditDistance(@"flarn", @"flarn"), 0UL);
+    XCTAssertEqual(CLKEditDistance(@"kitten", @"sitting"), 3UL);
+    XCTAssertEqual(CLKEditDistance(@"verbose", @"vrebose"), 2UL);
+    XCTAssertEqual(CLKEditDistance(@"verbose", @"verbos"), 1UL);
+    XCTAssertEqual(CLKEditDistance(@"ålpha", @"alpha"), 1UL);
+    
+    // patterns at and past the width of a word
+    NSString *sixtyFour = [@"" stringByPaddingToLength:64 withString:@"ab" startingAtIndex:0];
+    NSString *seventy = [@"" stringByPaddingToLength:70 withString:@"ab" startingAtIndex:0];
+    XCTAssertEqual(CLKEditDistance(sixtyFour, seventy), 6UL);
+    XCTAssertEqual(CLKEditDistance(seventy, sixtyFour), 6UL);
+    XCTAssertEqual(CLKEditDistance(sixtyFour, [sixtyFour stringByReplacingOccurrencesOfString:@"b" withString:@"c"]), 32UL);
+    
+    // random strings over a small alphabet, so that they share plenty of characters
+    NSArray<NSString *> *alphabet = @[ @"a", @"b", @"c", @"é" ];
+    srandom(17);
+    for (NSUInteger trial = 0 ; trial < 500 ; trial++) {
+        NSMutableString *string = [NSMutableString string];
+        NSMutableString *otherString = [NSMutableString string];
+        NSUInteger length = (NSUInteger)(random() % 80);
+        NSUInteger otherLength = (NSUInteger)(random() % 80);
+        for (NSUInteger i = 0 ; i < length ; i++) {
+            [string appendString:alphabet[(NSUInteger)random() % alphabet.count]];
+        }
+        
+        for (NSUInteger i = 0 ; i < otherLength ; i++) {
+            [otherString appendString:alphabet[(NSUInteger)random() % alphabet.count]];
+        }
+        
+        XCTAssertEqual(CLKEditDistance(string, otherString), [self _tableDistanceFromString:string toString:otherString], @"'%@' '%@'", string, otherString);
+    }
+}
+
+- (void)testSuggestions
+{
+    NSArray<NSString *> *strings = @[ @"verbose", @"version", @"quiet", @"output", @"outputs", @"dry-run", @"ålpha", @"alpha", @"" ];
+    CLKSuggestionIndex *index = [CLKSuggestionIndex indexWithStrings:strings];
+    
+    XCTAssertEqualObjects([index suggestionsForString:@"verbos"], @[ @"verbose" ]);
+    XCTAssertEqualObjects([index suggestionsForString:@"vrebose"], @[ @"verbose" ]);
+    XCTAssertEqualObjects([index suggestionsForString:@"quiett"], @[ @"quiet" ]);
+    XCTAssertEqualObjects([index suggestionsForString:@"dryrun"], @[ @"dry-run" ]);
+    XCTAssertEqualObjects([index suggestionsForString:@"outptu"], (@[ @"output", @"outputs" ]));
+    XCTAssertEqualObjects([index suggestionsForString:@"Verbose"], @[ @"verbose" ]);
+    
+    // a misspelled first character still finds a suggestion
+    XCTAssertEqualObjects([index suggestionsForString:@"berbose"], @[ @"verbose" ]);
+    XCTAssertEqualObjects([index suggestionsForString:@"blpha"], (@[ @"ålpha", @"alpha" ]));
+    XCTAssertEqualObjects([index suggestionsForString:@"ålphb"], @[ @"ålpha" ]);
+    
+    // the closest are suggested, in the order they were given, up to the limit
+    CLKSuggestionIndex *tied = [CLKSuggestionIndex indexWithStrings:@[ @"flarn", @"flarp", @"flarm", @"flarb", @"blarn" ]];
+    XCTAssertEqualObjects([tied suggestionsForString:@"flarx"], (@[ @"flarn", @"flarp", @"flarm" ]));
+    XCTAssertEqualObjects([tied suggestionsForString:@"xlarn"], (@[ @"flarn", @"blarn" ]));
+    
+    // but one sharing the first character comes first
+    XCTAssertEqualObjects([tied suggestionsForString:@"blarp"], (@[ @"blarn", @"flarp" ]));
+    
+    // names that are in the index, too far off, or too short to say
+    XCTAssertEqualObjects([index suggestionsForString:@"verbose"], @[]);
+    XCTAssertEqualObjects([index suggestionsForString:@"xyzzy"], @[]);
+    XCTAssertEqualObjects([index suggestionsForString:@"out"], @[]);
+    XCTAssertEqualObjects([index suggestionsForString:@"q"], @[]);
+    XCTAssertEqualObjects([index suggestionsForString:@""], @[]);
+    XCTAssertEqualObjects([[CLKSuggestionIndex indexWithStrings:@[]] suggestionsForString:@"verbose"], @[]);
+    
+    // a misspelling too long for one word
+    NSString *longName = [@"" stringByPaddingToLength:70 withString:@"long-option-" startingAtIndex:0];
+    CLKSuggestionIndex *longIndex = [CLKSuggestionIndex indexWithStrings:@[ @"verbose", longName ]];
+    XCTAssertEqualObjects([longIndex suggestionsForString:[longName stringByAppendingString:@"x"]], @[ longName ]);
+    XCTAssertEqualObjects([longIndex suggestionsForString:[longName substringFromIndex:3]], @[ longName ]);
+}
+
+- (void)testSuggestions_largeIndex
+{
+    NSArray<NSString *> *names = [self _optionNamesWithCount:2000];
+    CLKSuggestionIndex *index = [CLKSuggestionIndex indexWithStrings:names];
+    
+    // a misspelling of every hundredth name is matched by that name or one just as close
+    for (NSUInteger i = 0 ; i < names.count ; i += 100) {
+        NSString *name = names[i];
+        NSString *misspelling = [name stringByReplacingCharactersInRange:NSMakeRange(1, 1) withString:@"#"];
+        NSArray<NSString *> *suggestions = [index suggestionsForString:misspelling];
+        XCTAssertGreaterThan(suggestions.count, 0UL, @"%@", misspelling);
+        XCTAssertLessThanOrEqual(suggestions.count, (NSUInteger)CLKSuggestionLimit);
+        for (NSString *suggestion in suggestions) {
+            XCTAssertEqual(CLKEditDistance(misspelling, suggestion), 1UL, @"%@ %@", misspelling, suggestion);
+        }
+        
+        XCTAssertTrue([suggestions containsObject:name] || suggestions.count == CLKSuggestionLimit, @"%@", misspelling);
+    }
+}
+
+- (void)testSuggestionListDescription
+{
+    XCTAssertEqualObjects(CLKSuggestionListDescription(@[ @"--alpha" ]), @"'--alpha'");
+    XCTAssertEqualObjects(CLKSuggestionListDescription((@[ @"alpha", @"bravo" ])), @"'alpha' or 'bravo'");
+    XCTAssertEqualObjects(CLKSuggestionListDescription((@[ @"alpha", @"bravo", @"charlie" ])), @"'alpha', 'bravo' or 'charlie'");
+}
+
+#pragma mark -
+#pragma mark Benchmarks
+
+// the error path for a misspelled option of a 2000-option command: this should stay well under a millisecond
+- (void)testPerformance_suggestions
+{
+    NSArray<NSString *> *names = [self _optionNamesWithCount:2000];
+    CLKSuggestionIndex *index = [CLKSuggestionIndex indexWithStrings:names];
+    NSArray<NSString *> *misspellings = @[ @"outptu-branch-3", @"verbose-clor-1", @"xyzzy", @"timeout-timeout-6", @"dry-rn-0" ];
+    [self measureBlock:^{
+        for (NSUInteger i = 0 ; i < 100 ; i++) {
+            for (NSString *misspelling in misspellings) {
+                (void)[index suggestionsForString:misspelling];
+            }
+        }
+    }];
+}
+
+- (void)testPerformance_indexing
+{
+    NSArray<NSString *> *names = [self _optionNamesWithCount:2000];
+    [self measureBlock:^{
+        for (NSUInteger i = 0 ; i < 100 ; i++) {
+            (void)[CLKSuggestionIndex indexWithStrings:names];
+        }
+    }];
+}
+
+@end
@@ -318,6 +318,83 @@ NS_ASSUME_NONNULL_END
     }];
 }
 
+- (void)test_CLKTokenAnalyze
+{
+    // forms must agree with the per-form predicates for every input token
+    [self enumerateInputTokens:^(NSString *token, CLKTokenForm form) {
+        XCTAssertEqual(CLKTokenAnalyze(token).form, form, @"token: '%@'", token);
+    }];
+    
+    CLKTokenAnalysis analysis = CLKTokenAnalyze(@"--flarn=barf");
+    XCTAssertEqual(analysis.form, CLKTokenFormParameterOptionNameAssignment);
+    XCTAssertTrue(NSEqualRanges(analysis.optionRange, NSMakeRange(2, 5)));
+    XCTAssertTrue(NSEqualRanges(analysis.argumentRange, NSMakeRange(8, 4)));
+    
+    analysis = CLKTokenAnalyze(@"--flarn:barf=quone");
+    XCTAssertEqual(analysis.form, CLKTokenFormParameterOptionNameAssignment);
+    XCTAssertTrue(NSEqualRanges(analysis.optionRange, NSMakeRange(2, 5)));
+    XCTAssertTrue(NSEqualRanges(analysis.argumentRange, NSMakeRange(8, 10)));
+    
+    analysis = CLKTokenAnalyze(@"--flarn=");
+    XCTAssertEqual(analysis.form, CLKTokenFormParameterOptionNameAssignment);
+    XCTAssertTrue(NSEqualRanges(analysis.argumentRange, NSMakeRange(8, 0)));
+    
+    analysis = CLKTokenAnalyze(@"-q:barf");
+    XCTAssertEqual(analysis.form, CLKTokenFormParameterOptionFlagAssignment);
+    XCTAssertTrue(NSEqualRanges(analysis.optionRange, NSMakeRange(1, 1)));
+    XCTAssertTrue(NSEqualRanges(analysis.argumentRange, NSMakeRange(3, 4)));
+    
+    analysis = CLKTokenAnalyze(@"--flarn");
+    XCTAssertEqual(analysis.form, CLKTokenFormOptionName);
+    XCTAssertTrue(NSEqualRanges(analysis.optionRange, NSMakeRange(2, 5)));
+    XCTAssertEqual(analysis.argumentRange.location, (NSUInteger)NSNotFound);
+    
+    analysis = CLKTokenAnalyze(@"-xyz");
+    XCTAssertEqual(analysis.form, CLKTokenFormOptionFlagSet);
+    XCTAssertTrue(NSEqualRanges(analysis.optionRange, NSMakeRange(1, 3)));
+    
+    analysis = CLKTokenAnalyze(@"/flarn/barf.txt");
+    XCTAssertEqual(analysis.form, CLKTokenFormArgument);
+    XCTAssertEqual(analysis.optionRange.location, (NSUInteger)NSNotFound);
+    XCTAssertEqual(analysis.argumentRange.location, (NSUInteger)NSNotFound);
+}
+
+- (void)test_CLKTokenAnalyze_longTokens
+{
+    // long tokens exercise the block scanner and the heap buffer.
+    // place an interesting character at every offset to catch block boundary errors.
+    NSString *longName = [@"" stringByPaddingToLength:300 withString:@"flarn" startingAtIndex:0];
+    XCTAssertEqual(CLKTokenAnalyze([@"--" stringByAppendingString:longName]).form, CLKTokenFormOptionName);
+    XCTAssertEqual(CLKTokenAnalyze([@"-" stringByAppendingString:longName]).form, CLKTokenFormOptionFlagSet);
+    XCTAssertEqual(CLKTokenAnalyze([longName stringByAppendingString:@" --barf"]).form, CLKTokenFormArgument);
+    
+    for (NSUInteger i = 1 ; i < 40 ; i++) {
+        NSString *name = [longName substringToIndex:i];
+        NSString *tail = [longName substringToIndex:(40 - i)];
+        
+        NSString *token = [NSString stringWithFormat:@"--%@=%@", name, tail];
+        CLKTokenAnalysis analysis = CLKTokenAnalyze(token);
+        XCTAssertEqual(analysis.form, CLKTokenFormParameterOptionNameAssignment, @"token: '%@'", token);
+        XCTAssertTrue(NSEqualRanges(analysis.optionRange, NSMakeRange(2, i)), @"token: '%@'", token);
+        XCTAssertTrue(NSEqualRanges(analysis.argumentRange, NSMakeRange((i + 3), (40 - i))), @"token: '%@'", token);
+        
+        token = [NSString stringWithFormat:@"--%@ %@", name, tail];
+        XCTAssertEqual(CLKTokenAnalyze(token).form, CLKTokenFormMalformedOption, @"token: '%@'", token);
+        
+        token = [NSString stringWithFormat:@"--%@\u3000%@", name, tail];
+        XCTAssertEqual(CLKTokenAnalyze(token).form, CLKTokenFormMalformedOption, @"token: '%@'", token);
+        
+        token = [NSString stringWithFormat:@"--%@\u00e9%@", name, tail];
+        XCTAssertEqual(CLKTokenAnalyze(token).form, CLKTokenFormOptionName, @"token: '%@'", token);
+        
+        token = [NSString stringWithFormat:@"-%@-%@", name, tail];
+        XCTAssertEqual(CLKTokenAnalyze(token).form, CLKTokenFormMalformedOption, @"token: '%@'", token);
+        
+        token = [NSString stringWithFormat:@"--%@-%@", name, tail];
+        XCTAssertEqual(CLKTokenAnalyze(token).form, CLKTokenFormOptionName, @"token: '%@'", token);
+    }
+}
+
 - (void)test_CLKTokenIsOptionName
 {
     [self enumerateInputTokens:^(NSString *token, CLKTokenForm form) {
@@ -9,9 +9,13 @@
 #import "CLKCommandResult.h"
 #import "CLKArgumentManifest_Private.h"
 #import "CLKOption.h"
+#import "CLKOptionGroup.h"
+#import "CLKOptionRegistry.h"
+#import "CLKOptionSchema_Private.h"
 #import "CLKVerb.h"
 #import "CLKVerbDepot.h"
-#import "CLKVerbFamily.h"
+#import "CLKVerbDescriptor.h"
+#import "CLKVerbFamily_Private.h"
 #import "StuntVerb.h"
 #import "NSError+CLKAdditions.h"
 #import "XCTestCase+CLKAdditions.h"
@@ -72,7 +76,7 @@ NS_ASSUME_NONNULL_END
     
     depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[] verbs:verbs verbFamilies:@[]];
     XCTAssertNotNil(depot);
-    
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wnonnull"
     XCTAssertThrows([[CLKVerbDepot alloc] initWithArgumentVector:nil verbs:verbs]);
@@ -112,7 +116,7 @@ NS_ASSUME_NONNULL_END
     
     depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[] verbs:topLevelVerbs verbFamilies:families];
     XCTAssertNotNil(depot);
-
+    
     // [#] should this be allowed?
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wnonnull"
@@ -202,6 +206,34 @@ NS_ASSUME_NONNULL_END
     [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
 }
 
+- (void)test_dispatchVerb_unrecognizedVerb_suggestions
+{
+    NSArray<id<CLKVerb>> *verbs = @[ [StuntVerb flarnVerb], [StuntVerb xyzzyVerb], [StuntVerb quoneVerb] ];
+    NSArray<CLKVerbFamily *> *families = @[ [CLKVerbFamily familyWithName:@"confound" verbs:@[ [StuntVerb barfVerb], [StuntVerb synVerb] ]] ];
+    
+    // top-level verbs and families are suggested together
+    NSError *expectedError = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb suggestions:@[ @"flarn" ] description:@"flarm: Unrecognized verb. Did you mean 'flarn'?"];
+    CLKCommandResult *expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"flarm" ] verbs:verbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+    
+    expectedError = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb suggestions:@[ @"confound" ] description:@"confuond: Unrecognized verb. Did you mean 'confound'?"];
+    expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"confuond", @"barf" ] verbs:verbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+    
+    expectedError = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb suggestions:@[ @"barf" ] description:@"bark: Unrecognized confound verb. Did you mean 'barf'?"];
+    expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"confound", @"bark" ] verbs:verbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+    
+    // an option where a verb was expected is left alone
+    expectedError = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb description:@"--quone: Unrecognized verb."];
+    expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"--quone" ] verbs:verbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+}
+
 - (void)test_dispatchVerb_optionlessVerb
 {
     NSArray<id<CLKVerb>> *verbs = @[ [StuntVerb verbWithName:@"xyzzy" options:nil] ];
@@ -351,4 +383,345 @@ NS_ASSUME_NONNULL_END
     [self _performDispatchTestWithDepot:depot expectedVerb:@"syn" expectedManifest:expectedManifest];
 }
 
+- (void)test_dispatchVerb_subfamilies
+{
+    CLKOption *charlie = [CLKOption optionWithName:@"charlie" flag:@"c"];
+    CLKVerbFamily *track = [CLKVerbFamily familyWithName:@"track" verbs:@[ [StuntVerb verbWithName:@"set" option:charlie] ]];
+    CLKVerbFamily *branch = [CLKVerbFamily familyWithName:@"branch" options:nil optionGroups:nil verbs:@[ [StuntVerb flarnVerb], [StuntVerb barfVerb] ] subfamilies:@[ track ]];
+    CLKVerbFamily *remote = [CLKVerbFamily familyWithName:@"remote" options:nil optionGroups:nil verbs:@[ [StuntVerb quoneVerb] ] subfamilies:@[ branch ]];
+    NSArray<id<CLKVerb>> *topLevelVerbs = @[ [StuntVerb xyzzyVerb] ];
+    NSArray<CLKVerbFamily *> *families = @[ remote, [CLKVerbFamily familyWithName:@"delivery" verbs:@[ [StuntVerb synVerb] ]] ];
+    
+    CLKArgumentManifest *expectedManifest = [self manifestWithSwitchOptions:@{ charlie : @(1) } parameterOptions:nil];
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"branch", @"track", @"set", @"-c" ] verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedVerb:@"set" expectedManifest:expectedManifest];
+    
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"quone", @"--charlie" ] verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedVerb:@"quone" expectedManifest:expectedManifest];
+    
+    CLKOption *alpha = [CLKOption optionWithName:@"alpha" flag:@"a"];
+    // names past the verb are its arguments, even when they name a subfamily
+    CLKVerbDepot *flarnDepot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"branch", @"flarn", @"-a", @"track" ] verbs:topLevelVerbs verbFamilies:families];
+    CLKCommandResult *result = [flarnDepot dispatchVerb];
+    XCTAssertEqualObjects(result.userInfo[@"verb"], @"flarn");
+    XCTAssertEqualObjects([result.userInfo[@"manifest"] positionalArguments], @[ @"track" ]);
+    
+    // errors name the family by its path, and suggest its verbs and subfamilies alike
+    NSError *expectedError = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb description:@"set: Unrecognized remote branch verb."];
+    CLKCommandResult *expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"branch", @"set" ] verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+    
+    expectedError = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb suggestions:@[ @"track" ] description:@"trakc: Unrecognized remote branch verb. Did you mean 'track'?"];
+    expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"branch", @"trakc", @"set" ] verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+    
+    expectedError = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb suggestions:@[ @"set" ] description:@"sat: Unrecognized remote branch track verb. Did you mean 'set'?"];
+    expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"branch", @"track", @"sat" ] verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+    
+    // subfamilies are only found under their superfamily
+    expectedError = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb description:@"branch: Unrecognized verb."];
+    expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"branch", @"flarn" ] verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+    
+    // and aren't top-level families themselves
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"branch", @"flarn" ] verbs:topLevelVerbs verbFamilies:@[ remote, branch ]];
+    XCTAssertThrowsSpecificNamed([depot dispatchVerb], NSException, NSInvalidArgumentException);
+}
+
+- (void)test_dispatchVerb_familyOptions
+{
+    CLKOption *verbose = [CLKOption optionWithName:@"verbose" flag:@"v"];
+    CLKOption *quiet = [CLKOption optionWithName:@"quiet" flag:@"q"];
+    CLKOption *force = [CLKOption optionWithName:@"force" flag:@"f"];
+    CLKOption *alpha = [CLKOption optionWithName:@"alpha" flag:@"a"];
+    CLKOption *bravo = [CLKOption optionWithName:@"bravo" flag:@"b"];
+    NSArray *remoteGroups = @[ [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"verbose", @"quiet" ]] ];
+    
+    // delete's group refers to an option it inherits
+    NSArray *deleteGroups = @[ [CLKOptionGroup groupForOptionNamed:@"bravo" requiringDependency:@"force"] ];
+    StuntVerb *delete = [[StuntVerb alloc] initWithName:@"delete" options:@[ bravo ] optionGroups:deleteGroups];
+    CLKVerbFamily *branch = [CLKVerbFamily familyWithName:@"branch" options:@[ force ] optionGroups:nil verbs:@[ [StuntVerb verbWithName:@"rename" option:alpha], delete ] subfamilies:nil];
+    CLKVerbFamily *remote = [CLKVerbFamily familyWithName:@"remote" options:@[ verbose, quiet ] optionGroups:remoteGroups verbs:@[ [StuntVerb verbWithName:@"show" options:nil] ] subfamilies:@[ branch ]];
+    NSArray<id<CLKVerb>> *topLevelVerbs = @[ [StuntVerb verbWithName:@"status" options:nil] ];
+    NSArray<CLKVerbFamily *> *families = @[ remote ];
+    
+    CLKArgumentManifest *expectedManifest = [self manifestWithSwitchOptions:@{ verbose : @(1) } parameterOptions:nil];
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"show", @"-v" ] verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedVerb:@"show" expectedManifest:expectedManifest];
+    
+    expectedManifest = [self manifestWithSwitchOptions:@{ alpha : @(1), force : @(1), quiet : @(2) } parameterOptions:nil];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"branch", @"rename", @"-aqf", @"--quiet" ] verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedVerb:@"rename" expectedManifest:expectedManifest];
+    
+    expectedManifest = [self manifestWithSwitchOptions:@{ bravo : @(1), force : @(1) } parameterOptions:nil];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"branch", @"delete", @"--bravo", @"--force" ] verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedVerb:@"delete" expectedManifest:expectedManifest];
+    
+    // inherited groups and groups referring to inherited options are enforced
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"branch", @"rename", @"-v", @"-q" ] verbs:topLevelVerbs verbFamilies:families];
+    CLKCommandResult *result = [depot dispatchVerb];
+    XCTAssertEqual(result.exitStatus, EX_USAGE);
+    XCTAssertEqualObjects([result.errors valueForKey:@"localizedDescription"], @[ @"--verbose --quiet: mutually exclusive options encountered" ]);
+    
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"branch", @"delete", @"-b" ] verbs:topLevelVerbs verbFamilies:families];
+    result = [depot dispatchVerb];
+    XCTAssertEqual(result.exitStatus, EX_USAGE);
+    XCTAssertEqualObjects([result.errors valueForKey:@"localizedDescription"], @[ @"--force is required when using --bravo" ]);
+    
+    // options aren't inherited upward or by top-level verbs
+    NSError *expectedError = [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '--force'"];
+    CLKCommandResult *expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"show", @"--force" ] verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+    
+    expectedError = [NSError clk_POSIXErrorWithCode:EINVAL description:@"unrecognized option: '--verbose'"];
+    expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"status", @"--verbose" ] verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+    
+    // the family's options are indexed once, however many of its verbs run
+    CLKOptionSchema *renameSchema = [branch _schemaForVerbDescriptor:[branch verbDescriptorNamed:@"rename"] archive:nil verbRecord:0];
+    CLKOptionSchema *deleteSchema = [branch _schemaForVerbDescriptor:[branch verbDescriptorNamed:@"delete"] archive:nil verbRecord:0];
+    XCTAssertNotNil(renameSchema.optionRegistry.parentRegistry);
+    XCTAssertEqual(renameSchema.optionRegistry.parentRegistry, deleteSchema.optionRegistry.parentRegistry);
+    XCTAssertEqual(renameSchema.optionRegistry.parentRegistry, branch.optionSchema.optionRegistry);
+    
+    // a verb option can't shadow an inherited one
+    CLKVerbFamily *shadowed = [CLKVerbFamily familyWithName:@"shadowed" options:@[ alpha ] optionGroups:nil verbs:@[ [StuntVerb flarnVerb] ] subfamilies:nil];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"shadowed", @"flarn" ] verbs:topLevelVerbs verbFamilies:@[ shadowed ]];
+    XCTAssertThrowsSpecificNamed([depot dispatchVerb], NSException, NSInvalidArgumentException);
+}
+
+- (void)test_dispatchVerb_abbreviatedOptionNames
+{
+    CLKOption *verbose = [CLKOption optionWithName:@"verbose" flag:@"v"];
+    CLKOption *alpha = [CLKOption optionWithName:@"alpha" flag:@"a"];
+    CLKVerbFamily *remote = [CLKVerbFamily familyWithName:@"remote" options:@[ verbose ] optionGroups:nil verbs:@[ [StuntVerb verbWithName:@"flarn" option:alpha] ] subfamilies:nil];
+    NSArray<CLKVerbFamily *> *families = @[ remote ];
+    
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"remote", @"flarn", @"--al", @"--verb" ] verbs:@[ [StuntVerb quoneVerb] ] verbFamilies:families];
+    XCTAssertFalse(depot.abbreviatedOptionNamesEnabled);
+    XCTAssertEqual([depot dispatchVerb].exitStatus, EX_USAGE);
+    
+    depot.abbreviatedOptionNamesEnabled = YES;
+    CLKArgumentManifest *expectedManifest = [self manifestWithSwitchOptions:@{ alpha : @(1), verbose : @(1) } parameterOptions:nil];
+    [self _performDispatchTestWithDepot:depot expectedVerb:@"flarn" expectedManifest:expectedManifest];
+    
+    // verb and family names aren't abbreviated
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"rem", @"flarn" ] verbs:@[ [StuntVerb quoneVerb] ] verbFamilies:families];
+    depot.abbreviatedOptionNamesEnabled = YES;
+    XCTAssertEqual([depot dispatchVerb].exitStatus, EX_USAGE);
+}
+
+- (void)test_dispatchVerb_verbDescriptors
+{
+    NSMutableArray<NSString *> *instantiatedVerbs = [NSMutableArray array];
+    CLKVerbDescriptor *(^descriptor)(NSString *, StuntVerb *(^)(void)) = ^(NSString *name, StuntVerb *(^factory)(void)) {
+        return [CLKVerbDescriptor descriptorWithName:name factory:^{
+            [instantiatedVerbs addObject:name];
+            return factory();
+        }];
+    };
+    
+    NSArray<CLKVerbDescriptor *> *topLevelVerbs = @[
+        descriptor(@"flarn", ^{ return [StuntVerb flarnVerb]; }),
+        descriptor(@"quone", ^{ return [StuntVerb quoneVerb]; })
+    ];
+    
+    NSArray<CLKVerbFamily *> *families = @[
+        [CLKVerbFamily familyWithName:@"delivery" verbDescriptors:@[
+            descriptor(@"syn", ^{ return [StuntVerb synVerb]; }),
+            descriptor(@"ack", ^{ return [StuntVerb ackVerb]; })
+        ]]
+    ];
+    
+    CLKOption *alpha = [CLKOption optionWithName:@"alpha" flag:@"a"];
+    CLKOption *foxtrot = [CLKOption optionWithName:@"foxtrot" flag:@"f"];
+    
+    CLKArgumentManifest *expectedManifest = [self manifestWithSwitchOptions:@{ alpha : @(1) } parameterOptions:nil];
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"flarn", @"-a" ] verbDescriptors:topLevelVerbs verbFamilies:families];
+    XCTAssertEqualObjects(instantiatedVerbs, @[]);
+    [self _performDispatchTestWithDepot:depot expectedVerb:@"flarn" expectedManifest:expectedManifest];
+    XCTAssertEqualObjects(instantiatedVerbs, @[ @"flarn" ]);
+    
+    // a second dispatch reuses the verb
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"flarn", @"--alpha" ] verbDescriptors:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedVerb:@"flarn" expectedManifest:expectedManifest];
+    XCTAssertEqualObjects(instantiatedVerbs, @[ @"flarn" ]);
+    
+    const char *ackArgv[] = { "delivery", "ack", "-f" };
+    expectedManifest = [self manifestWithSwitchOptions:@{ foxtrot : @(1) } parameterOptions:nil];
+    depot = [[CLKVerbDepot alloc] initWithArgv:ackArgv argc:3 verbDescriptors:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedVerb:@"ack" expectedManifest:expectedManifest];
+    XCTAssertEqualObjects(instantiatedVerbs, (@[ @"flarn", @"ack" ]));
+    
+    // unrecognized verbs and usage errors instantiate nothing new
+    NSError *expectedError = [NSError clk_CLKErrorWithCode:CLKErrorUnrecognizedVerb description:@"xyzzy: Unrecognized delivery verb."];
+    CLKCommandResult *expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"delivery", @"xyzzy" ] verbDescriptors:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+    XCTAssertEqualObjects(instantiatedVerbs, (@[ @"flarn", @"ack" ]));
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    XCTAssertThrows([[CLKVerbDepot alloc] initWithArgumentVector:@[] verbDescriptors:nil verbFamilies:nil]);
+    XCTAssertThrows([[CLKVerbDepot alloc] initWithArgumentVector:@[] verbDescriptors:@[] verbFamilies:nil]);
+#pragma clang diagnostic pop
+}
+
+- (void)test_dispatchVerb_argv
+{
+    CLKOption *alpha = [CLKOption optionWithName:@"alpha" flag:@"a"];
+    CLKOption *echo = [CLKOption parameterOptionWithName:@"echo" flag:@"e" required:NO recurrent:YES transformer:nil];
+    NSArray<id<CLKVerb>> *topLevelVerbs = @[ [StuntVerb verbWithName:@"flarn" option:alpha] ];
+    NSArray<CLKVerbFamily *> *families = @[
+        [CLKVerbFamily familyWithName:@"delivery" verbs:@[ [StuntVerb verbWithName:@"syn" option:echo] ]]
+    ];
+    
+    const char *flarnArgv[] = { "flarn", "--alpha", "-a" };
+    CLKArgumentManifest *expectedManifest = [self manifestWithSwitchOptions:@{ alpha : @(2) } parameterOptions:nil];
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgv:flarnArgv argc:3 verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedVerb:@"flarn" expectedManifest:expectedManifest];
+    
+    const char *synArgv[] = { "delivery", "syn", "--echo", "acme", "-e=st\xc3\xa4tion" };
+    expectedManifest = [self manifestWithSwitchOptions:nil parameterOptions:@{ echo : @[ @"acme", @"stätion" ] }];
+    depot = [[CLKVerbDepot alloc] initWithArgv:synArgv argc:5 verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedVerb:@"syn" expectedManifest:expectedManifest];
+    
+    NSError *expectedError = [NSError clk_CLKErrorWithCode:CLKErrorNoVerbSpecified description:@"No verb specified."];
+    CLKCommandResult *expectedResult = [CLKCommandResult resultWithExitStatus:EX_USAGE errors:@[ expectedError ]];
+    depot = [[CLKVerbDepot alloc] initWithArgv:flarnArgv argc:0 verbs:topLevelVerbs verbFamilies:families];
+    [self _performDispatchTestWithDepot:depot expectedResult:expectedResult];
+}
+
+- (void)test_dispatchVerb_reset
+{
+    CLKOption *alpha = [CLKOption optionWithName:@"alpha" flag:@"a"];
+    CLKOption *echo = [CLKOption parameterOptionWithName:@"echo" flag:@"e" required:NO recurrent:YES transformer:nil];
+    NSArray<id<CLKVerb>> *topLevelVerbs = @[ [StuntVerb verbWithName:@"flarn" option:alpha] ];
+    NSArray<CLKVerbFamily *> *families = @[
+        [CLKVerbFamily familyWithName:@"delivery" verbs:@[ [StuntVerb verbWithName:@"syn" option:echo] ]]
+    ];
+    
+    // the manifest belongs to the verb's parser, so the same manifest means the same parser
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"flarn", @"--alpha" ] verbs:topLevelVerbs verbFamilies:families];
+    CLKCommandResult *result = [depot dispatchVerb];
+    CLKArgumentManifest *flarnManifest = result.userInfo[@"manifest"];
+    XCTAssertEqualObjects(flarnManifest.dictionaryRepresentationForAccumulatedOptions, @{ @"alpha" : @(1) });
+    
+    [depot resetWithArgumentVector:@[ @"delivery", @"syn", @"-e", @"acme" ]];
+    result = [depot dispatchVerb];
+    CLKArgumentManifest *synManifest = result.userInfo[@"manifest"];
+    XCTAssertNotEqual(synManifest, flarnManifest);
+    XCTAssertEqualObjects(synManifest.dictionaryRepresentationForAccumulatedOptions, @{ @"echo" : @[ @"acme" ] });
+    
+    [depot resetWithArgumentVector:@[ @"flarn", @"-a", @"-a", @"bravo" ]];
+    result = [depot dispatchVerb];
+    XCTAssertEqual(result.userInfo[@"manifest"], flarnManifest);
+    XCTAssertEqualObjects(flarnManifest.dictionaryRepresentationForAccumulatedOptions, @{ @"alpha" : @(2) });
+    XCTAssertEqualObjects(flarnManifest.positionalArguments, @[ @"bravo" ]);
+    
+    // a reused parser reports its own run's issues
+    [depot resetWithArgumentVector:@[ @"flarn", @"--xyzzy" ]];
+    result = [depot dispatchVerb];
+    XCTAssertEqual(result.exitStatus, EX_USAGE);
+    XCTAssertEqual(result.errors.count, 1UL);
+    
+    const char *synArgv[] = { "delivery", "syn", "--echo", "station" };
+    [depot resetWithArgv:synArgv argc:4];
+    result = [depot dispatchVerb];
+    XCTAssertEqual(result.userInfo[@"manifest"], synManifest);
+    XCTAssertEqualObjects(synManifest.dictionaryRepresentationForAccumulatedOptions, @{ @"echo" : @[ @"station" ] });
+}
+
+- (void)test_completions
+{
+    NSMutableArray<NSString *> *instantiatedVerbs = [NSMutableArray array];
+    CLKVerbDescriptor *(^descriptor)(NSString *, StuntVerb *(^)(void)) = ^(NSString *name, StuntVerb *(^factory)(void)) {
+        return [CLKVerbDescriptor descriptorWithName:name factory:^{
+            [instantiatedVerbs addObject:name];
+            return factory();
+        }];
+    };
+    
+    CLKOption *alpha = [CLKOption optionWithName:@"alpha" flag:@"a"];
+    CLKOption *echo = [CLKOption parameterOptionWithName:@"echo" flag:@"e"];
+    CLKOption *extra = [CLKOption optionWithName:@"extra" flag:@"x"];
+    NSArray<CLKVerbDescriptor *> *topLevelVerbs = @[
+        descriptor(@"flarn", ^{ return [StuntVerb verbWithName:@"flarn" option:alpha]; }),
+        descriptor(@"flock", ^{ return [StuntVerb verbWithName:@"flock" options:nil]; }),
+        descriptor(@"barf", ^{ return [StuntVerb barfVerb]; })
+    ];
+    
+    NSArray<CLKVerbFamily *> *families = @[
+        [CLKVerbFamily familyWithName:@"fleet" verbDescriptors:@[
+            descriptor(@"syn", ^{ return [StuntVerb verbWithName:@"syn" options:@[ echo, extra ]]; }),
+            descriptor(@"sync", ^{ return [StuntVerb verbWithName:@"sync" options:nil]; })
+        ]]
+    ];
+    
+    NSArray<NSString *> *(^complete)(NSArray<NSString *> *, NSUInteger) = ^(NSArray<NSString *> *argv, NSUInteger idx) {
+        CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:argv verbDescriptors:topLevelVerbs verbFamilies:families];
+        return [depot completionsForArgumentAtIndex:idx];
+    };
+    
+    XCTAssertEqualObjects(complete(@[], 0), (@[ @"barf", @"flarn", @"fleet", @"flock" ]));
+    XCTAssertEqualObjects(complete(@[ @"fl" ], 0), (@[ @"flarn", @"fleet", @"flock" ]));
+    XCTAssertEqualObjects(complete(@[ @"fle", @"--alpha" ], 0), @[ @"fleet" ]);
+    XCTAssertEqualObjects(complete(@[ @"xyzzy" ], 0), @[]);
+    XCTAssertEqualObjects(complete(@[ @"fleet" ], 1), (@[ @"syn", @"sync" ]));
+    XCTAssertEqualObjects(complete(@[ @"fleet", @"sync" ], 1), @[ @"sync" ]);
+    XCTAssertEqualObjects(instantiatedVerbs, @[]);
+    
+    XCTAssertEqualObjects(complete(@[ @"flarn" ], 1), @[ @"--alpha" ]);
+    XCTAssertEqualObjects(complete(@[ @"flarn", @"-" ], 1), (@[ @"-a", @"--alpha" ]));
+    XCTAssertEqualObjects(instantiatedVerbs, @[ @"flarn" ]);
+    
+    XCTAssertEqualObjects(complete(@[ @"fleet", @"syn", @"--e" ], 2), (@[ @"--echo", @"--extra" ]));
+    XCTAssertEqualObjects(complete(@[ @"fleet", @"syn", @"-e", @"acme", @"--e" ], 4), @[ @"--extra" ]);
+    XCTAssertEqualObjects(complete(@[ @"fleet", @"syn", @"--echo" ], 3), @[]);
+    XCTAssertEqualObjects(instantiatedVerbs, (@[ @"flarn", @"syn" ]));
+    
+    // unknown verbs don't complete
+    XCTAssertEqualObjects(complete(@[ @"xyzzy" ], 1), @[]);
+    XCTAssertEqualObjects(complete(@[ @"fleet", @"xyzzy" ], 2), @[]);
+    XCTAssertEqualObjects(instantiatedVerbs, (@[ @"flarn", @"syn" ]));
+    
+    CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:@[ @"flarn" ] verbDescriptors:topLevelVerbs verbFamilies:families];
+    XCTAssertThrows([depot completionsForArgumentAtIndex:2]);
+}
+
+- (void)test_completions_subfamilies
+{
+    CLKOption *verbose = [CLKOption optionWithName:@"verbose" flag:@"v"];
+    CLKOption *force = [CLKOption optionWithName:@"force" flag:@"f"];
+    CLKVerbFamily *track = [CLKVerbFamily familyWithName:@"track" verbs:@[ [StuntVerb verbWithName:@"set" options:nil] ]];
+    CLKVerbFamily *branch = [CLKVerbFamily familyWithName:@"branch" options:@[ force ] optionGroups:nil verbs:@[ [StuntVerb verbWithName:@"rename" options:nil], [StuntVerb verbWithName:@"tag" options:nil] ] subfamilies:@[ track ]];
+    CLKVerbFamily *remote = [CLKVerbFamily familyWithName:@"remote" options:@[ verbose ] optionGroups:nil verbs:@[ [StuntVerb verbWithName:@"show" options:nil] ] subfamilies:@[ branch ]];
+    NSArray<CLKVerbFamily *> *families = @[ remote ];
+    
+    NSArray<NSString *> *(^complete)(NSArray<NSString *> *, NSUInteger) = ^(NSArray<NSString *> *argv, NSUInteger idx) {
+        CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:argv verbs:@[ [StuntVerb flarnVerb] ] verbFamilies:families];
+        return [depot completionsForArgumentAtIndex:idx];
+    };
+    
+    XCTAssertEqualObjects(complete(@[ @"remote" ], 1), (@[ @"branch", @"show" ]));
+    XCTAssertEqualObjects(complete(@[ @"remote", @"branch" ], 2), (@[ @"rename", @"tag", @"track" ]));
+    XCTAssertEqualObjects(complete(@[ @"remote", @"branch", @"t" ], 2), (@[ @"tag", @"track" ]));
+    XCTAssertEqualObjects(complete(@[ @"remote", @"branch", @"track" ], 3), @[ @"set" ]);
+    
+    // verbs complete the options they inherit
+    XCTAssertEqualObjects(complete(@[ @"remote", @"show", @"--" ], 2), @[ @"--verbose" ]);
+    XCTAssertEqualObjects(complete(@[ @"remote", @"branch", @"track", @"set", @"--" ], 4), (@[ @"--force", @"--verbose" ]));
+    XCTAssertEqualObjects(complete(@[ @"remote", @"branch", @"tag", @"-f", @"--" ], 4), (@[ @"--force", @"--verbose" ]));
+    
+    XCTAssertEqualObjects(complete(@[ @"remote", @"xyzzy" ], 2), @[]);
+    XCTAssertEqualObjects(complete(@[ @"remote", @"branch", @"xyzzy" ], 3), @[]);
+}
+
 @end
@@ -0,0 +1,123 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "CLKCommandResult.h"
+#import "CLKOption.h"
+#import "CLKOptionSchema.h"
+#import "CLKVerb.h"
+#import "CLKVerbDescriptor.h"
+#import "StuntVerb.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// a verb that counts its options reads, as DeliveryVerb-style verbs build their options on every read
+@interface CountingVerb : NSObject <CLKVerb>
+
+@property (readonly) NSUInteger optionsReadCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation CountingVerb
+{
+    NSUInteger _optionsReadCount;
+}
+
+@synthesize optionsReadCount = _optionsReadCount;
+
+- (NSString *)name
+{
+    return @"counting";
+}
+
+- (NSArray<CLKOption *> *)options
+{
+    _optionsReadCount++;
+    return @[ [CLKOption optionWithName:@"alpha" flag:@"a"] ];
+}
+
+- (NSArray<CLKOptionGroup *> *)optionGroups
+{
+    return nil;
+}
+
+- (CLKCommandResult *)runWithManifest:(__unused CLKArgumentManifest *)manifest
+{
+    return [CLKCommandResult resultWithExitStatus:0];
+}
+
+@end
+
+#pragma mark -
+
+@interface Test_CLKVerbDescriptor : XCTestCase
+
+@end
+
+@implementation Test_CLKVerbDescriptor
+
+- (void)testInit
+{
+    StuntVerb *flarn = [StuntVerb flarnVerb];
+    CLKVerbDescriptor *descriptor = [CLKVerbDescriptor descriptorWithVerb:flarn];
+    XCTAssertEqualObjects(descriptor.name, @"flarn");
+    XCTAssertEqual(descriptor.verb, flarn);
+    
+    descriptor = [CLKVerbDescriptor descriptorWithName:@"counting" verbClass:[CountingVerb class]];
+    XCTAssertEqualObjects(descriptor.name, @"counting");
+    XCTAssertTrue([(id)descriptor.verb isKindOfClass:[CountingVerb class]]);
+    
+    XCTAssertThrows([CLKVerbDescriptor descriptorWithName:@"flarn" verbClass:[NSObject class]]);
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    XCTAssertThrows([CLKVerbDescriptor descriptorWithVerb:nil]);
+    XCTAssertThrows([CLKVerbDescriptor descriptorWithName:nil factory:^{ return flarn; }]);
+    XCTAssertThrows([CLKVerbDescriptor descriptorWithName:@"flarn" factory:nil]);
+    XCTAssertThrows([CLKVerbDescriptor descriptorWithName:@"flarn" verbClass:nil]);
+#pragma clang diagnostic pop
+}
+
+- (void)testLazyInstantiation
+{
+    __block NSUInteger factoryCallCount = 0;
+    CLKVerbDescriptor *descriptor = [CLKVerbDescriptor descriptorWithName:@"flarn" factory:^{
+        factoryCallCount++;
+        return [StuntVerb flarnVerb];
+    }];
+    
+    XCTAssertEqualObjects(descriptor.name, @"flarn");
+    XCTAssertEqual(factoryCallCount, 0UL);
+    
+    id<CLKVerb> verb = descriptor.verb;
+    XCTAssertEqualObjects(verb.name, @"flarn");
+    XCTAssertEqual(descriptor.verb, verb);
+    XCTAssertEqual(factoryCallCount, 1UL);
+    
+    // the verb has to have the name it was registered under
+    descriptor = [CLKVerbDescriptor descriptorWithName:@"barf" factory:^{
+        return [StuntVerb quoneVerb];
+    }];
+    
+    XCTAssertThrows(descriptor.verb);
+}
+
+- (void)testSchemaCaching
+{
+    CLKVerbDescriptor *descriptor = [CLKVerbDescriptor descriptorWithName:@"counting" verbClass:[CountingVerb class]];
+    CLKOptionSchema *schema = descriptor.schema;
+    XCTAssertEqualObjects([schema.options valueForKey:@"name"], @[ @"alpha" ]);
+    XCTAssertNil(schema.optionGroups);
+    XCTAssertEqual(descriptor.schema, schema);
+    XCTAssertEqual(((CountingVerb *)descriptor.verb).optionsReadCount, 1UL);
+    
+    // a verb without options gets an empty schema
+    descriptor = [CLKVerbDescriptor descriptorWithVerb:[StuntVerb verbWithName:@"xyzzy" options:nil]];
+    XCTAssertEqualObjects(descriptor.schema.options, @[]);
+}
+
+@end
@@ -4,7 +4,12 @@
 
 #import <XCTest/XCTest.h>
 
-#import "CLKVerbFamily.h"
+#import "CLKOption.h"
+#import "CLKOptionGroup.h"
+#import "CLKOptionRegistry.h"
+#import "CLKOptionSchema_Private.h"
+#import "CLKVerbDescriptor.h"
+#import "CLKVerbFamily_Private.h"
 #import "StuntVerb.h"
 
 @interface Test_CLKVerbFamily : XCTestCase
@@ -19,7 +24,7 @@
     CLKVerbFamily *family = [CLKVerbFamily familyWithName:@"confound" verbs:@[ flarn ]];
     XCTAssertEqualObjects(family.name, @"confound");
     XCTAssertEqualObjects(family.verbs, @[ flarn ]);
-    
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wnonnull"
     XCTAssertThrows([CLKVerbFamily familyWithName:nil verbs:@[ flarn ]]);
@@ -28,6 +33,121 @@
 #pragma clang diagnostic pop
 }
 
+- (void)testSubfamilies
+{
+    CLKVerbFamily *track = [CLKVerbFamily familyWithName:@"track" verbs:@[ [StuntVerb flarnVerb] ]];
+    CLKVerbFamily *branch = [CLKVerbFamily familyWithName:@"branch" options:nil optionGroups:nil verbs:@[ [StuntVerb quoneVerb] ] subfamilies:@[ track ]];
+    CLKVerbFamily *remote = [CLKVerbFamily familyWithName:@"remote" options:nil optionGroups:nil verbs:@[] subfamilies:@[ branch ]];
+    XCTAssertEqualObjects(remote.subfamilies, @[ branch ]);
+    XCTAssertEqualObjects(remote.verbDescriptors, @[]);
+    XCTAssertEqualObjects(track.subfamilies, @[]);
+    
+    XCTAssertEqual([remote subfamilyNamed:@"branch"], branch);
+    XCTAssertEqual([branch subfamilyNamed:@"track"], track);
+    XCTAssertNil([remote subfamilyNamed:@"track"]);
+    XCTAssertNil([branch subfamilyNamed:@"quone"]);
+    XCTAssertNil([branch verbDescriptorNamed:@"track"]);
+    
+    XCTAssertNil(remote.superfamily);
+    XCTAssertEqual(branch.superfamily, remote);
+    XCTAssertEqual(track.superfamily, branch);
+    XCTAssertEqualObjects(remote.path, @"remote");
+    XCTAssertEqualObjects(track.path, @"remote branch track");
+    
+    // verbs and subfamilies share a namespace
+    XCTAssertEqualObjects(branch.childNames, (@[ @"quone", @"track" ]));
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    XCTAssertThrows([CLKVerbFamily familyWithName:@"remote" options:nil optionGroups:nil verbs:@[] subfamilies:nil]);
+    XCTAssertThrows([CLKVerbFamily familyWithName:@"remote" options:nil optionGroups:nil verbs:nil subfamilies:@[ [CLKVerbFamily familyWithName:@"branch" verbs:@[ [StuntVerb quoneVerb] ]] ]]);
+#pragma clang diagnostic pop
+}
+
+- (void)testSubfamilyCollision
+{
+    CLKVerbFamily *flarnFamily = [CLKVerbFamily familyWithName:@"flarn" verbs:@[ [StuntVerb quoneVerb] ]];
+    XCTAssertThrowsSpecificNamed([CLKVerbFamily familyWithName:@"confound" options:nil optionGroups:nil verbs:@[ [StuntVerb flarnVerb] ] subfamilies:@[ flarnFamily ]], NSException, NSInvalidArgumentException);
+    
+    NSArray *subfamilies = @[
+        [CLKVerbFamily familyWithName:@"barf" verbs:@[ [StuntVerb quoneVerb] ]],
+        [CLKVerbFamily familyWithName:@"barf" verbs:@[ [StuntVerb xyzzyVerb] ]]
+    ];
+    
+    XCTAssertThrowsSpecificNamed([CLKVerbFamily familyWithName:@"confound" options:nil optionGroups:nil verbs:@[] subfamilies:subfamilies], NSException, NSInvalidArgumentException);
+    
+    // a subfamily belongs to one family
+    CLKVerbFamily *subfamily = [CLKVerbFamily familyWithName:@"syn" verbs:@[ [StuntVerb quoneVerb] ]];
+    CLKVerbFamily *family = [CLKVerbFamily familyWithName:@"confound" options:nil optionGroups:nil verbs:@[] subfamilies:@[ subfamily ]];
+    XCTAssertThrowsSpecificNamed([CLKVerbFamily familyWithName:@"delivery" options:nil optionGroups:nil verbs:@[] subfamilies:@[ subfamily ]], NSException, NSInvalidArgumentException);
+    XCTAssertEqual(subfamily.superfamily, family);
+}
+
+- (void)testOptionSchema
+{
+    CLKOption *verbose = [CLKOption optionWithName:@"verbose" flag:@"v"];
+    CLKOption *quiet = [CLKOption optionWithName:@"quiet" flag:@"q"];
+    CLKOption *force = [CLKOption optionWithName:@"force" flag:@"f"];
+    NSArray *groups = @[ [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"verbose", @"quiet" ]] ];
+    
+    CLKVerbDescriptor *quone = [CLKVerbDescriptor descriptorWithVerb:[StuntVerb quoneVerb]];
+    CLKVerbDescriptor *xyzzy = [CLKVerbDescriptor descriptorWithVerb:[StuntVerb xyzzyVerb]];
+    CLKVerbDescriptor *flarn = [CLKVerbDescriptor descriptorWithVerb:[StuntVerb flarnVerb]];
+    CLKVerbFamily *plain = [CLKVerbFamily familyWithName:@"plain" verbDescriptors:@[ flarn ]];
+    CLKVerbFamily *branch = [CLKVerbFamily familyWithName:@"branch" options:@[ force ] optionGroups:nil verbDescriptors:@[ quone, xyzzy ] subfamilies:@[ plain ]];
+    CLKVerbFamily *remote = [CLKVerbFamily familyWithName:@"remote" options:@[ verbose, quiet ] optionGroups:groups verbDescriptors:@[] subfamilies:@[ branch ]];
+    XCTAssertEqualObjects(remote.options, (@[ verbose, quiet ]));
+    XCTAssertEqualObjects(branch.options, @[ force ]);
+    XCTAssertNil(plain.options);
+    
+    // each family's options are compiled once, on top of its superfamily's
+    CLKOptionSchema *remoteSchema = remote.optionSchema;
+    CLKOptionSchema *branchSchema = branch.optionSchema;
+    XCTAssertEqualObjects(remoteSchema.options, (@[ verbose, quiet ]));
+    XCTAssertEqualObjects(branchSchema.options, (@[ verbose, quiet, force ]));
+    XCTAssertEqualObjects(branchSchema.optionGroups, groups);
+    XCTAssertEqual(branchSchema.optionRegistry.parentRegistry, remoteSchema.optionRegistry);
+    XCTAssertEqual(plain.optionSchema, branchSchema);
+    XCTAssertEqual(remote.optionSchema, remoteSchema);
+    
+    // verbs share the family's registry rather than indexing its options again
+    CLKOptionSchema *quoneSchema = [branch _schemaForVerbDescriptor:quone archive:nil verbRecord:0];
+    CLKOptionSchema *xyzzySchema = [branch _schemaForVerbDescriptor:xyzzy archive:nil verbRecord:0];
+    XCTAssertEqual(quoneSchema.optionRegistry.parentRegistry, branchSchema.optionRegistry);
+    XCTAssertEqual(xyzzySchema.optionRegistry.parentRegistry, branchSchema.optionRegistry);
+    XCTAssertEqualObjects(quoneSchema.options.lastObject.name, @"charlie");
+    XCTAssertEqual([quoneSchema handleForOptionNamed:@"force"], 2UL);
+    XCTAssertEqual([quoneSchema handleForOptionNamed:@"charlie"], 3UL);
+    XCTAssertEqual(quoneSchema.constraintProgram.optionRegistry, quoneSchema.optionRegistry);
+    XCTAssertEqual([branch _schemaForVerbDescriptor:quone archive:nil verbRecord:0], quoneSchema);
+    
+    // the descriptor's own schema only has the verb's options
+    XCTAssertNotEqual(quoneSchema, quone.schema);
+    XCTAssertEqual(quone.schema.options.count, 1UL);
+    
+    // families without options anywhere above them use the verb's own schema
+    CLKVerbFamily *optionless = [CLKVerbFamily familyWithName:@"optionless" verbDescriptors:@[ quone ]];
+    XCTAssertNil(optionless.optionSchema);
+    XCTAssertEqual([optionless _schemaForVerbDescriptor:quone archive:nil verbRecord:0], quone.schema);
+}
+
+- (void)testOptionSchema_invalid
+{
+    CLKOption *alpha = [CLKOption optionWithName:@"alpha" flag:@"a"];
+    
+    // flarn's --alpha collides with the inherited one
+    CLKVerbDescriptor *flarn = [CLKVerbDescriptor descriptorWithVerb:[StuntVerb flarnVerb]];
+    CLKVerbFamily *family = [CLKVerbFamily familyWithName:@"confound" options:@[ alpha ] optionGroups:nil verbDescriptors:@[ flarn ] subfamilies:nil];
+    XCTAssertThrowsSpecificNamed([family _schemaForVerbDescriptor:flarn archive:nil verbRecord:0], NSException, NSInvalidArgumentException);
+    
+    // family groups may only refer to the family's options and those it inherits
+    NSArray *groups = @[ [CLKOptionGroup mutexedGroupForOptionsNamed:@[ @"alpha", @"charlie" ]] ];
+    CLKVerbFamily *subfamily = [CLKVerbFamily familyWithName:@"syn" options:nil optionGroups:groups verbs:@[ [StuntVerb quoneVerb] ] subfamilies:nil];
+    CLKVerbFamily *superfamily = [CLKVerbFamily familyWithName:@"delivery" options:@[ alpha ] optionGroups:nil verbs:@[] subfamilies:@[ subfamily ]];
+    XCTAssertEqual(subfamily.superfamily, superfamily);
+    XCTAssertThrowsSpecificNamed(subfamily.optionSchema, NSException, NSInvalidArgumentException);
+}
+
 - (void)testVerbCollision
 {
     NSArray *verbs = @[
@@ -37,7 +157,7 @@
     ];
     
     XCTAssertThrows([CLKVerbFamily familyWithName:@"confound" verbs:verbs]);
-    
+
 /* [future: when case-insensitive lookup is implemented] */
 //
 //    verbs = @[
@@ -59,4 +179,33 @@
     XCTAssertNil([family verbNamed:@"xyzzy"]);
 }
 
+- (void)testVerbDescriptors
+{
+    __block NSUInteger factoryCallCount = 0;
+    CLKVerbDescriptor *flarn = [CLKVerbDescriptor descriptorWithName:@"flarn" factory:^{
+        factoryCallCount++;
+        return [StuntVerb flarnVerb];
+    }];
+    
+    CLKVerbDescriptor *quone = [CLKVerbDescriptor descriptorWithName:@"quone" factory:^{
+        factoryCallCount++;
+        return [StuntVerb quoneVerb];
+    }];
+    
+    CLKVerbFamily *family = [CLKVerbFamily familyWithName:@"confound" verbDescriptors:@[ flarn, quone ]];
+    XCTAssertEqualObjects(family.verbDescriptors, (@[ flarn, quone ]));
+    XCTAssertEqual([family verbDescriptorNamed:@"quone"], quone);
+    XCTAssertNil([family verbDescriptorNamed:@"xyzzy"]);
+    XCTAssertEqual(factoryCallCount, 0UL);
+    
+    XCTAssertEqualObjects([family verbNamed:@"quone"].name, @"quone");
+    XCTAssertEqual(factoryCallCount, 1UL);
+    
+    XCTAssertEqual(family.verbs.count, 2UL);
+    XCTAssertEqual(factoryCallCount, 2UL);
+    
+    NSArray *collidingDescriptors = @[ flarn, [CLKVerbDescriptor descriptorWithVerb:[StuntVerb flarnVerb]] ];
+    XCTAssertThrows([CLKVerbFamily familyWithName:@"confound" verbDescriptors:collidingDescriptors]);
+}
+
 @end
@@ -0,0 +1,394 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import <sys/stat.h>
+#import <sysexits.h>
+
+#import "CLKArgumentManifest.h"
+#import "CLKCommandContext.h"
+#import "CLKCommandResult.h"
+#import "CLKOption.h"
+#import "CLKServerProtocol.h"
+#import "CLKVerb.h"
+#import "CLKVerbDescriptor.h"
+#import "CLKVerbFamily.h"
+#import "CLKVerbServer.h"
+#import "StuntVerb.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// prints its --name argument along with the working directory and $FLARN it was run with
+@interface EchoVerb : NSObject <CLKVerb>
+
+@end
+
+@interface ServerResponse : NSObject
+
+@property int exitStatus;
+@property (readonly) NSMutableString *output;
+@property (readonly) NSMutableString *errorOutput;
+
+@end
+
+@interface Test_CLKVerbServer : XCTestCase
+
+@property (readonly) NSString *socketPath;
+
+- (nullable ServerResponse *)_sendArguments:(NSArray<NSString *> *)arguments environment:(NSDictionary<NSString *, NSString *> *)environment;
+- (nullable ServerResponse *)_sendFrames:(void (^)(int fd))frameWriter;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+@implementation EchoVerb
+
+- (NSString *)name
+{
+    return @"echo";
+}
+
+- (NSArray<CLKOption *> *)options
+{
+    return @[ [CLKOption parameterOptionWithName:@"name" flag:@"n"] ];
+}
+
+- (NSArray<CLKOptionGroup *> *)optionGroups
+{
+    return nil;
+}
+
+- (CLKCommandResult *)runWithManifest:(CLKArgumentManifest *)manifest
+{
+    CLKCommandContext *context = [CLKCommandContext currentContext];
+    [context printOutput:@"%@ %@ %@\n", manifest[@"name"][0], context.workingDirectory, context.environment[@"FLARN"]];
+    [context printError:@"echoed\n"];
+    return [CLKCommandResult resultWithExitStatus:7];
+}
+
+@end
+
+@implementation ServerResponse
+
+@synthesize exitStatus = _exitStatus;
+@synthesize output = _output;
+@synthesize errorOutput = _errorOutput;
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self != nil) {
+        _exitStatus = -1;
+        _output = [NSMutableString string];
+        _errorOutput = [NSMutableString string];
+    }
+    
+    return self;
+}
+
+@end
+
+@implementation Test_CLKVerbServer
+{
+    NSString *_socketPath;
+}
+
+@synthesize socketPath = _socketPath;
+
+- (void)setUp
+{
+    [super setUp];
+    
+    // sun_path is short, so stay out of the (long) per-user temporary directory
+    _socketPath = [NSString stringWithFormat:@"/tmp/clkit-%d-%@.sock", getpid(), NSUUID.UUID.UUIDString];
+}
+
+- (void)tearDown
+{
+    unlink(_socketPath.fileSystemRepresentation);
+    [super tearDown];
+}
+
+- (ServerResponse *)_sendArguments:(NSArray<NSString *> *)arguments environment:(NSDictionary<NSString *, NSString *> *)environment
+{
+    return [self _sendFrames:^(int fd) {
+        CLKServerWriteIntegerFrame(fd, CLKServerFrameTypeHello, CLKServerProtocolVersion);
+        CLKServerWriteFrame(fd, CLKServerFrameTypeWorkingDirectory, "/flarn/barf", 11);
+        for (NSString *argument in arguments) {
+            CLKServerWriteFrame(fd, CLKServerFrameTypeArgument, argument.UTF8String, (uint32_t)strlen(argument.UTF8String));
+        }
+        
+        [environment enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSString *value, __unused BOOL *outStop) {
+            NSString *variable = [NSString stringWithFormat:@"%@=%@", name, value];
+            CLKServerWriteFrame(fd, CLKServerFrameTypeEnvironment, variable.UTF8String, (uint32_t)strlen(variable.UTF8String));
+        }];
+        
+        CLKServerWriteFrame(fd, CLKServerFrameTypeRun, NULL, 0);
+    }];
+}
+
+- (ServerResponse *)_sendFrames:(void (^)(int fd))frameWriter
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, _socketPath.fileSystemRepresentation, sizeof(address.sun_path) - 1);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        
+        return nil;
+    }
+    
+    CLKServerConfigureSocket(fd);
+    frameWriter(fd);
+    
+    ServerResponse *response = [[ServerResponse alloc] init];
+    for (;;) {
+        CLKServerFrameType type;
+        uint32_t length;
+        if (CLKServerReadFrameHeader(fd, &type, &length) != 0) {
+            break;
+        }
+        
+        NSMutableData *payload = [NSMutableData dataWithLength:length];
+        if (length > 0 && CLKServerReadFully(fd, payload.mutableBytes, length) != 0) {
+            break;
+        }
+        
+        if (type == CLKServerFrameTypeExit) {
+            response.exitStatus = CLKServerDecodeInteger(payload.bytes);
+            break;
+        }
+        
+        NSString *string = [[NSString alloc] initWithData:payload encoding:NSUTF8StringEncoding];
+        [(type == CLKServerFrameTypeOutput ? response.output : response.errorOutput) appendString:string];
+    }
+    
+    close(fd);
+    return response;
+}
+
+#pragma mark -
+
+- (void)testInit
+{
+    NSArray<CLKVerbDescriptor *> *verbs = @[ [CLKVerbDescriptor descriptorWithVerb:[StuntVerb flarnVerb]] ];
+    CLKVerbServer *server = [CLKVerbServer serverWithSocketPath:_socketPath verbDescriptors:verbs verbFamilies:nil];
+    XCTAssertNotNil(server);
+    XCTAssertEqualObjects(server.socketPath, _socketPath);
+    XCTAssertFalse(server.listening);
+    
+    CLKVerbFamily *family = [CLKVerbFamily familyWithName:@"flarn" verbs:@[ [StuntVerb barfVerb] ]];
+    XCTAssertThrows([CLKVerbServer serverWithSocketPath:_socketPath verbDescriptors:verbs verbFamilies:@[ family ]]);
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+    XCTAssertThrows([CLKVerbServer serverWithSocketPath:nil verbDescriptors:verbs verbFamilies:nil]);
+    XCTAssertThrows([CLKVerbServer serverWithSocketPath:@"" verbDescriptors:verbs verbFamilies:nil]);
+    XCTAssertThrows([CLKVerbServer serverWithSocketPath:_socketPath verbDescriptors:nil verbFamilies:nil]);
+    XCTAssertThrows([CLKVerbServer serverWithSocketPath:_socketPath verbDescriptors:@[] verbFamilies:nil]);
+#pragma clang diagnostic pop
+}
+
+- (void)testListening
+{
+    NSArray<CLKVerbDescriptor *> *verbs = @[ [CLKVerbDescriptor descriptorWithVerb:[StuntVerb flarnVerb]] ];
+    CLKVerbServer *server = [CLKVerbServer serverWithSocketPath:_socketPath verbDescriptors:verbs verbFamilies:nil];
+    NSError *error = nil;
+    XCTAssertTrue([server startListening:&error]);
+    XCTAssertNil(error);
+    XCTAssertTrue(server.listening);
+    XCTAssertThrows([server startListening:nil]);
+    
+    struct stat status;
+    XCTAssertEqual(lstat(_socketPath.fileSystemRepresentation, &status), 0);
+    XCTAssertTrue(S_ISSOCK(status.st_mode));
+    XCTAssertEqual((status.st_mode & 0777), (mode_t)0600);
+    
+    // a second server can't take over a socket that's in use
+    CLKVerbServer *rival = [CLKVerbServer serverWithSocketPath:_socketPath verbDescriptors:verbs verbFamilies:nil];
+    XCTAssertFalse([rival startListening:&error]);
+    XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+    XCTAssertEqual(error.code, EADDRINUSE);
+    
+    [server stopListening];
+    XCTAssertFalse(server.listening);
+    XCTAssertNotEqual(lstat(_socketPath.fileSystemRepresentation, &status), 0);
+    XCTAssertNil([self _sendArguments:@[ @"flarn" ] environment:@{}]);
+    
+    // a stale socket is replaced
+    int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, _socketPath.fileSystemRepresentation, sizeof(address.sun_path) - 1);
+    XCTAssertEqual(bind(stale, (struct sockaddr *)&address, sizeof(address)), 0);
+    close(stale);
+    
+    error = nil;
+    XCTAssertTrue([rival startListening:&error]);
+    XCTAssertNil(error);
+    XCTAssertNotNil([self _sendArguments:@[ @"flarn" ] environment:@{}]);
+    [rival stopListening];
+    
+    NSString *longPath = [@"/tmp/" stringByPaddingToLength:200 withString:@"x" startingAtIndex:0];
+    CLKVerbServer *longServer = [CLKVerbServer serverWithSocketPath:longPath verbDescriptors:verbs verbFamilies:nil];
+    XCTAssertFalse([longServer startListening:&error]);
+    XCTAssertEqual(error.code, ENAMETOOLONG);
+    XCTAssertFalse(longServer.listening);
+}
+
+- (void)testDispatch
+{
+    NSArray<CLKVerbDescriptor *> *verbs = @[
+        [CLKVerbDescriptor descriptorWithName:@"echo" verbClass:[EchoVerb class]],
+        [CLKVerbDescriptor descriptorWithVerb:[StuntVerb flarnVerb]]
+    ];
+    
+    CLKVerbFamily *family = [CLKVerbFamily familyWithName:@"delivery" verbs:@[ [[EchoVerb alloc] init] ]];
+    CLKVerbServer *server = [CLKVerbServer serverWithSocketPath:_socketPath verbDescriptors:verbs verbFamilies:@[ family ]];
+    XCTAssertTrue([server startListening:nil]);
+    
+    ServerResponse *response = [self _sendArguments:@[ @"echo", @"--name", @"stätion" ] environment:@{ @"FLARN" : @"barf=quone" }];
+    XCTAssertEqual(response.exitStatus, 7);
+    XCTAssertEqualObjects(response.output, @"stätion /flarn/barf barf=quone\n");
+    XCTAssertEqualObjects(response.errorOutput, @"echoed\n");
+    
+    response = [self _sendArguments:@[ @"delivery", @"echo", @"-n", @"acme" ] environment:@{}];
+    XCTAssertEqual(response.exitStatus, 7);
+    XCTAssertEqualObjects(response.output, @"acme /flarn/barf (null)\n");
+    
+    // errors are reported the way a standalone tool reports them
+    response = [self _sendArguments:@[ @"xyzzy" ] environment:@{}];
+    XCTAssertEqual(response.exitStatus, EX_USAGE);
+    XCTAssertEqualObjects(response.output, @"");
+    XCTAssertEqualObjects(response.errorOutput, @"xyzzy: Unrecognized verb.\n");
+    
+    response = [self _sendArguments:@[] environment:@{}];
+    XCTAssertEqual(response.exitStatus, EX_USAGE);
+    XCTAssertEqualObjects(response.errorOutput, @"No verb specified.\n");
+    
+    response = [self _sendArguments:@[ @"echo", @"--name" ] environment:@{}];
+    XCTAssertEqual(response.exitStatus, EX_USAGE);
+    XCTAssertEqualObjects(response.errorOutput, @"expected argument for option '--name'\n");
+    
+    // the process context is untouched
+    XCTAssertEqualObjects([CLKCommandContext currentContext].workingDirectory, NSFileManager.defaultManager.currentDirectoryPath);
+    
+    [server stopListening];
+}
+
+- (void)testDispatch_concurrent
+{
+    __block NSUInteger instantiationCount = 0;
+    NSArray<CLKVerbDescriptor *> *verbs = @[
+        [CLKVerbDescriptor descriptorWithName:@"echo" factory:^{
+            @synchronized (self) {
+                instantiationCount++;
+            }
+            
+            return [[EchoVerb alloc] init];
+        }]
+    ];
+    
+    CLKVerbServer *server = [CLKVerbServer serverWithSocketPath:_socketPath verbDescriptors:verbs verbFamilies:nil];
+    XCTAssertTrue([server startListening:nil]);
+    
+    const NSUInteger requestCount = 64;
+    NSMutableArray<ServerResponse *> *responses = [NSMutableArray array];
+    dispatch_apply(requestCount, dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^(size_t idx) {
+        NSString *name = [NSString stringWithFormat:@"request-%zu", idx];
+        ServerResponse *response = [self _sendArguments:@[ @"echo", @"--name", name ] environment:@{ @"FLARN" : name }];
+        @synchronized (responses) {
+            [responses addObject:response];
+        }
+        
+        NSString *expectedOutput = [NSString stringWithFormat:@"%@ /flarn/barf %@\n", name, name];
+        XCTAssertEqualObjects(response.output, expectedOutput);
+    });
+    
+    XCTAssertEqual(responses.count, requestCount);
+    for (ServerResponse *response in responses) {
+        XCTAssertEqual(response.exitStatus, 7);
+    }
+    
+    XCTAssertEqual(instantiationCount, 1UL);
+    [server stopListening];
+}
+
+- (void)testDispatch_malformedRequests
+{
+    NSArray<CLKVerbDescriptor *> *verbs = @[ [CLKVerbDescriptor descriptorWithName:@"echo" verbClass:[EchoVerb class]] ];
+    CLKVerbServer *server = [CLKVerbServer serverWithSocketPath:_socketPath verbDescriptors:verbs verbFamilies:nil];
+    XCTAssertTrue([server startListening:nil]);
+    
+    ServerResponse *response = [self _sendFrames:^(int fd) {
+        CLKServerWriteIntegerFrame(fd, CLKServerFrameTypeHello, 99);
+    }];
+    
+    XCTAssertEqual(response.exitStatus, EX_PROTOCOL);
+    XCTAssertEqualObjects(response.errorOutput, @"Unsupported protocol version 99 (the server speaks version 1).\n");
+    
+    response = [self _sendFrames:^(int fd) {
+        CLKServerWriteFrame(fd, CLKServerFrameTypeArgument, "echo", 4);
+    }];
+    
+    XCTAssertEqual(response.exitStatus, EX_PROTOCOL);
+    XCTAssertEqualObjects(response.errorOutput, @"Malformed request: expected a protocol version.\n");
+    
+    response = [self _sendFrames:^(int fd) {
+        CLKServerWriteIntegerFrame(fd, CLKServerFrameTypeHello, CLKServerProtocolVersion);
+        CLKServerWriteFrame(fd, CLKServerFrameTypeArgument, "echo", 4);
+        CLKServerWriteFrame(fd, CLKServerFrameTypeRun, NULL, 0);
+    }];
+    
+    XCTAssertEqual(response.exitStatus, EX_PROTOCOL);
+    XCTAssertEqualObjects(response.errorOutput, @"Malformed request: missing working directory.\n");
+    
+    response = [self _sendFrames:^(int fd) {
+        CLKServerWriteIntegerFrame(fd, CLKServerFrameTypeHello, CLKServerProtocolVersion);
+        CLKServerWriteFrame(fd, CLKServerFrameTypeEnvironment, "FLARN", 5);
+    }];
+    
+    XCTAssertEqual(response.exitStatus, EX_PROTOCOL);
+    XCTAssertEqualObjects(response.errorOutput, @"Malformed request: 'FLARN' is not an environment variable.\n");
+    
+    response = [self _sendFrames:^(int fd) {
+        CLKServerWriteIntegerFrame(fd, CLKServerFrameTypeHello, CLKServerProtocolVersion);
+        CLKServerWriteFrame(fd, CLKServerFrameTypeArgument, "\xff", 1);
+    }];
+    
+    XCTAssertEqual(response.exitStatus, EX_PROTOCOL);
+    XCTAssertEqualObjects(response.errorOutput, @"Malformed request: a string is not valid UTF-8.\n");
+    
+    // every frame is within the frame length limit, but together they are over the request limit
+    response = [self _sendFrames:^(int fd) {
+        NSMutableData *argument = [NSMutableData dataWithLength:(1024 * 1024)];
+        memset(argument.mutableBytes, 'a', argument.length);
+        CLKServerWriteIntegerFrame(fd, CLKServerFrameTypeHello, CLKServerProtocolVersion);
+        CLKServerWriteFrame(fd, CLKServerFrameTypeWorkingDirectory, "/flarn/barf", 11);
+        for (int i = 0 ; i < 16 ; i++) {
+            if (CLKServerWriteFrame(fd, CLKServerFrameTypeArgument, argument.bytes, (uint32_t)argument.length) != 0) {
+                break; // the server has stopped reading
+            }
+        }
+    }];
+    
+    XCTAssertEqual(response.exitStatus, EX_PROTOCOL);
+    XCTAssertEqualObjects(response.errorOutput, @"Malformed request: too large.\n");
+    
+    // the server outlives its bad clients
+    response = [self _sendArguments:@[ @"echo", @"-n", @"flarn" ] environment:@{}];
+    XCTAssertEqual(response.exitStatus, 7);
+    
+    [server stopListening];
+}
+
+@end
@@ -71,6 +71,7 @@
 {
     CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options optionGroups:groups];
     [self evaluateSpec:spec usingParser:parser];
+    [self _evaluateSpec:spec usingArgvParserWithArgumentVector:argv options:options optionGroups:groups];
 }
 
 - (void)performTestWithArgumentVector:(NSArray<NSString *> *)argv options:(NSArray<CLKOption *> *)options error:(NSError *)error
@@ -78,6 +79,7 @@
     ArgumentParsingResultSpec *spec = [ArgumentParsingResultSpec specWithError:error];
     CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options];
     [self evaluateSpec:spec usingParser:parser];
+    [self _evaluateSpec:spec usingArgvParserWithArgumentVector:argv options:options optionGroups:nil];
 }
 
 - (void)performTestWithArgumentVector:(NSArray<NSString *> *)argv
@@ -88,6 +90,24 @@
     ArgumentParsingResultSpec *spec = [ArgumentParsingResultSpec specWithError:error];
     CLKArgumentParser *parser = [CLKArgumentParser parserWithArgumentVector:argv options:options optionGroups:groups];
     [self evaluateSpec:spec usingParser:parser];
+    [self _evaluateSpec:spec usingArgvParserWithArgumentVector:argv options:options optionGroups:groups];
+}
+
+// runs the same spec through the C argv entry point, which classifies tokens on their UTF-8 bytes
+- (void)_evaluateSpec:(ArgumentParsingResultSpec *)spec
+    usingArgvParserWithArgumentVector:(NSArray<NSString *> *)argv
+                              options:(NSArray<CLKOption *> *)options
+                         optionGroups:(NSArray<CLKOptionGroup *> *)groups
+{
+    // the UTF-8 buffers belong to the strings in `argv`, which outlive the parser
+    const char **cargv = calloc((argv.count + 1), sizeof(char *));
+    for (NSUInteger i = 0 ; i < argv.count ; i++) {
+        cargv[i] = argv[i].UTF8String;
+    }
+    
+    CLKArgumentParser *parser = [CLKArgumentParser parserWithArgv:cargv argc:(int)argv.count options:options optionGroups:groups];
+    [self evaluateSpec:spec usingParser:parser];
+    free(cargv);
 }
 
 - (void)evaluateSpec:(ArgumentParsingResultSpec *)spec usingParser:(CLKArgumentParser *)parser
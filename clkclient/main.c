@@ -0,0 +1,134 @@
+//
+//  Copyright (c) 2019 Plastic Pulse. All rights reserved.
+//
+
+// the client shim for CLKVerbServer. it sends its arguments, working directory and environment to
+// the server listening at $CLK_SERVER_SOCKET, copies the verb's output to stdout and stderr and
+// exits with the verb's exit status. it is plain C so that it starts as quickly as possible.
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sysexits.h>
+
+#include "CLKServerProtocol.h"
+
+extern char **environ;
+
+static int CLKClientSendString(int fd, CLKServerFrameType type, const char *string)
+{
+    size_t length = strlen(string);
+    if (length > CLKServerMaximumFrameLength) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    
+    return CLKServerWriteFrame(fd, type, string, (uint32_t)length);
+}
+
+static int CLKClientSendRequest(int fd, int argc, char *argv[])
+{
+    char workingDirectory[PATH_MAX];
+    if (getcwd(workingDirectory, sizeof(workingDirectory)) == NULL) {
+        return -1;
+    }
+    
+    if (CLKServerWriteIntegerFrame(fd, CLKServerFrameTypeHello, CLKServerProtocolVersion) != 0
+        || CLKClientSendString(fd, CLKServerFrameTypeWorkingDirectory, workingDirectory) != 0)
+    {
+        return -1;
+    }
+    
+    for (int i = 1 ; i < argc ; i++) {
+        if (CLKClientSendString(fd, CLKServerFrameTypeArgument, argv[i]) != 0) {
+            return -1;
+        }
+    }
+    
+    for (char **variable = environ ; *variable != NULL ; variable++) {
+        if (CLKClientSendString(fd, CLKServerFrameTypeEnvironment, *variable) != 0) {
+            return -1;
+        }
+    }
+    
+    return CLKServerWriteFrame(fd, CLKServerFrameTypeRun, NULL, 0);
+}
+
+// answers the verb's exit status, or -1 if the response is cut short or malformed
+static int CLKClientReceiveResponse(int fd)
+{
+    static uint8_t buffer[64 * 1024];
+    
+    for (;;) {
+        CLKServerFrameType type;
+        uint32_t length;
+        if (CLKServerReadFrameHeader(fd, &type, &length) != 0) {
+            return -1;
+        }
+        
+        if (type == CLKServerFrameTypeExit) {
+            if (length != sizeof(int32_t) || CLKServerReadFully(fd, buffer, length) != 0) {
+                return -1;
+            }
+            
+            return CLKServerDecodeInteger(buffer);
+        }
+        
+        if (type != CLKServerFrameTypeOutput && type != CLKServerFrameTypeErrorOutput) {
+            errno = EPROTO;
+            return -1;
+        }
+        
+        FILE *file = (type == CLKServerFrameTypeOutput ? stdout : stderr);
+        while (length > 0) {
+            uint32_t chunkLength = (length < sizeof(buffer) ? length : (uint32_t)sizeof(buffer));
+            if (CLKServerReadFully(fd, buffer, chunkLength) != 0) {
+                return -1;
+            }
+            
+            fwrite(buffer, 1, chunkLength, file);
+            length -= chunkLength;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *socketPath = getenv(CLKServerSocketEnvironmentVariable);
+    if (socketPath == NULL || socketPath[0] == '\0') {
+        fprintf(stderr, "clkclient: %s is not set.\n", CLKServerSocketEnvironmentVariable);
+        return EX_USAGE;
+    }
+    
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "clkclient: %s: Socket path is too long.\n", socketPath);
+        return EX_USAGE;
+    }
+    
+    strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "clkclient: %s: %s\n", socketPath, strerror(errno));
+        return EX_UNAVAILABLE;
+    }
+    
+    CLKServerConfigureSocket(fd);
+    
+    if (CLKClientSendRequest(fd, argc, argv) != 0) {
+        fprintf(stderr, "clkclient: Failed to send request: %s\n", strerror(errno));
+        return EX_IOERR;
+    }
+    
+    int status = CLKClientReceiveResponse(fd);
+    if (status < 0) {
+        fprintf(stderr, "clkclient: Failed to read response: %s\n", strerror(errno));
+        return EX_PROTOCOL;
+    }
+    
+    close(fd);
+    return status;
+}
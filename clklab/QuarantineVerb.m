@@ -26,10 +26,11 @@
 
 - (CLKCommandResult *)runWithManifest:(CLKArgumentManifest *)manifest
 {
-    fprintf(stdout, "=================================================\n");
-    fprintf(stdout, "# %s\n", self.name.UTF8String);
-    fprintf(stdout, "=================================================\n");
-    fprintf(stdout, "%s\n", manifest.debugDescription.UTF8String);
+    CLKCommandContext *context = [CLKCommandContext currentContext];
+    [context printOutput:@"=================================================\n"];
+    [context printOutput:@"# %@\n", self.name];
+    [context printOutput:@"=================================================\n"];
+    [context printOutput:@"%@\n", manifest.debugDescription];
     return [CLKCommandResult resultWithExitStatus:0];
 }
 
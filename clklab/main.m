@@ -3,6 +3,8 @@
 //
 
 #import <Foundation/Foundation.h>
+#import <dispatch/dispatch.h>
+#import <sysexits.h>
 
 #import "CLKit.h"
 
@@ -14,19 +16,52 @@
 int main(int argc, const char *argv[])
 {
     @autoreleasepool {
-        NSArray *argvec = [NSArray clk_arrayWithArgv:argv+1 argc:argc-1];
-        NSArray<id<CLKVerb>> *topLevelVerbs = @[
-            [[ConfoundVerb alloc] init],
-            [[DeliveryVerb alloc] init]
+        // only the dispatched verb is created
+        NSArray<CLKVerbDescriptor *> *topLevelVerbs = @[
+            [CLKVerbDescriptor descriptorWithName:@"confound" verbClass:[ConfoundVerb class]],
+            [CLKVerbDescriptor descriptorWithName:@"delivery" verbClass:[DeliveryVerb class]]
         ];
         
-        NSArray<id<CLKVerb>> *thrudVerbs = @[
-            [[BlasphemeVerb alloc] init],
-            [[QuarantineVerb alloc] init]
+        NSArray<CLKVerbDescriptor *> *thrudVerbs = @[
+            [CLKVerbDescriptor descriptorWithName:@"blaspheme" verbClass:[BlasphemeVerb class]],
+            [CLKVerbDescriptor descriptorWithName:@"quarantine" verbClass:[QuarantineVerb class]]
         ];
         
-        CLKVerbFamily *thrud = [CLKVerbFamily familyWithName:@"thrud" verbs:thrudVerbs];
-        CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgumentVector:argvec verbs:topLevelVerbs verbFamilies:@[ thrud ]];
+        CLKVerbFamily *thrud = [CLKVerbFamily familyWithName:@"thrud" verbDescriptors:thrudVerbs];
+        
+        // clklab --serve <socket> keeps the verbs resident for clkclient. the verbs print through
+        // CLKCommandContext, so their output reaches the client.
+        if (argc == 3 && strcmp(argv[1], "--serve") == 0) {
+            NSString *socketPath = [NSFileManager.defaultManager stringWithFileSystemRepresentation:argv[2] length:strlen(argv[2])];
+            CLKVerbServer *server = [CLKVerbServer serverWithSocketPath:socketPath verbDescriptors:topLevelVerbs verbFamilies:@[ thrud ]];
+            NSError *error = nil;
+            if (![server startListening:&error]) {
+                fprintf(stderr, "%s\n", error.localizedDescription.UTF8String);
+                return EX_OSERR;
+            }
+            
+            dispatch_main();
+        }
+        
+        // clklab --archive-schema <path> writes the verbs' compiled schemas. the build puts one next
+        // to the executable, where it is picked up below.
+        if (argc == 3 && strcmp(argv[1], "--archive-schema") == 0) {
+            NSString *archivePath = [NSFileManager.defaultManager stringWithFileSystemRepresentation:argv[2] length:strlen(argv[2])];
+            NSData *archiveData = [CLKSchemaArchive archiveDataWithVerbDescriptors:topLevelVerbs verbFamilies:@[ thrud ]];
+            NSError *error = nil;
+            if (![archiveData writeToFile:archivePath options:NSDataWritingAtomic error:&error]) {
+                fprintf(stderr, "%s\n", error.localizedDescription.UTF8String);
+                return EX_CANTCREAT;
+            }
+            
+            return EX_OK;
+        }
+        
+        // without an archive (or with a stale one) the dispatched verb's schema is compiled as usual
+        NSString *archivePath = [NSBundle.mainBundle.executablePath stringByAppendingPathExtension:@"schema"];
+        CLKSchemaArchive *archive = (archivePath != nil ? [CLKSchemaArchive archiveWithContentsOfFile:archivePath error:NULL] : nil);
+        
+        CLKVerbDepot *depot = [[CLKVerbDepot alloc] initWithArgv:(argv + 1) argc:(argc - 1) verbDescriptors:topLevelVerbs verbFamilies:@[ thrud ] schemaArchive:archive];
         CLKCommandResult *result = [depot dispatchVerb];
         if (result.errors != nil) {
             fprintf(stderr, "%s\n", result.errorDescription.UTF8String);